@@ -59,6 +59,37 @@ typedef struct Texture2D
 	SDL_Surface *surface;
 } Texture2D;
 
+/* MATERIALS */
+#define MATERIAL_MAX_TEXTURES 4
+//the IQM exporter reverses Blender's winding, front faces come clockwise
+#define MATERIAL_IQM_FRONT_FACE SDL_GPU_FRONTFACE_CLOCKWISE
+
+//mapped to the pipeline cache's blend modes by material.h
+typedef enum MaterialBlend
+{
+	MATERIAL_BLEND_NONE = 0,
+	MATERIAL_BLEND_ALPHA,
+	MATERIAL_BLEND_ADD
+} MaterialBlend;
+
+//how a mesh wants to be drawn, turned into pipelines by material.h
+typedef struct Material
+{
+	char name[64];
+	//shader library names, NULL keeps the screen's own
+	const char *vertex_shader;
+	const char *fragment_shader;
+	SDL_GPUCullMode cull_mode;
+	SDL_GPUFrontFace front_face;
+	MaterialBlend blend;
+	bool depth_test;
+	bool depth_write;
+	SDL_GPUCompareOp compare_op;
+	//fragment sampler slots, owned by the mesh
+	SDL_GPUTexture *textures[MATERIAL_MAX_TEXTURES];
+	Uint32 num_textures;
+} Material;
+
 /* SKYBOXES */
 /*typedef struct Skybox
 {
@@ -105,6 +136,13 @@ typedef struct Mesh
 	SDL_GPUBuffer *ibuffer;
 	//texture
 	Texture2D diffuse;
+	//the same texels as a layer of a shared array, NULL unless
+	//TexArray_Pack packed it
+	SDL_GPUTexture *diffuse_array;
+	Uint32 diffuse_layer;
+	Material material;
+	//local space bounds, used for culling
+	AABB bounds;
 	//mesh name
 	char meshname[64];
 } Mesh;
@@ -121,6 +159,8 @@ typedef struct MeshArray
 typedef struct Model
 {
 	MeshArray meshes;
+	//local space bounds of all meshes
+	AABB bounds;
 } Model;
 
 /* OBJECTS */
@@ -170,6 +210,15 @@ bool LoadTextureFile(SDL_GPUDevice *device, Texture2D *texture,
 
 void ReleaseTexture2D(SDL_GPUDevice *device, Texture2D *texture);
 
+/* MATERIALS */
+
+//closed, opaque and depth tested: back faces culled
+void InitMaterial(Material *material, const char *name);
+
+//comma separated flags after the texture in IQM material names, like
+//"leaves.png,twosided,blend": twosided, blend, additive, nodepth
+void ParseMaterialFlags(Material *material, const char *flags);
+
 /* SKYBOXES */
 //TODO
 
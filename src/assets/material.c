@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2025 Matheus Klein Schaefer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <SDL3/SDL.h>
+#include <assets.h>
+
+void InitMaterial(Material *material, const char *name)
+{
+	*material = (Material){ 0 };
+	SDL_strlcpy(material->name, (name != NULL) ? name : "", sizeof(material->name));
+	material->cull_mode = SDL_GPU_CULLMODE_BACK;
+	material->front_face = MATERIAL_IQM_FRONT_FACE;
+	material->blend = MATERIAL_BLEND_NONE;
+	material->depth_test = true;
+	material->depth_write = true;
+	material->compare_op = SDL_GPU_COMPAREOP_LESS;
+}
+
+void ParseMaterialFlags(Material *material, const char *flags)
+{
+	while(flags != NULL && *flags != '\0')
+	{
+		const char *end = SDL_strchr(flags, ',');
+		size_t len = (end != NULL) ? (size_t)(end - flags) : SDL_strlen(flags);
+		if(len == 8 && SDL_strncmp(flags, "twosided", len) == 0)
+		{
+			material->cull_mode = SDL_GPU_CULLMODE_NONE;
+		}
+		else if(len == 5 && SDL_strncmp(flags, "blend", len) == 0)
+		{
+			//see-through surfaces don't hide what's drawn after them
+			material->blend = MATERIAL_BLEND_ALPHA;
+			material->depth_write = false;
+		}
+		else if(len == 8 && SDL_strncmp(flags, "additive", len) == 0)
+		{
+			material->blend = MATERIAL_BLEND_ADD;
+			material->depth_write = false;
+		}
+		else if(len == 7 && SDL_strncmp(flags, "nodepth", len) == 0)
+		{
+			material->depth_test = false;
+			material->depth_write = false;
+		}
+		else if(len > 0)
+		{
+			SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Material %s: unknown flag %.*s.", material->name, (int)len, flags);
+		}
+		flags = (end != NULL) ? end + 1 : NULL;
+	}
+}
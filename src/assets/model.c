@@ -41,6 +41,7 @@
 #include <iqm.h>
 #include <assets.h>
 #include <fileio.h>
+#include <gpumem.h>
 
 /**************************************************************************************
  * ARRAY HELPERS (vertices, indices, textures, meshes and materials
@@ -232,11 +233,53 @@ static void _arrayClearMeshes(MeshArray *arr)
 	_arrayInitMeshes(arr);
 }
 
+static AABB computebounds(const Vertex3D *vertices, size_t count)
+{
+	AABB box = { 0 };
+	if(vertices == NULL || count == 0)
+	{
+		return box;
+	}
+	Vector3 min = vertices[0].position;
+	Vector3 max = vertices[0].position;
+	for(size_t i = 1; i < count; i++)
+	{
+		Vector3 p = vertices[i].position;
+		min.x = SDL_min(min.x, p.x);
+		min.y = SDL_min(min.y, p.y);
+		min.z = SDL_min(min.z, p.z);
+		max.x = SDL_max(max.x, p.x);
+		max.y = SDL_max(max.y, p.y);
+		max.z = SDL_max(max.z, p.z);
+	}
+	box.center = Vector3_Scale(Vector3_Add(min, max), 0.5f);
+	box.half_size = Vector3_Scale(Vector3_Sub(max, min), 0.5f);
+	return box;
+}
+
+static AABB mergebounds(AABB a, AABB b)
+{
+	Vector3 min = {
+		SDL_min(a.center.x - a.half_size.x, b.center.x - b.half_size.x),
+		SDL_min(a.center.y - a.half_size.y, b.center.y - b.half_size.y),
+		SDL_min(a.center.z - a.half_size.z, b.center.z - b.half_size.z)
+	};
+	Vector3 max = {
+		SDL_max(a.center.x + a.half_size.x, b.center.x + b.half_size.x),
+		SDL_max(a.center.y + a.half_size.y, b.center.y + b.half_size.y),
+		SDL_max(a.center.z + a.half_size.z, b.center.z + b.half_size.z)
+	};
+	AABB result;
+	result.center = Vector3_Scale(Vector3_Add(min, max), 0.5f);
+	result.half_size = Vector3_Scale(Vector3_Sub(max, min), 0.5f);
+	return result;
+}
+
 static void uploadmesh(SDL_GPUDevice *device, Mesh *mesh)
 {
 	if(mesh == NULL) return;
 
-	mesh->vbuffer = SDL_CreateGPUBuffer(
+	mesh->vbuffer = GPUMem_CreateBuffer(
 		device,
 		&(SDL_GPUBufferCreateInfo) {
 			.usage = SDL_GPU_BUFFERUSAGE_VERTEX,
@@ -244,7 +287,7 @@ static void uploadmesh(SDL_GPUDevice *device, Mesh *mesh)
 		}
 	);
 
-	mesh->ibuffer = SDL_CreateGPUBuffer(
+	mesh->ibuffer = GPUMem_CreateBuffer(
 		device,
 		&(SDL_GPUBufferCreateInfo) {
 			.usage = SDL_GPU_BUFFERUSAGE_INDEX,
@@ -252,14 +295,14 @@ static void uploadmesh(SDL_GPUDevice *device, Mesh *mesh)
 		}
 	);
 
-	SDL_GPUTransferBuffer* vbufferTransferBuffer = SDL_CreateGPUTransferBuffer(
+	SDL_GPUTransferBuffer* vbufferTransferBuffer = GPUMem_CreateTransferBuffer(
 		device,
 		&(SDL_GPUTransferBufferCreateInfo) {
 			.usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
 			.size = (sizeof(Vertex3D) * mesh->varray.count)
 		}
 	);
-	SDL_GPUTransferBuffer* ibufferTransferBuffer = SDL_CreateGPUTransferBuffer(
+	SDL_GPUTransferBuffer* ibufferTransferBuffer = GPUMem_CreateTransferBuffer(
 		device,
 		&(SDL_GPUTransferBufferCreateInfo) {
 			.usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
@@ -307,8 +350,8 @@ static void uploadmesh(SDL_GPUDevice *device, Mesh *mesh)
 	);
 	SDL_EndGPUCopyPass(copyPass);
 
-	SDL_ReleaseGPUTransferBuffer(device, vbufferTransferBuffer);
-	SDL_ReleaseGPUTransferBuffer(device, ibufferTransferBuffer);
+	GPUMem_ReleaseTransferBuffer(device, vbufferTransferBuffer);
+	GPUMem_ReleaseTransferBuffer(device, ibufferTransferBuffer);
 
 	SDL_SubmitGPUCommandBuffer(cmdbuf);
 
@@ -493,17 +536,31 @@ bool ImportIQM(SDL_GPUDevice *device, Model *model,
 			}
 		}
 		SDL_snprintf(mesh.meshname, 64, "%s", iqm_mesh_name);
+		mesh.bounds = computebounds(mesh.varray.vertices, mesh.varray.count);
+		model->bounds = (i == 0) ? mesh.bounds : mergebounds(model->bounds, mesh.bounds);
 
 		char path_copy[512];
 		SDL_strlcpy(path_copy, iqmfile, sizeof(path_copy));
 		path_copy[sizeof(path_copy) - 1] = '\0';
 		char *dirpath = FileIOGetDirName(path_copy);
+		//material names are the texture path, maybe followed by flags
+		char texturename[256];
+		SDL_strlcpy(texturename, iqm_material, sizeof(texturename));
+		char *flags = SDL_strchr(texturename, ',');
+		if(flags != NULL)
+		{
+			*flags++ = '\0';
+		}
 		char fullpath[1024];
-		SDL_snprintf(fullpath, sizeof(fullpath), "%s/%s", dirpath, iqm_material);
+		SDL_snprintf(fullpath, sizeof(fullpath), "%s/%s", dirpath, texturename);
 		if(!LoadTextureFile(device, &mesh.diffuse, fullpath))
 		{
 			SDL_LogInfo(SDL_LOG_CATEGORY_ERROR, "Graphics: Error: Failed to load model's texture.");
 		}
+		InitMaterial(&mesh.material, texturename);
+		ParseMaterialFlags(&mesh.material, flags);
+		mesh.material.textures[0] = mesh.diffuse.texture;
+		mesh.material.num_textures = 1;
 
 		//everything might be ok here, so i can finally upload the mesh
 		uploadmesh(device, &mesh);
@@ -536,8 +593,8 @@ void ReleaseModel(SDL_GPUDevice *device, Model *model)
 	for(Uint32 i = 0; i < model->meshes.count; i++)
 	{
 		//destroy buffers
-		SDL_ReleaseGPUBuffer(device, model->meshes.meshes[i].vbuffer);
-		SDL_ReleaseGPUBuffer(device, model->meshes.meshes[i].ibuffer);
+		GPUMem_ReleaseBuffer(device, model->meshes.meshes[i].vbuffer);
+		GPUMem_ReleaseBuffer(device, model->meshes.meshes[i].ibuffer);
 
 		ReleaseTexture2D(device, &model->meshes.meshes[i].diffuse);
 
@@ -18,6 +18,7 @@
 #include <SDL3_image/SDL_image.h>
 #include <assets.h>
 #include <fileio.h>
+#include <gpumem.h>
 
 bool LoadTextureFile(SDL_GPUDevice *device, Texture2D *texture,
 						const char *path)
@@ -52,7 +53,7 @@ bool LoadTextureFile(SDL_GPUDevice *device, Texture2D *texture,
 	texcreateinfo.layer_count_or_depth = 1;
 	texcreateinfo.num_levels = 1;
 	texcreateinfo.usage = SDL_GPU_TEXTUREUSAGE_SAMPLER;
-	texture->texture = SDL_CreateGPUTexture(device, &texcreateinfo);
+	texture->texture = GPUMem_CreateTexture(device, &texcreateinfo);
 
 	if(texture == NULL)
 	{
@@ -60,7 +61,7 @@ bool LoadTextureFile(SDL_GPUDevice *device, Texture2D *texture,
 		return false;
 	}
 
-	SDL_GPUTransferBuffer* textureTransferBuffer = SDL_CreateGPUTransferBuffer(
+	SDL_GPUTransferBuffer* textureTransferBuffer = GPUMem_CreateTransferBuffer(
 		device,
 		&(SDL_GPUTransferBufferCreateInfo) {
 			.usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
@@ -97,7 +98,7 @@ bool LoadTextureFile(SDL_GPUDevice *device, Texture2D *texture,
 
 	SDL_EndGPUCopyPass(copyPass);
 	SDL_SubmitGPUCommandBuffer(uploadCmdBuf);
-	SDL_ReleaseGPUTransferBuffer(device, textureTransferBuffer);
+	GPUMem_ReleaseTransferBuffer(device, textureTransferBuffer);
 
 	return true;
 }
@@ -108,6 +109,6 @@ void ReleaseTexture2D(SDL_GPUDevice *device, Texture2D *texture)
 	{
 		return;
 	}
-	SDL_ReleaseGPUTexture(device, texture->texture);
+	GPUMem_ReleaseTexture(device, texture->texture);
 	SDL_DestroySurface(texture->surface);
 }
\ No newline at end of file
@@ -71,10 +71,17 @@ Matrix4x4 Matrix4x4_Scale(Matrix4x4 mat, Vector3 scale);
 Matrix4x4 Matrix4x4_Perspective(float fov, float aspectratio,
 								float near, float far);
 
+//same 0..1 depth and handedness as Matrix4x4_Perspective
+Matrix4x4 Matrix4x4_Orthographic(float left, float right, float bottom, float top,
+								float near, float far);
+
 Matrix4x4 Matrix4x4_LookAt(Vector3 camera_position,
 							Vector3 camera_target,
 							Vector3 camera_up);
 
+//general inverse, identity when the matrix is singular
+Matrix4x4 Matrix4x4_Inverse(Matrix4x4 mat);
+
 float RadToDeg(float radians);
 
 float DegToRad(float degrees);
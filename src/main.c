@@ -81,6 +81,15 @@ SDL_AppResult SDL_AppInit(void **appstate, int argc, char *argv[])
 	int width = (int)INIGetFloat(ini, "graphics", "screen_width");
 	int height = (int)INIGetFloat(ini, "graphics", "screen_heigth");
 
+	LeidenSettings settings = { 0 };
+	settings.dynamic_resolution = (INIGetFloat(ini, "graphics", "dynamic_resolution") == 0.0f) ? false : true;
+	settings.target_fps = INIGetFloat(ini, "graphics", "target_fps");
+	settings.min_render_scale = INIGetFloat(ini, "graphics", "min_render_scale");
+	settings.fifthgen_width = (int)INIGetFloat(ini, "graphics", "fifthgen_width");
+	settings.fifthgen_height = (int)INIGetFloat(ini, "graphics", "fifthgen_height");
+	settings.texture_arrays = (INIGetFloat(ini, "graphics", "texture_arrays") == 0.0f) ? false : true;
+	settings.gpu_memory_budget_mb = (int)INIGetFloat(ini, "graphics", "gpu_memory_budget_mb");
+
 	if(fullscreen)
 	{
 		window = SDL_CreateWindow("Project Leiden", width, height, SDL_WINDOW_FULLSCREEN);
@@ -117,6 +126,7 @@ SDL_AppResult SDL_AppInit(void **appstate, int argc, char *argv[])
 
 	//more stuff
 	SCR_SetContext(window, device);
+	SCR_SetSettings(&settings);
 	SCR_Setup();
 
 	return SDL_APP_CONTINUE;
@@ -0,0 +1,340 @@
+/*
+ * Copyright (C) 2025 Matheus Klein Schaefer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <SDL3/SDL.h>
+#include <SDL3_image/SDL_image.h>
+#include <capture.h>
+#include <texturepool.h>
+#include <fileio.h>
+#include <gpumem.h>
+
+//the main thread moves a slot from free to encoding, a worker claims
+//it and marks it encoded, the main thread frees it again
+typedef enum CaptureState
+{
+	CAPTURE_FREE = 0,
+	CAPTURE_RECORDED, //download in a submitted or upcoming frame
+	CAPTURE_ENCODING, //mapped, waiting for a worker
+	CAPTURE_CLAIMED, //a worker is on it
+	CAPTURE_ENCODED //the worker is done with the mapping
+} CaptureState;
+
+typedef struct CaptureSlot
+{
+	SDL_GPUTransferBuffer *buffer;
+	Uint32 capacity;
+	Uint32 width, height;
+	SDL_PixelFormat format;
+	Uint64 frame; //texture pool frame carrying the download
+	char filename[CAPTURE_MAX_PATH];
+	void *mapped;
+	SDL_AtomicInt state;
+} CaptureSlot;
+
+static SDL_GPUDevice *capture_device = NULL;
+static CaptureSlot slots[CAPTURE_SLOTS];
+static SDL_Thread *workers[CAPTURE_WORKERS];
+static int worker_count = 0;
+static SDL_Semaphore *work;
+static SDL_AtomicInt quit;
+static SDL_AtomicInt written, failed;
+static CaptureStats stats;
+
+/*******************************************************************
+ * WORKERS *********************************************************
+ ******************************************************************/
+
+//alpha is dropped, swapchains don't promise anything in it
+static bool encode(CaptureSlot *slot)
+{
+	SDL_Surface *source = SDL_CreateSurfaceFrom((int)slot->width, (int)slot->height, slot->format,
+												slot->mapped, (int)slot->width * 4);
+	SDL_Surface *rgb = (source != NULL) ? SDL_ConvertSurface(source, SDL_PIXELFORMAT_RGB24) : NULL;
+	SDL_DestroySurface(source);
+	if(rgb == NULL)
+	{
+		return false;
+	}
+	SDL_IOStream *stream = SDL_IOFromDynamicMem();
+	bool ok = stream != NULL && IMG_SavePNG_IO(rgb, stream, false);
+	if(ok)
+	{
+		void *data = SDL_GetPointerProperty(SDL_GetIOProperties(stream), SDL_PROP_IOSTREAM_DYNAMIC_MEMORY_POINTER, NULL);
+		Sint64 size = SDL_TellIO(stream);
+		ok = data != NULL && size > 0 && FileIOWrite(slot->filename, data, (size_t)size, false);
+	}
+	if(stream != NULL)
+	{
+		SDL_CloseIO(stream);
+	}
+	SDL_DestroySurface(rgb);
+	return ok;
+}
+
+//oldest frame first, so files land in the order they were taken
+static CaptureSlot *claim()
+{
+	for(;;)
+	{
+		CaptureSlot *oldest = NULL;
+		for(int i = 0; i < CAPTURE_SLOTS; i++)
+		{
+			if(SDL_GetAtomicInt(&slots[i].state) == CAPTURE_ENCODING && (oldest == NULL || slots[i].frame < oldest->frame))
+			{
+				oldest = &slots[i];
+			}
+		}
+		if(oldest == NULL)
+		{
+			return NULL;
+		}
+		//another worker may have taken it meanwhile
+		if(SDL_CompareAndSwapAtomicInt(&oldest->state, CAPTURE_ENCODING, CAPTURE_CLAIMED))
+		{
+			return oldest;
+		}
+	}
+}
+
+static int capture_worker(void *data)
+{
+	for(;;)
+	{
+		SDL_WaitSemaphore(work);
+		CaptureSlot *slot = claim();
+		if(slot == NULL)
+		{
+			if(SDL_GetAtomicInt(&quit))
+			{
+				return 0;
+			}
+			continue;
+		}
+		SDL_AddAtomicInt(encode(slot) ? &written : &failed, 1);
+		SDL_SetAtomicInt(&slot->state, CAPTURE_ENCODED);
+	}
+}
+
+bool Capture_Init(SDL_GPUDevice *device)
+{
+	if(device == NULL)
+	{
+		return false;
+	}
+	SDL_zeroa(slots);
+	stats = (CaptureStats){ 0 };
+	SDL_SetAtomicInt(&quit, 0);
+	SDL_SetAtomicInt(&written, 0);
+	SDL_SetAtomicInt(&failed, 0);
+	work = SDL_CreateSemaphore(0);
+	if(work == NULL)
+	{
+		return false;
+	}
+	worker_count = 0;
+	for(int i = 0; i < CAPTURE_WORKERS; i++)
+	{
+		workers[worker_count] = SDL_CreateThread(capture_worker, "capture", NULL);
+		if(workers[worker_count] != NULL)
+		{
+			worker_count++;
+		}
+	}
+	if(worker_count == 0)
+	{
+		SDL_DestroySemaphore(work);
+		work = NULL;
+		SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Capture: no worker threads, captures are off.");
+		return false;
+	}
+	capture_device = device;
+	return true;
+}
+
+/*******************************************************************
+ * CAPTURES ********************************************************
+ ******************************************************************/
+
+static SDL_PixelFormat pixel_format(SDL_GPUTextureFormat format)
+{
+	switch(format)
+	{
+		case SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM:
+		case SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM_SRGB:
+			return SDL_PIXELFORMAT_ABGR8888;
+		case SDL_GPU_TEXTUREFORMAT_B8G8R8A8_UNORM:
+		case SDL_GPU_TEXTUREFORMAT_B8G8R8A8_UNORM_SRGB:
+			return SDL_PIXELFORMAT_ARGB8888;
+		default:
+			return SDL_PIXELFORMAT_UNKNOWN;
+	}
+}
+
+bool Capture_Texture(SDL_GPUCommandBuffer *cmdbuf, SDL_GPUTexture *texture, Uint32 width, Uint32 height,
+						SDL_GPUTextureFormat format, const char *filename)
+{
+	if(capture_device == NULL)
+	{
+		return false;
+	}
+	stats.requested++;
+	Capture_Update();
+	SDL_PixelFormat pixels = pixel_format(format);
+	CaptureSlot *slot = NULL;
+	for(int i = 0; i < CAPTURE_SLOTS && slot == NULL; i++)
+	{
+		if(SDL_GetAtomicInt(&slots[i].state) == CAPTURE_FREE)
+		{
+			slot = &slots[i];
+		}
+	}
+	if(slot == NULL || pixels == SDL_PIXELFORMAT_UNKNOWN)
+	{
+		stats.dropped++;
+		return false;
+	}
+
+	Uint32 size = width * height * 4;
+	if(slot->capacity < size)
+	{
+		if(slot->buffer != NULL)
+		{
+			GPUMem_ReleaseTransferBuffer(capture_device, slot->buffer);
+		}
+		slot->buffer = GPUMem_CreateTransferBuffer(capture_device, &(SDL_GPUTransferBufferCreateInfo){
+			.usage = SDL_GPU_TRANSFERBUFFERUSAGE_DOWNLOAD,
+			.size = size
+		});
+		slot->capacity = (slot->buffer != NULL) ? size : 0;
+		if(slot->buffer == NULL)
+		{
+			stats.dropped++;
+			return false;
+		}
+	}
+	slot->width = width;
+	slot->height = height;
+	slot->format = pixels;
+	slot->frame = TexturePool_GetFrame();
+	SDL_strlcpy(slot->filename, filename, sizeof(slot->filename));
+
+	SDL_GPUCopyPass *copypass = SDL_BeginGPUCopyPass(cmdbuf);
+	SDL_DownloadFromGPUTexture(copypass,
+		&(SDL_GPUTextureRegion){ .texture = texture, .w = width, .h = height, .d = 1 },
+		&(SDL_GPUTextureTransferInfo){ .transfer_buffer = slot->buffer, .offset = 0 });
+	SDL_EndGPUCopyPass(copypass);
+	SDL_SetAtomicInt(&slot->state, CAPTURE_RECORDED);
+	return true;
+}
+
+static void queue_slot(CaptureSlot *slot)
+{
+	slot->mapped = SDL_MapGPUTransferBuffer(capture_device, slot->buffer, false);
+	if(slot->mapped == NULL)
+	{
+		SDL_AddAtomicInt(&failed, 1);
+		SDL_SetAtomicInt(&slot->state, CAPTURE_FREE);
+		return;
+	}
+	SDL_SetAtomicInt(&slot->state, CAPTURE_ENCODING);
+	SDL_SignalSemaphore(work);
+}
+
+static void free_slot(CaptureSlot *slot)
+{
+	SDL_UnmapGPUTransferBuffer(capture_device, slot->buffer);
+	slot->mapped = NULL;
+	SDL_SetAtomicInt(&slot->state, CAPTURE_FREE);
+}
+
+void Capture_Update()
+{
+	if(capture_device == NULL)
+	{
+		return;
+	}
+	for(int i = 0; i < CAPTURE_SLOTS; i++)
+	{
+		CaptureSlot *slot = &slots[i];
+		int state = SDL_GetAtomicInt(&slot->state);
+		if(state == CAPTURE_RECORDED && TexturePool_FrameDone(slot->frame))
+		{
+			queue_slot(slot);
+		}
+		else if(state == CAPTURE_ENCODED)
+		{
+			free_slot(slot);
+		}
+	}
+}
+
+CaptureStats Capture_GetStats()
+{
+	CaptureStats current = stats;
+	current.written = (Uint32)SDL_GetAtomicInt(&written);
+	current.failed = (Uint32)SDL_GetAtomicInt(&failed);
+	current.pending = 0;
+	for(int i = 0; i < CAPTURE_SLOTS; i++)
+	{
+		current.pending += SDL_GetAtomicInt(&slots[i].state) != CAPTURE_FREE;
+	}
+	return current;
+}
+
+void Capture_Destroy()
+{
+	if(capture_device == NULL)
+	{
+		return;
+	}
+	//everything submitted is done after this, fenced or not
+	SDL_WaitForGPUIdle(capture_device);
+	for(int i = 0; i < CAPTURE_SLOTS; i++)
+	{
+		if(SDL_GetAtomicInt(&slots[i].state) == CAPTURE_RECORDED)
+		{
+			queue_slot(&slots[i]);
+		}
+	}
+	//workers drain the queue before they see quit
+	SDL_SetAtomicInt(&quit, 1);
+	for(int i = 0; i < worker_count; i++)
+	{
+		SDL_SignalSemaphore(work);
+	}
+	for(int i = 0; i < worker_count; i++)
+	{
+		SDL_WaitThread(workers[i], NULL);
+	}
+	worker_count = 0;
+	for(int i = 0; i < CAPTURE_SLOTS; i++)
+	{
+		if(SDL_GetAtomicInt(&slots[i].state) == CAPTURE_ENCODED)
+		{
+			free_slot(&slots[i]);
+		}
+		if(slots[i].buffer != NULL)
+		{
+			GPUMem_ReleaseTransferBuffer(capture_device, slots[i].buffer);
+		}
+	}
+	SDL_DestroySemaphore(work);
+	work = NULL;
+	CaptureStats final = Capture_GetStats();
+	SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Capture: %u written, %u failed, %u dropped.",
+				final.written, final.failed, final.dropped);
+	capture_device = NULL;
+}
@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2025 Matheus Klein Schaefer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include <SDL3/SDL.h>
+
+/*******************************************************************
+ * STRUCTURES AND ENUMS ********************************************
+ ******************************************************************/
+
+//downloads in flight or being encoded, each with its own transfer
+//buffer; with all of them busy new captures are dropped, never waited on
+#define CAPTURE_SLOTS 8
+#define CAPTURE_WORKERS 2
+#define CAPTURE_MAX_PATH 128
+
+typedef struct CaptureStats
+{
+	Uint32 requested;
+	Uint32 dropped; //no free slot or unsupported format
+	Uint32 written; //by the workers
+	Uint32 failed;
+	Uint32 pending;
+} CaptureStats;
+
+/*******************************************************************
+ * FUNCTIONS *******************************************************
+ ******************************************************************/
+
+bool Capture_Init(SDL_GPUDevice *device);
+
+//records a download of the texture (swapchain or any render target)
+//into cmdbuf, after the passes that write it; once the frame's fence
+//signals, a worker thread writes it as a PNG through FileIOWrite
+//the command buffer should go through TexturePool_Submit, the fence
+//is how the capture knows the download is done
+//8 bit RGBA/BGRA textures only, returns false when dropped
+bool Capture_Texture(SDL_GPUCommandBuffer *cmdbuf, SDL_GPUTexture *texture, Uint32 width, Uint32 height,
+						SDL_GPUTextureFormat format, const char *filename);
+
+//hands finished downloads to the workers and recycles the buffers of
+//written ones, once per frame
+void Capture_Update();
+
+CaptureStats Capture_GetStats();
+
+//waits for the GPU and the workers, every capture taken is written
+void Capture_Destroy();
+
+#endif
@@ -0,0 +1,162 @@
+/*
+ * Copyright (C) 2025 Matheus Klein Schaefer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <SDL3/SDL.h>
+#include <clusters.h>
+#include <culling.h>
+#include <shader.h>
+#include <gpumem.h>
+
+//flat light so unlit sides still show the texture
+#define CLUSTERS_AMBIENT 0.25f
+
+static SDL_GPUBuffer *create_buffer(SDL_GPUDevice *device, SDL_GPUBufferUsageFlags usage, Uint32 size)
+{
+	return GPUMem_CreateBuffer(device, &(SDL_GPUBufferCreateInfo){ .usage = usage, .size = size });
+}
+
+bool Clusters_Init(SDL_GPUDevice *device, ClusteredLights *clusters)
+{
+	*clusters = (ClusteredLights){ 0 };
+	clusters->device = device;
+	clusters->bin_pipeline = ShaderLib_GetCompute("shaders/clusters/bin.comp.spv");
+	clusters->lights = create_buffer(device, SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_READ | SDL_GPU_BUFFERUSAGE_GRAPHICS_STORAGE_READ,
+										sizeof(ClusterLight) * CLUSTERS_MAX_LIGHTS);
+	clusters->counts = create_buffer(device, SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_WRITE | SDL_GPU_BUFFERUSAGE_GRAPHICS_STORAGE_READ,
+										sizeof(Uint32) * CLUSTERS_COUNT);
+	clusters->indices = create_buffer(device, SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_WRITE | SDL_GPU_BUFFERUSAGE_GRAPHICS_STORAGE_READ,
+										sizeof(Uint32) * CLUSTERS_COUNT * CLUSTERS_LIGHTS_PER_CLUSTER);
+	clusters->transfer = GPUMem_CreateTransferBuffer(device, &(SDL_GPUTransferBufferCreateInfo){
+		.usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
+		.size = sizeof(ClusterLight) * CLUSTERS_MAX_LIGHTS
+	});
+	if(clusters->bin_pipeline == NULL || clusters->lights == NULL || clusters->counts == NULL ||
+		clusters->indices == NULL || clusters->transfer == NULL)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Graphics: Error: Clustered lighting not available.");
+		Clusters_Destroy(clusters);
+		return false;
+	}
+	return true;
+}
+
+//a sphere is out when it's fully behind one plane
+static bool sphere_visible(const Frustum *frustum, Vector3 center, float radius)
+{
+	for(int i = 0; i < 6; i++)
+	{
+		Vector4 plane = frustum->planes[i];
+		if(plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w < -radius)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+bool Clusters_Update(ClusteredLights *clusters, SDL_GPUCommandBuffer *cmdbuf, const Scene *scene,
+						const Camera *camera, Uint32 viewport_w, Uint32 viewport_h)
+{
+	ClusterLight *mapped = (ClusterLight*)SDL_MapGPUTransferBuffer(clusters->device, clusters->transfer, true);
+	if(mapped == NULL)
+	{
+		return false;
+	}
+	//no point binning what's off screen
+	Frustum frustum = Culling_FrustumFromCamera(camera);
+	clusters->stats = (ClusterStats){ .lights = scene->num_lights };
+	Uint32 count = 0;
+	for(Uint32 i = 0; i < scene->num_lights; i++)
+	{
+		const SceneLight *light = &scene->lights[i];
+		if(!sphere_visible(&frustum, light->position, light->radius))
+		{
+			continue;
+		}
+		if(count == CLUSTERS_MAX_LIGHTS)
+		{
+			clusters->stats.dropped++;
+			continue;
+		}
+		mapped[count++] = (ClusterLight){
+			.position = { light->position.x, light->position.y, light->position.z },
+			.radius = light->radius,
+			.color = { light->color.x * light->intensity, light->color.y * light->intensity, light->color.z * light->intensity }
+		};
+	}
+	SDL_UnmapGPUTransferBuffer(clusters->device, clusters->transfer);
+	clusters->stats.visible = count;
+
+	clusters->params = (ClusterParams){
+		.view = camera->view,
+		.camera_position = { camera->position.x, camera->position.y, camera->position.z, 1.0f },
+		.camera_forward = { camera->front.x, camera->front.y, camera->front.z, 0.0f },
+		.projection_scale = { 1.0f / camera->projection.aa, 1.0f / camera->projection.bb },
+		.depth_range = { CLUSTERS_NEAR, CLUSTERS_FAR },
+		.viewport = { (float)viewport_w, (float)viewport_h },
+		.light_count = count,
+		.ambient = CLUSTERS_AMBIENT
+	};
+
+	if(count != 0)
+	{
+		SDL_GPUCopyPass *copypass = SDL_BeginGPUCopyPass(cmdbuf);
+		SDL_UploadToGPUBuffer(copypass, &(SDL_GPUTransferBufferLocation){ clusters->transfer, 0 },
+								&(SDL_GPUBufferRegion){ clusters->lights, 0, sizeof(ClusterLight) * count }, true);
+		SDL_EndGPUCopyPass(copypass);
+	}
+
+	//one thread per cluster, with no lights it just clears the counts
+	SDL_GPUComputePass *computepass = SDL_BeginGPUComputePass(cmdbuf, NULL, 0,
+		(SDL_GPUStorageBufferReadWriteBinding[]){
+			{ .buffer = clusters->counts, .cycle = true },
+			{ .buffer = clusters->indices, .cycle = true }
+		}, 2);
+	SDL_BindGPUComputePipeline(computepass, clusters->bin_pipeline);
+	SDL_BindGPUComputeStorageBuffers(computepass, 0, &clusters->lights, 1);
+	SDL_PushGPUComputeUniformData(cmdbuf, 0, &clusters->params, sizeof(clusters->params));
+	SDL_DispatchGPUCompute(computepass, (CLUSTERS_COUNT + CLUSTERS_GROUP - 1) / CLUSTERS_GROUP, 1, 1);
+	SDL_EndGPUComputePass(computepass);
+	return true;
+}
+
+void Clusters_Bind(ClusteredLights *clusters, SDL_GPURenderPass *renderpass, SDL_GPUCommandBuffer *cmdbuf)
+{
+	SDL_BindGPUFragmentStorageBuffers(renderpass, 0, (SDL_GPUBuffer*[]){
+										clusters->lights, clusters->counts, clusters->indices }, 3);
+	SDL_PushGPUFragmentUniformData(cmdbuf, 0, &clusters->params, sizeof(clusters->params));
+}
+
+void Clusters_Destroy(ClusteredLights *clusters)
+{
+	if(clusters->device == NULL)
+	{
+		return;
+	}
+	SDL_GPUBuffer *buffers[] = { clusters->lights, clusters->counts, clusters->indices };
+	for(size_t i = 0; i < SDL_arraysize(buffers); i++)
+	{
+		if(buffers[i] != NULL)
+		{
+			GPUMem_ReleaseBuffer(clusters->device, buffers[i]);
+		}
+	}
+	if(clusters->transfer != NULL)
+	{
+		GPUMem_ReleaseTransferBuffer(clusters->device, clusters->transfer);
+	}
+	*clusters = (ClusteredLights){ 0 };
+}
@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2025 Matheus Klein Schaefer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef CLUSTERS_H
+#define CLUSTERS_H
+
+#include <SDL3/SDL.h>
+#include <linmath.h>
+#include <assets.h>
+#include <scene.h>
+
+/*******************************************************************
+ * STRUCTURES AND ENUMS ********************************************
+ ******************************************************************/
+
+//view space grid: screen tiles by exponential depth slices
+//must match clusters/clusters.glsl
+#define CLUSTERS_X 16
+#define CLUSTERS_Y 9
+#define CLUSTERS_Z 24
+#define CLUSTERS_COUNT (CLUSTERS_X * CLUSTERS_Y * CLUSTERS_Z)
+#define CLUSTERS_LIGHTS_PER_CLUSTER 128
+#define CLUSTERS_GROUP 64
+//the first slice covers everything up to CLUSTERS_NEAR, the last one
+//everything past CLUSTERS_FAR
+#define CLUSTERS_NEAR 1.0f
+#define CLUSTERS_FAR 5000.0f
+//lights in view after the CPU frustum test, the rest are dropped
+#define CLUSTERS_MAX_LIGHTS 1024
+
+//same layout as Light in clusters.glsl (std430)
+typedef struct ClusterLight
+{
+	float position[3]; //world space
+	float radius;
+	float color[3]; //premultiplied by the intensity
+	float padding;
+} ClusterLight;
+
+//same layout as ClusterParams in clusters.glsl (std140), pushed to the
+//binning pass and to every lit fragment shader
+typedef struct ClusterParams
+{
+	Matrix4x4 view;
+	Vector4 camera_position;
+	Vector4 camera_forward;
+	float projection_scale[2]; //1 / projection diagonal, tile edges in view space
+	float depth_range[2]; //CLUSTERS_NEAR, CLUSTERS_FAR
+	float viewport[2];
+	Uint32 light_count;
+	float ambient;
+} ClusterParams;
+
+typedef struct ClusterStats
+{
+	Uint32 lights; //in the scene
+	Uint32 visible; //sent to the GPU
+	Uint32 dropped; //over CLUSTERS_MAX_LIGHTS
+} ClusterStats;
+
+//clustered forward lighting: every frame the lights touching the view
+//are uploaded and a compute pass lists, per cluster, the ones reaching
+//it; lit fragment shaders find their cluster from the screen position
+//and depth and only loop over that list, so the cost per pixel follows
+//the local light count instead of the total
+typedef struct ClusteredLights
+{
+	SDL_GPUDevice *device;
+	SDL_GPUComputePipeline *bin_pipeline;
+	SDL_GPUBuffer *lights;
+	SDL_GPUBuffer *counts; //one per cluster
+	SDL_GPUBuffer *indices; //CLUSTERS_LIGHTS_PER_CLUSTER per cluster
+	SDL_GPUTransferBuffer *transfer;
+	ClusterParams params;
+	ClusterStats stats;
+} ClusteredLights;
+
+/*******************************************************************
+ * FUNCTIONS *******************************************************
+ ******************************************************************/
+
+bool Clusters_Init(SDL_GPUDevice *device, ClusteredLights *clusters);
+
+//uploads the scene's lights and records the binning pass, before the
+//render passes that shade with them; outside the render graph since
+//it only writes buffers
+bool Clusters_Update(ClusteredLights *clusters, SDL_GPUCommandBuffer *cmdbuf, const Scene *scene,
+						const Camera *camera, Uint32 viewport_w, Uint32 viewport_h);
+
+//fragment storage buffer slots 0-2 (SDL counts those apart from the
+//samplers) and fragment uniform slot 0
+void Clusters_Bind(ClusteredLights *clusters, SDL_GPURenderPass *renderpass, SDL_GPUCommandBuffer *cmdbuf);
+
+void Clusters_Destroy(ClusteredLights *clusters);
+
+#endif
@@ -0,0 +1,549 @@
+/*
+ * Copyright (C) 2025 Matheus Klein Schaefer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <SDL3/SDL.h>
+#include <SDL3/SDL_intrin.h>
+#include <culling.h>
+
+//all SoA arrays are allocated with this alignment (fits AVX)
+#define CULLING_ALIGNMENT 32
+
+typedef enum CullingPath
+{
+	CULLINGPATH_UNKNOWN = 0,
+	CULLINGPATH_SCALAR,
+	CULLINGPATH_SSE,
+	CULLINGPATH_AVX,
+	CULLINGPATH_NEON
+} CullingPath;
+
+//planes split into components, plus the absolute value of the
+//normals, which is what the box extents get projected on
+typedef struct CullingPlanes
+{
+	float nx[6], ny[6], nz[6], d[6];
+	float ax[6], ay[6], az[6];
+} CullingPlanes;
+
+static CullingPath culling_path = CULLINGPATH_UNKNOWN;
+
+/*******************************************************************
+ * FRUSTUM *********************************************************
+ ******************************************************************/
+
+static Vector4 normalize_plane(Vector4 plane)
+{
+	float length = SDL_sqrtf(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z);
+	if(length <= 0.0f)
+	{
+		return plane;
+	}
+	plane.x /= length;
+	plane.y /= length;
+	plane.z /= length;
+	plane.w /= length;
+	return plane;
+}
+
+Frustum Culling_ExtractFrustum(Matrix4x4 viewproj)
+{
+	//clip = v * viewproj, so each clip component is a column
+	Vector4 col0 = { viewproj.aa, viewproj.ba, viewproj.ca, viewproj.da };
+	Vector4 col1 = { viewproj.ab, viewproj.bb, viewproj.cb, viewproj.db };
+	Vector4 col2 = { viewproj.ac, viewproj.bc, viewproj.cc, viewproj.dc };
+	Vector4 col3 = { viewproj.ad, viewproj.bd, viewproj.cd, viewproj.dd };
+
+	Frustum frustum;
+	frustum.planes[0] = (Vector4){ col3.x + col0.x, col3.y + col0.y, col3.z + col0.z, col3.w + col0.w };
+	frustum.planes[1] = (Vector4){ col3.x - col0.x, col3.y - col0.y, col3.z - col0.z, col3.w - col0.w };
+	frustum.planes[2] = (Vector4){ col3.x + col1.x, col3.y + col1.y, col3.z + col1.z, col3.w + col1.w };
+	frustum.planes[3] = (Vector4){ col3.x - col1.x, col3.y - col1.y, col3.z - col1.z, col3.w - col1.w };
+	//depth goes from 0 to 1 (see Matrix4x4_Perspective)
+	frustum.planes[4] = col2;
+	frustum.planes[5] = (Vector4){ col3.x - col2.x, col3.y - col2.y, col3.z - col2.z, col3.w - col2.w };
+
+	for(int i = 0; i < 6; i++)
+	{
+		frustum.planes[i] = normalize_plane(frustum.planes[i]);
+	}
+	return frustum;
+}
+
+Frustum Culling_FrustumFromCamera(const Camera *camera)
+{
+	return Culling_ExtractFrustum(Matrix4x4_Mul(camera->view, camera->projection));
+}
+
+AABB Culling_TransformAABB(AABB box, Matrix4x4 transform)
+{
+	AABB result;
+	Vector3 c = box.center;
+	Vector3 e = box.half_size;
+	result.center.x = c.x * transform.aa + c.y * transform.ba + c.z * transform.ca + transform.da;
+	result.center.y = c.x * transform.ab + c.y * transform.bb + c.z * transform.cb + transform.db;
+	result.center.z = c.x * transform.ac + c.y * transform.bc + c.z * transform.cc + transform.dc;
+	result.half_size.x = e.x * SDL_fabsf(transform.aa) + e.y * SDL_fabsf(transform.ba) + e.z * SDL_fabsf(transform.ca);
+	result.half_size.y = e.x * SDL_fabsf(transform.ab) + e.y * SDL_fabsf(transform.bb) + e.z * SDL_fabsf(transform.cb);
+	result.half_size.z = e.x * SDL_fabsf(transform.ac) + e.y * SDL_fabsf(transform.bc) + e.z * SDL_fabsf(transform.cc);
+	return result;
+}
+
+static void prepare_planes(const Frustum *frustum, CullingPlanes *planes)
+{
+	for(int i = 0; i < 6; i++)
+	{
+		planes->nx[i] = frustum->planes[i].x;
+		planes->ny[i] = frustum->planes[i].y;
+		planes->nz[i] = frustum->planes[i].z;
+		planes->d[i] = frustum->planes[i].w;
+		planes->ax[i] = SDL_fabsf(frustum->planes[i].x);
+		planes->ay[i] = SDL_fabsf(frustum->planes[i].y);
+		planes->az[i] = SDL_fabsf(frustum->planes[i].z);
+	}
+}
+
+/*******************************************************************
+ * BOUNDS **********************************************************
+ ******************************************************************/
+
+static float *bounds_realloc(float *old, size_t count, size_t new_capacity)
+{
+	float *aux = (float*)SDL_aligned_alloc(CULLING_ALIGNMENT, sizeof(float) * new_capacity);
+	if(aux == NULL)
+	{
+		return NULL;
+	}
+	if(old != NULL)
+	{
+		SDL_memcpy(aux, old, sizeof(float) * count);
+		SDL_aligned_free(old);
+	}
+	return aux;
+}
+
+static bool bounds_grow(CullingBounds *bounds, size_t new_capacity)
+{
+	//keep the capacity a multiple of 8, one AVX register
+	new_capacity = (new_capacity + 7) & ~((size_t)7);
+	float **arrays[6] = {
+		&bounds->center_x, &bounds->center_y, &bounds->center_z,
+		&bounds->extent_x, &bounds->extent_y, &bounds->extent_z
+	};
+	for(int i = 0; i < 6; i++)
+	{
+		float *aux = bounds_realloc(*arrays[i], bounds->count, new_capacity);
+		if(aux == NULL)
+		{
+			SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Culling: cannot grow bounds, memory error.");
+			return false;
+		}
+		*arrays[i] = aux;
+	}
+	bounds->capacity = new_capacity;
+	return true;
+}
+
+bool Culling_InitBounds(CullingBounds *bounds, size_t capacity)
+{
+	if(bounds == NULL)
+	{
+		return false;
+	}
+	*bounds = (CullingBounds){ 0 };
+	if(capacity == 0)
+	{
+		capacity = 8;
+	}
+	return bounds_grow(bounds, capacity);
+}
+
+int Culling_AddBounds(CullingBounds *bounds, AABB box)
+{
+	if(bounds == NULL)
+	{
+		return -1;
+	}
+	if(bounds->count == bounds->capacity)
+	{
+		if(!bounds_grow(bounds, bounds->capacity * 2))
+		{
+			return -1;
+		}
+	}
+	size_t index = bounds->count++;
+	Culling_SetBounds(bounds, index, box);
+	return (int)index;
+}
+
+void Culling_SetBounds(CullingBounds *bounds, size_t index, AABB box)
+{
+	if(bounds == NULL || index >= bounds->count)
+	{
+		return;
+	}
+	bounds->center_x[index] = box.center.x;
+	bounds->center_y[index] = box.center.y;
+	bounds->center_z[index] = box.center.z;
+	bounds->extent_x[index] = box.half_size.x;
+	bounds->extent_y[index] = box.half_size.y;
+	bounds->extent_z[index] = box.half_size.z;
+}
+
+void Culling_ResetBounds(CullingBounds *bounds)
+{
+	if(bounds != NULL)
+	{
+		bounds->count = 0;
+	}
+}
+
+void Culling_DestroyBounds(CullingBounds *bounds)
+{
+	if(bounds == NULL)
+	{
+		return;
+	}
+	SDL_aligned_free(bounds->center_x);
+	SDL_aligned_free(bounds->center_y);
+	SDL_aligned_free(bounds->center_z);
+	SDL_aligned_free(bounds->extent_x);
+	SDL_aligned_free(bounds->extent_y);
+	SDL_aligned_free(bounds->extent_z);
+	*bounds = (CullingBounds){ 0 };
+}
+
+/*******************************************************************
+ * CULLING PATHS ***************************************************
+ ******************************************************************/
+
+//scalar, also used for the tail of the SIMD loops
+static size_t cull_scalar(const CullingBounds *bounds, const CullingPlanes *planes,
+							size_t first, Uint32 *visible, size_t written)
+{
+	for(size_t i = first; i < bounds->count; i++)
+	{
+		bool inside = true;
+		for(int p = 0; p < 6; p++)
+		{
+			float dist = bounds->center_x[i] * planes->nx[p] +
+							bounds->center_y[i] * planes->ny[p] +
+							bounds->center_z[i] * planes->nz[p] + planes->d[p];
+			float radius = bounds->extent_x[i] * planes->ax[p] +
+							bounds->extent_y[i] * planes->ay[p] +
+							bounds->extent_z[i] * planes->az[p];
+			if(dist + radius < 0.0f)
+			{
+				inside = false;
+				break;
+			}
+		}
+		//branchless append, the slot is overwritten if culled
+		visible[written] = (Uint32)i;
+		written += inside ? 1 : 0;
+	}
+	return written;
+}
+
+#ifdef SDL_SSE_INTRINSICS
+static size_t cull_sse(const CullingBounds *bounds, const CullingPlanes *planes, Uint32 *visible)
+{
+	__m128 nx[6], ny[6], nz[6], d[6], ax[6], ay[6], az[6];
+	for(int p = 0; p < 6; p++)
+	{
+		nx[p] = _mm_set1_ps(planes->nx[p]);
+		ny[p] = _mm_set1_ps(planes->ny[p]);
+		nz[p] = _mm_set1_ps(planes->nz[p]);
+		d[p] = _mm_set1_ps(planes->d[p]);
+		ax[p] = _mm_set1_ps(planes->ax[p]);
+		ay[p] = _mm_set1_ps(planes->ay[p]);
+		az[p] = _mm_set1_ps(planes->az[p]);
+	}
+	const __m128 zero = _mm_setzero_ps();
+
+	size_t written = 0;
+	size_t i = 0;
+	for(; i + 4 <= bounds->count; i += 4)
+	{
+		__m128 cx = _mm_load_ps(&bounds->center_x[i]);
+		__m128 cy = _mm_load_ps(&bounds->center_y[i]);
+		__m128 cz = _mm_load_ps(&bounds->center_z[i]);
+		__m128 ex = _mm_load_ps(&bounds->extent_x[i]);
+		__m128 ey = _mm_load_ps(&bounds->extent_y[i]);
+		__m128 ez = _mm_load_ps(&bounds->extent_z[i]);
+		__m128 outside = zero;
+		for(int p = 0; p < 6; p++)
+		{
+			__m128 dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(cx, nx[p]), _mm_mul_ps(cy, ny[p])),
+										_mm_add_ps(_mm_mul_ps(cz, nz[p]), d[p]));
+			__m128 radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ex, ax[p]), _mm_mul_ps(ey, ay[p])),
+										_mm_mul_ps(ez, az[p]));
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(dist, radius), zero));
+		}
+		int mask = ~_mm_movemask_ps(outside);
+		for(int k = 0; k < 4; k++)
+		{
+			visible[written] = (Uint32)(i + k);
+			written += (mask >> k) & 1;
+		}
+	}
+	return cull_scalar(bounds, planes, i, visible, written);
+}
+#endif
+
+#ifdef SDL_AVX_INTRINSICS
+SDL_TARGETING("avx") static size_t cull_avx(const CullingBounds *bounds, const CullingPlanes *planes, Uint32 *visible)
+{
+	__m256 nx[6], ny[6], nz[6], d[6], ax[6], ay[6], az[6];
+	for(int p = 0; p < 6; p++)
+	{
+		nx[p] = _mm256_set1_ps(planes->nx[p]);
+		ny[p] = _mm256_set1_ps(planes->ny[p]);
+		nz[p] = _mm256_set1_ps(planes->nz[p]);
+		d[p] = _mm256_set1_ps(planes->d[p]);
+		ax[p] = _mm256_set1_ps(planes->ax[p]);
+		ay[p] = _mm256_set1_ps(planes->ay[p]);
+		az[p] = _mm256_set1_ps(planes->az[p]);
+	}
+	const __m256 zero = _mm256_setzero_ps();
+
+	size_t written = 0;
+	size_t i = 0;
+	for(; i + 8 <= bounds->count; i += 8)
+	{
+		__m256 cx = _mm256_load_ps(&bounds->center_x[i]);
+		__m256 cy = _mm256_load_ps(&bounds->center_y[i]);
+		__m256 cz = _mm256_load_ps(&bounds->center_z[i]);
+		__m256 ex = _mm256_load_ps(&bounds->extent_x[i]);
+		__m256 ey = _mm256_load_ps(&bounds->extent_y[i]);
+		__m256 ez = _mm256_load_ps(&bounds->extent_z[i]);
+		__m256 outside = zero;
+		for(int p = 0; p < 6; p++)
+		{
+			__m256 dist = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(cx, nx[p]), _mm256_mul_ps(cy, ny[p])),
+										_mm256_add_ps(_mm256_mul_ps(cz, nz[p]), d[p]));
+			__m256 radius = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ex, ax[p]), _mm256_mul_ps(ey, ay[p])),
+										_mm256_mul_ps(ez, az[p]));
+			outside = _mm256_or_ps(outside, _mm256_cmp_ps(_mm256_add_ps(dist, radius), zero, _CMP_LT_OQ));
+		}
+		int mask = ~_mm256_movemask_ps(outside);
+		for(int k = 0; k < 8; k++)
+		{
+			visible[written] = (Uint32)(i + k);
+			written += (mask >> k) & 1;
+		}
+	}
+	return cull_scalar(bounds, planes, i, visible, written);
+}
+#endif
+
+#ifdef SDL_NEON_INTRINSICS
+static size_t cull_neon(const CullingBounds *bounds, const CullingPlanes *planes, Uint32 *visible)
+{
+	const float32x4_t zero = vdupq_n_f32(0.0f);
+
+	size_t written = 0;
+	size_t i = 0;
+	for(; i + 4 <= bounds->count; i += 4)
+	{
+		float32x4_t cx = vld1q_f32(&bounds->center_x[i]);
+		float32x4_t cy = vld1q_f32(&bounds->center_y[i]);
+		float32x4_t cz = vld1q_f32(&bounds->center_z[i]);
+		float32x4_t ex = vld1q_f32(&bounds->extent_x[i]);
+		float32x4_t ey = vld1q_f32(&bounds->extent_y[i]);
+		float32x4_t ez = vld1q_f32(&bounds->extent_z[i]);
+		uint32x4_t outside = vdupq_n_u32(0);
+		for(int p = 0; p < 6; p++)
+		{
+			float32x4_t dist = vdupq_n_f32(planes->d[p]);
+			dist = vmlaq_n_f32(dist, cx, planes->nx[p]);
+			dist = vmlaq_n_f32(dist, cy, planes->ny[p]);
+			dist = vmlaq_n_f32(dist, cz, planes->nz[p]);
+			dist = vmlaq_n_f32(dist, ex, planes->ax[p]);
+			dist = vmlaq_n_f32(dist, ey, planes->ay[p]);
+			dist = vmlaq_n_f32(dist, ez, planes->az[p]);
+			outside = vorrq_u32(outside, vcltq_f32(dist, zero));
+		}
+		Uint32 lanes[4];
+		vst1q_u32(lanes, outside);
+		for(int k = 0; k < 4; k++)
+		{
+			visible[written] = (Uint32)(i + k);
+			written += lanes[k] ? 0 : 1;
+		}
+	}
+	return cull_scalar(bounds, planes, i, visible, written);
+}
+#endif
+
+static size_t cull_with_path(CullingPath path, const CullingBounds *bounds,
+								const CullingPlanes *planes, Uint32 *visible)
+{
+	switch(path)
+	{
+#ifdef SDL_AVX_INTRINSICS
+		case CULLINGPATH_AVX: return cull_avx(bounds, planes, visible);
+#endif
+#ifdef SDL_SSE_INTRINSICS
+		case CULLINGPATH_SSE: return cull_sse(bounds, planes, visible);
+#endif
+#ifdef SDL_NEON_INTRINSICS
+		case CULLINGPATH_NEON: return cull_neon(bounds, planes, visible);
+#endif
+		default: return cull_scalar(bounds, planes, 0, visible, 0);
+	}
+}
+
+static bool path_available(CullingPath path)
+{
+	switch(path)
+	{
+#ifdef SDL_AVX_INTRINSICS
+		case CULLINGPATH_AVX: return SDL_HasAVX();
+#endif
+#ifdef SDL_SSE_INTRINSICS
+		case CULLINGPATH_SSE: return SDL_HasSSE();
+#endif
+#ifdef SDL_NEON_INTRINSICS
+		case CULLINGPATH_NEON: return SDL_HasNEON();
+#endif
+		case CULLINGPATH_SCALAR: return true;
+		default: return false;
+	}
+}
+
+static const char *path_name(CullingPath path)
+{
+	switch(path)
+	{
+		case CULLINGPATH_SCALAR: return "scalar";
+		case CULLINGPATH_SSE: return "SSE";
+		case CULLINGPATH_AVX: return "AVX";
+		case CULLINGPATH_NEON: return "NEON";
+		default: return "unknown";
+	}
+}
+
+static CullingPath select_path()
+{
+	if(culling_path == CULLINGPATH_UNKNOWN)
+	{
+		const CullingPath preferred[] = { CULLINGPATH_AVX, CULLINGPATH_SSE, CULLINGPATH_NEON };
+		culling_path = CULLINGPATH_SCALAR;
+		for(size_t i = 0; i < SDL_arraysize(preferred); i++)
+		{
+			if(path_available(preferred[i]))
+			{
+				culling_path = preferred[i];
+				break;
+			}
+		}
+		SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Culling: using %s path.", path_name(culling_path));
+	}
+	return culling_path;
+}
+
+size_t Culling_CullFrustum(const CullingBounds *bounds,
+							const Frustum *frustum,
+							Uint32 *visible)
+{
+	if(bounds == NULL || frustum == NULL || visible == NULL || bounds->count == 0)
+	{
+		return 0;
+	}
+	CullingPlanes planes;
+	prepare_planes(frustum, &planes);
+	return cull_with_path(select_path(), bounds, &planes, visible);
+}
+
+const char *Culling_GetPathName()
+{
+	return path_name(select_path());
+}
+
+/*******************************************************************
+ * BENCHMARK *******************************************************
+ ******************************************************************/
+
+void Culling_Benchmark(Uint32 count)
+{
+	const int iterations = 20;
+
+	CullingBounds bounds;
+	if(!Culling_InitBounds(&bounds, count))
+	{
+		return;
+	}
+	Uint32 *visible = (Uint32*)SDL_malloc(sizeof(Uint32) * count);
+	if(visible == NULL)
+	{
+		Culling_DestroyBounds(&bounds);
+		return;
+	}
+
+	//boxes scattered all around the camera, only a few percent end up visible
+	for(Uint32 i = 0; i < count; i++)
+	{
+		AABB box;
+		box.center = (Vector3){ (SDL_randf() - 0.5f) * 1000.0f,
+								(SDL_randf() - 0.5f) * 1000.0f,
+								(SDL_randf() - 0.5f) * 1000.0f };
+		box.half_size = (Vector3){ 0.5f + SDL_randf() * 4.5f,
+									0.5f + SDL_randf() * 4.5f,
+									0.5f + SDL_randf() * 4.5f };
+		Culling_AddBounds(&bounds, box);
+	}
+
+	Camera camera;
+	InitCameraBasic(&camera, (Vector3){ 0.0f, 0.0f, 0.0f }, 16.0f / 9.0f);
+	Frustum frustum = Culling_FrustumFromCamera(&camera);
+	CullingPlanes planes;
+	prepare_planes(&frustum, &planes);
+
+	SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Culling: benchmark with %u boxes, %d iterations.", count, iterations);
+
+	size_t reference = 0;
+	const CullingPath paths[] = { CULLINGPATH_SCALAR, CULLINGPATH_SSE, CULLINGPATH_AVX, CULLINGPATH_NEON };
+	for(size_t p = 0; p < SDL_arraysize(paths); p++)
+	{
+		if(!path_available(paths[p]))
+		{
+			continue;
+		}
+		size_t visible_count = 0;
+		Uint64 start = SDL_GetPerformanceCounter();
+		for(int i = 0; i < iterations; i++)
+		{
+			visible_count = cull_with_path(paths[p], &bounds, &planes, visible);
+		}
+		Uint64 end = SDL_GetPerformanceCounter();
+		double ms = (double)(end - start) * 1000.0 / (double)SDL_GetPerformanceFrequency() / iterations;
+
+		if(paths[p] == CULLINGPATH_SCALAR)
+		{
+			reference = visible_count;
+		}
+		else if(visible_count != reference)
+		{
+			SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Culling: %s path disagrees with scalar (%zu vs %zu).",
+						path_name(paths[p]), visible_count, reference);
+		}
+		SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Culling: %-6s %8.3f ms, %zu visible, %zu culled.",
+					path_name(paths[p]), ms, visible_count, (size_t)count - visible_count);
+	}
+
+	SDL_free(visible);
+	Culling_DestroyBounds(&bounds);
+}
@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2025 Matheus Klein Schaefer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef CULLING_H
+#define CULLING_H
+
+#include <SDL3/SDL.h>
+#include <linmath.h>
+#include <physics.h>
+#include <assets.h>
+
+/*******************************************************************
+ * STRUCTURES AND ENUMS ********************************************
+ ******************************************************************/
+
+//planes are (normal.xyz, distance), pointing inside the frustum
+//order: left, right, bottom, top, near, far
+typedef struct Frustum
+{
+	Vector4 planes[6];
+} Frustum;
+
+//bounding boxes stored as structure of arrays, so the SIMD paths can
+//load 4 or 8 boxes with a single instruction per component
+typedef struct CullingBounds
+{
+	size_t count;
+	size_t capacity;
+	float *center_x;
+	float *center_y;
+	float *center_z;
+	float *extent_x;
+	float *extent_y;
+	float *extent_z;
+} CullingBounds;
+
+/*******************************************************************
+ * FUNCTIONS *******************************************************
+ ******************************************************************/
+
+/* FRUSTUM */
+
+//works with the row-vector convention used everywhere in linmath
+//(model * view * projection) and 0..1 clip depth
+Frustum Culling_ExtractFrustum(Matrix4x4 viewproj);
+
+Frustum Culling_FrustumFromCamera(const Camera *camera);
+
+//world space box from a local box, conservative for rotations
+AABB Culling_TransformAABB(AABB box, Matrix4x4 transform);
+
+/* BOUNDS */
+
+bool Culling_InitBounds(CullingBounds *bounds, size_t capacity);
+
+//returns the index of the new box, or -1 if out of memory
+int Culling_AddBounds(CullingBounds *bounds, AABB box);
+
+void Culling_SetBounds(CullingBounds *bounds, size_t index, AABB box);
+
+//keeps the memory, only drops the boxes
+void Culling_ResetBounds(CullingBounds *bounds);
+
+void Culling_DestroyBounds(CullingBounds *bounds);
+
+/* CULLING */
+
+//writes the indices of every box touching the frustum in visible
+//(must hold bounds->count entries) and returns how many were written
+//picks AVX, SSE, NEON or scalar code at runtime
+size_t Culling_CullFrustum(const CullingBounds *bounds,
+							const Frustum *frustum,
+							Uint32 *visible);
+
+//name of the path Culling_CullFrustum is using, for logs
+const char *Culling_GetPathName();
+
+//culls count random boxes with every available path and logs timings
+void Culling_Benchmark(Uint32 count);
+
+#endif
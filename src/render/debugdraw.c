@@ -0,0 +1,354 @@
+/*
+ * Copyright (C) 2025 Matheus Klein Schaefer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <SDL3/SDL.h>
+#include <debugdraw.h>
+
+#ifdef LEIDEN_DEBUG_DRAW
+
+#include <pipelinecache.h>
+#include <gpumem.h>
+
+//first allocation, grows by doubling up to DEBUGDRAW_MAX_VERTICES
+#define DEBUGDRAW_INITIAL_VERTICES 4096
+
+static SDL_GPUDevice *debug_device = NULL;
+static DebugVertex *vertices = NULL;
+static Uint32 vertex_count = 0;
+static Uint32 vertex_capacity = 0;
+static SDL_GPUBuffer *vertex_buffer = NULL;
+static SDL_GPUTransferBuffer *transfer = NULL;
+static Uint32 gpu_capacity = 0;
+//what DebugDraw_Render draws this frame
+static Uint32 uploaded = 0;
+//the last pipeline asked for, so the cache isn't hit every frame
+static SDL_GPUGraphicsPipeline *pipeline = NULL;
+static SDL_GPUTextureFormat pipeline_color = SDL_GPU_TEXTUREFORMAT_INVALID;
+static SDL_GPUTextureFormat pipeline_depth = SDL_GPU_TEXTUREFORMAT_INVALID;
+static DebugDrawStats stats;
+
+bool DebugDraw_Init(SDL_GPUDevice *device)
+{
+	if(device == NULL)
+	{
+		return false;
+	}
+	debug_device = device;
+	vertex_count = uploaded = 0;
+	pipeline = NULL;
+	stats = (DebugDrawStats){ 0 };
+	return true;
+}
+
+/*******************************************************************
+ * SHAPES **********************************************************
+ ******************************************************************/
+
+static bool reserve_vertices(Uint32 count)
+{
+	if(vertex_count + count <= vertex_capacity)
+	{
+		return true;
+	}
+	if(vertex_count + count > DEBUGDRAW_MAX_VERTICES)
+	{
+		return false;
+	}
+	Uint32 new_capacity = (vertex_capacity == 0) ? DEBUGDRAW_INITIAL_VERTICES : vertex_capacity * 2;
+	while(new_capacity < vertex_count + count)
+	{
+		new_capacity *= 2;
+	}
+	new_capacity = SDL_min(new_capacity, DEBUGDRAW_MAX_VERTICES);
+	DebugVertex *aux = (DebugVertex*)SDL_realloc(vertices, sizeof(DebugVertex) * new_capacity);
+	if(aux == NULL)
+	{
+		return false;
+	}
+	vertices = aux;
+	vertex_capacity = new_capacity;
+	return true;
+}
+
+void DebugDraw_Line(Vector3 a, Vector3 b, Uint32 color)
+{
+	//nothing draws them without a device, don't let them pile up
+	if(debug_device == NULL)
+	{
+		return;
+	}
+	if(!reserve_vertices(2))
+	{
+		stats.dropped++;
+		return;
+	}
+	vertices[vertex_count++] = (DebugVertex){ a, color };
+	vertices[vertex_count++] = (DebugVertex){ b, color };
+}
+
+//corners are numbered by bits: 1 is +x, 2 is +y, 4 is +z, so every
+//edge joins two corners one bit apart
+static void corner_edges(const Vector3 corners[8], Uint32 color)
+{
+	for(Uint32 i = 0; i < 8; i++)
+	{
+		for(Uint32 bit = 1; bit < 8; bit <<= 1)
+		{
+			if((i & bit) == 0)
+			{
+				DebugDraw_Line(corners[i], corners[i | bit], color);
+			}
+		}
+	}
+}
+
+static void box_corners(AABB box, Vector3 corners[8])
+{
+	for(Uint32 i = 0; i < 8; i++)
+	{
+		corners[i] = (Vector3){
+			box.center.x + ((i & 1) ? box.half_size.x : -box.half_size.x),
+			box.center.y + ((i & 2) ? box.half_size.y : -box.half_size.y),
+			box.center.z + ((i & 4) ? box.half_size.z : -box.half_size.z)
+		};
+	}
+}
+
+void DebugDraw_AABB(AABB box, Uint32 color)
+{
+	Vector3 corners[8];
+	box_corners(box, corners);
+	corner_edges(corners, color);
+}
+
+void DebugDraw_Box(AABB box, Matrix4x4 transform, Uint32 color)
+{
+	Vector3 corners[8];
+	box_corners(box, corners);
+	for(Uint32 i = 0; i < 8; i++)
+	{
+		Vector3 p = corners[i];
+		corners[i] = (Vector3){
+			p.x * transform.aa + p.y * transform.ba + p.z * transform.ca + transform.da,
+			p.x * transform.ab + p.y * transform.bb + p.z * transform.cb + transform.db,
+			p.x * transform.ac + p.y * transform.bc + p.z * transform.cc + transform.dc
+		};
+	}
+	corner_edges(corners, color);
+}
+
+void DebugDraw_Sphere(Vector3 center, float radius, Uint32 color)
+{
+	Vector3 previous[3];
+	for(Uint32 s = 0; s <= DEBUGDRAW_SPHERE_SEGMENTS; s++)
+	{
+		float angle = (2.0f * SDL_PI_F * (float)s) / (float)DEBUGDRAW_SPHERE_SEGMENTS;
+		float c = SDL_cosf(angle) * radius;
+		float n = SDL_sinf(angle) * radius;
+		Vector3 points[3] = {
+			{ center.x + c, center.y + n, center.z },
+			{ center.x + c, center.y, center.z + n },
+			{ center.x, center.y + c, center.z + n }
+		};
+		for(Uint32 i = 0; s > 0 && i < 3; i++)
+		{
+			DebugDraw_Line(previous[i], points[i], color);
+		}
+		SDL_memcpy(previous, points, sizeof(points));
+	}
+}
+
+//the point on all three planes, planes are (normal, distance) with
+//dot(normal, p) + distance = 0 on them
+static Vector3 plane_corner(Vector4 a, Vector4 b, Vector4 c)
+{
+	Vector3 na = { a.x, a.y, a.z };
+	Vector3 nb = { b.x, b.y, b.z };
+	Vector3 nc = { c.x, c.y, c.z };
+	Vector3 bc = Vector3_Cross(nb, nc);
+	float det = Vector3_Dot(na, bc);
+	if(SDL_fabsf(det) < 1e-6f)
+	{
+		return (Vector3){ 0.0f, 0.0f, 0.0f };
+	}
+	Vector3 sum = Vector3_Add(Vector3_Scale(bc, -a.w),
+								Vector3_Add(Vector3_Scale(Vector3_Cross(nc, na), -b.w),
+											Vector3_Scale(Vector3_Cross(na, nb), -c.w)));
+	return Vector3_Scale(sum, 1.0f / det);
+}
+
+void DebugDraw_Frustum(const Frustum *frustum, Uint32 color)
+{
+	//plane order is left, right, bottom, top, near, far, so bit 1 picks
+	//right over left, 2 top over bottom and 4 far over near
+	Vector3 corners[8];
+	for(Uint32 i = 0; i < 8; i++)
+	{
+		corners[i] = plane_corner(frustum->planes[(i & 1) ? 1 : 0],
+									frustum->planes[(i & 2) ? 3 : 2],
+									frustum->planes[(i & 4) ? 5 : 4]);
+	}
+	corner_edges(corners, color);
+}
+
+void DebugDraw_Polygon(const Vector3 *points, Uint32 count, Uint32 color)
+{
+	for(Uint32 i = 0; count > 1 && i < count; i++)
+	{
+		DebugDraw_Line(points[i], points[(i + 1) % count], color);
+	}
+}
+
+/*******************************************************************
+ * DRAWING *********************************************************
+ ******************************************************************/
+
+static void release_gpu_buffers()
+{
+	if(vertex_buffer != NULL)
+	{
+		GPUMem_ReleaseBuffer(debug_device, vertex_buffer);
+		vertex_buffer = NULL;
+	}
+	if(transfer != NULL)
+	{
+		GPUMem_ReleaseTransferBuffer(debug_device, transfer);
+		transfer = NULL;
+	}
+	gpu_capacity = 0;
+}
+
+static bool create_gpu_buffers()
+{
+	Uint32 size = sizeof(DebugVertex) * vertex_capacity;
+	vertex_buffer = GPUMem_CreateBuffer(debug_device, &(SDL_GPUBufferCreateInfo){
+		.usage = SDL_GPU_BUFFERUSAGE_VERTEX,
+		.size = size
+	});
+	transfer = GPUMem_CreateTransferBuffer(debug_device, &(SDL_GPUTransferBufferCreateInfo){
+		.usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
+		.size = size
+	});
+	if(vertex_buffer == NULL || transfer == NULL)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Graphics: Error: Failed to create debug draw buffers: %s", SDL_GetError());
+		release_gpu_buffers();
+		return false;
+	}
+	gpu_capacity = vertex_capacity;
+	return true;
+}
+
+void DebugDraw_Upload(SDL_GPUCommandBuffer *cmdbuf)
+{
+	uploaded = 0;
+	stats.lines = 0;
+	if(debug_device == NULL || vertex_count == 0)
+	{
+		return;
+	}
+	Uint32 count = vertex_count;
+	vertex_count = 0;
+
+	//the vertex array grew since the buffers were made
+	if(gpu_capacity < vertex_capacity)
+	{
+		release_gpu_buffers();
+		if(!create_gpu_buffers())
+		{
+			return;
+		}
+	}
+
+	//both cycle, last frame's lines may still be drawing
+	Uint32 size = sizeof(DebugVertex) * count;
+	DebugVertex *mapped = (DebugVertex*)SDL_MapGPUTransferBuffer(debug_device, transfer, true);
+	if(mapped == NULL)
+	{
+		return;
+	}
+	SDL_memcpy(mapped, vertices, size);
+	SDL_UnmapGPUTransferBuffer(debug_device, transfer);
+
+	SDL_GPUCopyPass *copypass = SDL_BeginGPUCopyPass(cmdbuf);
+	SDL_UploadToGPUBuffer(copypass,
+		&(SDL_GPUTransferBufferLocation){ .transfer_buffer = transfer, .offset = 0 },
+		&(SDL_GPUBufferRegion){ .buffer = vertex_buffer, .offset = 0, .size = size },
+		true);
+	SDL_EndGPUCopyPass(copypass);
+	uploaded = count;
+	stats.lines = count / 2;
+}
+
+void DebugDraw_Render(SDL_GPURenderPass *renderpass, SDL_GPUCommandBuffer *cmdbuf, Matrix4x4 viewproj,
+						SDL_GPUTextureFormat color_format, SDL_GPUTextureFormat depth_format)
+{
+	if(uploaded == 0)
+	{
+		return;
+	}
+	if(pipeline == NULL || pipeline_color != color_format || pipeline_depth != depth_format)
+	{
+		PipelineDesc desc = {
+			.vertex_shader = "shaders/debug/line.vert.spv",
+			.fragment_shader = "shaders/debug/line.frag.spv",
+			.vertex_layout = PIPELINE_VERTEX_LINE,
+			.primitive_type = SDL_GPU_PRIMITIVETYPE_LINELIST,
+			.num_color_targets = 1,
+			.color_formats = { color_format },
+			.depth_format = depth_format,
+			.depth_test = true,
+			.depth_write = false,
+			.compare_op = SDL_GPU_COMPAREOP_LESS_OR_EQUAL,
+			.cull_mode = SDL_GPU_CULLMODE_NONE,
+			.fill_mode = SDL_GPU_FILLMODE_FILL,
+			.blend = PIPELINE_BLEND_ALPHA
+		};
+		pipeline = PipelineCache_Get(&desc);
+		pipeline_color = color_format;
+		pipeline_depth = depth_format;
+		if(pipeline == NULL)
+		{
+			return;
+		}
+	}
+	SDL_BindGPUGraphicsPipeline(renderpass, pipeline);
+	SDL_BindGPUVertexBuffers(renderpass, 0, &(SDL_GPUBufferBinding){ vertex_buffer, 0 }, 1);
+	SDL_PushGPUVertexUniformData(cmdbuf, 0, &viewproj, sizeof(viewproj));
+	SDL_DrawGPUPrimitives(renderpass, uploaded, 1, 0, 0);
+}
+
+DebugDrawStats DebugDraw_GetStats()
+{
+	return stats;
+}
+
+void DebugDraw_Destroy()
+{
+	if(debug_device == NULL)
+	{
+		return;
+	}
+	release_gpu_buffers();
+	SDL_free(vertices);
+	vertices = NULL;
+	vertex_count = vertex_capacity = uploaded = 0;
+	pipeline = NULL;
+	debug_device = NULL;
+}
+
+#endif
@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2025 Matheus Klein Schaefer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef DEBUGDRAW_H
+#define DEBUGDRAW_H
+
+#include <SDL3/SDL.h>
+#include <linmath.h>
+#include <physics.h>
+#include <culling.h>
+
+/*******************************************************************
+ * STRUCTURES AND ENUMS ********************************************
+ ******************************************************************/
+
+//two per line; past this, lines are dropped until the next upload
+#define DEBUGDRAW_MAX_VERTICES (1u << 20)
+#define DEBUGDRAW_SPHERE_SEGMENTS 24
+
+//packed the way the UBYTE4_NORM attribute reads it, red in the low byte
+#define DEBUGDRAW_RGBA(r, g, b, a) ((Uint32)(r) | ((Uint32)(g) << 8) | ((Uint32)(b) << 16) | ((Uint32)(a) << 24))
+#define DEBUGDRAW_WHITE DEBUGDRAW_RGBA(255, 255, 255, 255)
+#define DEBUGDRAW_RED DEBUGDRAW_RGBA(255, 64, 64, 255)
+#define DEBUGDRAW_GREEN DEBUGDRAW_RGBA(64, 255, 64, 255)
+#define DEBUGDRAW_BLUE DEBUGDRAW_RGBA(64, 128, 255, 255)
+#define DEBUGDRAW_YELLOW DEBUGDRAW_RGBA(255, 230, 64, 255)
+
+typedef struct DebugVertex
+{
+	Vector3 position;
+	Uint32 color;
+} DebugVertex;
+
+typedef struct DebugDrawStats
+{
+	Uint32 lines; //in the last upload
+	Uint32 dropped; //since DebugDraw_Init
+} DebugDrawStats;
+
+/*******************************************************************
+ * FUNCTIONS *******************************************************
+ ******************************************************************/
+
+//LEIDEN_DEBUG_DRAW is only defined outside release builds; without it
+//every call below compiles to nothing and its arguments aren't evaluated
+#ifdef LEIDEN_DEBUG_DRAW
+
+bool DebugDraw_Init(SDL_GPUDevice *device);
+
+//immediate mode, from the main thread: shapes are collected until the
+//next DebugDraw_Upload, everything in world space
+void DebugDraw_Line(Vector3 a, Vector3 b, Uint32 color);
+void DebugDraw_AABB(AABB box, Uint32 color);
+//a local box under a transform, oriented like the object
+void DebugDraw_Box(AABB box, Matrix4x4 transform, Uint32 color);
+//three circles, one around each axis
+void DebugDraw_Sphere(Vector3 center, float radius, Uint32 color);
+//corners come from intersecting the planes, so any frustum works
+//(camera, shadow tile, portal) as long as it has a far plane
+void DebugDraw_Frustum(const Frustum *frustum, Uint32 color);
+//closed loop, like a portal's outline
+void DebugDraw_Polygon(const Vector3 *vertices, Uint32 count, Uint32 color);
+
+//copies the frame's lines to the GPU and starts collecting the next
+//frame's; outside any pass, before DebugDraw_Render
+void DebugDraw_Upload(SDL_GPUCommandBuffer *cmdbuf);
+
+//every uploaded line in a single draw, inside a pass writing one color
+//target; with a depth format the lines are depth tested, not written
+void DebugDraw_Render(SDL_GPURenderPass *renderpass, SDL_GPUCommandBuffer *cmdbuf, Matrix4x4 viewproj,
+						SDL_GPUTextureFormat color_format, SDL_GPUTextureFormat depth_format);
+
+DebugDrawStats DebugDraw_GetStats();
+
+void DebugDraw_Destroy();
+
+#else
+
+//a function, so ignoring the result doesn't warn
+static inline bool DebugDraw_Init(SDL_GPUDevice *device) { return true; }
+#define DebugDraw_Line(a, b, color) ((void)0)
+#define DebugDraw_AABB(box, color) ((void)0)
+#define DebugDraw_Box(box, transform, color) ((void)0)
+#define DebugDraw_Sphere(center, radius, color) ((void)0)
+#define DebugDraw_Frustum(frustum, color) ((void)0)
+#define DebugDraw_Polygon(vertices, count, color) ((void)0)
+#define DebugDraw_Upload(cmdbuf) ((void)0)
+#define DebugDraw_Render(renderpass, cmdbuf, viewproj, color_format, depth_format) ((void)0)
+#define DebugDraw_GetStats() ((DebugDrawStats){ 0 })
+#define DebugDraw_Destroy() ((void)0)
+
+#endif
+
+#endif
@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2025 Matheus Klein Schaefer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <SDL3/SDL.h>
+#include <dynres.h>
+
+//over this the frame is late, under the low mark there is room to grow
+#define DYNRES_HIGH 1.05
+#define DYNRES_ON_TARGET 1.02
+#define DYNRES_LOW 0.85
+
+static Uint32 scaled_size(Uint32 size, float scale)
+{
+	//even sizes keep 2x2 quads whole
+	Uint32 scaled = (Uint32)((float)size * scale + 0.5f) & ~1u;
+	return SDL_clamp(scaled, SDL_min(8u, size), size);
+}
+
+static bool apply_scale(DynamicResolution *dynres, float scale)
+{
+	dynres->scale = SDL_clamp(scale, dynres->min_scale, dynres->max_scale);
+	Uint32 width = scaled_size(dynres->max_width, dynres->scale);
+	Uint32 height = scaled_size(dynres->max_height, dynres->scale);
+	bool changed = width != dynres->width || height != dynres->height;
+	dynres->width = width;
+	dynres->height = height;
+	return changed;
+}
+
+void DynRes_Init(DynamicResolution *dynres, float target_fps,
+					float min_scale, float max_scale)
+{
+	*dynres = (DynamicResolution){ 0 };
+	dynres->target_ms = 1000.0 / (double)((target_fps > 0.0f) ? target_fps : 60.0f);
+	dynres->min_scale = SDL_clamp(min_scale, 0.1f, 1.0f);
+	dynres->max_scale = SDL_clamp(max_scale, dynres->min_scale, 1.0f);
+	dynres->scale = dynres->max_scale;
+	dynres->hold_frames = DYNRES_HOLD;
+}
+
+void DynRes_SetMaxSize(DynamicResolution *dynres, Uint32 width, Uint32 height)
+{
+	if(width == dynres->max_width && height == dynres->max_height)
+	{
+		return;
+	}
+	dynres->max_width = width;
+	dynres->max_height = height;
+	apply_scale(dynres, dynres->scale);
+}
+
+bool DynRes_Update(DynamicResolution *dynres, double frame_ms)
+{
+	if(frame_ms <= 0.0)
+	{
+		return false;
+	}
+	dynres->average_ms = (dynres->average_ms == 0.0) ? frame_ms : dynres->average_ms * 0.9 + frame_ms * 0.1;
+	if(dynres->hold > 0)
+	{
+		dynres->hold--;
+	}
+	if(dynres->cooldown > 0)
+	{
+		dynres->cooldown--;
+		return false;
+	}
+
+	float scale = dynres->scale;
+	double ratio = dynres->average_ms / dynres->target_ms;
+	if(ratio > DYNRES_HIGH && scale > dynres->min_scale)
+	{
+		//GPU cost follows the pixel count, which goes with scale squared
+		//a vsync miss reads as twice the time, so don't follow it all the way
+		scale = SDL_clamp(scale * SDL_sqrtf((float)(1.0 / ratio)), scale - 4.0f * DYNRES_STEP, scale - DYNRES_STEP);
+		dynres->hold_frames = dynres->probing ? SDL_min(dynres->hold_frames * 2, DYNRES_MAX_HOLD) : DYNRES_HOLD;
+		dynres->hold = dynres->hold_frames;
+		dynres->probing = false;
+	}
+	else if(scale < dynres->max_scale &&
+			(ratio < DYNRES_LOW || (ratio < DYNRES_ON_TARGET && dynres->hold == 0)))
+	{
+		scale += DYNRES_STEP;
+		dynres->hold = dynres->hold_frames;
+		dynres->probing = true;
+	}
+	else
+	{
+		return false;
+	}
+
+	dynres->cooldown = DYNRES_COOLDOWN;
+	dynres->average_ms = 0.0;
+	return apply_scale(dynres, scale);
+}
+
+void DynRes_Reset(DynamicResolution *dynres)
+{
+	dynres->average_ms = 0.0;
+	dynres->cooldown = 0;
+	dynres->hold = 0;
+	dynres->hold_frames = DYNRES_HOLD;
+	dynres->probing = false;
+	apply_scale(dynres, dynres->max_scale);
+}
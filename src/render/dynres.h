@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2025 Matheus Klein Schaefer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef DYNRES_H
+#define DYNRES_H
+
+#include <SDL3/SDL.h>
+
+/*******************************************************************
+ * STRUCTURES AND ENUMS ********************************************
+ ******************************************************************/
+
+//scale changes per step, per axis
+#define DYNRES_STEP 0.05f
+//frames between two changes, so the average sees the new cost
+#define DYNRES_COOLDOWN 10
+//frames after a drop before trying a higher scale again, doubled each
+//time the higher scale turns out too slow
+#define DYNRES_HOLD 120
+#define DYNRES_MAX_HOLD (DYNRES_HOLD * 16)
+
+//scene targets are allocated once at the maximum size and only the
+//top-left width x height part is drawn, so changing the scale never
+//reallocates anything
+typedef struct DynamicResolution
+{
+	Uint32 max_width, max_height;
+	Uint32 width, height;
+	float scale;
+	float min_scale, max_scale;
+	double target_ms;
+	double average_ms;
+	Uint32 cooldown;
+	Uint32 hold;
+	Uint32 hold_frames; //grows while scaling up keeps failing
+	bool probing; //last change went up
+} DynamicResolution;
+
+/*******************************************************************
+ * FUNCTIONS *******************************************************
+ ******************************************************************/
+
+void DynRes_Init(DynamicResolution *dynres, float target_fps,
+					float min_scale, float max_scale);
+
+//window resizes, keeps the current scale
+void DynRes_SetMaxSize(DynamicResolution *dynres, Uint32 width, Uint32 height);
+
+//feeds the last frame time, true when width/height changed
+//frame times are CPU side intervals: with vsync they can't go under the
+//refresh period, so being on target counts as headroom and a higher
+//scale is tried every DYNRES_HOLD frames
+bool DynRes_Update(DynamicResolution *dynres, double frame_ms);
+
+//back to the maximum scale
+void DynRes_Reset(DynamicResolution *dynres);
+
+#endif
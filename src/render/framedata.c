@@ -0,0 +1,180 @@
+/*
+ * Copyright (C) 2025 Matheus Klein Schaefer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <SDL3/SDL.h>
+#include <framedata.h>
+#include <gpumem.h>
+
+static void release_gpu_buffers(SDL_GPUDevice *device, FrameData *framedata)
+{
+	if(framedata->buffer != NULL)
+	{
+		GPUMem_ReleaseBuffer(device, framedata->buffer);
+		framedata->buffer = NULL;
+	}
+	if(framedata->transfer != NULL)
+	{
+		GPUMem_ReleaseTransferBuffer(device, framedata->transfer);
+		framedata->transfer = NULL;
+	}
+	framedata->gpu_capacity = 0;
+}
+
+static bool create_gpu_buffers(SDL_GPUDevice *device, FrameData *framedata)
+{
+	Uint32 size = sizeof(FrameObjectData) * framedata->capacity;
+
+	framedata->buffer = GPUMem_CreateBuffer(
+		device,
+		&(SDL_GPUBufferCreateInfo) {
+			.usage = SDL_GPU_BUFFERUSAGE_GRAPHICS_STORAGE_READ,
+			.size = size
+		}
+	);
+	framedata->transfer = GPUMem_CreateTransferBuffer(
+		device,
+		&(SDL_GPUTransferBufferCreateInfo) {
+			.usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
+			.size = size
+		}
+	);
+
+	if(framedata->buffer == NULL || framedata->transfer == NULL)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Graphics: Error: Failed to create frame data buffers: %s", SDL_GetError());
+		release_gpu_buffers(device, framedata);
+		return false;
+	}
+	framedata->gpu_capacity = framedata->capacity;
+	return true;
+}
+
+bool FrameData_Init(SDL_GPUDevice *device, FrameData *framedata,
+					Uint32 capacity)
+{
+	if(device == NULL || framedata == NULL)
+	{
+		return false;
+	}
+	*framedata = (FrameData){ 0 };
+	framedata->capacity = (capacity == 0) ? 64 : capacity;
+	framedata->viewproj = Matrix4x4_Identity();
+	framedata->objects = (FrameObjectData*)SDL_calloc(framedata->capacity, sizeof(FrameObjectData));
+	if(framedata->objects == NULL)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Graphics: Error: Failed to alloc frame data.");
+		return false;
+	}
+	if(!create_gpu_buffers(device, framedata))
+	{
+		SDL_free(framedata->objects);
+		framedata->objects = NULL;
+		return false;
+	}
+	return true;
+}
+
+void FrameData_Begin(FrameData *framedata, Matrix4x4 viewproj)
+{
+	framedata->count = 0;
+	framedata->viewproj = viewproj;
+}
+
+Uint32 FrameData_Push(FrameData *framedata, Matrix4x4 model)
+{
+	if(framedata->count == framedata->capacity)
+	{
+		//GPU buffers catch up on the next upload
+		Uint32 new_capacity = framedata->capacity * 2;
+		FrameObjectData *aux = (FrameObjectData*)SDL_realloc(framedata->objects, sizeof(FrameObjectData) * new_capacity);
+		if(aux == NULL)
+		{
+			SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Graphics: Error: Failed to grow frame data, reusing last slot.");
+			return framedata->count - 1;
+		}
+		framedata->objects = aux;
+		framedata->capacity = new_capacity;
+	}
+	Uint32 index = framedata->count++;
+	framedata->objects[index].model = model;
+	framedata->objects[index].mvp = Matrix4x4_Mul(model, framedata->viewproj);
+	return index;
+}
+
+bool FrameData_Upload(SDL_GPUDevice *device, FrameData *framedata,
+						SDL_GPUCommandBuffer *cmdbuf)
+{
+	if(framedata->count == 0)
+	{
+		return true;
+	}
+
+	//capacity grew during the frame
+	if(framedata->buffer == NULL || framedata->gpu_capacity < framedata->capacity)
+	{
+		release_gpu_buffers(device, framedata);
+		if(!create_gpu_buffers(device, framedata))
+		{
+			return false;
+		}
+	}
+
+	Uint32 size = sizeof(FrameObjectData) * framedata->count;
+
+	//cycling lets the driver hand us a fresh buffer while last frame's
+	//copy is still being read by the GPU
+	FrameObjectData *mapped = SDL_MapGPUTransferBuffer(device, framedata->transfer, true);
+	if(mapped == NULL)
+	{
+		return false;
+	}
+	SDL_memcpy(mapped, framedata->objects, size);
+	SDL_UnmapGPUTransferBuffer(device, framedata->transfer);
+
+	SDL_GPUCopyPass *copypass = SDL_BeginGPUCopyPass(cmdbuf);
+	SDL_UploadToGPUBuffer(
+		copypass,
+		&(SDL_GPUTransferBufferLocation) {
+			.transfer_buffer = framedata->transfer,
+			.offset = 0
+		},
+		&(SDL_GPUBufferRegion) {
+			.buffer = framedata->buffer,
+			.offset = 0,
+			.size = size
+		},
+		true
+	);
+	SDL_EndGPUCopyPass(copypass);
+	return true;
+}
+
+void FrameData_Bind(FrameData *framedata, SDL_GPURenderPass *renderpass,
+					Uint32 slot)
+{
+	SDL_BindGPUVertexStorageBuffers(renderpass, slot, &framedata->buffer, 1);
+}
+
+void FrameData_Destroy(SDL_GPUDevice *device, FrameData *framedata)
+{
+	if(device == NULL || framedata == NULL)
+	{
+		return;
+	}
+	release_gpu_buffers(device, framedata);
+	SDL_free(framedata->objects);
+	*framedata = (FrameData){ 0 };
+}
@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2025 Matheus Klein Schaefer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef FRAMEDATA_H
+#define FRAMEDATA_H
+
+#include <SDL3/SDL.h>
+#include <linmath.h>
+
+/*******************************************************************
+ * STRUCTURES AND ENUMS ********************************************
+ ******************************************************************/
+
+//same layout as ObjectData in the framedata shaders (std430)
+typedef struct FrameObjectData
+{
+	Matrix4x4 mvp;
+	Matrix4x4 model;
+} FrameObjectData;
+
+//all object matrices of a frame, uploaded once to a storage buffer
+//draws pass their object index as first_instance and the vertex
+//shader fetches objects[gl_InstanceIndex] (Vulkan includes the
+//first instance on gl_InstanceIndex, which is all we target)
+typedef struct FrameData
+{
+	SDL_GPUBuffer *buffer;
+	SDL_GPUTransferBuffer *transfer;
+	FrameObjectData *objects; //CPU copy, written during the frame
+	Uint32 count;
+	Uint32 capacity;
+	Uint32 gpu_capacity; //lags behind capacity until the next upload
+	Matrix4x4 viewproj;
+} FrameData;
+
+/*******************************************************************
+ * FUNCTIONS *******************************************************
+ ******************************************************************/
+
+bool FrameData_Init(SDL_GPUDevice *device, FrameData *framedata,
+					Uint32 capacity);
+
+//drops last frame's objects, viewproj is used by FrameData_Push
+void FrameData_Begin(FrameData *framedata, Matrix4x4 viewproj);
+
+//computes the MVP once and returns the index to use as first_instance
+Uint32 FrameData_Push(FrameData *framedata, Matrix4x4 model);
+
+//records a copy pass on cmdbuf, must come before the render passes
+//that read the buffer; grows the GPU buffers if needed
+bool FrameData_Upload(SDL_GPUDevice *device, FrameData *framedata,
+						SDL_GPUCommandBuffer *cmdbuf);
+
+void FrameData_Bind(FrameData *framedata, SDL_GPURenderPass *renderpass,
+					Uint32 slot);
+
+void FrameData_Destroy(SDL_GPUDevice *device, FrameData *framedata);
+
+#endif
@@ -0,0 +1,305 @@
+/*
+ * Copyright (C) 2025 Matheus Klein Schaefer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <SDL3/SDL.h>
+#include <gpumem.h>
+
+#define GPUMEM_MB (1024.0 * 1024.0)
+
+//open addressing on the handle, linear probing
+typedef struct GPUMemEntry
+{
+	const void *handle; //NULL is an empty slot
+	Uint64 size;
+	GPUMemCategory category;
+} GPUMemEntry;
+
+static const char *category_names[GPUMEM_COUNT] = { "geometry", "data", "textures", "render targets", "staging" };
+
+static GPUMemEntry *entries = NULL;
+static Uint32 capacity = 0; //power of two
+static Uint32 used = 0;
+static SDL_Mutex *lock = NULL;
+static GPUMemStats stats;
+static bool warned = false;
+
+void GPUMem_Init(Uint64 budget)
+{
+	if(lock == NULL)
+	{
+		lock = SDL_CreateMutex();
+	}
+	stats.budget = budget;
+	warned = false;
+	if(budget != 0)
+	{
+		SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "GPU memory budget: %.1f MB.", (double)budget / GPUMEM_MB);
+	}
+}
+
+/*******************************************************************
+ * TABLE ***********************************************************
+ ******************************************************************/
+
+static Uint32 slot_of(const void *handle)
+{
+	Uint64 key = (Uint64)(uintptr_t)handle;
+	key = (key >> 4) * 0x9E3779B97F4A7C15ull;
+	return (Uint32)(key >> 32) & (capacity - 1);
+}
+
+static bool grow()
+{
+	Uint32 old_capacity = capacity;
+	GPUMemEntry *old = entries;
+	Uint32 new_capacity = (capacity == 0) ? 256 : capacity * 2;
+	GPUMemEntry *aux = (GPUMemEntry*)SDL_calloc(new_capacity, sizeof(GPUMemEntry));
+	if(aux == NULL)
+	{
+		return false;
+	}
+	entries = aux;
+	capacity = new_capacity;
+	for(Uint32 i = 0; i < old_capacity; i++)
+	{
+		if(old[i].handle == NULL)
+		{
+			continue;
+		}
+		Uint32 slot = slot_of(old[i].handle);
+		while(entries[slot].handle != NULL)
+		{
+			slot = (slot + 1) & (capacity - 1);
+		}
+		entries[slot] = old[i];
+	}
+	SDL_free(old);
+	return true;
+}
+
+static void track(const void *handle, Uint64 size, GPUMemCategory category)
+{
+	if(handle == NULL)
+	{
+		return;
+	}
+	SDL_LockMutex(lock);
+	//kept under 3/4 full so probes stay short
+	if((used + 1) * 4 > capacity * 3 && !grow())
+	{
+		SDL_UnlockMutex(lock);
+		return;
+	}
+	Uint32 slot = slot_of(handle);
+	while(entries[slot].handle != NULL)
+	{
+		slot = (slot + 1) & (capacity - 1);
+	}
+	entries[slot] = (GPUMemEntry){ handle, size, category };
+	used++;
+
+	GPUMemCategoryStats *cat = &stats.categories[category];
+	cat->bytes += size;
+	cat->count++;
+	cat->peak = SDL_max(cat->peak, cat->bytes);
+	stats.bytes += size;
+	stats.peak = SDL_max(stats.peak, stats.bytes);
+	bool warn = stats.budget != 0 && stats.bytes > stats.budget && !warned;
+	if(warn)
+	{
+		warned = true;
+		stats.over_budget++;
+	}
+	SDL_UnlockMutex(lock);
+
+	if(warn)
+	{
+		SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "GPU memory over budget: %.1f of %.1f MB, %.1f MB in %s.",
+					(double)stats.bytes / GPUMEM_MB, (double)stats.budget / GPUMEM_MB,
+					(double)stats.categories[category].bytes / GPUMEM_MB, category_names[category]);
+	}
+}
+
+//the entries after the removed one move back if their probe crossed it
+static void untrack(const void *handle)
+{
+	if(handle == NULL)
+	{
+		return;
+	}
+	SDL_LockMutex(lock);
+	if(capacity == 0)
+	{
+		SDL_UnlockMutex(lock);
+		return;
+	}
+	Uint32 slot = slot_of(handle);
+	while(entries[slot].handle != NULL && entries[slot].handle != handle)
+	{
+		slot = (slot + 1) & (capacity - 1);
+	}
+	if(entries[slot].handle == NULL)
+	{
+		//created before tracking or by someone else
+		SDL_UnlockMutex(lock);
+		return;
+	}
+	GPUMemCategoryStats *cat = &stats.categories[entries[slot].category];
+	cat->bytes -= entries[slot].size;
+	cat->count--;
+	stats.bytes -= entries[slot].size;
+	if(stats.bytes <= stats.budget)
+	{
+		warned = false;
+	}
+	entries[slot].handle = NULL;
+	used--;
+
+	Uint32 hole = slot;
+	for(Uint32 next = (hole + 1) & (capacity - 1); entries[next].handle != NULL; next = (next + 1) & (capacity - 1))
+	{
+		Uint32 home = slot_of(entries[next].handle);
+		//can it stay, i.e. is its home in (hole, next] going around
+		bool stays = (hole < next) ? (home > hole && home <= next) : (home > hole || home <= next);
+		if(!stays)
+		{
+			entries[hole] = entries[next];
+			entries[next].handle = NULL;
+			hole = next;
+		}
+	}
+	SDL_UnlockMutex(lock);
+}
+
+/*******************************************************************
+ * RESOURCES *******************************************************
+ ******************************************************************/
+
+static GPUMemCategory buffer_category(SDL_GPUBufferUsageFlags usage)
+{
+	return (usage & (SDL_GPU_BUFFERUSAGE_VERTEX | SDL_GPU_BUFFERUSAGE_INDEX)) ? GPUMEM_GEOMETRY : GPUMEM_DATA;
+}
+
+static GPUMemCategory texture_category(SDL_GPUTextureUsageFlags usage)
+{
+	SDL_GPUTextureUsageFlags targets = SDL_GPU_TEXTUREUSAGE_COLOR_TARGET | SDL_GPU_TEXTUREUSAGE_DEPTH_STENCIL_TARGET |
+										SDL_GPU_TEXTUREUSAGE_COMPUTE_STORAGE_WRITE |
+										SDL_GPU_TEXTUREUSAGE_COMPUTE_STORAGE_SIMULTANEOUS_READ_WRITE;
+	return (usage & targets) ? GPUMEM_TARGETS : GPUMEM_TEXTURES;
+}
+
+//every mip level, times the samples
+static Uint64 texture_size(const SDL_GPUTextureCreateInfo *info)
+{
+	Uint64 size = 0;
+	for(Uint32 level = 0; level < SDL_max(info->num_levels, 1u); level++)
+	{
+		Uint32 width = SDL_max(info->width >> level, 1u);
+		Uint32 height = SDL_max(info->height >> level, 1u);
+		Uint32 depth = info->layer_count_or_depth;
+		if(info->type == SDL_GPU_TEXTURETYPE_3D)
+		{
+			depth = SDL_max(depth >> level, 1u);
+		}
+		size += SDL_CalculateGPUTextureFormatSize(info->format, width, height, SDL_max(depth, 1u));
+	}
+	return size << (Uint32)info->sample_count;
+}
+
+SDL_GPUBuffer *GPUMem_CreateBuffer(SDL_GPUDevice *device, const SDL_GPUBufferCreateInfo *info)
+{
+	SDL_GPUBuffer *buffer = SDL_CreateGPUBuffer(device, info);
+	track(buffer, info->size, buffer_category(info->usage));
+	return buffer;
+}
+
+SDL_GPUTexture *GPUMem_CreateTexture(SDL_GPUDevice *device, const SDL_GPUTextureCreateInfo *info)
+{
+	SDL_GPUTexture *texture = SDL_CreateGPUTexture(device, info);
+	track(texture, texture_size(info), texture_category(info->usage));
+	return texture;
+}
+
+SDL_GPUTransferBuffer *GPUMem_CreateTransferBuffer(SDL_GPUDevice *device, const SDL_GPUTransferBufferCreateInfo *info)
+{
+	SDL_GPUTransferBuffer *buffer = SDL_CreateGPUTransferBuffer(device, info);
+	track(buffer, info->size, GPUMEM_STAGING);
+	return buffer;
+}
+
+void GPUMem_ReleaseBuffer(SDL_GPUDevice *device, SDL_GPUBuffer *buffer)
+{
+	untrack(buffer);
+	SDL_ReleaseGPUBuffer(device, buffer);
+}
+
+void GPUMem_ReleaseTexture(SDL_GPUDevice *device, SDL_GPUTexture *texture)
+{
+	untrack(texture);
+	SDL_ReleaseGPUTexture(device, texture);
+}
+
+void GPUMem_ReleaseTransferBuffer(SDL_GPUDevice *device, SDL_GPUTransferBuffer *buffer)
+{
+	untrack(buffer);
+	SDL_ReleaseGPUTransferBuffer(device, buffer);
+}
+
+/*******************************************************************
+ * STATS ***********************************************************
+ ******************************************************************/
+
+GPUMemStats GPUMem_GetStats()
+{
+	SDL_LockMutex(lock);
+	GPUMemStats current = stats;
+	SDL_UnlockMutex(lock);
+	return current;
+}
+
+const char *GPUMem_GetCategoryName(GPUMemCategory category)
+{
+	return (category < GPUMEM_COUNT) ? category_names[category] : "unknown";
+}
+
+void GPUMem_LogStats()
+{
+	GPUMemStats current = GPUMem_GetStats();
+	SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "GPU memory: %.1f MB, peak %.1f MB%s",
+				(double)current.bytes / GPUMEM_MB, (double)current.peak / GPUMEM_MB,
+				(current.budget != 0 && current.bytes > current.budget) ? ", over budget" : "");
+	for(int i = 0; i < GPUMEM_COUNT; i++)
+	{
+		GPUMemCategoryStats *cat = &current.categories[i];
+		SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "  %-15s %9.2f MB in %5u, peak %9.2f MB",
+					category_names[i], (double)cat->bytes / GPUMEM_MB, cat->count, (double)cat->peak / GPUMEM_MB);
+	}
+}
+
+void GPUMem_Destroy()
+{
+	GPUMem_LogStats();
+	if(stats.bytes != 0)
+	{
+		SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "GPU memory: %u resources never released.", used);
+	}
+	SDL_free(entries);
+	entries = NULL;
+	capacity = used = 0;
+	stats = (GPUMemStats){ 0 };
+	SDL_DestroyMutex(lock);
+	lock = NULL;
+}
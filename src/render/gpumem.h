@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2025 Matheus Klein Schaefer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef GPUMEM_H
+#define GPUMEM_H
+
+#include <SDL3/SDL.h>
+
+/*******************************************************************
+ * STRUCTURES AND ENUMS ********************************************
+ ******************************************************************/
+
+//picked from the usage flags, callers don't say
+typedef enum GPUMemCategory
+{
+	GPUMEM_GEOMETRY = 0, //vertex and index buffers
+	GPUMEM_DATA, //storage and indirect buffers
+	GPUMEM_TEXTURES, //sampled only
+	GPUMEM_TARGETS, //render, depth and storage targets
+	GPUMEM_STAGING, //transfer buffers
+	GPUMEM_COUNT
+} GPUMemCategory;
+
+typedef struct GPUMemCategoryStats
+{
+	Uint64 bytes;
+	Uint64 peak; //high-water mark
+	Uint32 count;
+} GPUMemCategoryStats;
+
+typedef struct GPUMemStats
+{
+	GPUMemCategoryStats categories[GPUMEM_COUNT];
+	Uint64 bytes;
+	Uint64 peak;
+	Uint64 budget; //0 for none
+	Uint32 over_budget; //times the total went past the budget
+} GPUMemStats;
+
+/*******************************************************************
+ * FUNCTIONS *******************************************************
+ ******************************************************************/
+
+//budget in bytes, 0 for none; going over it logs a warning once until
+//the total drops back under it
+//tracking works before this too, it only sets the budget and a lock
+void GPUMem_Init(Uint64 budget);
+
+//same as the SDL calls, with the size added to the resource's category
+//sizes are what the resource holds, the driver may round them up
+SDL_GPUBuffer *GPUMem_CreateBuffer(SDL_GPUDevice *device, const SDL_GPUBufferCreateInfo *info);
+SDL_GPUTexture *GPUMem_CreateTexture(SDL_GPUDevice *device, const SDL_GPUTextureCreateInfo *info);
+SDL_GPUTransferBuffer *GPUMem_CreateTransferBuffer(SDL_GPUDevice *device, const SDL_GPUTransferBufferCreateInfo *info);
+
+void GPUMem_ReleaseBuffer(SDL_GPUDevice *device, SDL_GPUBuffer *buffer);
+void GPUMem_ReleaseTexture(SDL_GPUDevice *device, SDL_GPUTexture *texture);
+void GPUMem_ReleaseTransferBuffer(SDL_GPUDevice *device, SDL_GPUTransferBuffer *buffer);
+
+GPUMemStats GPUMem_GetStats();
+
+const char *GPUMem_GetCategoryName(GPUMemCategory category);
+
+//per category totals, peaks and counts
+void GPUMem_LogStats();
+
+//logs what's still alive, then forgets everything
+void GPUMem_Destroy();
+
+#endif
@@ -0,0 +1,498 @@
+/*
+ * Copyright (C) 2025 Matheus Klein Schaefer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <SDL3/SDL.h>
+#include <shader.h>
+#include <culling.h>
+#include <gpuscene.h>
+#include <gpumem.h>
+
+//must match cull.comp
+#define GPUSCENE_GROUP 64
+
+//std430 layouts, see cull.comp
+typedef struct GPUMeshInfo
+{
+	Uint32 index_count, first_index;
+	Sint32 vertex_offset;
+	Uint32 layer;
+	float center[4];
+	float extent[4];
+} GPUMeshInfo;
+
+typedef struct GPUCullInfo
+{
+	Vector4 planes[6];
+	Uint32 draw_count;
+	Uint32 padding[3];
+} GPUCullInfo;
+
+static void release_buffer(SDL_GPUDevice *device, SDL_GPUBuffer **buffer)
+{
+	if(*buffer != NULL)
+	{
+		GPUMem_ReleaseBuffer(device, *buffer);
+		*buffer = NULL;
+	}
+}
+
+static SDL_GPUBuffer *create_buffer(SDL_GPUDevice *device, SDL_GPUBufferUsageFlags usage, Uint32 size)
+{
+	SDL_GPUBuffer *buffer = GPUMem_CreateBuffer(device, &(SDL_GPUBufferCreateInfo){ .usage = usage, .size = size });
+	if(buffer == NULL)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Graphics: Error: Failed to create GPU scene buffer: %s", SDL_GetError());
+	}
+	return buffer;
+}
+
+bool GPUScene_Init(SDL_GPUDevice *device, GPUScene *scene, Uint32 capacity)
+{
+	*scene = (GPUScene){ 0 };
+	scene->device = device;
+	scene->capacity = (capacity == 0) ? 64 : capacity;
+	scene->objects = (Matrix4x4*)SDL_malloc(sizeof(Matrix4x4) * scene->capacity);
+	scene->object_models = (Uint32*)SDL_malloc(sizeof(Uint32) * scene->capacity);
+	scene->cull_pipeline = ShaderLib_GetCompute("shaders/gpuscene/cull.comp.spv");
+	if(scene->objects == NULL || scene->object_models == NULL || scene->cull_pipeline == NULL)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Graphics: Error: GPU scene not available.");
+		GPUScene_Destroy(scene);
+		return false;
+	}
+	return true;
+}
+
+/*******************************************************************
+ * CONTENT *********************************************************
+ ******************************************************************/
+
+static Uint32 find_batch(GPUScene *scene, SDL_GPUTexture *texture, bool array)
+{
+	for(Uint32 i = 0; i < scene->num_batches; i++)
+	{
+		if(scene->batches[i].texture == texture && scene->batches[i].array == array)
+		{
+			return i;
+		}
+	}
+	if(scene->num_batches == GPUSCENE_MAX_BATCHES)
+	{
+		return GPUSCENE_MAX_BATCHES;
+	}
+	scene->batches[scene->num_batches] = (GPUSceneBatch){ .texture = texture, .array = array };
+	return scene->num_batches++;
+}
+
+int GPUScene_AddModel(GPUScene *scene, const Model *model)
+{
+	if(model == NULL || scene->num_models == GPUSCENE_MAX_MODELS ||
+		scene->num_meshes + model->meshes.count > GPUSCENE_MAX_MESHES)
+	{
+		return -1;
+	}
+	GPUSceneModel *entry = &scene->models[scene->num_models];
+	*entry = (GPUSceneModel){ .model = model, .first_mesh = scene->num_meshes };
+	for(size_t m = 0; m < model->meshes.count; m++)
+	{
+		const Mesh *mesh = &model->meshes.meshes[m];
+		bool array = mesh->diffuse_array != NULL;
+		Uint32 batch = find_batch(scene, array ? mesh->diffuse_array : mesh->diffuse.texture, array);
+		if(batch == GPUSCENE_MAX_BATCHES)
+		{
+			SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "GPU scene: too many textures, %s left out.", mesh->meshname);
+			continue;
+		}
+		scene->meshes[scene->num_meshes++] = (GPUSceneMesh){
+			.mesh = mesh,
+			.first_index = scene->num_indices,
+			.index_count = (Uint32)mesh->iarray.count,
+			.vertex_offset = (Sint32)scene->num_vertices,
+			.batch = batch
+		};
+		scene->num_vertices += (Uint32)mesh->varray.count;
+		scene->num_indices += (Uint32)mesh->iarray.count;
+		entry->num_meshes++;
+	}
+	scene->geometry_dirty = true;
+	scene->draws_dirty = true;
+	return (int)scene->num_models++;
+}
+
+int GPUScene_AddObject(GPUScene *scene, int model, Matrix4x4 transform)
+{
+	if(model < 0 || (Uint32)model >= scene->num_models)
+	{
+		return -1;
+	}
+	if(scene->num_objects == scene->capacity)
+	{
+		Uint32 new_capacity = scene->capacity * 2;
+		Matrix4x4 *objects = (Matrix4x4*)SDL_realloc(scene->objects, sizeof(Matrix4x4) * new_capacity);
+		if(objects != NULL)
+		{
+			scene->objects = objects;
+		}
+		Uint32 *models = (Uint32*)SDL_realloc(scene->object_models, sizeof(Uint32) * new_capacity);
+		if(models != NULL)
+		{
+			scene->object_models = models;
+		}
+		if(objects == NULL || models == NULL)
+		{
+			return -1;
+		}
+		scene->capacity = new_capacity;
+	}
+	Uint32 object = scene->num_objects++;
+	scene->object_models[object] = (Uint32)model;
+	scene->draws_dirty = true;
+	GPUScene_SetTransform(scene, object, transform);
+	return (int)object;
+}
+
+void GPUScene_SetTransform(GPUScene *scene, Uint32 object, Matrix4x4 transform)
+{
+	if(object >= scene->num_objects)
+	{
+		return;
+	}
+	scene->objects[object] = transform;
+	if(scene->dirty_first == scene->dirty_end)
+	{
+		scene->dirty_first = object;
+		scene->dirty_end = object + 1;
+		return;
+	}
+	scene->dirty_first = SDL_min(scene->dirty_first, object);
+	scene->dirty_end = SDL_max(scene->dirty_end, object + 1);
+}
+
+void GPUScene_ClearObjects(GPUScene *scene)
+{
+	scene->num_objects = 0;
+	scene->dirty_first = scene->dirty_end = 0;
+	scene->draws_dirty = true;
+}
+
+//draws grouped by batch, so each batch is one indirect call
+static bool build_draws(GPUScene *scene)
+{
+	Uint32 count = 0;
+	for(Uint32 b = 0; b < scene->num_batches; b++)
+	{
+		scene->batches[b].num_draws = 0;
+	}
+	for(Uint32 o = 0; o < scene->num_objects; o++)
+	{
+		GPUSceneModel *model = &scene->models[scene->object_models[o]];
+		for(Uint32 m = 0; m < model->num_meshes; m++)
+		{
+			scene->batches[scene->meshes[model->first_mesh + m].batch].num_draws++;
+		}
+		count += model->num_meshes;
+	}
+	if(count > scene->draw_capacity)
+	{
+		GPUSceneDraw *draws = (GPUSceneDraw*)SDL_realloc(scene->draws, sizeof(GPUSceneDraw) * count);
+		if(draws == NULL)
+		{
+			return false;
+		}
+		scene->draws = draws;
+		scene->draw_capacity = count;
+	}
+
+	Uint32 first = 0;
+	for(Uint32 b = 0; b < scene->num_batches; b++)
+	{
+		scene->batches[b].first_draw = first;
+		first += scene->batches[b].num_draws;
+		scene->batches[b].num_draws = 0;
+	}
+	for(Uint32 o = 0; o < scene->num_objects; o++)
+	{
+		GPUSceneModel *model = &scene->models[scene->object_models[o]];
+		for(Uint32 m = 0; m < model->num_meshes; m++)
+		{
+			Uint32 mesh = model->first_mesh + m;
+			GPUSceneBatch *batch = &scene->batches[scene->meshes[mesh].batch];
+			scene->draws[batch->first_draw + batch->num_draws++] = (GPUSceneDraw){ o, mesh };
+		}
+	}
+	scene->num_draws = count;
+	return true;
+}
+
+/*******************************************************************
+ * GPU *************************************************************
+ ******************************************************************/
+
+//every mesh gets copied again, buffers only grow when models are added
+static bool build_geometry(GPUScene *scene, SDL_GPUCopyPass *copypass)
+{
+	release_buffer(scene->device, &scene->vertices);
+	release_buffer(scene->device, &scene->indices);
+	if(scene->num_vertices == 0)
+	{
+		return true;
+	}
+	scene->vertices = create_buffer(scene->device, SDL_GPU_BUFFERUSAGE_VERTEX, sizeof(Vertex3D) * scene->num_vertices);
+	scene->indices = create_buffer(scene->device, SDL_GPU_BUFFERUSAGE_INDEX, sizeof(Uint32) * scene->num_indices);
+	if(scene->vertices == NULL || scene->indices == NULL)
+	{
+		return false;
+	}
+	for(Uint32 i = 0; i < scene->num_meshes; i++)
+	{
+		GPUSceneMesh *entry = &scene->meshes[i];
+		SDL_CopyGPUBufferToBuffer(copypass,
+			&(SDL_GPUBufferLocation){ entry->mesh->vbuffer, 0 },
+			&(SDL_GPUBufferLocation){ scene->vertices, sizeof(Vertex3D) * (Uint32)entry->vertex_offset },
+			sizeof(Vertex3D) * (Uint32)entry->mesh->varray.count, false);
+		SDL_CopyGPUBufferToBuffer(copypass,
+			&(SDL_GPUBufferLocation){ entry->mesh->ibuffer, 0 },
+			&(SDL_GPUBufferLocation){ scene->indices, sizeof(Uint32) * entry->first_index },
+			sizeof(Uint32) * entry->index_count, false);
+	}
+	return true;
+}
+
+static bool reserve_gpu(GPUScene *scene)
+{
+	if(scene->gpu_capacity < scene->capacity)
+	{
+		release_buffer(scene->device, &scene->object_buffer);
+		scene->object_buffer = create_buffer(scene->device,
+												SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_READ | SDL_GPU_BUFFERUSAGE_GRAPHICS_STORAGE_READ,
+												sizeof(Matrix4x4) * scene->capacity);
+		scene->gpu_capacity = (scene->object_buffer != NULL) ? scene->capacity : 0;
+		//new buffer, nothing in it yet
+		scene->dirty_first = 0;
+		scene->dirty_end = scene->num_objects;
+	}
+	if(scene->mesh_buffer == NULL)
+	{
+		scene->mesh_buffer = create_buffer(scene->device,
+											SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_READ | SDL_GPU_BUFFERUSAGE_GRAPHICS_STORAGE_READ,
+											sizeof(GPUMeshInfo) * GPUSCENE_MAX_MESHES);
+	}
+	if(scene->gpu_draw_capacity < scene->draw_capacity)
+	{
+		release_buffer(scene->device, &scene->draw_buffer);
+		release_buffer(scene->device, &scene->command_buffer);
+		scene->draw_buffer = create_buffer(scene->device,
+											SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_READ | SDL_GPU_BUFFERUSAGE_GRAPHICS_STORAGE_READ,
+											sizeof(GPUSceneDraw) * scene->draw_capacity);
+		scene->command_buffer = create_buffer(scene->device,
+												SDL_GPU_BUFFERUSAGE_INDIRECT | SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_WRITE,
+												sizeof(SDL_GPUIndexedIndirectDrawCommand) * scene->draw_capacity);
+		bool ok = scene->draw_buffer != NULL && scene->command_buffer != NULL;
+		scene->gpu_draw_capacity = ok ? scene->draw_capacity : 0;
+		scene->draws_dirty = true;
+	}
+	return scene->gpu_capacity != 0 && scene->mesh_buffer != NULL &&
+			(scene->draw_capacity == 0 || scene->gpu_draw_capacity != 0);
+}
+
+static bool reserve_transfer(GPUScene *scene, Uint32 size)
+{
+	if(size <= scene->transfer_size)
+	{
+		return true;
+	}
+	if(scene->transfer != NULL)
+	{
+		GPUMem_ReleaseTransferBuffer(scene->device, scene->transfer);
+	}
+	scene->transfer = GPUMem_CreateTransferBuffer(scene->device, &(SDL_GPUTransferBufferCreateInfo){
+		.usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
+		.size = size
+	});
+	scene->transfer_size = (scene->transfer != NULL) ? size : 0;
+	return scene->transfer != NULL;
+}
+
+//only moved objects, plus meshes and draws when the object set changed
+static bool upload(GPUScene *scene, SDL_GPUCopyPass *copypass)
+{
+	bool upload_draws = scene->draws_dirty;
+	Uint32 num_dirty = scene->dirty_end - scene->dirty_first;
+	Uint32 objects_size = sizeof(Matrix4x4) * num_dirty;
+	Uint32 meshes_size = upload_draws ? sizeof(GPUMeshInfo) * scene->num_meshes : 0;
+	Uint32 draws_size = upload_draws ? sizeof(GPUSceneDraw) * scene->num_draws : 0;
+	Uint32 size = objects_size + meshes_size + draws_size;
+	if(size == 0)
+	{
+		scene->draws_dirty = false;
+		return true;
+	}
+	if(!reserve_transfer(scene, size))
+	{
+		return false;
+	}
+
+	Uint8 *mapped = (Uint8*)SDL_MapGPUTransferBuffer(scene->device, scene->transfer, true);
+	if(mapped == NULL)
+	{
+		return false;
+	}
+	SDL_memcpy(mapped, &scene->objects[scene->dirty_first], objects_size);
+	GPUMeshInfo *meshes = (GPUMeshInfo*)(mapped + objects_size);
+	for(Uint32 i = 0; upload_draws && i < scene->num_meshes; i++)
+	{
+		const GPUSceneMesh *entry = &scene->meshes[i];
+		const AABB *bounds = &entry->mesh->bounds;
+		meshes[i] = (GPUMeshInfo){
+			.index_count = entry->index_count,
+			.first_index = entry->first_index,
+			.vertex_offset = entry->vertex_offset,
+			.layer = entry->mesh->diffuse_layer,
+			.center = { bounds->center.x, bounds->center.y, bounds->center.z, 1.0f },
+			.extent = { bounds->half_size.x, bounds->half_size.y, bounds->half_size.z, 0.0f }
+		};
+	}
+	if(draws_size != 0)
+	{
+		SDL_memcpy(mapped + objects_size + meshes_size, scene->draws, draws_size);
+	}
+	SDL_UnmapGPUTransferBuffer(scene->device, scene->transfer);
+
+	Uint32 offset = 0;
+	if(objects_size != 0)
+	{
+		SDL_UploadToGPUBuffer(copypass, &(SDL_GPUTransferBufferLocation){ scene->transfer, offset },
+								&(SDL_GPUBufferRegion){ scene->object_buffer, sizeof(Matrix4x4) * scene->dirty_first, objects_size }, false);
+		offset += objects_size;
+	}
+	if(meshes_size != 0)
+	{
+		SDL_UploadToGPUBuffer(copypass, &(SDL_GPUTransferBufferLocation){ scene->transfer, offset },
+								&(SDL_GPUBufferRegion){ scene->mesh_buffer, 0, meshes_size }, false);
+		offset += meshes_size;
+	}
+	if(draws_size != 0)
+	{
+		SDL_UploadToGPUBuffer(copypass, &(SDL_GPUTransferBufferLocation){ scene->transfer, offset },
+								&(SDL_GPUBufferRegion){ scene->draw_buffer, 0, draws_size }, false);
+	}
+	scene->dirty_first = scene->dirty_end = 0;
+	scene->draws_dirty = false;
+	return true;
+}
+
+bool GPUScene_Prepare(GPUScene *scene, SDL_GPUCommandBuffer *cmdbuf, Matrix4x4 viewproj)
+{
+	scene->viewproj = viewproj;
+	scene->stats = (GPUSceneStats){ .objects = scene->num_objects };
+	if(scene->draws_dirty && !build_draws(scene))
+	{
+		return false;
+	}
+	if(!reserve_gpu(scene))
+	{
+		return false;
+	}
+
+	SDL_GPUCopyPass *copypass = SDL_BeginGPUCopyPass(cmdbuf);
+	bool ok = true;
+	if(scene->geometry_dirty)
+	{
+		ok = build_geometry(scene, copypass);
+		scene->geometry_dirty = !ok;
+	}
+	ok = ok && upload(scene, copypass);
+	SDL_EndGPUCopyPass(copypass);
+	if(!ok || scene->num_draws == 0)
+	{
+		return ok;
+	}
+
+	//same planes as Culling_CullFrustum, one thread per draw
+	GPUCullInfo info = { .draw_count = scene->num_draws };
+	Frustum frustum = Culling_ExtractFrustum(viewproj);
+	SDL_memcpy(info.planes, frustum.planes, sizeof(info.planes));
+
+	SDL_GPUComputePass *computepass = SDL_BeginGPUComputePass(cmdbuf, NULL, 0,
+		&(SDL_GPUStorageBufferReadWriteBinding){ .buffer = scene->command_buffer, .cycle = true }, 1);
+	SDL_BindGPUComputePipeline(computepass, scene->cull_pipeline);
+	SDL_BindGPUComputeStorageBuffers(computepass, 0, (SDL_GPUBuffer*[]){
+										scene->object_buffer, scene->mesh_buffer, scene->draw_buffer }, 3);
+	SDL_PushGPUComputeUniformData(cmdbuf, 0, &info, sizeof(info));
+	SDL_DispatchGPUCompute(computepass, (scene->num_draws + GPUSCENE_GROUP - 1) / GPUSCENE_GROUP, 1, 1);
+	SDL_EndGPUComputePass(computepass);
+	scene->stats.draws = scene->num_draws;
+	return true;
+}
+
+void GPUScene_Draw(GPUScene *scene, SDL_GPURenderPass *renderpass, SDL_GPUCommandBuffer *cmdbuf,
+					SDL_GPUGraphicsPipeline *pipeline, SDL_GPUGraphicsPipeline *array_pipeline,
+					SDL_GPUSampler *sampler)
+{
+	if(scene->num_draws == 0 || scene->vertices == NULL || scene->command_buffer == NULL)
+	{
+		return;
+	}
+	SDL_GPUGraphicsPipeline *bound = NULL;
+	//culled draws are still in the range, with no instances
+	for(Uint32 b = 0; b < scene->num_batches; b++)
+	{
+		GPUSceneBatch *batch = &scene->batches[b];
+		SDL_GPUGraphicsPipeline *batch_pipeline = batch->array ? array_pipeline : pipeline;
+		if(batch->num_draws == 0 || batch_pipeline == NULL)
+		{
+			continue;
+		}
+		if(batch_pipeline != bound)
+		{
+			//at most twice per pass, plain and packed batches
+			SDL_BindGPUGraphicsPipeline(renderpass, batch_pipeline);
+			SDL_BindGPUVertexBuffers(renderpass, 0, &(SDL_GPUBufferBinding){ scene->vertices, 0 }, 1);
+			SDL_BindGPUIndexBuffer(renderpass, &(SDL_GPUBufferBinding){ scene->indices, 0 }, SDL_GPU_INDEXELEMENTSIZE_32BIT);
+			SDL_BindGPUVertexStorageBuffers(renderpass, 0, (SDL_GPUBuffer*[]){
+												scene->object_buffer, scene->mesh_buffer, scene->draw_buffer }, 3);
+			SDL_PushGPUVertexUniformData(cmdbuf, 0, &scene->viewproj, sizeof(Matrix4x4));
+			bound = batch_pipeline;
+		}
+		SDL_BindGPUFragmentSamplers(renderpass, 0, &(SDL_GPUTextureSamplerBinding){ batch->texture, sampler }, 1);
+		SDL_DrawGPUIndexedPrimitivesIndirect(renderpass, scene->command_buffer,
+												sizeof(SDL_GPUIndexedIndirectDrawCommand) * batch->first_draw,
+												batch->num_draws);
+		scene->stats.draw_calls++;
+	}
+}
+
+void GPUScene_Destroy(GPUScene *scene)
+{
+	if(scene->device == NULL)
+	{
+		return;
+	}
+	release_buffer(scene->device, &scene->vertices);
+	release_buffer(scene->device, &scene->indices);
+	release_buffer(scene->device, &scene->object_buffer);
+	release_buffer(scene->device, &scene->mesh_buffer);
+	release_buffer(scene->device, &scene->draw_buffer);
+	release_buffer(scene->device, &scene->command_buffer);
+	if(scene->transfer != NULL)
+	{
+		GPUMem_ReleaseTransferBuffer(scene->device, scene->transfer);
+	}
+	SDL_free(scene->objects);
+	SDL_free(scene->object_models);
+	SDL_free(scene->draws);
+	*scene = (GPUScene){ 0 };
+}
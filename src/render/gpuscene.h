@@ -0,0 +1,147 @@
+/*
+ * Copyright (C) 2025 Matheus Klein Schaefer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef GPUSCENE_H
+#define GPUSCENE_H
+
+#include <SDL3/SDL.h>
+#include <linmath.h>
+#include <assets.h>
+
+/*******************************************************************
+ * STRUCTURES AND ENUMS ********************************************
+ ******************************************************************/
+
+#define GPUSCENE_MAX_MODELS 32
+#define GPUSCENE_MAX_MESHES 256
+//one indirect call per texture or texture array, see GPUScene_Draw
+#define GPUSCENE_MAX_BATCHES 64
+
+//where a mesh ended up in the shared buffers
+typedef struct GPUSceneMesh
+{
+	const Mesh *mesh;
+	Uint32 first_index, index_count;
+	Sint32 vertex_offset;
+	Uint32 batch;
+} GPUSceneMesh;
+
+typedef struct GPUSceneModel
+{
+	const Model *model;
+	Uint32 first_mesh, num_meshes;
+} GPUSceneModel;
+
+//one mesh of one object, culled by one compute thread into the
+//indirect command at the same index; the vertex shader finds it again
+//through first_instance
+typedef struct GPUSceneDraw
+{
+	Uint32 object;
+	Uint32 mesh;
+} GPUSceneDraw;
+
+//draws sharing a texture, contiguous in the command buffer
+typedef struct GPUSceneBatch
+{
+	SDL_GPUTexture *texture;
+	bool array; //packed meshes, the layer comes with the draw
+	Uint32 first_draw, num_draws;
+} GPUSceneBatch;
+
+typedef struct GPUSceneStats
+{
+	Uint32 objects;
+	Uint32 draws; //meshes culled on the GPU
+	Uint32 draw_calls; //what the CPU issued
+} GPUSceneStats;
+
+//objects live on the GPU: only new or moved ones get uploaded, the
+//compute pass culls every draw and writes the indirect commands, and
+//the CPU cost of drawing is one call per batch whatever the object count
+typedef struct GPUScene
+{
+	SDL_GPUDevice *device;
+	SDL_GPUComputePipeline *cull_pipeline;
+
+	//shared geometry, copied from each mesh's own buffers on the GPU
+	GPUSceneModel models[GPUSCENE_MAX_MODELS];
+	Uint32 num_models;
+	GPUSceneMesh meshes[GPUSCENE_MAX_MESHES];
+	Uint32 num_meshes;
+	Uint32 num_vertices, num_indices;
+	SDL_GPUBuffer *vertices;
+	SDL_GPUBuffer *indices;
+	bool geometry_dirty;
+
+	//CPU side copies, the GPU buffers are sized for capacity
+	Matrix4x4 *objects;
+	Uint32 *object_models;
+	Uint32 num_objects, capacity;
+	Uint32 dirty_first, dirty_end; //object range to upload
+	GPUSceneDraw *draws;
+	Uint32 num_draws, draw_capacity;
+	GPUSceneBatch batches[GPUSCENE_MAX_BATCHES];
+	Uint32 num_batches;
+	bool draws_dirty;
+
+	//all three also read by the vertex shader
+	SDL_GPUBuffer *object_buffer;
+	SDL_GPUBuffer *mesh_buffer;
+	SDL_GPUBuffer *draw_buffer;
+	SDL_GPUBuffer *command_buffer;
+	Uint32 gpu_capacity, gpu_draw_capacity;
+	SDL_GPUTransferBuffer *transfer;
+	Uint32 transfer_size;
+
+	Matrix4x4 viewproj;
+	GPUSceneStats stats;
+} GPUScene;
+
+/*******************************************************************
+ * FUNCTIONS *******************************************************
+ ******************************************************************/
+
+bool GPUScene_Init(SDL_GPUDevice *device, GPUScene *scene, Uint32 capacity);
+
+//copies the model's meshes into the shared buffers on the next
+//GPUScene_Prepare, returns the model id or -1
+//meshes packed by TexArray_Pack batch by their array instead of their
+//own texture, so pack before adding
+int GPUScene_AddModel(GPUScene *scene, const Model *model);
+
+//returns the object index or -1
+int GPUScene_AddObject(GPUScene *scene, int model, Matrix4x4 transform);
+
+void GPUScene_SetTransform(GPUScene *scene, Uint32 object, Matrix4x4 transform);
+
+//drops every object, keeps the models
+void GPUScene_ClearObjects(GPUScene *scene);
+
+//uploads what changed and culls every draw against the frustum
+//goes on the command buffer before the render pass that draws
+bool GPUScene_Prepare(GPUScene *scene, SDL_GPUCommandBuffer *cmdbuf, Matrix4x4 viewproj);
+
+//both pipelines use shaders/gpuscene/scene.vert, the fragment shader
+//gets the batch texture in slot 0: a 2D texture for pipeline and a 2D
+//array for array_pipeline (NULL skips packed batches)
+void GPUScene_Draw(GPUScene *scene, SDL_GPURenderPass *renderpass, SDL_GPUCommandBuffer *cmdbuf,
+					SDL_GPUGraphicsPipeline *pipeline, SDL_GPUGraphicsPipeline *array_pipeline,
+					SDL_GPUSampler *sampler);
+
+void GPUScene_Destroy(GPUScene *scene);
+
+#endif
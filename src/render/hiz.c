@@ -0,0 +1,405 @@
+/*
+ * Copyright (C) 2025 Matheus Klein Schaefer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <SDL3/SDL.h>
+#include <shader.h>
+#include <pipelinecache.h>
+#include <texturepool.h>
+#include <hiz.h>
+#include <gpumem.h>
+
+#define HIZ_FORMAT SDL_GPU_TEXTUREFORMAT_R32_FLOAT
+//must match downsample.comp
+#define HIZ_GROUP 8
+
+typedef struct HiZInfo
+{
+	Sint32 source_width, source_height;
+	Sint32 level_width, level_height;
+} HiZInfo;
+
+/*******************************************************************
+ * PYRAMID *********************************************************
+ ******************************************************************/
+
+static void release_levels(HiZ *hiz)
+{
+	for(Uint32 i = 0; i < hiz->num_levels; i++)
+	{
+		GPUMem_ReleaseTexture(hiz->device, hiz->levels[i]);
+		hiz->levels[i] = NULL;
+	}
+	hiz->num_levels = 0;
+	hiz->alloc_width = hiz->alloc_height = 0;
+}
+
+//halves until both sides fit HIZ_READBACK_SIZE, never below 1
+static Uint32 level_sizes(Uint32 width, Uint32 height, Uint32 *widths, Uint32 *heights)
+{
+	Uint32 count = 0;
+	do
+	{
+		width = SDL_max(width / 2, 1u);
+		height = SDL_max(height / 2, 1u);
+		widths[count] = width;
+		heights[count] = height;
+		count++;
+	} while(count < HIZ_MAX_LEVELS && (width > HIZ_READBACK_SIZE || height > HIZ_READBACK_SIZE));
+	return count;
+}
+
+static bool alloc_levels(HiZ *hiz, Uint32 width, Uint32 height)
+{
+	if(width <= hiz->alloc_width && height <= hiz->alloc_height)
+	{
+		return true;
+	}
+	release_levels(hiz);
+
+	Uint32 widths[HIZ_MAX_LEVELS], heights[HIZ_MAX_LEVELS];
+	Uint32 count = level_sizes(width, height, widths, heights);
+	for(Uint32 i = 0; i < count; i++)
+	{
+		hiz->levels[i] = GPUMem_CreateTexture(hiz->device, &(SDL_GPUTextureCreateInfo){
+			.type = SDL_GPU_TEXTURETYPE_2D,
+			.format = HIZ_FORMAT,
+			.usage = SDL_GPU_TEXTUREUSAGE_SAMPLER | SDL_GPU_TEXTUREUSAGE_COMPUTE_STORAGE_WRITE,
+			.width = widths[i],
+			.height = heights[i],
+			.layer_count_or_depth = 1,
+			.num_levels = 1
+		});
+		if(hiz->levels[i] == NULL)
+		{
+			SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Graphics: Error: Failed to create Hi-Z level: %s", SDL_GetError());
+			hiz->num_levels = i;
+			release_levels(hiz);
+			return false;
+		}
+		hiz->num_levels = i + 1;
+	}
+	hiz->alloc_width = width;
+	hiz->alloc_height = height;
+	return true;
+}
+
+bool HiZ_Init(SDL_GPUDevice *device, HiZ *hiz)
+{
+	*hiz = (HiZ){ 0 };
+	hiz->device = device;
+	if(!SDL_GPUTextureSupportsFormat(device, HIZ_FORMAT, SDL_GPU_TEXTURETYPE_2D,
+										SDL_GPU_TEXTUREUSAGE_SAMPLER | SDL_GPU_TEXTUREUSAGE_COMPUTE_STORAGE_WRITE))
+	{
+		SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Hi-Z: R32 float storage textures not available.");
+		return false;
+	}
+	hiz->pipeline = ShaderLib_GetCompute("shaders/hiz/downsample.comp.spv");
+	hiz->sampler = PipelineCache_GetSampler(&(SDL_GPUSamplerCreateInfo){
+		.min_filter = SDL_GPU_FILTER_NEAREST,
+		.mag_filter = SDL_GPU_FILTER_NEAREST,
+		.mipmap_mode = SDL_GPU_SAMPLERMIPMAPMODE_NEAREST,
+		.address_mode_u = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE,
+		.address_mode_v = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE,
+		.address_mode_w = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE
+	});
+	hiz->depth = (float*)SDL_malloc(sizeof(float) * HIZ_READBACK_SIZE * HIZ_READBACK_SIZE);
+	if(hiz->pipeline == NULL || hiz->sampler == NULL || hiz->depth == NULL)
+	{
+		HiZ_Destroy(hiz);
+		return false;
+	}
+	for(int i = 0; i < HIZ_READBACKS; i++)
+	{
+		hiz->readbacks[i].buffer = GPUMem_CreateTransferBuffer(device, &(SDL_GPUTransferBufferCreateInfo){
+			.usage = SDL_GPU_TRANSFERBUFFERUSAGE_DOWNLOAD,
+			.size = sizeof(float) * HIZ_READBACK_SIZE * HIZ_READBACK_SIZE
+		});
+		if(hiz->readbacks[i].buffer == NULL)
+		{
+			SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Graphics: Error: Failed to create Hi-Z readback: %s", SDL_GetError());
+			HiZ_Destroy(hiz);
+			return false;
+		}
+	}
+	return true;
+}
+
+static void downsample_pass(RenderGraph *graph, SDL_GPUCommandBuffer *cmdbuf,
+							SDL_GPUComputePass *computepass, void *userdata)
+{
+	HiZPass *pass = (HiZPass*)userdata;
+	HiZ *hiz = pass->hiz;
+	Uint32 level = pass->level;
+	HiZInfo info = {
+		.source_width = (Sint32)((level == 0) ? hiz->source_width : hiz->level_width[level - 1]),
+		.source_height = (Sint32)((level == 0) ? hiz->source_height : hiz->level_height[level - 1]),
+		.level_width = (Sint32)hiz->level_width[level],
+		.level_height = (Sint32)hiz->level_height[level]
+	};
+	SDL_BindGPUComputePipeline(computepass, hiz->pipeline);
+	SDL_BindGPUComputeSamplers(computepass, 0, &(SDL_GPUTextureSamplerBinding){
+									RenderGraph_GetTexture(graph, pass->source), hiz->sampler }, 1);
+	SDL_PushGPUComputeUniformData(cmdbuf, 0, &info, sizeof(info));
+	SDL_DispatchGPUCompute(computepass, (hiz->level_width[level] + HIZ_GROUP - 1) / HIZ_GROUP,
+							(hiz->level_height[level] + HIZ_GROUP - 1) / HIZ_GROUP, 1);
+}
+
+void HiZ_AddPasses(HiZ *hiz, RenderGraph *graph, RGTexture depth,
+					Uint32 width, Uint32 height, Matrix4x4 viewproj)
+{
+	hiz->frame++;
+	hiz->built_levels = 0;
+	if(!alloc_levels(hiz, width, height))
+	{
+		return;
+	}
+	hiz->source_width = width;
+	hiz->source_height = height;
+	hiz->viewproj = viewproj;
+	Uint32 count = level_sizes(width, height, hiz->level_width, hiz->level_height);
+
+	//levels are imported, so the graph keeps the passes even though
+	//nothing in it reads the last one
+	RGTexture source = depth;
+	for(Uint32 i = 0; i < count; i++)
+	{
+		RGTexture level = RenderGraph_ImportTexture(graph, "hi-z", hiz->levels[i],
+													hiz->level_width[i], hiz->level_height[i]);
+		hiz->passes[i] = (HiZPass){ .hiz = hiz, .level = i, .source = source };
+		RGPass pass = RenderGraph_AddComputePass(graph, "hi-z", downsample_pass, &hiz->passes[i]);
+		RenderGraph_Read(graph, pass, source);
+		RenderGraph_WriteStorage(graph, pass, level);
+		source = level;
+	}
+	hiz->built_levels = count;
+}
+
+/*******************************************************************
+ * READBACK ********************************************************
+ ******************************************************************/
+
+//takes every finished download, keeps the newest
+static void collect_readbacks(HiZ *hiz)
+{
+	for(int i = 0; i < HIZ_READBACKS; i++)
+	{
+		HiZReadback *readback = &hiz->readbacks[i];
+		if(!readback->pending || !TexturePool_FrameDone(readback->submitted))
+		{
+			continue;
+		}
+		readback->pending = false;
+		if(readback->frame <= hiz->depth_info.frame)
+		{
+			continue;
+		}
+		float *mapped = (float*)SDL_MapGPUTransferBuffer(hiz->device, readback->buffer, false);
+		if(mapped == NULL)
+		{
+			continue;
+		}
+		SDL_memcpy(hiz->depth, mapped, sizeof(float) * readback->width * readback->height);
+		SDL_UnmapGPUTransferBuffer(hiz->device, readback->buffer);
+		hiz->depth_info = *readback;
+	}
+}
+
+void HiZ_Readback(HiZ *hiz, SDL_GPUCommandBuffer *cmdbuf)
+{
+	collect_readbacks(hiz);
+	if(hiz->built_levels == 0)
+	{
+		return;
+	}
+	HiZReadback *readback = NULL;
+	for(int i = 0; i < HIZ_READBACKS && readback == NULL; i++)
+	{
+		if(!hiz->readbacks[i].pending)
+		{
+			readback = &hiz->readbacks[i];
+		}
+	}
+	if(readback == NULL)
+	{
+		//GPU is behind, the last readback just gets a bit older
+		return;
+	}
+
+	Uint32 last = hiz->built_levels - 1;
+	readback->width = hiz->level_width[last];
+	readback->height = hiz->level_height[last];
+	readback->source_width = hiz->source_width;
+	readback->source_height = hiz->source_height;
+	readback->shift = hiz->built_levels;
+	readback->viewproj = hiz->viewproj;
+	readback->frame = hiz->frame;
+	readback->recorded = true;
+
+	SDL_GPUCopyPass *copypass = SDL_BeginGPUCopyPass(cmdbuf);
+	SDL_DownloadFromGPUTexture(copypass,
+		&(SDL_GPUTextureRegion){
+			.texture = hiz->levels[last],
+			.w = readback->width,
+			.h = readback->height,
+			.d = 1
+		},
+		&(SDL_GPUTextureTransferInfo){
+			.transfer_buffer = readback->buffer,
+			.offset = 0,
+			.pixels_per_row = readback->width,
+			.rows_per_layer = readback->height
+		}
+	);
+	SDL_EndGPUCopyPass(copypass);
+}
+
+bool HiZ_Submit(HiZ *hiz, SDL_GPUCommandBuffer *cmdbuf)
+{
+	Uint64 frame = TexturePool_GetFrame();
+	bool fenced = TexturePool_Submit(cmdbuf);
+	for(int i = 0; i < HIZ_READBACKS; i++)
+	{
+		HiZReadback *readback = &hiz->readbacks[i];
+		if(readback->recorded)
+		{
+			//without a fence there's no telling when it lands
+			readback->recorded = false;
+			readback->pending = fenced;
+			readback->submitted = frame;
+		}
+	}
+	return fenced;
+}
+
+/*******************************************************************
+ * OCCLUSION *******************************************************
+ ******************************************************************/
+
+static bool same_view(Matrix4x4 a, Matrix4x4 b)
+{
+	const float *x = &a.aa;
+	const float *y = &b.aa;
+	for(int i = 0; i < 16; i++)
+	{
+		if(SDL_fabsf(x[i] - y[i]) > HIZ_MAX_VIEW_CHANGE)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+//projects the box with the readback's view and compares its nearest
+//depth with the farthest occluder over the texels it covers
+static bool box_occluded(const HiZ *hiz, const CullingBounds *bounds, Uint32 index)
+{
+	const HiZReadback *info = &hiz->depth_info;
+	const Matrix4x4 *m = &info->viewproj;
+	float min_x = 1.0f, max_x = -1.0f, min_y = 1.0f, max_y = -1.0f;
+	float min_depth = 1.0f;
+	for(int c = 0; c < 8; c++)
+	{
+		float x = bounds->center_x[index] + ((c & 1) ? bounds->extent_x[index] : -bounds->extent_x[index]);
+		float y = bounds->center_y[index] + ((c & 2) ? bounds->extent_y[index] : -bounds->extent_y[index]);
+		float z = bounds->center_z[index] + ((c & 4) ? bounds->extent_z[index] : -bounds->extent_z[index]);
+		float clip_x = x * m->aa + y * m->ba + z * m->ca + m->da;
+		float clip_y = x * m->ab + y * m->bb + z * m->cb + m->db;
+		float clip_z = x * m->ac + y * m->bc + z * m->cc + m->dc;
+		float clip_w = x * m->ad + y * m->bd + z * m->cd + m->dd;
+		if(clip_w <= 1e-5f)
+		{
+			//reaches behind the camera
+			return false;
+		}
+		float inv_w = 1.0f / clip_w;
+		min_x = SDL_min(min_x, clip_x * inv_w);
+		max_x = SDL_max(max_x, clip_x * inv_w);
+		min_y = SDL_min(min_y, clip_y * inv_w);
+		max_y = SDL_max(max_y, clip_y * inv_w);
+		min_depth = SDL_min(min_depth, clip_z * inv_w);
+	}
+	if(min_x < -1.0f || max_x > 1.0f || min_y < -1.0f || max_y > 1.0f || min_depth <= 0.0f)
+	{
+		//partly outside the old view, there is no depth to test against
+		return false;
+	}
+
+	//to source pixels (y goes down in textures), then to level texels
+	float scale_x = (float)info->source_width / (float)(1u << info->shift);
+	float scale_y = (float)info->source_height / (float)(1u << info->shift);
+	int x0 = (int)((min_x * 0.5f + 0.5f) * scale_x);
+	int x1 = SDL_min((int)((max_x * 0.5f + 0.5f) * scale_x), (int)info->width - 1);
+	int y0 = (int)((0.5f - max_y * 0.5f) * scale_y);
+	int y1 = SDL_min((int)((0.5f - min_y * 0.5f) * scale_y), (int)info->height - 1);
+	for(int ty = y0; ty <= y1; ty++)
+	{
+		const float *row = &hiz->depth[ty * info->width];
+		for(int tx = x0; tx <= x1; tx++)
+		{
+			if(row[tx] + HIZ_DEPTH_BIAS >= min_depth)
+			{
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+size_t HiZ_CullOcclusion(HiZ *hiz, const CullingBounds *bounds,
+							Uint32 *visible, size_t count, Matrix4x4 viewproj)
+{
+	collect_readbacks(hiz);
+	hiz->stats = (HiZStats){ 0 };
+	//depth that is too old or from somewhere else would hide things that
+	//came into view since, so everything stays until a fresh one arrives
+	if(hiz->depth_info.frame == 0 || hiz->frame > hiz->depth_info.frame + HIZ_MAX_AGE ||
+		!same_view(hiz->depth_info.viewproj, viewproj))
+	{
+		return count;
+	}
+	hiz->stats.active = true;
+
+	size_t kept = 0;
+	for(size_t i = 0; i < count; i++)
+	{
+		if(!box_occluded(hiz, bounds, visible[i]))
+		{
+			visible[kept++] = visible[i];
+		}
+	}
+	hiz->stats.tested = (Uint32)count;
+	hiz->stats.occluded = (Uint32)(count - kept);
+	return kept;
+}
+
+void HiZ_Destroy(HiZ *hiz)
+{
+	if(hiz->device == NULL)
+	{
+		return;
+	}
+	for(int i = 0; i < HIZ_READBACKS; i++)
+	{
+		HiZReadback *readback = &hiz->readbacks[i];
+		if(readback->buffer != NULL)
+		{
+			GPUMem_ReleaseTransferBuffer(hiz->device, readback->buffer);
+		}
+	}
+	release_levels(hiz);
+	SDL_free(hiz->depth);
+	*hiz = (HiZ){ 0 };
+}
@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2025 Matheus Klein Schaefer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef HIZ_H
+#define HIZ_H
+
+#include <SDL3/SDL.h>
+#include <linmath.h>
+#include <culling.h>
+#include <rendergraph.h>
+
+/*******************************************************************
+ * STRUCTURES AND ENUMS ********************************************
+ ******************************************************************/
+
+//each level keeps the farthest depth of 2x2 texels of the one above,
+//starting from the scene depth; levels are separate textures so a pass
+//never reads and writes the same one
+#define HIZ_MAX_LEVELS 12
+//the pyramid is built down to the first level that fits this, which is
+//what goes back to the CPU
+#define HIZ_READBACK_SIZE 128
+//downloads in flight, each waits for its frame to finish
+#define HIZ_READBACKS 3
+//readbacks older than this (in frames) are not trusted
+#define HIZ_MAX_AGE 4
+//largest change of any view-projection element before the readback is
+//considered from another point of view and occlusion is skipped
+#define HIZ_MAX_VIEW_CHANGE 0.05f
+//boxes must be this much farther than the occluders to be culled
+#define HIZ_DEPTH_BIAS 0.0005f
+
+typedef struct HiZ HiZ;
+
+//userdata of one downsample pass
+typedef struct HiZPass
+{
+	HiZ *hiz;
+	Uint32 level;
+	RGTexture source;
+} HiZPass;
+
+typedef struct HiZReadback
+{
+	SDL_GPUTransferBuffer *buffer;
+	Uint64 submitted; //texture pool frame that carries the download
+	Uint32 width, height;
+	//drawn depth size, one texel covers 1 << shift of it per axis
+	Uint32 source_width, source_height;
+	Uint32 shift;
+	Matrix4x4 viewproj;
+	Uint64 frame;
+	bool recorded; //download added to the current command buffer
+	bool pending;
+} HiZReadback;
+
+typedef struct HiZStats
+{
+	Uint32 tested;
+	Uint32 occluded;
+	bool active; //false when no recent readback matched the view
+} HiZStats;
+
+struct HiZ
+{
+	SDL_GPUDevice *device;
+	SDL_GPUComputePipeline *pipeline;
+	SDL_GPUSampler *sampler;
+	//levels allocated for the largest depth seen, built for the drawn part
+	Uint32 alloc_width, alloc_height;
+	SDL_GPUTexture *levels[HIZ_MAX_LEVELS];
+	Uint32 num_levels;
+	//this frame's pyramid
+	Uint32 source_width, source_height;
+	Uint32 level_width[HIZ_MAX_LEVELS], level_height[HIZ_MAX_LEVELS];
+	Uint32 built_levels;
+	HiZPass passes[HIZ_MAX_LEVELS];
+	Matrix4x4 viewproj;
+	HiZReadback readbacks[HIZ_READBACKS];
+	//latest readback that made it back, in texel rows from the top
+	float *depth;
+	HiZReadback depth_info; //sizes, view and frame of what's in depth
+	Uint64 frame;
+	HiZStats stats;
+};
+
+/*******************************************************************
+ * FUNCTIONS *******************************************************
+ ******************************************************************/
+
+//false when compute or R32 float storage textures aren't available
+bool HiZ_Init(SDL_GPUDevice *device, HiZ *hiz);
+
+//builds this frame's pyramid from the top-left width x height of depth
+//(after the pre-pass or the main pass), viewproj is what drew it
+void HiZ_AddPasses(HiZ *hiz, RenderGraph *graph, RGTexture depth,
+					Uint32 width, Uint32 height, Matrix4x4 viewproj);
+
+//after RenderGraph_Execute: copies the smallest level to a free
+//readback buffer
+void HiZ_Readback(HiZ *hiz, SDL_GPUCommandBuffer *cmdbuf);
+
+//submits the command buffer through TexturePool_Submit, whose frame
+//fences tell when a readback arrived
+bool HiZ_Submit(HiZ *hiz, SDL_GPUCommandBuffer *cmdbuf);
+
+//removes occluded boxes from a visible list (from Culling_CullFrustum)
+//and returns the new count; tests against the latest finished readback,
+//a few frames old, so anything it can't be sure about stays visible
+size_t HiZ_CullOcclusion(HiZ *hiz, const CullingBounds *bounds,
+							Uint32 *visible, size_t count, Matrix4x4 viewproj);
+
+void HiZ_Destroy(HiZ *hiz);
+
+#endif
@@ -0,0 +1,165 @@
+/*
+ * Copyright (C) 2025 Matheus Klein Schaefer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <SDL3/SDL.h>
+#include <material.h>
+
+#define DEPTH_BITS 31
+#define DEPTH_MAX ((1u << DEPTH_BITS) - 1)
+
+//what Material_ApplyDesc changes, the rest comes from the screen
+typedef struct MaterialState
+{
+	const char *vertex_shader;
+	const char *fragment_shader;
+	SDL_GPUCullMode cull_mode;
+	SDL_GPUFrontFace front_face;
+	MaterialBlend blend;
+	bool depth_test;
+	bool depth_write;
+	SDL_GPUCompareOp compare_op;
+} MaterialState;
+
+static MaterialState states[MATERIAL_MAX_STATES];
+static Uint32 state_count = 0;
+static bool state_warned = false;
+
+static PipelineBlend pipeline_blend(MaterialBlend blend)
+{
+	switch(blend)
+	{
+		case MATERIAL_BLEND_ALPHA:
+			return PIPELINE_BLEND_ALPHA;
+		case MATERIAL_BLEND_ADD:
+			return PIPELINE_BLEND_ADD;
+		default:
+			return PIPELINE_BLEND_NONE;
+	}
+}
+
+void Material_ApplyRaster(const Material *material, PipelineDesc *desc)
+{
+	desc->cull_mode = material->cull_mode;
+	desc->front_face = material->front_face;
+}
+
+void Material_ApplyDesc(const Material *material, PipelineDesc *desc)
+{
+	if(material->vertex_shader != NULL)
+	{
+		desc->vertex_shader = material->vertex_shader;
+	}
+	if(material->fragment_shader != NULL)
+	{
+		desc->fragment_shader = material->fragment_shader;
+	}
+	Material_ApplyRaster(material, desc);
+	desc->blend = pipeline_blend(material->blend);
+	desc->depth_test = material->depth_test;
+	desc->depth_write = material->depth_write;
+	desc->compare_op = material->compare_op;
+}
+
+SDL_GPUGraphicsPipeline *Material_GetPipeline(const Material *material, const PipelineDesc *base)
+{
+	PipelineDesc desc = *base;
+	Material_ApplyDesc(material, &desc);
+	SDL_GPUGraphicsPipeline *pipeline = PipelineCache_Get(&desc);
+	if(pipeline == NULL)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Graphics: Error: Material %s has no pipeline.", material->name);
+	}
+	return pipeline;
+}
+
+/*******************************************************************
+ * SORTING *********************************************************
+ ******************************************************************/
+
+static bool same_shader(const char *a, const char *b)
+{
+	return (a == NULL || b == NULL) ? a == b : SDL_strcmp(a, b) == 0;
+}
+
+Uint32 Material_GetStateId(const Material *material)
+{
+	MaterialState state = {
+		.vertex_shader = material->vertex_shader,
+		.fragment_shader = material->fragment_shader,
+		.cull_mode = material->cull_mode,
+		.front_face = material->front_face,
+		.blend = material->blend,
+		.depth_test = material->depth_test,
+		.depth_write = material->depth_write,
+		.compare_op = material->compare_op
+	};
+	for(Uint32 i = 0; i < state_count; i++)
+	{
+		MaterialState *other = &states[i];
+		if(same_shader(other->vertex_shader, state.vertex_shader) &&
+			same_shader(other->fragment_shader, state.fragment_shader) &&
+			other->cull_mode == state.cull_mode && other->front_face == state.front_face &&
+			other->blend == state.blend && other->depth_test == state.depth_test &&
+			other->depth_write == state.depth_write && other->compare_op == state.compare_op)
+		{
+			return i;
+		}
+	}
+	if(state_count == MATERIAL_STATE_OVERFLOW)
+	{
+		if(!state_warned)
+		{
+			SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Graphics: Error: Out of material states, %s and later ones share a sort key.", material->name);
+			state_warned = true;
+		}
+		return MATERIAL_STATE_OVERFLOW;
+	}
+	states[state_count] = state;
+	return state_count++;
+}
+
+//textures only need to group, not order, 16 bits of the pointer do
+static Uint64 texture_bits(const Material *material)
+{
+	Uint64 texture = (material->num_textures > 0) ? (Uint64)(uintptr_t)material->textures[0] : 0;
+	texture >>= 4;
+	return (Uint64)((texture ^ (texture >> 16) ^ (texture >> 32)) & 0xFFFF);
+}
+
+Uint64 Material_SortKey(const Material *material, float depth)
+{
+	depth = SDL_clamp(depth, 0.0f, 1.0f);
+	//a float can't hold DEPTH_MAX, 1.0 would round up past it
+	Uint64 quantized = SDL_min((Uint64)((double)depth * (double)DEPTH_MAX), DEPTH_MAX);
+	Uint64 state = Material_GetStateId(material) & 0xFFFF;
+	if(material->blend != MATERIAL_BLEND_NONE)
+	{
+		return MATERIAL_KEY_BLENDED | ((DEPTH_MAX - quantized) << 32) | (state << 16) | texture_bits(material);
+	}
+	return (state << 47) | (texture_bits(material) << DEPTH_BITS) | quantized;
+}
+
+static int compare_draws(const void *a, const void *b)
+{
+	Uint64 x = ((const MaterialDraw*)a)->key;
+	Uint64 y = ((const MaterialDraw*)b)->key;
+	return (x > y) - (x < y);
+}
+
+void Material_SortDraws(MaterialDraw *draws, Uint32 count)
+{
+	SDL_qsort(draws, count, sizeof(MaterialDraw), compare_draws);
+}
@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2025 Matheus Klein Schaefer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef MATERIAL_H
+#define MATERIAL_H
+
+#include <SDL3/SDL.h>
+#include <assets.h>
+#include <pipelinecache.h>
+
+/*******************************************************************
+ * STRUCTURES AND ENUMS ********************************************
+ ******************************************************************/
+
+//distinct pipeline states that get their own sort key id, the last id
+//is kept for whatever doesn't fit
+#define MATERIAL_MAX_STATES 256
+#define MATERIAL_STATE_OVERFLOW (MATERIAL_MAX_STATES - 1)
+
+//sort keys put opaque draws first, grouped by pipeline state, then
+//texture, then front to back; blended draws go after, back to front
+#define MATERIAL_KEY_BLENDED (1ull << 63)
+
+typedef struct MaterialDraw
+{
+	Uint64 key;
+	Uint32 index; //whatever the caller draws from
+} MaterialDraw;
+
+/*******************************************************************
+ * FUNCTIONS *******************************************************
+ ******************************************************************/
+
+//the material's shaders (when set), raster, blend and depth state on
+//top of a screen's description, targets and vertex layout stay
+void Material_ApplyDesc(const Material *material, PipelineDesc *desc);
+
+//only cull mode and winding, for depth-only and debug variants
+void Material_ApplyRaster(const Material *material, PipelineDesc *desc);
+
+//cached like every other pipeline, don't release it
+SDL_GPUGraphicsPipeline *Material_GetPipeline(const Material *material, const PipelineDesc *base);
+
+//same id for materials that would build the same pipeline
+Uint32 Material_GetStateId(const Material *material);
+
+//depth is the distance to the camera over the far plane, 0 to 1
+Uint64 Material_SortKey(const Material *material, float depth);
+
+void Material_SortDraws(MaterialDraw *draws, Uint32 count);
+
+#endif
@@ -0,0 +1,378 @@
+/*
+ * Copyright (C) 2025 Matheus Klein Schaefer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <SDL3/SDL.h>
+#include <particles.h>
+#include <shader.h>
+#include <pipelinecache.h>
+#include <gpumem.h>
+
+//std140, pushed with each emit dispatch
+typedef struct EmitParams
+{
+	ParticleEmitter emitter;
+	Uint32 first;
+	Uint32 count;
+	Uint32 seed;
+	Uint32 capacity;
+	Uint32 clear;
+	Uint32 padding[3];
+} EmitParams;
+
+//std140, count.comp
+typedef struct CountParams
+{
+	Uint32 stage;
+	Uint32 emitted;
+	Uint32 capacity;
+	Uint32 clear;
+} CountParams;
+
+//std140, billboard.vert
+typedef struct DrawParams
+{
+	Matrix4x4 viewproj;
+	Vector4 right;
+	Vector4 up;
+	float fade_time;
+	float padding[3];
+} DrawParams;
+
+//byte offsets in the args buffer
+#define PARTICLES_DISPATCH_OFFSET 0
+#define PARTICLES_DRAW_OFFSET (sizeof(Uint32) * 3)
+
+static SDL_GPUBuffer *create_buffer(SDL_GPUDevice *device, SDL_GPUBufferUsageFlags usage, Uint32 size)
+{
+	return GPUMem_CreateBuffer(device, &(SDL_GPUBufferCreateInfo){ .usage = usage, .size = size });
+}
+
+static SDL_GPUTexture *create_depth(ParticleSystem *system, Uint32 width, Uint32 height)
+{
+	return GPUMem_CreateTexture(system->device, &(SDL_GPUTextureCreateInfo){
+		.type = SDL_GPU_TEXTURETYPE_2D,
+		.format = PARTICLES_DEPTH_FORMAT,
+		.usage = SDL_GPU_TEXTUREUSAGE_SAMPLER | SDL_GPU_TEXTUREUSAGE_COLOR_TARGET,
+		.width = width,
+		.height = height,
+		.layer_count_or_depth = 1,
+		.num_levels = 1
+	});
+}
+
+bool Particles_Init(SDL_GPUDevice *device, ParticleSystem *system, Uint32 capacity)
+{
+	*system = (ParticleSystem){ 0 };
+	system->device = device;
+	system->capacity = capacity;
+	system->gravity[1] = -9.8f;
+	system->drag = 0.1f;
+	system->restitution = 0.4f;
+	system->size = 0.05f;
+	system->collide = true;
+	system->clear = true;
+	system->draw_color = system->draw_depth = SDL_GPU_TEXTUREFORMAT_INVALID;
+	system->stats.capacity = capacity;
+
+	system->emit_pipeline = ShaderLib_GetCompute("shaders/particles/emit.comp.spv");
+	system->count_pipeline = ShaderLib_GetCompute("shaders/particles/count.comp.spv");
+	system->simulate_pipeline = ShaderLib_GetCompute("shaders/particles/simulate.comp.spv");
+	SDL_GPUBufferUsageFlags list_usage = SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_READ | SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_WRITE |
+											SDL_GPU_BUFFERUSAGE_GRAPHICS_STORAGE_READ;
+	for(int i = 0; i < 2; i++)
+	{
+		system->particles[i] = create_buffer(device, list_usage, sizeof(Particle) * capacity);
+	}
+	system->counters = create_buffer(device, SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_READ | SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_WRITE,
+										sizeof(Uint32) * 4);
+	system->args = create_buffer(device, SDL_GPU_BUFFERUSAGE_INDIRECT | SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_WRITE,
+									sizeof(Uint32) * 8);
+	if(capacity == 0 || system->emit_pipeline == NULL || system->count_pipeline == NULL || system->simulate_pipeline == NULL ||
+		system->particles[0] == NULL || system->particles[1] == NULL || system->counters == NULL || system->args == NULL)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Graphics: Error: Particles not available.");
+		Particles_Destroy(system);
+		return false;
+	}
+
+	//the simulation always samples something, a 1x1 texture stands in
+	//until the first copy; collisions are optional on their own
+	system->depth_sampler = PipelineCache_GetSampler(&(SDL_GPUSamplerCreateInfo){
+		.min_filter = SDL_GPU_FILTER_NEAREST,
+		.mag_filter = SDL_GPU_FILTER_NEAREST,
+		.mipmap_mode = SDL_GPU_SAMPLERMIPMAPMODE_NEAREST,
+		.address_mode_u = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE,
+		.address_mode_v = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE,
+		.address_mode_w = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE
+	});
+	bool depth_format = SDL_GPUTextureSupportsFormat(device, PARTICLES_DEPTH_FORMAT, SDL_GPU_TEXTURETYPE_2D,
+														SDL_GPU_TEXTUREUSAGE_SAMPLER | SDL_GPU_TEXTUREUSAGE_COLOR_TARGET);
+	system->depth_texture = depth_format ? create_depth(system, 1, 1) : NULL;
+	system->depth_pipeline = PipelineCache_Get(&(PipelineDesc){
+		.vertex_shader = "shaders/post/fullscreen.vert.spv",
+		.fragment_shader = "shaders/particles/depth.frag.spv",
+		.vertex_layout = PIPELINE_VERTEX_NONE,
+		.primitive_type = SDL_GPU_PRIMITIVETYPE_TRIANGLELIST,
+		.num_color_targets = 1,
+		.color_formats = { PARTICLES_DEPTH_FORMAT },
+		.cull_mode = SDL_GPU_CULLMODE_NONE,
+		.fill_mode = SDL_GPU_FILLMODE_FILL
+	});
+	if(system->depth_sampler == NULL || system->depth_texture == NULL || system->depth_pipeline == NULL)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Graphics: Error: Particle depth copy not available.");
+		Particles_Destroy(system);
+		return false;
+	}
+	system->depth_alloc_width = system->depth_alloc_height = 1;
+	system->depth_width = system->depth_height = 1;
+	return true;
+}
+
+void Particles_Emit(ParticleSystem *system, const ParticleEmitter *emitter, Uint32 count)
+{
+	if(count == 0)
+	{
+		return;
+	}
+	if(system->num_emits == PARTICLES_MAX_EMITS)
+	{
+		system->stats.dropped++;
+		return;
+	}
+	system->emits[system->num_emits] = *emitter;
+	system->emit_counts[system->num_emits] = count;
+	system->num_emits++;
+}
+
+void Particles_Clear(ParticleSystem *system)
+{
+	system->clear = true;
+}
+
+/*******************************************************************
+ * SIMULATION ******************************************************
+ ******************************************************************/
+
+static void count_pass(ParticleSystem *system, SDL_GPUCommandBuffer *cmdbuf, const CountParams *params)
+{
+	SDL_GPUComputePass *computepass = SDL_BeginGPUComputePass(cmdbuf, NULL, 0,
+		(SDL_GPUStorageBufferReadWriteBinding[]){
+			{ .buffer = system->counters, .cycle = false },
+			{ .buffer = system->args, .cycle = false }
+		}, 2);
+	SDL_BindGPUComputePipeline(computepass, system->count_pipeline);
+	SDL_PushGPUComputeUniformData(cmdbuf, 0, params, sizeof(*params));
+	SDL_DispatchGPUCompute(computepass, 1, 1, 1);
+	SDL_EndGPUComputePass(computepass);
+}
+
+bool Particles_Update(ParticleSystem *system, SDL_GPUCommandBuffer *cmdbuf, float delta)
+{
+	//every buffer here carries state from the last frame, none of them
+	//may be cycled
+	SDL_GPUBuffer *current = system->particles[system->current];
+	SDL_GPUBuffer *next = system->particles[system->current ^ 1];
+
+	Uint32 emitted = 0;
+	if(system->num_emits != 0)
+	{
+		SDL_GPUComputePass *computepass = SDL_BeginGPUComputePass(cmdbuf, NULL, 0,
+			&(SDL_GPUStorageBufferReadWriteBinding){ .buffer = current, .cycle = false }, 1);
+		SDL_BindGPUComputePipeline(computepass, system->emit_pipeline);
+		SDL_BindGPUComputeStorageBuffers(computepass, 0, &system->counters, 1);
+		for(Uint32 i = 0; i < system->num_emits; i++)
+		{
+			Uint32 count = SDL_min(system->emit_counts[i], system->capacity - SDL_min(emitted, system->capacity));
+			if(count == 0)
+			{
+				break;
+			}
+			EmitParams params = {
+				.emitter = system->emits[i],
+				.first = emitted,
+				.count = count,
+				.seed = ++system->seed,
+				.capacity = system->capacity,
+				.clear = system->clear
+			};
+			SDL_PushGPUComputeUniformData(cmdbuf, 0, &params, sizeof(params));
+			SDL_DispatchGPUCompute(computepass, (count + PARTICLES_GROUP - 1) / PARTICLES_GROUP, 1, 1);
+			emitted += count;
+		}
+		SDL_EndGPUComputePass(computepass);
+	}
+	system->stats.emitted = emitted;
+	system->num_emits = 0;
+
+	//alive count and dispatch size only exist on the GPU
+	count_pass(system, cmdbuf, &(CountParams){
+		.stage = 0,
+		.emitted = emitted,
+		.capacity = system->capacity,
+		.clear = system->clear
+	});
+	system->clear = false;
+
+	ParticleSimParams params = {
+		.depth_viewproj = system->depth_viewproj,
+		.depth_inverse = Matrix4x4_Inverse(system->depth_viewproj),
+		.gravity = { system->gravity[0], system->gravity[1], system->gravity[2] },
+		.delta = delta,
+		.depth_size = { (float)system->depth_width, (float)system->depth_height },
+		.drag = system->drag,
+		.restitution = system->restitution,
+		.collide = system->collide && system->depth_valid
+	};
+	system->stats.collisions = params.collide != 0;
+	SDL_GPUComputePass *computepass = SDL_BeginGPUComputePass(cmdbuf, NULL, 0,
+		(SDL_GPUStorageBufferReadWriteBinding[]){
+			{ .buffer = next, .cycle = false },
+			{ .buffer = system->counters, .cycle = false }
+		}, 2);
+	SDL_BindGPUComputePipeline(computepass, system->simulate_pipeline);
+	SDL_BindGPUComputeSamplers(computepass, 0, &(SDL_GPUTextureSamplerBinding){
+									system->depth_texture, system->depth_sampler }, 1);
+	SDL_BindGPUComputeStorageBuffers(computepass, 0, &current, 1);
+	SDL_PushGPUComputeUniformData(cmdbuf, 0, &params, sizeof(params));
+	SDL_DispatchGPUComputeIndirect(computepass, system->args, PARTICLES_DISPATCH_OFFSET);
+	SDL_EndGPUComputePass(computepass);
+
+	//survivors become the alive list and the draw's instance count
+	count_pass(system, cmdbuf, &(CountParams){ .stage = 1 });
+	system->current ^= 1;
+	system->updated = true;
+	return true;
+}
+
+/*******************************************************************
+ * DRAWING *********************************************************
+ ******************************************************************/
+
+void Particles_Draw(ParticleSystem *system, SDL_GPURenderPass *renderpass, SDL_GPUCommandBuffer *cmdbuf,
+					const Camera *camera, SDL_GPUTextureFormat color_format, SDL_GPUTextureFormat depth_format)
+{
+	if(!system->updated)
+	{
+		return;
+	}
+	if(system->draw_pipeline == NULL || system->draw_color != color_format || system->draw_depth != depth_format)
+	{
+		system->draw_pipeline = PipelineCache_Get(&(PipelineDesc){
+			.vertex_shader = "shaders/particles/billboard.vert.spv",
+			.fragment_shader = "shaders/particles/billboard.frag.spv",
+			.vertex_layout = PIPELINE_VERTEX_NONE,
+			.primitive_type = SDL_GPU_PRIMITIVETYPE_TRIANGLELIST,
+			.num_color_targets = 1,
+			.color_formats = { color_format },
+			.depth_format = depth_format,
+			.depth_test = true,
+			.depth_write = false,
+			.compare_op = SDL_GPU_COMPAREOP_LESS_OR_EQUAL,
+			.cull_mode = SDL_GPU_CULLMODE_NONE,
+			.fill_mode = SDL_GPU_FILLMODE_FILL,
+			.blend = PIPELINE_BLEND_ADD
+		});
+		system->draw_color = color_format;
+		system->draw_depth = depth_format;
+		if(system->draw_pipeline == NULL)
+		{
+			return;
+		}
+	}
+	DrawParams params = {
+		.viewproj = Matrix4x4_Mul(camera->view, camera->projection),
+		.right = { camera->right.x, camera->right.y, camera->right.z, system->size },
+		.up = { camera->up.x, camera->up.y, camera->up.z, 0.0f },
+		.fade_time = PARTICLES_FADE_TIME
+	};
+	SDL_BindGPUGraphicsPipeline(renderpass, system->draw_pipeline);
+	SDL_BindGPUVertexStorageBuffers(renderpass, 0, &system->particles[system->current], 1);
+	SDL_PushGPUVertexUniformData(cmdbuf, 0, &params, sizeof(params));
+	SDL_DrawGPUPrimitivesIndirect(renderpass, system->args, PARTICLES_DRAW_OFFSET, 1);
+}
+
+static void depth_pass(RenderGraph *graph, SDL_GPUCommandBuffer *cmdbuf,
+						SDL_GPURenderPass *renderpass, void *userdata)
+{
+	ParticleSystem *system = (ParticleSystem*)userdata;
+	SDL_BindGPUGraphicsPipeline(renderpass, system->depth_pipeline);
+	SDL_SetGPUViewport(renderpass, &(SDL_GPUViewport){
+		0.0f, 0.0f, (float)system->depth_width, (float)system->depth_height, 0.0f, 1.0f });
+	SDL_BindGPUFragmentSamplers(renderpass, 0, &(SDL_GPUTextureSamplerBinding){
+									RenderGraph_GetTexture(graph, system->depth_source), system->depth_sampler }, 1);
+	SDL_DrawGPUPrimitives(renderpass, 3, 1, 0, 0);
+}
+
+void Particles_AddDepthPass(ParticleSystem *system, RenderGraph *graph, RGTexture depth,
+							Uint32 width, Uint32 height, Matrix4x4 viewproj)
+{
+	if(!system->collide || width == 0 || height == 0)
+	{
+		//a later copy brings collisions back, not an old one
+		system->depth_valid = false;
+		return;
+	}
+	//grows only, dynamic resolution changes the drawn part every frame
+	if(width > system->depth_alloc_width || height > system->depth_alloc_height)
+	{
+		Uint32 alloc_width = SDL_max(width, system->depth_alloc_width);
+		Uint32 alloc_height = SDL_max(height, system->depth_alloc_height);
+		SDL_GPUTexture *texture = create_depth(system, alloc_width, alloc_height);
+		if(texture == NULL)
+		{
+			return;
+		}
+		GPUMem_ReleaseTexture(system->device, system->depth_texture);
+		system->depth_texture = texture;
+		system->depth_alloc_width = alloc_width;
+		system->depth_alloc_height = alloc_height;
+	}
+	system->depth_width = width;
+	system->depth_height = height;
+	system->depth_viewproj = viewproj;
+	system->depth_source = depth;
+	system->depth_valid = true;
+
+	//imported, so the graph keeps the pass although nothing reads it
+	RGTexture copy = RenderGraph_ImportTexture(graph, "particle depth", system->depth_texture,
+												system->depth_alloc_width, system->depth_alloc_height);
+	RGPass pass = RenderGraph_AddPass(graph, "particle depth", depth_pass, system);
+	RenderGraph_Read(graph, pass, depth);
+	RenderGraph_WriteColor(graph, pass, copy, NULL);
+}
+
+void Particles_Destroy(ParticleSystem *system)
+{
+	if(system->device == NULL)
+	{
+		return;
+	}
+	SDL_GPUBuffer *buffers[] = { system->particles[0], system->particles[1], system->counters, system->args };
+	for(size_t i = 0; i < SDL_arraysize(buffers); i++)
+	{
+		if(buffers[i] != NULL)
+		{
+			GPUMem_ReleaseBuffer(system->device, buffers[i]);
+		}
+	}
+	if(system->depth_texture != NULL)
+	{
+		GPUMem_ReleaseTexture(system->device, system->depth_texture);
+	}
+	*system = (ParticleSystem){ 0 };
+}
@@ -0,0 +1,165 @@
+/*
+ * Copyright (C) 2025 Matheus Klein Schaefer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef PARTICLES_H
+#define PARTICLES_H
+
+#include <SDL3/SDL.h>
+#include <linmath.h>
+#include <assets.h>
+#include <rendergraph.h>
+
+/*******************************************************************
+ * STRUCTURES AND ENUMS ********************************************
+ ******************************************************************/
+
+//threads per group of every particle pass, must match particles.glsl
+#define PARTICLES_GROUP 256
+//Particles_Emit calls kept per frame, one emit dispatch each
+#define PARTICLES_MAX_EMITS 16
+//the last seconds of a particle's life fade its alpha to nothing
+#define PARTICLES_FADE_TIME 0.5f
+//the scene depth copy for collisions, only sampled by the simulation
+#define PARTICLES_DEPTH_FORMAT SDL_GPU_TEXTUREFORMAT_R32_FLOAT
+
+//same layout as Particle in particles.glsl (std430), 32 bytes so a
+//million of them read and written once per frame stays cheap
+typedef struct Particle
+{
+	float position[3];
+	float life; //seconds left
+	float velocity[3];
+	Uint32 color; //rgba8, red in the low byte
+} Particle;
+
+//std140, pushed with each emit dispatch
+typedef struct ParticleEmitter
+{
+	Vector3 position;
+	float radius; //spawned anywhere inside this sphere
+	Vector3 velocity;
+	float spread; //random extra velocity, up to this length
+	float life_min, life_max; //seconds
+	Uint32 color;
+	float padding;
+} ParticleEmitter;
+
+//std140, pushed to the simulation
+typedef struct ParticleSimParams
+{
+	Matrix4x4 depth_viewproj; //what drew the copied depth
+	Matrix4x4 depth_inverse;
+	float gravity[3];
+	float delta; //seconds
+	float depth_size[2]; //drawn part of depth_texture
+	float drag;
+	float restitution;
+	Uint32 collide;
+	Uint32 padding[3];
+} ParticleSimParams;
+
+typedef struct ParticleStats
+{
+	Uint32 capacity;
+	Uint32 emitted; //requested last update
+	Uint32 dropped; //emits over PARTICLES_MAX_EMITS
+	bool collisions; //a depth copy was available to the last update
+} ParticleStats;
+
+//particles only live on the GPU: emitting appends to the alive list,
+//the simulation moves every alive particle and appends the survivors to
+//the other list, and the draw takes its instance count from what the
+//simulation left in a buffer, so the CPU never knows how many are alive
+typedef struct ParticleSystem
+{
+	SDL_GPUDevice *device;
+	SDL_GPUComputePipeline *emit_pipeline;
+	SDL_GPUComputePipeline *count_pipeline;
+	SDL_GPUComputePipeline *simulate_pipeline;
+	Uint32 capacity;
+
+	//ping-pong lists, current holds the alive particles from 0
+	SDL_GPUBuffer *particles[2];
+	Uint32 current;
+	//alive, next alive
+	SDL_GPUBuffer *counters;
+	//simulation dispatch, then the billboard draw
+	SDL_GPUBuffer *args;
+
+	ParticleEmitter emits[PARTICLES_MAX_EMITS];
+	Uint32 emit_counts[PARTICLES_MAX_EMITS];
+	Uint32 num_emits;
+	Uint32 seed;
+	//the counters start out undefined, so the first update clears too
+	bool clear;
+	bool updated; //the draw arguments exist
+
+	float gravity[3];
+	float drag;
+	float restitution;
+	float size; //billboard side in world units
+
+	//last frame's scene depth, copied by Particles_AddDepthPass, so the
+	//simulation at the start of the next frame can collide against it
+	bool collide;
+	SDL_GPUTexture *depth_texture;
+	Uint32 depth_alloc_width, depth_alloc_height;
+	Uint32 depth_width, depth_height;
+	Matrix4x4 depth_viewproj;
+	bool depth_valid;
+	RGTexture depth_source; //graph handle, only valid during the pass
+	SDL_GPUSampler *depth_sampler;
+	SDL_GPUGraphicsPipeline *depth_pipeline;
+
+	//the last pipeline asked for by Particles_Draw
+	SDL_GPUGraphicsPipeline *draw_pipeline;
+	SDL_GPUTextureFormat draw_color, draw_depth;
+
+	ParticleStats stats;
+} ParticleSystem;
+
+/*******************************************************************
+ * FUNCTIONS *******************************************************
+ ******************************************************************/
+
+//false without compute support; capacity is fixed, emits past it are
+//dropped on the GPU
+bool Particles_Init(SDL_GPUDevice *device, ParticleSystem *system, Uint32 capacity);
+
+//queues count new particles for the next update
+void Particles_Emit(ParticleSystem *system, const ParticleEmitter *emitter, Uint32 count);
+
+//drops every particle on the next update
+void Particles_Clear(ParticleSystem *system);
+
+//records emit, simulate and compact, before the render passes that
+//draw them; outside the render graph since it only writes buffers
+bool Particles_Update(ParticleSystem *system, SDL_GPUCommandBuffer *cmdbuf, float delta);
+
+//one indirect draw of camera-facing quads, additive and depth tested
+//without writing depth; nothing until the first update
+void Particles_Draw(ParticleSystem *system, SDL_GPURenderPass *renderpass, SDL_GPUCommandBuffer *cmdbuf,
+					const Camera *camera, SDL_GPUTextureFormat color_format, SDL_GPUTextureFormat depth_format);
+
+//copies the top-left width x height of depth (after the passes drawing
+//it, viewproj is what drew it) for the next update's collisions
+void Particles_AddDepthPass(ParticleSystem *system, RenderGraph *graph, RGTexture depth,
+							Uint32 width, Uint32 height, Matrix4x4 viewproj);
+
+void Particles_Destroy(ParticleSystem *system);
+
+#endif
@@ -0,0 +1,429 @@
+/*
+ * Copyright (C) 2025 Matheus Klein Schaefer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <SDL3/SDL.h>
+#include <hashtable.h>
+#include <assets.h>
+#include <shader.h>
+#include <pipelinecache.h>
+
+#define PIPELINECACHE_MAX_WORKERS 4
+
+//value stored on the hashtables
+//ready is false while some thread is still creating the object
+typedef struct CacheEntry
+{
+	void *object;
+	bool ready;
+} CacheEntry;
+
+typedef struct PrewarmJob
+{
+	PipelineDesc *descs;
+	size_t count;
+	SDL_AtomicInt next;
+} PrewarmJob;
+
+static SDL_GPUDevice *cache_device = NULL;
+static Hashtable *pipelines = NULL;
+static Hashtable *samplers = NULL;
+static SDL_Mutex *cache_lock = NULL;
+static SDL_Condition *cache_ready = NULL;
+static Uint32 cache_hits = 0;
+static Uint32 cache_misses = 0;
+
+static PrewarmJob prewarm_job;
+static SDL_Thread *prewarm_threads[PIPELINECACHE_MAX_WORKERS];
+static int prewarm_thread_count = 0;
+
+/*******************************************************************
+ * KEYS ************************************************************
+ ******************************************************************/
+
+//descriptors become strings, the hashtable takes care of the hashing
+static void pipeline_key(const PipelineDesc *desc, char *key, size_t len)
+{
+	int written = SDL_snprintf(key, len, "%s|%s|%d|%d|%d,%d,%d,%d,%d,%d,%d,%d|%d",
+								desc->vertex_shader, desc->fragment_shader,
+								(int)desc->vertex_layout, (int)desc->primitive_type,
+								(int)desc->depth_format, desc->depth_test, desc->depth_write,
+								(int)desc->compare_op, (int)desc->cull_mode, (int)desc->front_face,
+								(int)desc->fill_mode, (int)desc->blend, (int)desc->num_color_targets);
+	for(Uint32 i = 0; i < desc->num_color_targets && i < PIPELINE_MAX_COLOR_TARGETS; i++)
+	{
+		if(written < 0 || (size_t)written >= len)
+		{
+			break;
+		}
+		written += SDL_snprintf(key + written, len - written, ",%d", (int)desc->color_formats[i]);
+	}
+}
+
+static void sampler_key(const SDL_GPUSamplerCreateInfo *info, char *key, size_t len)
+{
+	SDL_snprintf(key, len, "%d,%d,%d,%d,%d,%d|%g,%g,%g,%g|%d,%d,%d",
+					(int)info->min_filter, (int)info->mag_filter, (int)info->mipmap_mode,
+					(int)info->address_mode_u, (int)info->address_mode_v, (int)info->address_mode_w,
+					info->mip_lod_bias, info->max_anisotropy, info->min_lod, info->max_lod,
+					(int)info->compare_op, info->enable_anisotropy, info->enable_compare);
+}
+
+/*******************************************************************
+ * CREATION ********************************************************
+ ******************************************************************/
+
+static SDL_GPUGraphicsPipeline *build_pipeline(const PipelineDesc *desc)
+{
+	//shaders belong to the shader library
+	SDL_GPUShader *vs = ShaderLib_Get(desc->vertex_shader, SDL_GPU_SHADERSTAGE_VERTEX);
+	SDL_GPUShader *fs = ShaderLib_Get(desc->fragment_shader, SDL_GPU_SHADERSTAGE_FRAGMENT);
+	if(vs == NULL || fs == NULL)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Graphics: Error: Failed to load shaders %s / %s.",
+						desc->vertex_shader, desc->fragment_shader);
+		return NULL;
+	}
+
+	//mesh and quad layouts are position + uv, only the pitch changes;
+	//debug lines carry a packed color instead of the uv
+	Uint32 pitch = sizeof(float) * 5;
+	if(desc->vertex_layout == PIPELINE_VERTEX_MESH)
+	{
+		pitch = sizeof(Vertex3D);
+	}
+	else if(desc->vertex_layout == PIPELINE_VERTEX_LINE)
+	{
+		pitch = sizeof(float) * 3 + sizeof(Uint32);
+	}
+	SDL_GPUVertexBufferDescription vertex_buffer = {
+		.slot = 0,
+		.input_rate = SDL_GPU_VERTEXINPUTRATE_VERTEX,
+		.instance_step_rate = 0,
+		.pitch = pitch
+	};
+	SDL_GPUVertexAttribute vertex_attributes[2] = {{
+		//position
+		.buffer_slot = 0,
+		.format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT3,
+		.location = 0,
+		.offset = 0
+	}, {
+		//uv, or color
+		.buffer_slot = 0,
+		.format = (desc->vertex_layout == PIPELINE_VERTEX_LINE) ? SDL_GPU_VERTEXELEMENTFORMAT_UBYTE4_NORM : SDL_GPU_VERTEXELEMENTFORMAT_FLOAT2,
+		.location = 1,
+		.offset = (sizeof(float) * 3)
+	}};
+
+	SDL_GPUColorTargetDescription color_targets[PIPELINE_MAX_COLOR_TARGETS] = { 0 };
+	Uint32 num_color_targets = SDL_min(desc->num_color_targets, PIPELINE_MAX_COLOR_TARGETS);
+	for(Uint32 i = 0; i < num_color_targets; i++)
+	{
+		color_targets[i].format = desc->color_formats[i];
+		if(desc->blend == PIPELINE_BLEND_ALPHA)
+		{
+			color_targets[i].blend_state = (SDL_GPUColorTargetBlendState){
+				.enable_blend = true,
+				.color_blend_op = SDL_GPU_BLENDOP_ADD,
+				.alpha_blend_op = SDL_GPU_BLENDOP_ADD,
+				.src_color_blendfactor = SDL_GPU_BLENDFACTOR_SRC_ALPHA,
+				.dst_color_blendfactor = SDL_GPU_BLENDFACTOR_ONE_MINUS_SRC_ALPHA,
+				.src_alpha_blendfactor = SDL_GPU_BLENDFACTOR_SRC_ALPHA,
+				.dst_alpha_blendfactor = SDL_GPU_BLENDFACTOR_ONE_MINUS_SRC_ALPHA
+			};
+		}
+		else if(desc->blend == PIPELINE_BLEND_ADD)
+		{
+			color_targets[i].blend_state = (SDL_GPUColorTargetBlendState){
+				.enable_blend = true,
+				.color_blend_op = SDL_GPU_BLENDOP_ADD,
+				.alpha_blend_op = SDL_GPU_BLENDOP_ADD,
+				.src_color_blendfactor = SDL_GPU_BLENDFACTOR_ONE,
+				.dst_color_blendfactor = SDL_GPU_BLENDFACTOR_ONE,
+				.src_alpha_blendfactor = SDL_GPU_BLENDFACTOR_ONE,
+				.dst_alpha_blendfactor = SDL_GPU_BLENDFACTOR_ONE
+			};
+		}
+	}
+
+	bool has_depth = desc->depth_format != SDL_GPU_TEXTUREFORMAT_INVALID;
+	SDL_GPUGraphicsPipelineCreateInfo pipeline_createinfo = { 0 };
+	pipeline_createinfo = (SDL_GPUGraphicsPipelineCreateInfo)
+	{
+		.target_info =
+		{
+			.num_color_targets = num_color_targets,
+			.color_target_descriptions = color_targets,
+			.has_depth_stencil_target = has_depth,
+			.depth_stencil_format = desc->depth_format
+		},
+		.depth_stencil_state = (SDL_GPUDepthStencilState){
+			.enable_depth_test = has_depth && desc->depth_test,
+			.enable_depth_write = has_depth && desc->depth_write,
+			.enable_stencil_test = false,
+			.compare_op = (desc->compare_op == SDL_GPU_COMPAREOP_INVALID) ? SDL_GPU_COMPAREOP_LESS : desc->compare_op,
+			.write_mask = 0xFF
+		},
+		.rasterizer_state = (SDL_GPURasterizerState){
+			.cull_mode = desc->cull_mode,
+			.fill_mode = desc->fill_mode,
+			.front_face = desc->front_face
+		},
+		.vertex_input_state = (SDL_GPUVertexInputState){
+			.num_vertex_buffers = (desc->vertex_layout == PIPELINE_VERTEX_NONE) ? 0 : 1,
+			.vertex_buffer_descriptions = &vertex_buffer,
+			.num_vertex_attributes = (desc->vertex_layout == PIPELINE_VERTEX_NONE) ? 0 : 2,
+			.vertex_attributes = vertex_attributes
+		},
+		.primitive_type = desc->primitive_type,
+		.vertex_shader = vs,
+		.fragment_shader = fs
+	};
+	SDL_GPUGraphicsPipeline *pipeline = SDL_CreateGPUGraphicsPipeline(cache_device, &pipeline_createinfo);
+	if(pipeline == NULL)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Graphics: Error: Failed to create pipeline %s / %s: %s",
+						desc->vertex_shader, desc->fragment_shader, SDL_GetError());
+	}
+	return pipeline;
+}
+
+//shared lookup, the creator runs outside of the lock so other
+//threads can keep compiling different pipelines meanwhile
+static void *cache_get(Hashtable *table, const char *key,
+						void *(*create)(const void *), const void *desc)
+{
+	SDL_LockMutex(cache_lock);
+	CacheEntry *entry = (CacheEntry*)HashtableFind(table, key);
+	if(entry == NULL)
+	{
+		entry = (CacheEntry*)SDL_calloc(1, sizeof(CacheEntry));
+		if(entry == NULL || !HashtableInsert(table, key, entry))
+		{
+			SDL_UnlockMutex(cache_lock);
+			SDL_free(entry);
+			return create(desc);
+		}
+		cache_misses++;
+		SDL_UnlockMutex(cache_lock);
+
+		void *object = create(desc);
+
+		SDL_LockMutex(cache_lock);
+		entry->object = object;
+		entry->ready = true;
+		SDL_BroadcastCondition(cache_ready);
+		SDL_UnlockMutex(cache_lock);
+		return object;
+	}
+
+	cache_hits++;
+	while(!entry->ready)
+	{
+		SDL_WaitCondition(cache_ready, cache_lock);
+	}
+	void *object = entry->object;
+	SDL_UnlockMutex(cache_lock);
+	return object;
+}
+
+static void *create_pipeline(const void *desc)
+{
+	return build_pipeline((const PipelineDesc*)desc);
+}
+
+static void *create_sampler(const void *info)
+{
+	return SDL_CreateGPUSampler(cache_device, (const SDL_GPUSamplerCreateInfo*)info);
+}
+
+/*******************************************************************
+ * PUBLIC **********************************************************
+ ******************************************************************/
+
+bool PipelineCache_Init(SDL_GPUDevice *device)
+{
+	if(device == NULL)
+	{
+		return false;
+	}
+	if(cache_device != NULL)
+	{
+		//already up
+		return true;
+	}
+	pipelines = HashtableInit();
+	samplers = HashtableInit();
+	cache_lock = SDL_CreateMutex();
+	cache_ready = SDL_CreateCondition();
+	if(pipelines == NULL || samplers == NULL || cache_lock == NULL || cache_ready == NULL)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Graphics: Error: Failed to init pipeline cache.");
+		PipelineCache_Destroy();
+		return false;
+	}
+	cache_device = device;
+	cache_hits = cache_misses = 0;
+	return true;
+}
+
+SDL_GPUGraphicsPipeline *PipelineCache_Get(const PipelineDesc *desc)
+{
+	if(cache_device == NULL || desc == NULL)
+	{
+		return NULL;
+	}
+	char key[1024];
+	pipeline_key(desc, key, sizeof(key));
+	return (SDL_GPUGraphicsPipeline*)cache_get(pipelines, key, create_pipeline, desc);
+}
+
+SDL_GPUSampler *PipelineCache_GetSampler(const SDL_GPUSamplerCreateInfo *info)
+{
+	if(cache_device == NULL || info == NULL)
+	{
+		return NULL;
+	}
+	char key[256];
+	sampler_key(info, key, sizeof(key));
+	return (SDL_GPUSampler*)cache_get(samplers, key, create_sampler, info);
+}
+
+static int prewarm_worker(void *data)
+{
+	PrewarmJob *job = (PrewarmJob*)data;
+	for(;;)
+	{
+		int index = SDL_AddAtomicInt(&job->next, 1);
+		if(index < 0 || (size_t)index >= job->count)
+		{
+			break;
+		}
+		PipelineCache_Get(&job->descs[index]);
+	}
+	return 0;
+}
+
+void PipelineCache_Prewarm(const PipelineDesc *descs, size_t count)
+{
+	if(cache_device == NULL || descs == NULL || count == 0)
+	{
+		return;
+	}
+	//one batch at a time is enough for startup
+	PipelineCache_WaitPrewarm();
+
+	prewarm_job.descs = (PipelineDesc*)SDL_malloc(sizeof(PipelineDesc) * count);
+	if(prewarm_job.descs == NULL)
+	{
+		return;
+	}
+	SDL_memcpy(prewarm_job.descs, descs, sizeof(PipelineDesc) * count);
+	prewarm_job.count = count;
+	SDL_SetAtomicInt(&prewarm_job.next, 0);
+
+	//leave one core for the main thread
+	int workers = SDL_GetNumLogicalCPUCores() - 1;
+	workers = SDL_clamp(workers, 1, PIPELINECACHE_MAX_WORKERS);
+	workers = SDL_min(workers, (int)count);
+	for(int i = 0; i < workers; i++)
+	{
+		prewarm_threads[prewarm_thread_count] = SDL_CreateThread(prewarm_worker, "pipeline prewarm", &prewarm_job);
+		if(prewarm_threads[prewarm_thread_count] != NULL)
+		{
+			prewarm_thread_count++;
+		}
+	}
+	if(prewarm_thread_count == 0)
+	{
+		//no threads, do it here
+		prewarm_worker(&prewarm_job);
+	}
+	SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Graphics: prewarming %zu pipelines on %d threads.", count, prewarm_thread_count);
+}
+
+void PipelineCache_WaitPrewarm()
+{
+	for(int i = 0; i < prewarm_thread_count; i++)
+	{
+		SDL_WaitThread(prewarm_threads[i], NULL);
+		prewarm_threads[i] = NULL;
+	}
+	prewarm_thread_count = 0;
+	SDL_free(prewarm_job.descs);
+	prewarm_job.descs = NULL;
+	prewarm_job.count = 0;
+}
+
+void PipelineCache_LogStats()
+{
+	SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Graphics: pipeline cache: %u created, %u reused.",
+				cache_misses, cache_hits);
+}
+
+static void release_entries(Hashtable *table, bool is_pipeline)
+{
+	for(int i = 0; i < HASH_SIZE; i++)
+	{
+		for(HashtableBucket *node = table->buckets[i]; node != NULL; node = node->next)
+		{
+			CacheEntry *entry = (CacheEntry*)node->value;
+			if(entry->object != NULL)
+			{
+				if(is_pipeline)
+				{
+					SDL_ReleaseGPUGraphicsPipeline(cache_device, (SDL_GPUGraphicsPipeline*)entry->object);
+				}
+				else
+				{
+					SDL_ReleaseGPUSampler(cache_device, (SDL_GPUSampler*)entry->object);
+				}
+			}
+			SDL_free(entry);
+		}
+	}
+	HashtableDestroy(table);
+}
+
+void PipelineCache_Destroy()
+{
+	PipelineCache_WaitPrewarm();
+	if(cache_device != NULL)
+	{
+		PipelineCache_LogStats();
+	}
+	if(pipelines != NULL)
+	{
+		release_entries(pipelines, true);
+		pipelines = NULL;
+	}
+	if(samplers != NULL)
+	{
+		release_entries(samplers, false);
+		samplers = NULL;
+	}
+	if(cache_ready != NULL)
+	{
+		SDL_DestroyCondition(cache_ready);
+		cache_ready = NULL;
+	}
+	if(cache_lock != NULL)
+	{
+		SDL_DestroyMutex(cache_lock);
+		cache_lock = NULL;
+	}
+	cache_device = NULL;
+}
@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2025 Matheus Klein Schaefer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef PIPELINECACHE_H
+#define PIPELINECACHE_H
+
+#include <SDL3/SDL.h>
+
+/*******************************************************************
+ * STRUCTURES AND ENUMS ********************************************
+ ******************************************************************/
+
+#define PIPELINE_MAX_COLOR_TARGETS 4
+
+//vertex layouts used by the project
+typedef enum PipelineVertexLayout
+{
+	PIPELINE_VERTEX_NONE = 0, //generated in the vertex shader
+	PIPELINE_VERTEX_MESH, //Vertex3D: position + uv
+	PIPELINE_VERTEX_QUAD, //EffectVertex and the splash quad: position + uv
+	PIPELINE_VERTEX_LINE //DebugVertex: position + 8 bit rgba
+} PipelineVertexLayout;
+
+typedef enum PipelineBlend
+{
+	PIPELINE_BLEND_NONE = 0,
+	PIPELINE_BLEND_ALPHA,
+	PIPELINE_BLEND_ADD //counters, like the overdraw view
+} PipelineBlend;
+
+//everything that makes a pipeline different from another one
+//shaders are referenced by path, so the same description gives the
+//same pipeline no matter which screen asks for it
+typedef struct PipelineDesc
+{
+	const char *vertex_shader; //shader library names
+	const char *fragment_shader;
+	PipelineVertexLayout vertex_layout;
+	SDL_GPUPrimitiveType primitive_type;
+	Uint32 num_color_targets;
+	SDL_GPUTextureFormat color_formats[PIPELINE_MAX_COLOR_TARGETS];
+	SDL_GPUTextureFormat depth_format; //INVALID means no depth target
+	bool depth_test;
+	bool depth_write;
+	SDL_GPUCompareOp compare_op;
+	SDL_GPUCullMode cull_mode;
+	SDL_GPUFrontFace front_face; //0 is counter-clockwise
+	SDL_GPUFillMode fill_mode;
+	PipelineBlend blend;
+} PipelineDesc;
+
+/*******************************************************************
+ * FUNCTIONS *******************************************************
+ ******************************************************************/
+
+bool PipelineCache_Init(SDL_GPUDevice *device);
+
+//returns a shared pipeline, creating it on first use
+//never release it, the cache owns it
+SDL_GPUGraphicsPipeline *PipelineCache_Get(const PipelineDesc *desc);
+
+//same idea for samplers
+SDL_GPUSampler *PipelineCache_GetSampler(const SDL_GPUSamplerCreateInfo *info);
+
+//creates the pipelines on worker threads and returns immediately
+//PipelineCache_Get waits if it asks for one that is still compiling
+void PipelineCache_Prewarm(const PipelineDesc *descs, size_t count);
+
+//blocks until every prewarm job is done
+void PipelineCache_WaitPrewarm();
+
+void PipelineCache_LogStats();
+
+//releases every cached pipeline and sampler
+void PipelineCache_Destroy();
+
+#endif
@@ -0,0 +1,295 @@
+/*
+ * Copyright (C) 2025 Matheus Klein Schaefer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <SDL3/SDL.h>
+#include <pipelinecache.h>
+#include <postchain.h>
+
+#define POSTCHAIN_INTERMEDIATE_FORMAT SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM
+
+static const char *kernel_shaders[] = {
+	"shaders/post/outline.frag.spv",
+	"shaders/post/blur.frag.spv",
+	"shaders/post/sharpen.frag.spv"
+};
+
+static bool is_kernel(PostEffectType type)
+{
+	return type <= POST_EFFECT_SHARPEN;
+}
+
+static SDL_GPUSampler *get_sampler(SDL_GPUFilter filter)
+{
+	SDL_GPUSamplerCreateInfo samplercreateinfo = { 0 };
+	samplercreateinfo.min_filter = filter;
+	samplercreateinfo.mag_filter = filter;
+	samplercreateinfo.mipmap_mode = SDL_GPU_SAMPLERMIPMAPMODE_NEAREST;
+	samplercreateinfo.address_mode_u = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE;
+	samplercreateinfo.address_mode_v = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE;
+	samplercreateinfo.address_mode_w = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE;
+	return PipelineCache_GetSampler(&samplercreateinfo);
+}
+
+static SDL_GPUGraphicsPipeline *get_pipeline(int kernel, SDL_GPUTextureFormat format)
+{
+	PipelineDesc desc = { 0 };
+	desc.vertex_shader = "shaders/post/fullscreen.vert.spv";
+	desc.fragment_shader = (kernel < 0) ? "shaders/post/copy.frag.spv" : kernel_shaders[kernel];
+	desc.vertex_layout = PIPELINE_VERTEX_NONE;
+	desc.primitive_type = SDL_GPU_PRIMITIVETYPE_TRIANGLELIST;
+	desc.num_color_targets = 1;
+	desc.color_formats[0] = format;
+	desc.depth_format = SDL_GPU_TEXTUREFORMAT_INVALID;
+	desc.compare_op = SDL_GPU_COMPAREOP_ALWAYS;
+	desc.cull_mode = SDL_GPU_CULLMODE_NONE;
+	desc.fill_mode = SDL_GPU_FILLMODE_FILL;
+	return PipelineCache_Get(&desc);
+}
+
+bool PostChain_Init(PostChain *chain)
+{
+	if(chain == NULL)
+	{
+		return false;
+	}
+	*chain = (PostChain){ 0 };
+	chain->point_sampler = get_sampler(SDL_GPU_FILTER_NEAREST);
+	chain->linear_sampler = get_sampler(SDL_GPU_FILTER_LINEAR);
+	return chain->point_sampler != NULL && chain->linear_sampler != NULL;
+}
+
+int PostChain_AddEffect(PostChain *chain, PostEffectType type, const float params[4])
+{
+	if(chain->num_effects == POSTCHAIN_MAX_EFFECTS || type >= POST_EFFECT_COUNT)
+	{
+		return -1;
+	}
+	PostEffect *effect = &chain->effects[chain->num_effects];
+	*effect = (PostEffect){ .type = type, .enabled = true };
+	if(params != NULL)
+	{
+		SDL_memcpy(effect->params, params, sizeof(effect->params));
+	}
+	return (int)chain->num_effects++;
+}
+
+void PostChain_SetEnabled(PostChain *chain, int effect, bool enabled)
+{
+	if(effect >= 0 && (Uint32)effect < chain->num_effects)
+	{
+		chain->effects[effect].enabled = enabled;
+	}
+}
+
+bool PostChain_IsEnabled(PostChain *chain, int effect)
+{
+	return effect >= 0 && (Uint32)effect < chain->num_effects && chain->effects[effect].enabled;
+}
+
+static PostChainPass *new_pass(PostChain *chain, int kernel)
+{
+	PostChainPass *pass = &chain->passes[chain->num_passes++];
+	*pass = (PostChainPass){ .chain = chain, .kernel = kernel };
+	return pass;
+}
+
+//post_tail applies the per-pixel effects in this order, whatever order
+//they were fused in
+static int tail_order(PostEffectType type)
+{
+	switch(type)
+	{
+		case POST_EFFECT_OVERDRAW:
+			return 0;
+		case POST_EFFECT_GRADE:
+			return 1;
+		default:
+			return 2;
+	}
+}
+
+//the latest tail step already in the pass, -1 for none
+static int last_fused(const PostChainPass *pass)
+{
+	if(pass->params.vignette[3] != 0.0f)
+	{
+		return tail_order(POST_EFFECT_VIGNETTE);
+	}
+	if(pass->params.grade[3] != 0.0f)
+	{
+		return tail_order(POST_EFFECT_GRADE);
+	}
+	if(pass->params.overdraw[3] != 0.0f)
+	{
+		return tail_order(POST_EFFECT_OVERDRAW);
+	}
+	return -1;
+}
+
+//per-pixel effects only touch the uniforms of the pass they fuse into;
+//one that the shader would run before (or instead of) something already
+//fused can't join, or it would run out of the order it was added in
+static bool fuse_effect(PostChainPass *pass, PostEffect *effect)
+{
+	if(tail_order(effect->type) <= last_fused(pass))
+	{
+		return false;
+	}
+	if(effect->type == POST_EFFECT_GRADE)
+	{
+		pass->params.grade[0] = effect->params[0];
+		pass->params.grade[1] = effect->params[1];
+		pass->params.grade[2] = effect->params[2];
+		pass->params.grade[3] = 1.0f;
+	}
+	else if(effect->type == POST_EFFECT_VIGNETTE)
+	{
+		pass->params.vignette[0] = effect->params[0];
+		pass->params.vignette[1] = effect->params[1];
+		pass->params.vignette[3] = 1.0f;
+	}
+	else if(effect->type == POST_EFFECT_OVERDRAW)
+	{
+		pass->params.overdraw[0] = effect->params[0];
+		pass->params.overdraw[3] = 1.0f;
+	}
+	return true;
+}
+
+static void run_pass(RenderGraph *graph, SDL_GPUCommandBuffer *cmdbuf,
+						SDL_GPURenderPass *renderpass, void *userdata)
+{
+	PostChainPass *pass = (PostChainPass*)userdata;
+	PostChain *chain = pass->chain;
+	//kernels want exact texels, copies and blurs can filter
+	bool point = pass->point_filter || pass->kernel == POST_EFFECT_OUTLINE || pass->kernel == POST_EFFECT_SHARPEN;
+	SDL_GPUTextureSamplerBinding bindings[2] = {
+		{ .texture = RenderGraph_GetTexture(graph, pass->input), .sampler = point ? chain->point_sampler : chain->linear_sampler },
+		{ .texture = RenderGraph_GetTexture(graph, pass->normals), .sampler = chain->point_sampler }
+	};
+
+	SDL_BindGPUGraphicsPipeline(renderpass, pass->pipeline);
+	if(pass->viewport_width != 0)
+	{
+		SDL_SetGPUViewport(renderpass, &(SDL_GPUViewport){
+			0.0f, 0.0f, (float)pass->viewport_width, (float)pass->viewport_height, 0.0f, 1.0f });
+	}
+	SDL_BindGPUFragmentSamplers(renderpass, 0, bindings, (pass->kernel == POST_EFFECT_OUTLINE) ? 2 : 1);
+	SDL_PushGPUFragmentUniformData(cmdbuf, 0, &pass->params, sizeof(PostParams));
+	PostChain_DrawFullscreen(renderpass);
+}
+
+bool PostChain_AddPasses(PostChain *chain, RenderGraph *graph, const PostChainTargets *targets)
+{
+	chain->num_passes = 0;
+	chain->stats = (PostChainStats){ 0 };
+	Uint32 viewport_width = (targets->viewport_width != 0) ? targets->viewport_width : targets->input_width;
+	Uint32 viewport_height = (targets->viewport_height != 0) ? targets->viewport_height : targets->input_height;
+
+	//a neighbourhood effect starts a pass, per-pixel effects join the
+	//current one, so "outline, grade, vignette, sharpen, grade" is two
+	//passes instead of five
+	PostChainPass *current = NULL;
+	for(Uint32 i = 0; i < chain->num_effects; i++)
+	{
+		PostEffect *effect = &chain->effects[i];
+		if(!effect->enabled)
+		{
+			continue;
+		}
+		if(effect->type == POST_EFFECT_OUTLINE && targets->normals == RENDERGRAPH_INVALID)
+		{
+			continue;
+		}
+		chain->stats.effects++;
+		if(is_kernel(effect->type))
+		{
+			current = new_pass(chain, (int)effect->type);
+			current->params.kernel[2] = effect->params[0];
+			current->params.kernel[3] = targets->octahedral_normals ? 1.0f : 0.0f;
+			current->normals = targets->normals;
+			continue;
+		}
+		//out of the shader's order (or a repeat) gets a copy pass of its own
+		if(current == NULL || !fuse_effect(current, effect))
+		{
+			current = new_pass(chain, -1);
+			fuse_effect(current, effect);
+		}
+	}
+
+	//kernels run at the input's resolution, scaling is left to a copy
+	//which per-pixel effects don't mind being fused into
+	bool scaled = viewport_width != targets->output_width ||
+					viewport_height != targets->output_height;
+	if(chain->num_passes == 0 || (scaled && current->kernel >= 0))
+	{
+		new_pass(chain, -1);
+	}
+
+	RGTexture input = targets->input;
+	for(Uint32 i = 0; i < chain->num_passes; i++)
+	{
+		PostChainPass *pass = &chain->passes[i];
+		bool last = i == chain->num_passes - 1;
+		pass->input = input;
+		pass->params.kernel[0] = 1.0f / (float)targets->input_width;
+		pass->params.kernel[1] = 1.0f / (float)targets->input_height;
+		pass->params.region[0] = (float)viewport_width / (float)targets->input_width;
+		pass->params.region[1] = (float)viewport_height / (float)targets->input_height;
+		if(!last)
+		{
+			//intermediates have the input's size, drawn in the same corner
+			pass->viewport_width = viewport_width;
+			pass->viewport_height = viewport_height;
+		}
+		else if(pass->kernel < 0)
+		{
+			pass->point_filter = targets->point_upscale;
+		}
+		pass->pipeline = get_pipeline(pass->kernel, last ? targets->output_format : POSTCHAIN_INTERMEDIATE_FORMAT);
+		if(pass->pipeline == NULL)
+		{
+			SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Graphics: Error: Post chain pipeline not available.");
+			chain->num_passes = 0;
+			return false;
+		}
+
+		RGTexture output = targets->output;
+		if(!last)
+		{
+			output = RenderGraph_CreateTexture(graph, "post", targets->input_width, targets->input_height,
+												POSTCHAIN_INTERMEDIATE_FORMAT);
+		}
+		RGPass rgpass = RenderGraph_AddPass(graph, "post", run_pass, pass);
+		RenderGraph_Read(graph, rgpass, input);
+		if(pass->kernel == POST_EFFECT_OUTLINE)
+		{
+			RenderGraph_Read(graph, rgpass, pass->normals);
+		}
+		//every pixel is written, intermediates need no clear; the output
+		//gets one so an imported target isn't loaded for nothing
+		RenderGraph_WriteColor(graph, rgpass, output, last ? &(SDL_FColor){ 0.0f, 0.0f, 0.0f, 1.0f } : NULL);
+		input = output;
+	}
+	chain->stats.passes = chain->num_passes;
+	return true;
+}
+
+void PostChain_DrawFullscreen(SDL_GPURenderPass *renderpass)
+{
+	SDL_DrawGPUPrimitives(renderpass, 3, 1, 0, 0);
+}
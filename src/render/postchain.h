@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2025 Matheus Klein Schaefer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef POSTCHAIN_H
+#define POSTCHAIN_H
+
+#include <SDL3/SDL.h>
+#include <rendergraph.h>
+
+/*******************************************************************
+ * STRUCTURES AND ENUMS ********************************************
+ ******************************************************************/
+
+#define POSTCHAIN_MAX_EFFECTS 8
+//every effect in its own pass, plus the final scale
+#define POSTCHAIN_MAX_PASSES (POSTCHAIN_MAX_EFFECTS + 1)
+
+typedef enum PostEffectType
+{
+	//neighbourhood effects, they sample around the pixel so each one
+	//starts a new pass
+	POST_EFFECT_OUTLINE = 0, //params: strength; needs the normal target
+	POST_EFFECT_BLUR, //params: tap distance in texels
+	POST_EFFECT_SHARPEN, //params: amount
+	//per-pixel effects, fused into the pass before them while they come in
+	//the order post_tail applies them (overdraw, grade, vignette)
+	POST_EFFECT_GRADE, //params: exposure, contrast, saturation
+	POST_EFFECT_VIGNETTE, //params: strength, radius
+	POST_EFFECT_OVERDRAW, //params: layers per unit; the input holds counts
+	POST_EFFECT_COUNT
+} PostEffectType;
+
+typedef struct PostEffect
+{
+	PostEffectType type;
+	bool enabled;
+	float params[4];
+} PostEffect;
+
+//fragment uniforms, see common/post.glsl
+typedef struct PostParams
+{
+	float kernel[4];
+	float grade[4];
+	float vignette[4];
+	float region[4]; //rendered part of the input, in uv
+	float overdraw[4];
+} PostParams;
+
+typedef struct PostChain PostChain;
+
+typedef struct PostChainPass
+{
+	PostChain *chain;
+	SDL_GPUGraphicsPipeline *pipeline;
+	int kernel; //PostEffectType, -1 for a plain copy
+	RGTexture input;
+	RGTexture normals;
+	Uint32 viewport_width, viewport_height; //0 for the whole target
+	bool point_filter;
+	PostParams params;
+} PostChainPass;
+
+//what the chain reads and where it ends
+typedef struct PostChainTargets
+{
+	RGTexture input;
+	Uint32 input_width, input_height;
+	//only the top-left part of the input may be drawn, the chain keeps
+	//to it until the final scale (0 = all of it)
+	Uint32 viewport_width, viewport_height;
+	RGTexture normals; //RENDERGRAPH_INVALID when there are none
+	bool octahedral_normals;
+	RGTexture output;
+	Uint32 output_width, output_height;
+	SDL_GPUTextureFormat output_format;
+	bool point_upscale; //blocky pixels instead of a filtered scale
+} PostChainTargets;
+
+typedef struct PostChainStats
+{
+	Uint32 effects; //enabled this frame
+	Uint32 passes; //after fusion
+} PostChainStats;
+
+struct PostChain
+{
+	PostEffect effects[POSTCHAIN_MAX_EFFECTS];
+	Uint32 num_effects;
+	PostChainPass passes[POSTCHAIN_MAX_PASSES];
+	Uint32 num_passes;
+	SDL_GPUSampler *point_sampler; //neighbourhood taps
+	SDL_GPUSampler *linear_sampler; //scaling
+	PostChainStats stats;
+};
+
+/*******************************************************************
+ * FUNCTIONS *******************************************************
+ ******************************************************************/
+
+//pipelines and samplers come from the pipeline cache, so there is
+//nothing to destroy
+bool PostChain_Init(PostChain *chain);
+
+//effects run in the order they were added, returns the index or -1
+int PostChain_AddEffect(PostChain *chain, PostEffectType type, const float params[4]);
+void PostChain_SetEnabled(PostChain *chain, int effect, bool enabled);
+bool PostChain_IsEnabled(PostChain *chain, int effect);
+
+//adds the fused passes to the graph, intermediates are transients
+//effects run at the input's (viewport) resolution, the output may be
+//any size
+//with nothing enabled this is a copy (and scale) to the output
+bool PostChain_AddPasses(PostChain *chain, RenderGraph *graph, const PostChainTargets *targets);
+
+//full-screen triangle, for anything else drawn with fullscreen.vert
+void PostChain_DrawFullscreen(SDL_GPURenderPass *renderpass);
+
+#endif
@@ -0,0 +1,496 @@
+/*
+ * Copyright (C) 2025 Matheus Klein Schaefer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <SDL3/SDL.h>
+#include <texturepool.h>
+#include <rendergraph.h>
+
+static bool is_depth_format(SDL_GPUTextureFormat format)
+{
+	switch(format)
+	{
+		case SDL_GPU_TEXTUREFORMAT_D16_UNORM:
+		case SDL_GPU_TEXTUREFORMAT_D24_UNORM:
+		case SDL_GPU_TEXTUREFORMAT_D32_FLOAT:
+		case SDL_GPU_TEXTUREFORMAT_D24_UNORM_S8_UINT:
+		case SDL_GPU_TEXTUREFORMAT_D32_FLOAT_S8_UINT:
+			return true;
+		default:
+			return false;
+	}
+}
+
+/*******************************************************************
+ * POOL ************************************************************
+ ******************************************************************/
+
+static bool acquire_texture(RenderGraph *graph, RenderGraphTexture *texture)
+{
+	TexturePoolDesc desc = {
+		.width = texture->width,
+		.height = texture->height,
+		.format = texture->format,
+		.usage = texture->usage,
+		.sample_count = SDL_GPU_SAMPLECOUNT_1
+	};
+	texture->texture = TexturePool_Acquire(&desc, &texture->cycle);
+	if(texture->texture == NULL)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Graphics: Error: Failed to allocate %s.", texture->name);
+		return false;
+	}
+	texture->pooled = true;
+	return true;
+}
+
+static void release_texture(RenderGraph *graph, RenderGraphTexture *texture)
+{
+	if(texture->pooled)
+	{
+		TexturePool_Release(texture->texture);
+		texture->pooled = false;
+	}
+}
+
+/*******************************************************************
+ * DECLARATION *****************************************************
+ ******************************************************************/
+
+bool RenderGraph_Init(SDL_GPUDevice *device, RenderGraph *graph)
+{
+	if(device == NULL || graph == NULL)
+	{
+		return false;
+	}
+	*graph = (RenderGraph){ 0 };
+	graph->device = device;
+	return true;
+}
+
+void RenderGraph_Begin(RenderGraph *graph)
+{
+	graph->num_passes = 0;
+	graph->num_textures = 0;
+	graph->stats = (RenderGraphStats){ 0 };
+}
+
+static RGTexture add_texture(RenderGraph *graph, RenderGraphTexture *texture)
+{
+	if(graph->num_textures == RENDERGRAPH_MAX_TEXTURES)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Graphics: Error: Too many render graph textures.");
+		return RENDERGRAPH_INVALID;
+	}
+	texture->pooled = false;
+	graph->textures[graph->num_textures] = *texture;
+	return graph->num_textures++;
+}
+
+RGTexture RenderGraph_CreateTexture(RenderGraph *graph, const char *name,
+									Uint32 width, Uint32 height,
+									SDL_GPUTextureFormat format)
+{
+	return add_texture(graph, &(RenderGraphTexture){
+		.name = name,
+		.width = width,
+		.height = height,
+		.format = format
+	});
+}
+
+RGTexture RenderGraph_ImportTexture(RenderGraph *graph, const char *name,
+									SDL_GPUTexture *texture,
+									Uint32 width, Uint32 height)
+{
+	return add_texture(graph, &(RenderGraphTexture){
+		.name = name,
+		.width = width,
+		.height = height,
+		.imported = true,
+		.texture = texture
+	});
+}
+
+RGPass RenderGraph_AddPass(RenderGraph *graph, const char *name,
+							RenderGraphExecute execute, void *userdata)
+{
+	if(graph->num_passes == RENDERGRAPH_MAX_PASSES)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Graphics: Error: Too many render graph passes.");
+		return RENDERGRAPH_INVALID;
+	}
+	graph->passes[graph->num_passes] = (RenderGraphPass){
+		.name = name,
+		.execute = execute,
+		.userdata = userdata
+	};
+	return graph->num_passes++;
+}
+
+RGPass RenderGraph_AddComputePass(RenderGraph *graph, const char *name,
+									RenderGraphCompute compute, void *userdata)
+{
+	RGPass pass = RenderGraph_AddPass(graph, name, NULL, userdata);
+	if(pass != RENDERGRAPH_INVALID)
+	{
+		graph->passes[pass].compute = compute;
+	}
+	return pass;
+}
+
+void RenderGraph_Read(RenderGraph *graph, RGPass pass, RGTexture texture)
+{
+	if(pass >= graph->num_passes || texture >= graph->num_textures)
+	{
+		return;
+	}
+	RenderGraphPass *p = &graph->passes[pass];
+	if(p->num_reads < RENDERGRAPH_MAX_READS)
+	{
+		p->reads[p->num_reads++] = texture;
+	}
+}
+
+void RenderGraph_WriteColor(RenderGraph *graph, RGPass pass, RGTexture texture,
+							const SDL_FColor *clear)
+{
+	if(pass >= graph->num_passes || texture >= graph->num_textures)
+	{
+		return;
+	}
+	RenderGraphPass *p = &graph->passes[pass];
+	if(p->num_colors < RENDERGRAPH_MAX_COLOR_TARGETS)
+	{
+		p->colors[p->num_colors++] = (RenderGraphTarget){
+			.texture = texture,
+			.clear = clear != NULL,
+			.clear_color = (clear != NULL) ? *clear : (SDL_FColor){ 0 }
+		};
+	}
+}
+
+void RenderGraph_WriteDepth(RenderGraph *graph, RGPass pass, RGTexture texture,
+							bool clear)
+{
+	if(pass >= graph->num_passes || texture >= graph->num_textures)
+	{
+		return;
+	}
+	RenderGraphPass *p = &graph->passes[pass];
+	p->depth = (RenderGraphTarget){
+		.texture = texture,
+		.clear = clear,
+		.clear_depth = 1.0f
+	};
+	p->has_depth = true;
+}
+
+void RenderGraph_WriteStorage(RenderGraph *graph, RGPass pass, RGTexture texture)
+{
+	if(pass >= graph->num_passes || texture >= graph->num_textures)
+	{
+		return;
+	}
+	RenderGraphPass *p = &graph->passes[pass];
+	if(p->num_storage < RENDERGRAPH_MAX_COLOR_TARGETS)
+	{
+		//fully overwritten, so previous content is as good as cleared
+		p->storage[p->num_storage++] = (RenderGraphTarget){
+			.texture = texture,
+			.clear = true
+		};
+	}
+}
+
+SDL_GPUTexture *RenderGraph_GetTexture(RenderGraph *graph, RGTexture texture)
+{
+	if(texture >= graph->num_textures)
+	{
+		return NULL;
+	}
+	return graph->textures[texture].texture;
+}
+
+/*******************************************************************
+ * COMPILE AND EXECUTE *********************************************
+ ******************************************************************/
+
+static Uint32 pass_targets(RenderGraphPass *pass, RenderGraphTarget **targets)
+{
+	Uint32 count = 0;
+	for(Uint32 i = 0; i < pass->num_colors; i++)
+	{
+		targets[count++] = &pass->colors[i];
+	}
+	if(pass->has_depth)
+	{
+		targets[count++] = &pass->depth;
+	}
+	for(Uint32 i = 0; i < pass->num_storage; i++)
+	{
+		targets[count++] = &pass->storage[i];
+	}
+	return count;
+}
+
+static SDL_GPUTextureUsageFlags target_usage(RenderGraphPass *pass, RenderGraphTarget *target)
+{
+	if(target == &pass->depth)
+	{
+		return SDL_GPU_TEXTUREUSAGE_DEPTH_STENCIL_TARGET;
+	}
+	if(pass->compute != NULL)
+	{
+		return SDL_GPU_TEXTUREUSAGE_COMPUTE_STORAGE_WRITE;
+	}
+	return SDL_GPU_TEXTUREUSAGE_COLOR_TARGET;
+}
+
+//walks backwards from the imported textures: a pass survives only if
+//something after it (or outside the graph) uses what it writes
+//passes run in declaration order, which is already a valid order since
+//a pass can only read what earlier passes declared
+static void compile(RenderGraph *graph)
+{
+	RenderGraphTarget *targets[RENDERGRAPH_MAX_COLOR_TARGETS * 2 + 1];
+
+	for(Uint32 i = 0; i < graph->num_textures; i++)
+	{
+		RenderGraphTexture *texture = &graph->textures[i];
+		texture->needed = texture->imported;
+		texture->written = texture->imported;
+		texture->first_use = texture->last_use = -1;
+		if(!texture->imported)
+		{
+			texture->usage = 0;
+		}
+	}
+
+	for(int p = (int)graph->num_passes - 1; p >= 0; p--)
+	{
+		RenderGraphPass *pass = &graph->passes[p];
+		Uint32 count = pass_targets(pass, targets);
+		bool live = false;
+		for(Uint32 t = 0; t < count; t++)
+		{
+			RenderGraphTexture *texture = &graph->textures[targets[t]->texture];
+			live = live || texture->needed || texture->imported;
+		}
+		pass->culled = !live;
+		if(!live)
+		{
+			continue;
+		}
+		for(Uint32 t = 0; t < count; t++)
+		{
+			RenderGraphTexture *texture = &graph->textures[targets[t]->texture];
+			//nobody reads it later, the tile memory never has to go out
+			targets[t]->store_op = texture->needed ? SDL_GPU_STOREOP_STORE : SDL_GPU_STOREOP_DONT_CARE;
+			texture->needed = !targets[t]->clear;
+		}
+		for(Uint32 r = 0; r < pass->num_reads; r++)
+		{
+			graph->textures[pass->reads[r]].needed = true;
+		}
+	}
+
+	for(Uint32 p = 0; p < graph->num_passes; p++)
+	{
+		RenderGraphPass *pass = &graph->passes[p];
+		if(pass->culled)
+		{
+			graph->stats.passes_culled++;
+			continue;
+		}
+		Uint32 count = pass_targets(pass, targets);
+		for(Uint32 t = 0; t < count; t++)
+		{
+			RenderGraphTexture *texture = &graph->textures[targets[t]->texture];
+			if(targets[t]->clear)
+			{
+				targets[t]->load_op = SDL_GPU_LOADOP_CLEAR;
+			}
+			else
+			{
+				//nothing written before, nothing worth loading
+				targets[t]->load_op = texture->written ? SDL_GPU_LOADOP_LOAD : SDL_GPU_LOADOP_DONT_CARE;
+			}
+			texture->written = true;
+			if(!texture->imported)
+			{
+				texture->usage |= target_usage(pass, targets[t]);
+			}
+			if(texture->first_use < 0)
+			{
+				texture->first_use = (int)p;
+			}
+			texture->last_use = (int)p;
+		}
+		for(Uint32 r = 0; r < pass->num_reads; r++)
+		{
+			RenderGraphTexture *texture = &graph->textures[pass->reads[r]];
+			if(!texture->written)
+			{
+				SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Graphics: pass %s reads %s before anything wrote it.", pass->name, texture->name);
+			}
+			if(!texture->imported)
+			{
+				texture->usage |= SDL_GPU_TEXTUREUSAGE_SAMPLER;
+			}
+			if(texture->first_use < 0)
+			{
+				texture->first_use = (int)p;
+			}
+			texture->last_use = (int)p;
+		}
+	}
+
+	for(Uint32 i = 0; i < graph->num_textures; i++)
+	{
+		if(!graph->textures[i].imported && graph->textures[i].first_use >= 0)
+		{
+			graph->stats.transient_textures++;
+		}
+	}
+}
+
+static void run_compute_pass(RenderGraph *graph, RenderGraphPass *pass, SDL_GPUCommandBuffer *cmdbuf)
+{
+	SDL_GPUStorageTextureReadWriteBinding storage[RENDERGRAPH_MAX_COLOR_TARGETS] = { 0 };
+	for(Uint32 i = 0; i < pass->num_storage; i++)
+	{
+		RenderGraphTexture *texture = &graph->textures[pass->storage[i].texture];
+		storage[i].texture = texture->texture;
+		storage[i].cycle = texture->cycle;
+		texture->cycle = false;
+	}
+	SDL_GPUComputePass *computepass = SDL_BeginGPUComputePass(cmdbuf, storage, pass->num_storage, NULL, 0);
+	pass->compute(graph, cmdbuf, computepass, pass->userdata);
+	SDL_EndGPUComputePass(computepass);
+}
+
+static void run_pass(RenderGraph *graph, RenderGraphPass *pass, SDL_GPUCommandBuffer *cmdbuf)
+{
+	if(pass->compute != NULL)
+	{
+		run_compute_pass(graph, pass, cmdbuf);
+		return;
+	}
+
+	SDL_GPUColorTargetInfo colors[RENDERGRAPH_MAX_COLOR_TARGETS] = { 0 };
+	for(Uint32 i = 0; i < pass->num_colors; i++)
+	{
+		RenderGraphTarget *target = &pass->colors[i];
+		RenderGraphTexture *texture = &graph->textures[target->texture];
+		colors[i].texture = texture->texture;
+		colors[i].clear_color = target->clear_color;
+		colors[i].load_op = target->load_op;
+		colors[i].store_op = target->store_op;
+		colors[i].cycle = texture->cycle && target->load_op != SDL_GPU_LOADOP_LOAD;
+		texture->cycle = false;
+	}
+
+	SDL_GPUDepthStencilTargetInfo depth = { 0 };
+	if(pass->has_depth)
+	{
+		RenderGraphTexture *texture = &graph->textures[pass->depth.texture];
+		depth.texture = texture->texture;
+		depth.clear_depth = pass->depth.clear_depth;
+		depth.load_op = pass->depth.load_op;
+		depth.store_op = pass->depth.store_op;
+		depth.stencil_load_op = SDL_GPU_LOADOP_DONT_CARE;
+		depth.stencil_store_op = SDL_GPU_STOREOP_DONT_CARE;
+		depth.cycle = texture->cycle && pass->depth.load_op != SDL_GPU_LOADOP_LOAD;
+		texture->cycle = false;
+	}
+
+	SDL_GPURenderPass *renderpass = NULL;
+	if(pass->num_colors > 0 || pass->has_depth)
+	{
+		renderpass = SDL_BeginGPURenderPass(cmdbuf, colors, pass->num_colors, pass->has_depth ? &depth : NULL);
+	}
+	if(pass->execute != NULL)
+	{
+		pass->execute(graph, cmdbuf, renderpass, pass->userdata);
+	}
+	if(renderpass != NULL)
+	{
+		SDL_EndGPURenderPass(renderpass);
+	}
+}
+
+bool RenderGraph_Execute(RenderGraph *graph, SDL_GPUCommandBuffer *cmdbuf)
+{
+	if(graph == NULL || cmdbuf == NULL)
+	{
+		return false;
+	}
+	compile(graph);
+
+	bool success = true;
+	for(Uint32 p = 0; p < graph->num_passes; p++)
+	{
+		RenderGraphPass *pass = &graph->passes[p];
+		if(pass->culled)
+		{
+			continue;
+		}
+
+		//transients get memory right before their first use...
+		bool ready = true;
+		for(Uint32 i = 0; i < graph->num_textures; i++)
+		{
+			RenderGraphTexture *texture = &graph->textures[i];
+			if(!texture->imported && texture->first_use == (int)p)
+			{
+				ready = acquire_texture(graph, texture) && ready;
+			}
+		}
+		if(ready)
+		{
+			run_pass(graph, pass, cmdbuf);
+			graph->stats.passes_run++;
+		}
+		else
+		{
+			success = false;
+		}
+
+		//...and give it back after their last one, so later transients
+		//of the same shape alias it
+		for(Uint32 i = 0; i < graph->num_textures; i++)
+		{
+			RenderGraphTexture *texture = &graph->textures[i];
+			if(!texture->imported && texture->last_use == (int)p)
+			{
+				release_texture(graph, texture);
+			}
+		}
+	}
+	graph->stats.pooled_textures = TexturePool_GetStats().textures;
+	return success;
+}
+
+void RenderGraph_Destroy(RenderGraph *graph)
+{
+	if(graph == NULL || graph->device == NULL)
+	{
+		return;
+	}
+	//transients went back to the pool during execute, it keeps them
+	//for the next screen
+	*graph = (RenderGraph){ 0 };
+}
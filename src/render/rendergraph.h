@@ -0,0 +1,160 @@
+/*
+ * Copyright (C) 2025 Matheus Klein Schaefer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef RENDERGRAPH_H
+#define RENDERGRAPH_H
+
+#include <SDL3/SDL.h>
+
+/*******************************************************************
+ * STRUCTURES AND ENUMS ********************************************
+ ******************************************************************/
+
+#define RENDERGRAPH_MAX_PASSES 32
+#define RENDERGRAPH_MAX_TEXTURES 32
+#define RENDERGRAPH_MAX_READS 8
+#define RENDERGRAPH_MAX_COLOR_TARGETS 4
+
+#define RENDERGRAPH_INVALID 0xFFFFFFFF
+
+//handles, valid until the next RenderGraph_Begin
+typedef Uint32 RGTexture;
+typedef Uint32 RGPass;
+
+typedef struct RenderGraph RenderGraph;
+
+//renderpass is already begun with the targets the pass declared
+typedef void (*RenderGraphExecute)(RenderGraph *graph,
+									SDL_GPUCommandBuffer *cmdbuf,
+									SDL_GPURenderPass *renderpass,
+									void *userdata);
+
+//same for compute passes, storage targets are already bound
+typedef void (*RenderGraphCompute)(RenderGraph *graph,
+									SDL_GPUCommandBuffer *cmdbuf,
+									SDL_GPUComputePass *computepass,
+									void *userdata);
+
+typedef struct RenderGraphTexture
+{
+	const char *name;
+	Uint32 width, height;
+	SDL_GPUTextureFormat format;
+	SDL_GPUTextureUsageFlags usage;
+	bool imported;
+	SDL_GPUTexture *texture; //only valid while executing
+	bool pooled; //borrowed from the texture pool right now
+	bool cycle; //pooled texture may still be in use by an earlier frame
+	int first_use, last_use;
+	bool needed; //someone after the current pass wants the content
+	bool written; //a pass before the current one wrote it
+} RenderGraphTexture;
+
+typedef struct RenderGraphTarget
+{
+	RGTexture texture;
+	bool clear;
+	SDL_FColor clear_color;
+	float clear_depth;
+	SDL_GPULoadOp load_op;
+	SDL_GPUStoreOp store_op;
+} RenderGraphTarget;
+
+typedef struct RenderGraphPass
+{
+	const char *name;
+	RenderGraphExecute execute;
+	RenderGraphCompute compute; //set for compute passes
+	void *userdata;
+	RGTexture reads[RENDERGRAPH_MAX_READS];
+	Uint32 num_reads;
+	RenderGraphTarget colors[RENDERGRAPH_MAX_COLOR_TARGETS];
+	Uint32 num_colors;
+	RenderGraphTarget depth;
+	bool has_depth;
+	RenderGraphTarget storage[RENDERGRAPH_MAX_COLOR_TARGETS];
+	Uint32 num_storage;
+	bool culled;
+} RenderGraphPass;
+
+typedef struct RenderGraphStats
+{
+	Uint32 passes_run;
+	Uint32 passes_culled;
+	Uint32 transient_textures; //declared this frame
+	Uint32 pooled_textures; //in the shared pool, any graph's
+} RenderGraphStats;
+
+struct RenderGraph
+{
+	SDL_GPUDevice *device;
+	RenderGraphPass passes[RENDERGRAPH_MAX_PASSES];
+	Uint32 num_passes;
+	RenderGraphTexture textures[RENDERGRAPH_MAX_TEXTURES];
+	Uint32 num_textures;
+	RenderGraphStats stats;
+};
+
+/*******************************************************************
+ * FUNCTIONS *******************************************************
+ ******************************************************************/
+
+bool RenderGraph_Init(SDL_GPUDevice *device, RenderGraph *graph);
+
+//drops last frame's passes and textures
+void RenderGraph_Begin(RenderGraph *graph);
+
+//transient texture, lives only during the frame and may share memory
+//with other transients whose lifetimes don't overlap
+//memory comes from the texture pool, which outlives the graph
+RGTexture RenderGraph_CreateTexture(RenderGraph *graph, const char *name,
+									Uint32 width, Uint32 height,
+									SDL_GPUTextureFormat format);
+
+//external texture (swapchain, persistent targets)
+//passes writing to these are never culled
+RGTexture RenderGraph_ImportTexture(RenderGraph *graph, const char *name,
+									SDL_GPUTexture *texture,
+									Uint32 width, Uint32 height);
+
+RGPass RenderGraph_AddPass(RenderGraph *graph, const char *name,
+							RenderGraphExecute execute, void *userdata);
+
+RGPass RenderGraph_AddComputePass(RenderGraph *graph, const char *name,
+									RenderGraphCompute compute, void *userdata);
+
+//sampled in the pass
+void RenderGraph_Read(RenderGraph *graph, RGPass pass, RGTexture texture);
+
+//clear == NULL keeps whatever was there
+void RenderGraph_WriteColor(RenderGraph *graph, RGPass pass, RGTexture texture,
+							const SDL_FColor *clear);
+
+void RenderGraph_WriteDepth(RenderGraph *graph, RGPass pass, RGTexture texture,
+							bool clear);
+
+//compute storage target, the pass is expected to overwrite all of it
+void RenderGraph_WriteStorage(RenderGraph *graph, RGPass pass, RGTexture texture);
+
+//only valid inside execute callbacks
+SDL_GPUTexture *RenderGraph_GetTexture(RenderGraph *graph, RGTexture texture);
+
+//culls, orders, allocates and runs every pass
+bool RenderGraph_Execute(RenderGraph *graph, SDL_GPUCommandBuffer *cmdbuf);
+
+void RenderGraph_Destroy(RenderGraph *graph);
+
+#endif
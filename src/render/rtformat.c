@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2025 Matheus Klein Schaefer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <SDL3/SDL.h>
+#include <rtformat.h>
+
+#define GBUFFER_USAGE (SDL_GPU_TEXTUREUSAGE_COLOR_TARGET | SDL_GPU_TEXTUREUSAGE_SAMPLER)
+
+static const char *normal_names[GBUFFER_NORMAL_COUNT] = { "RGBA8", "octahedral RG16", "octahedral RG8" };
+static const char *color_names[GBUFFER_COLOR_COUNT] = { "RGBA8", "RGB565" };
+
+//one format per encoding, the shaders are written for that layout
+static const SDL_GPUTextureFormat normal_formats[GBUFFER_NORMAL_COUNT] = {
+	SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM,
+	SDL_GPU_TEXTUREFORMAT_R16G16_UNORM,
+	SDL_GPU_TEXTUREFORMAT_R8G8_UNORM
+};
+
+static const SDL_GPUTextureFormat color_formats[GBUFFER_COLOR_COUNT] = {
+	SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM,
+	SDL_GPU_TEXTUREFORMAT_B5G6R5_UNORM
+};
+
+SDL_GPUTextureFormat RTFormat_Pick(SDL_GPUDevice *device,
+									SDL_GPUTextureUsageFlags usage,
+									const SDL_GPUTextureFormat *candidates,
+									int count)
+{
+	for(int i = 0; i < count; i++)
+	{
+		if(SDL_GPUTextureSupportsFormat(device, candidates[i], SDL_GPU_TEXTURETYPE_2D, usage))
+		{
+			return candidates[i];
+		}
+	}
+	return SDL_GPU_TEXTUREFORMAT_INVALID;
+}
+
+bool RTFormat_NegotiateGBuffer(SDL_GPUDevice *device,
+								GBufferNormalEncoding normal,
+								GBufferColorEncoding color,
+								GBufferFormats *formats)
+{
+	if(device == NULL || formats == NULL)
+	{
+		return false;
+	}
+
+	//smaller encodings fall back towards RGBA8, which every device has
+	SDL_GPUTextureFormat candidates[GBUFFER_NORMAL_COUNT];
+	int count = 0;
+	for(int e = SDL_min((int)normal, GBUFFER_NORMAL_COUNT - 1); e >= 0; e--)
+	{
+		candidates[count++] = normal_formats[e];
+	}
+	formats->normal = RTFormat_Pick(device, GBUFFER_USAGE, candidates, count);
+	formats->normal_encoding = GBUFFER_NORMAL_RGBA8;
+	for(int e = 0; e < GBUFFER_NORMAL_COUNT; e++)
+	{
+		if(normal_formats[e] == formats->normal)
+		{
+			formats->normal_encoding = (GBufferNormalEncoding)e;
+		}
+	}
+
+	count = 0;
+	for(int e = SDL_min((int)color, GBUFFER_COLOR_COUNT - 1); e >= 0; e--)
+	{
+		candidates[count++] = color_formats[e];
+	}
+	formats->color = RTFormat_Pick(device, GBUFFER_USAGE, candidates, count);
+	formats->color_encoding = (formats->color == color_formats[GBUFFER_COLOR_RGB565]) ? GBUFFER_COLOR_RGB565 : GBUFFER_COLOR_RGBA8;
+
+	//the particle collision pass samples depth after the scene
+	SDL_GPUTextureFormat depth_candidates[] = {
+		SDL_GPU_TEXTUREFORMAT_D16_UNORM,
+		SDL_GPU_TEXTUREFORMAT_D24_UNORM,
+		SDL_GPU_TEXTUREFORMAT_D32_FLOAT
+	};
+	formats->depth = RTFormat_Pick(device, SDL_GPU_TEXTUREUSAGE_DEPTH_STENCIL_TARGET | SDL_GPU_TEXTUREUSAGE_SAMPLER,
+									depth_candidates, SDL_arraysize(depth_candidates));
+
+	if(formats->normal == SDL_GPU_TEXTUREFORMAT_INVALID ||
+		formats->color == SDL_GPU_TEXTUREFORMAT_INVALID ||
+		formats->depth == SDL_GPU_TEXTUREFORMAT_INVALID)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Graphics: Error: No usable G-buffer formats.");
+		return false;
+	}
+	if(formats->normal_encoding != normal || formats->color_encoding != color)
+	{
+		SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Graphics: G-buffer fell back to normals %s, color %s.",
+					normal_names[formats->normal_encoding], color_names[formats->color_encoding]);
+	}
+	return true;
+}
+
+const char *RTFormat_GetNormalEncodingName(GBufferNormalEncoding encoding)
+{
+	return (encoding < GBUFFER_NORMAL_COUNT) ? normal_names[encoding] : "unknown";
+}
+
+const char *RTFormat_GetColorEncodingName(GBufferColorEncoding encoding)
+{
+	return (encoding < GBUFFER_COLOR_COUNT) ? color_names[encoding] : "unknown";
+}
@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2025 Matheus Klein Schaefer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef RTFORMAT_H
+#define RTFORMAT_H
+
+#include <SDL3/SDL.h>
+
+/*******************************************************************
+ * STRUCTURES AND ENUMS ********************************************
+ ******************************************************************/
+
+//how the G-buffer normal target is stored
+typedef enum GBufferNormalEncoding
+{
+	GBUFFER_NORMAL_RGBA8 = 0, //xyz * 0.5 + 0.5, the original layout
+	GBUFFER_NORMAL_OCT16, //octahedral in R16G16
+	GBUFFER_NORMAL_OCT8, //octahedral in R8G8
+	GBUFFER_NORMAL_COUNT
+} GBufferNormalEncoding;
+
+typedef enum GBufferColorEncoding
+{
+	GBUFFER_COLOR_RGBA8 = 0,
+	GBUFFER_COLOR_RGB565, //alpha isn't used by the post passes
+	GBUFFER_COLOR_COUNT
+} GBufferColorEncoding;
+
+//what was actually picked, encodings may fall back to a bigger one
+//when the device lacks a format
+typedef struct GBufferFormats
+{
+	GBufferNormalEncoding normal_encoding;
+	GBufferColorEncoding color_encoding;
+	SDL_GPUTextureFormat normal;
+	SDL_GPUTextureFormat color;
+	SDL_GPUTextureFormat depth;
+} GBufferFormats;
+
+/*******************************************************************
+ * FUNCTIONS *******************************************************
+ ******************************************************************/
+
+//first candidate the device supports for this usage, INVALID if none
+SDL_GPUTextureFormat RTFormat_Pick(SDL_GPUDevice *device,
+									SDL_GPUTextureUsageFlags usage,
+									const SDL_GPUTextureFormat *candidates,
+									int count);
+
+//cheapest supported formats for the wanted encodings
+//G-buffer targets are color targets sampled by the post passes
+bool RTFormat_NegotiateGBuffer(SDL_GPUDevice *device,
+								GBufferNormalEncoding normal,
+								GBufferColorEncoding color,
+								GBufferFormats *formats);
+
+const char *RTFormat_GetNormalEncodingName(GBufferNormalEncoding encoding);
+const char *RTFormat_GetColorEncodingName(GBufferColorEncoding encoding);
+
+#endif
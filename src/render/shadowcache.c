@@ -0,0 +1,305 @@
+/*
+ * Copyright (C) 2025 Matheus Klein Schaefer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <SDL3/SDL.h>
+#include <shadowcache.h>
+#include <pipelinecache.h>
+#include <rtformat.h>
+#include <gpumem.h>
+
+#define SHADOWCACHE_USAGE (SDL_GPU_TEXTUREUSAGE_DEPTH_STENCIL_TARGET | SDL_GPU_TEXTUREUSAGE_SAMPLER)
+
+static SDL_GPUTexture *create_depth(ShadowCache *cache)
+{
+	return GPUMem_CreateTexture(cache->device, &(SDL_GPUTextureCreateInfo){
+		.type = SDL_GPU_TEXTURETYPE_2D,
+		.format = cache->format,
+		.usage = SHADOWCACHE_USAGE,
+		.width = cache->size,
+		.height = cache->size,
+		.layer_count_or_depth = 1,
+		.num_levels = 1
+	});
+}
+
+//full-screen triangles limited to a tile by the viewport, depth only
+static PipelineDesc tile_desc(ShadowCache *cache, const char *fragment_shader)
+{
+	return (PipelineDesc){
+		.vertex_shader = "shaders/post/fullscreen.vert.spv",
+		.fragment_shader = fragment_shader,
+		.vertex_layout = PIPELINE_VERTEX_NONE,
+		.primitive_type = SDL_GPU_PRIMITIVETYPE_TRIANGLELIST,
+		.depth_format = cache->format,
+		.depth_test = true,
+		.depth_write = true,
+		.compare_op = SDL_GPU_COMPAREOP_ALWAYS,
+		.cull_mode = SDL_GPU_CULLMODE_NONE,
+		.fill_mode = SDL_GPU_FILLMODE_FILL
+	};
+}
+
+bool ShadowCache_Init(SDL_GPUDevice *device, ShadowCache *cache, Uint32 size, Uint32 tile_size)
+{
+	*cache = (ShadowCache){ 0 };
+	cache->device = device;
+	cache->size = (size != 0) ? size : SHADOWCACHE_DEFAULT_SIZE;
+	cache->tile_size = (tile_size != 0) ? tile_size : SHADOWCACHE_DEFAULT_TILE;
+	cache->tiles_per_row = cache->size / cache->tile_size;
+	cache->format = RTFormat_Pick(device, SHADOWCACHE_USAGE, (SDL_GPUTextureFormat[]){
+									SDL_GPU_TEXTUREFORMAT_D32_FLOAT, SDL_GPU_TEXTUREFORMAT_D16_UNORM }, 2);
+	if(cache->format == SDL_GPU_TEXTUREFORMAT_INVALID || cache->tiles_per_row == 0)
+	{
+		SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Shadows: no sampled depth format available.");
+		return false;
+	}
+
+	PipelineDesc caster_desc = {
+		.vertex_shader = "shaders/shadows/caster.vert.spv",
+		.fragment_shader = "shaders/depth/depth.frag.spv",
+		.vertex_layout = PIPELINE_VERTEX_MESH,
+		.primitive_type = SDL_GPU_PRIMITIVETYPE_TRIANGLELIST,
+		.depth_format = cache->format,
+		.depth_test = true,
+		.depth_write = true,
+		.compare_op = SDL_GPU_COMPAREOP_LESS,
+		.cull_mode = SDL_GPU_CULLMODE_NONE,
+		.fill_mode = SDL_GPU_FILLMODE_FILL
+	};
+	PipelineDesc copy_desc = tile_desc(cache, "shaders/shadows/copy.frag.spv");
+	PipelineDesc clear_desc = tile_desc(cache, "shaders/shadows/clear.frag.spv");
+	cache->caster_pipeline = PipelineCache_Get(&caster_desc);
+	cache->copy_pipeline = PipelineCache_Get(&copy_desc);
+	cache->clear_pipeline = PipelineCache_Get(&clear_desc);
+	cache->sampler = PipelineCache_GetSampler(&(SDL_GPUSamplerCreateInfo){
+		.min_filter = SDL_GPU_FILTER_NEAREST,
+		.mag_filter = SDL_GPU_FILTER_NEAREST,
+		.mipmap_mode = SDL_GPU_SAMPLERMIPMAPMODE_NEAREST,
+		.address_mode_u = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE,
+		.address_mode_v = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE,
+		.address_mode_w = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE
+	});
+	cache->static_depth = create_depth(cache);
+	cache->atlas = create_depth(cache);
+	if(cache->caster_pipeline == NULL || cache->copy_pipeline == NULL || cache->clear_pipeline == NULL ||
+		cache->sampler == NULL || cache->static_depth == NULL || cache->atlas == NULL)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Graphics: Error: Failed to create the shadow cache.");
+		ShadowCache_Destroy(cache);
+		return false;
+	}
+	return true;
+}
+
+/*******************************************************************
+ * TILES ***********************************************************
+ ******************************************************************/
+
+int ShadowCache_AddTile(ShadowCache *cache, Matrix4x4 viewproj)
+{
+	Uint32 capacity = SDL_min(cache->tiles_per_row * cache->tiles_per_row, SHADOWCACHE_MAX_TILES);
+	if(cache->num_tiles == capacity)
+	{
+		return -1;
+	}
+	Uint32 index = cache->num_tiles++;
+	ShadowTile *tile = &cache->tiles[index];
+	*tile = (ShadowTile){
+		.viewproj = viewproj,
+		.frustum = Culling_ExtractFrustum(viewproj),
+		.x = (index % cache->tiles_per_row) * cache->tile_size,
+		.y = (index / cache->tiles_per_row) * cache->tile_size,
+		.dirty = true
+	};
+	float scale = (float)cache->tile_size / (float)cache->size;
+	tile->rect[0] = (float)tile->x / (float)cache->size;
+	tile->rect[1] = (float)tile->y / (float)cache->size;
+	tile->rect[2] = scale;
+	tile->rect[3] = scale;
+	return (int)index;
+}
+
+void ShadowCache_SetTile(ShadowCache *cache, Uint32 tile, Matrix4x4 viewproj)
+{
+	if(tile >= cache->num_tiles || SDL_memcmp(&cache->tiles[tile].viewproj, &viewproj, sizeof(viewproj)) == 0)
+	{
+		return;
+	}
+	cache->tiles[tile].viewproj = viewproj;
+	cache->tiles[tile].frustum = Culling_ExtractFrustum(viewproj);
+	cache->tiles[tile].dirty = true;
+}
+
+//the box's corner furthest along each plane's normal decides
+static bool box_in_frustum(const Frustum *frustum, AABB box)
+{
+	for(int i = 0; i < 6; i++)
+	{
+		Vector4 plane = frustum->planes[i];
+		float reach = SDL_fabsf(plane.x) * box.half_size.x + SDL_fabsf(plane.y) * box.half_size.y +
+						SDL_fabsf(plane.z) * box.half_size.z;
+		if(plane.x * box.center.x + plane.y * box.center.y + plane.z * box.center.z + plane.w < -reach)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+void ShadowCache_InvalidateBounds(ShadowCache *cache, AABB bounds)
+{
+	for(Uint32 i = 0; i < cache->num_tiles; i++)
+	{
+		if(box_in_frustum(&cache->tiles[i].frustum, bounds))
+		{
+			cache->tiles[i].dirty = true;
+		}
+	}
+}
+
+void ShadowCache_InvalidateAll(ShadowCache *cache)
+{
+	for(Uint32 i = 0; i < cache->num_tiles; i++)
+	{
+		cache->tiles[i].dirty = true;
+	}
+}
+
+/*******************************************************************
+ * RENDERING *******************************************************
+ ******************************************************************/
+
+static void set_tile(SDL_GPURenderPass *renderpass, ShadowCache *cache, const ShadowTile *tile)
+{
+	SDL_SetGPUViewport(renderpass, &(SDL_GPUViewport){
+		(float)tile->x, (float)tile->y, (float)cache->tile_size, (float)cache->tile_size, 0.0f, 1.0f });
+	SDL_SetGPUScissor(renderpass, &(SDL_Rect){ (int)tile->x, (int)tile->y, (int)cache->tile_size, (int)cache->tile_size });
+}
+
+static bool any_dirty(ShadowCache *cache)
+{
+	for(Uint32 i = 0; i < cache->num_tiles; i++)
+	{
+		if(cache->tiles[i].dirty)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+bool ShadowCache_Render(ShadowCache *cache, SDL_GPUCommandBuffer *cmdbuf, ShadowDrawFunc draw, void *userdata)
+{
+	cache->stats.tiles = cache->num_tiles;
+	cache->stats.redrawn = 0;
+	cache->stats.composited = 0;
+	if(cache->num_tiles == 0)
+	{
+		return true;
+	}
+
+	//clean tiles keep their content, dirty ones are cleared one by one
+	//since a load op would take the whole texture
+	if(any_dirty(cache))
+	{
+		SDL_GPURenderPass *renderpass = SDL_BeginGPURenderPass(cmdbuf, NULL, 0, &(SDL_GPUDepthStencilTargetInfo){
+			.texture = cache->static_depth,
+			.clear_depth = 1.0f,
+			.load_op = cache->static_valid ? SDL_GPU_LOADOP_LOAD : SDL_GPU_LOADOP_CLEAR,
+			.store_op = SDL_GPU_STOREOP_STORE,
+			.stencil_load_op = SDL_GPU_LOADOP_DONT_CARE,
+			.stencil_store_op = SDL_GPU_STOREOP_DONT_CARE
+		});
+		if(renderpass == NULL)
+		{
+			return false;
+		}
+		for(Uint32 i = 0; i < cache->num_tiles; i++)
+		{
+			ShadowTile *tile = &cache->tiles[i];
+			if(!tile->dirty)
+			{
+				continue;
+			}
+			set_tile(renderpass, cache, tile);
+			if(cache->static_valid)
+			{
+				SDL_BindGPUGraphicsPipeline(renderpass, cache->clear_pipeline);
+				SDL_DrawGPUPrimitives(renderpass, 3, 1, 0, 0);
+			}
+			SDL_BindGPUGraphicsPipeline(renderpass, cache->caster_pipeline);
+			draw(renderpass, cmdbuf, tile, true, userdata);
+			tile->dirty = false;
+			cache->stats.redrawn++;
+		}
+		SDL_EndGPURenderPass(renderpass);
+		cache->static_valid = true;
+		cache->stats.total_redrawn += cache->stats.redrawn;
+	}
+
+	//every tile is overwritten, last frame's atlas can keep being read
+	SDL_GPURenderPass *renderpass = SDL_BeginGPURenderPass(cmdbuf, NULL, 0, &(SDL_GPUDepthStencilTargetInfo){
+		.texture = cache->atlas,
+		.clear_depth = 1.0f,
+		.load_op = SDL_GPU_LOADOP_CLEAR,
+		.store_op = SDL_GPU_STOREOP_STORE,
+		.stencil_load_op = SDL_GPU_LOADOP_DONT_CARE,
+		.stencil_store_op = SDL_GPU_STOREOP_DONT_CARE,
+		.cycle = true
+	});
+	if(renderpass == NULL)
+	{
+		return false;
+	}
+	for(Uint32 i = 0; i < cache->num_tiles; i++)
+	{
+		ShadowTile *tile = &cache->tiles[i];
+		set_tile(renderpass, cache, tile);
+		SDL_BindGPUGraphicsPipeline(renderpass, cache->copy_pipeline);
+		SDL_BindGPUFragmentSamplers(renderpass, 0, &(SDL_GPUTextureSamplerBinding){ cache->static_depth, cache->sampler }, 1);
+		SDL_DrawGPUPrimitives(renderpass, 3, 1, 0, 0);
+		SDL_BindGPUGraphicsPipeline(renderpass, cache->caster_pipeline);
+		draw(renderpass, cmdbuf, tile, false, userdata);
+		cache->stats.composited++;
+	}
+	SDL_EndGPURenderPass(renderpass);
+	return true;
+}
+
+void ShadowCache_PushTransform(SDL_GPUCommandBuffer *cmdbuf, const ShadowTile *tile, Matrix4x4 model)
+{
+	Matrix4x4 mvp = Matrix4x4_Mul(model, tile->viewproj);
+	SDL_PushGPUVertexUniformData(cmdbuf, 0, &mvp, sizeof(mvp));
+}
+
+void ShadowCache_Destroy(ShadowCache *cache)
+{
+	if(cache->device == NULL)
+	{
+		return;
+	}
+	if(cache->static_depth != NULL)
+	{
+		GPUMem_ReleaseTexture(cache->device, cache->static_depth);
+	}
+	if(cache->atlas != NULL)
+	{
+		GPUMem_ReleaseTexture(cache->device, cache->atlas);
+	}
+	SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Shadow cache: %llu tile redraws.",
+				(unsigned long long)cache->stats.total_redrawn);
+	*cache = (ShadowCache){ 0 };
+}
@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2025 Matheus Klein Schaefer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SHADOWCACHE_H
+#define SHADOWCACHE_H
+
+#include <SDL3/SDL.h>
+#include <linmath.h>
+#include <physics.h>
+#include <culling.h>
+
+/*******************************************************************
+ * STRUCTURES AND ENUMS ********************************************
+ ******************************************************************/
+
+#define SHADOWCACHE_MAX_TILES 64
+#define SHADOWCACHE_DEFAULT_SIZE 4096
+#define SHADOWCACHE_DEFAULT_TILE 1024
+
+//one shadow view in the atlas: a spot light, a cascade, a piece of the
+//sun's coverage
+typedef struct ShadowTile
+{
+	Matrix4x4 viewproj;
+	Frustum frustum;
+	Uint32 x, y; //pixel offset in the atlas
+	float rect[4]; //same as uv offset and scale, for lookups
+	bool dirty; //static casters need drawing again
+} ShadowTile;
+
+typedef struct ShadowCacheStats
+{
+	Uint32 tiles;
+	Uint32 redrawn; //tiles whose static casters were drawn this frame
+	Uint32 composited; //tiles copied to the atlas with dynamic casters
+	Uint64 total_redrawn; //since ShadowCache_Init
+} ShadowCacheStats;
+
+//static_casters says which set the tile needs, the cache has already
+//bound its caster pipeline and set the tile's viewport
+//draws push their matrix with ShadowCache_PushTransform
+typedef void (*ShadowDrawFunc)(SDL_GPURenderPass *renderpass, SDL_GPUCommandBuffer *cmdbuf,
+								const ShadowTile *tile, bool static_casters, void *userdata);
+
+//shadow maps split by what moves: static casters are drawn once into a
+//persistent depth texture and kept until their tile's light changes or
+//something static inside it does; every frame each tile is copied into
+//the atlas the lighting reads and only dynamic casters go on top
+typedef struct ShadowCache
+{
+	SDL_GPUDevice *device;
+	SDL_GPUTexture *static_depth;
+	SDL_GPUTexture *atlas;
+	SDL_GPUTextureFormat format;
+	Uint32 size, tile_size, tiles_per_row;
+	SDL_GPUGraphicsPipeline *caster_pipeline;
+	SDL_GPUGraphicsPipeline *copy_pipeline; //static depth into the atlas
+	SDL_GPUGraphicsPipeline *clear_pipeline; //one tile of the static depth
+	SDL_GPUSampler *sampler;
+	ShadowTile tiles[SHADOWCACHE_MAX_TILES];
+	Uint32 num_tiles;
+	bool static_valid; //false until the static depth has been cleared once
+	ShadowCacheStats stats;
+} ShadowCache;
+
+/*******************************************************************
+ * FUNCTIONS *******************************************************
+ ******************************************************************/
+
+//size and tile_size in pixels, 0 for the defaults
+bool ShadowCache_Init(SDL_GPUDevice *device, ShadowCache *cache, Uint32 size, Uint32 tile_size);
+
+//returns the tile index, or -1 when the atlas is full
+int ShadowCache_AddTile(ShadowCache *cache, Matrix4x4 viewproj);
+
+//only a different matrix marks the tile dirty, so lights can be set
+//every frame
+void ShadowCache_SetTile(ShadowCache *cache, Uint32 tile, Matrix4x4 viewproj);
+
+//a static caster moved, appeared or went away: call with its world
+//bounds (before and after for a move), only tiles seeing them redraw
+void ShadowCache_InvalidateBounds(ShadowCache *cache, AABB bounds);
+
+void ShadowCache_InvalidateAll(ShadowCache *cache);
+
+//redraws the dirty tiles' static casters, then rebuilds the atlas with
+//the dynamic ones; call before the passes sampling the atlas, it
+//records its own render passes
+bool ShadowCache_Render(ShadowCache *cache, SDL_GPUCommandBuffer *cmdbuf, ShadowDrawFunc draw, void *userdata);
+
+//vertex uniform slot 0, for use inside ShadowDrawFunc
+void ShadowCache_PushTransform(SDL_GPUCommandBuffer *cmdbuf, const ShadowTile *tile, Matrix4x4 model);
+
+void ShadowCache_Destroy(ShadowCache *cache);
+
+#endif
@@ -0,0 +1,365 @@
+/*
+ * Copyright (C) 2025 Matheus Klein Schaefer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <SDL3/SDL.h>
+#include <staticbatch.h>
+#include <material.h>
+#include <gpumem.h>
+
+//one instance placed in the grid, sorted so cells and then materials
+//come out contiguous
+typedef struct BuildItem
+{
+	int cell_x, cell_y, cell_z;
+	Uint32 material;
+	Uint32 instance;
+} BuildItem;
+
+bool StaticBatch_Init(SDL_GPUDevice *device, StaticBatch *batch, float cell_size)
+{
+	*batch = (StaticBatch){ 0 };
+	batch->device = device;
+	batch->cell_size = (cell_size > 0.0f) ? cell_size : STATICBATCH_DEFAULT_CELL;
+	return Culling_InitBounds(&batch->cell_bounds, 64);
+}
+
+bool StaticBatch_Add(StaticBatch *batch, const Model *model, Matrix4x4 transform)
+{
+	if(model == NULL || batch->vbuffer != NULL)
+	{
+		return false;
+	}
+	for(size_t i = 0; i < model->meshes.count; i++)
+	{
+		if(batch->num_instances == batch->instances_capacity)
+		{
+			Uint32 new_capacity = (batch->instances_capacity == 0) ? 64 : batch->instances_capacity * 2;
+			StaticInstance *aux = (StaticInstance*)SDL_realloc(batch->instances, sizeof(StaticInstance) * new_capacity);
+			if(aux == NULL)
+			{
+				return false;
+			}
+			batch->instances = aux;
+			batch->instances_capacity = new_capacity;
+		}
+		batch->instances[batch->num_instances++] = (StaticInstance){ &model->meshes.meshes[i], transform };
+	}
+	return true;
+}
+
+/*******************************************************************
+ * BUILD ***********************************************************
+ ******************************************************************/
+
+//same pipeline and same textures, so one draw can cover both
+static bool same_material(const Material *a, const Material *b)
+{
+	return Material_GetStateId(a) == Material_GetStateId(b) && a->num_textures == b->num_textures &&
+			SDL_memcmp(a->textures, b->textures, sizeof(a->textures)) == 0;
+}
+
+static int compare_items(const void *a, const void *b)
+{
+	const BuildItem *x = (const BuildItem*)a;
+	const BuildItem *y = (const BuildItem*)b;
+	if(x->cell_x != y->cell_x) return (x->cell_x > y->cell_x) - (x->cell_x < y->cell_x);
+	if(x->cell_y != y->cell_y) return (x->cell_y > y->cell_y) - (x->cell_y < y->cell_y);
+	if(x->cell_z != y->cell_z) return (x->cell_z > y->cell_z) - (x->cell_z < y->cell_z);
+	if(x->material != y->material) return (x->material > y->material) - (x->material < y->material);
+	return (x->instance > y->instance) - (x->instance < y->instance);
+}
+
+static AABB merge_bounds(AABB a, AABB b)
+{
+	Vector3 min = {
+		SDL_min(a.center.x - a.half_size.x, b.center.x - b.half_size.x),
+		SDL_min(a.center.y - a.half_size.y, b.center.y - b.half_size.y),
+		SDL_min(a.center.z - a.half_size.z, b.center.z - b.half_size.z)
+	};
+	Vector3 max = {
+		SDL_max(a.center.x + a.half_size.x, b.center.x + b.half_size.x),
+		SDL_max(a.center.y + a.half_size.y, b.center.y + b.half_size.y),
+		SDL_max(a.center.z + a.half_size.z, b.center.z + b.half_size.z)
+	};
+	return (AABB){ Vector3_Scale(Vector3_Add(min, max), 0.5f), Vector3_Scale(Vector3_Sub(max, min), 0.5f) };
+}
+
+static Vector3 transform_point(Vector3 p, const Matrix4x4 *m)
+{
+	return (Vector3){
+		p.x * m->aa + p.y * m->ba + p.z * m->ca + m->da,
+		p.x * m->ab + p.y * m->bb + p.z * m->cb + m->db,
+		p.x * m->ac + p.y * m->bc + p.z * m->cc + m->dc
+	};
+}
+
+//assigns cells and material ids, counts the merged size
+static BuildItem *place_instances(StaticBatch *batch, Uint32 *num_vertices, Uint32 *num_indices)
+{
+	BuildItem *items = (BuildItem*)SDL_malloc(sizeof(BuildItem) * batch->num_instances);
+	const Material **materials = (const Material**)SDL_malloc(sizeof(Material*) * batch->num_instances);
+	if(items == NULL || materials == NULL)
+	{
+		SDL_free(items);
+		SDL_free(materials);
+		return NULL;
+	}
+	Uint32 num_materials = 0;
+	*num_vertices = *num_indices = 0;
+	for(Uint32 i = 0; i < batch->num_instances; i++)
+	{
+		const StaticInstance *instance = &batch->instances[i];
+		//a mesh goes wholly into the cell holding its center, cell bounds
+		//grow to fit instead of splitting triangles
+		AABB bounds = Culling_TransformAABB(instance->mesh->bounds, instance->transform);
+		Uint32 material = 0;
+		while(material < num_materials && !same_material(materials[material], &instance->mesh->material))
+		{
+			material++;
+		}
+		if(material == num_materials)
+		{
+			materials[num_materials++] = &instance->mesh->material;
+		}
+		items[i] = (BuildItem){
+			(int)SDL_floorf(bounds.center.x / batch->cell_size),
+			(int)SDL_floorf(bounds.center.y / batch->cell_size),
+			(int)SDL_floorf(bounds.center.z / batch->cell_size),
+			material, i
+		};
+		*num_vertices += (Uint32)instance->mesh->varray.count;
+		*num_indices += (Uint32)instance->mesh->iarray.count;
+	}
+	SDL_free(materials);
+	SDL_qsort(items, batch->num_instances, sizeof(BuildItem), compare_items);
+	return items;
+}
+
+static bool upload(StaticBatch *batch, const Vertex3D *vertices, Uint32 num_vertices,
+					const Uint32 *indices, Uint32 num_indices)
+{
+	Uint32 vsize = sizeof(Vertex3D) * num_vertices;
+	Uint32 isize = sizeof(Uint32) * num_indices;
+	batch->vbuffer = GPUMem_CreateBuffer(batch->device, &(SDL_GPUBufferCreateInfo){
+		.usage = SDL_GPU_BUFFERUSAGE_VERTEX,
+		.size = vsize
+	});
+	batch->ibuffer = GPUMem_CreateBuffer(batch->device, &(SDL_GPUBufferCreateInfo){
+		.usage = SDL_GPU_BUFFERUSAGE_INDEX,
+		.size = isize
+	});
+	SDL_GPUTransferBuffer *transfer = GPUMem_CreateTransferBuffer(batch->device, &(SDL_GPUTransferBufferCreateInfo){
+		.usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
+		.size = vsize + isize
+	});
+	if(batch->vbuffer == NULL || batch->ibuffer == NULL || transfer == NULL)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Graphics: Error: Failed to create static batch buffers: %s", SDL_GetError());
+		if(transfer != NULL)
+		{
+			GPUMem_ReleaseTransferBuffer(batch->device, transfer);
+		}
+		return false;
+	}
+	Uint8 *mapped = (Uint8*)SDL_MapGPUTransferBuffer(batch->device, transfer, false);
+	if(mapped == NULL)
+	{
+		GPUMem_ReleaseTransferBuffer(batch->device, transfer);
+		return false;
+	}
+	SDL_memcpy(mapped, vertices, vsize);
+	SDL_memcpy(mapped + vsize, indices, isize);
+	SDL_UnmapGPUTransferBuffer(batch->device, transfer);
+
+	SDL_GPUCommandBuffer *cmdbuf = SDL_AcquireGPUCommandBuffer(batch->device);
+	if(cmdbuf == NULL)
+	{
+		GPUMem_ReleaseTransferBuffer(batch->device, transfer);
+		return false;
+	}
+	SDL_GPUCopyPass *copypass = SDL_BeginGPUCopyPass(cmdbuf);
+	SDL_UploadToGPUBuffer(copypass,
+		&(SDL_GPUTransferBufferLocation){ .transfer_buffer = transfer, .offset = 0 },
+		&(SDL_GPUBufferRegion){ .buffer = batch->vbuffer, .offset = 0, .size = vsize },
+		false);
+	SDL_UploadToGPUBuffer(copypass,
+		&(SDL_GPUTransferBufferLocation){ .transfer_buffer = transfer, .offset = vsize },
+		&(SDL_GPUBufferRegion){ .buffer = batch->ibuffer, .offset = 0, .size = isize },
+		false);
+	SDL_EndGPUCopyPass(copypass);
+	bool ok = SDL_SubmitGPUCommandBuffer(cmdbuf);
+	GPUMem_ReleaseTransferBuffer(batch->device, transfer);
+	return ok;
+}
+
+//back to the state before the build, the instances stay for a retry
+static void discard_build(StaticBatch *batch)
+{
+	if(batch->vbuffer != NULL)
+	{
+		GPUMem_ReleaseBuffer(batch->device, batch->vbuffer);
+		batch->vbuffer = NULL;
+	}
+	if(batch->ibuffer != NULL)
+	{
+		GPUMem_ReleaseBuffer(batch->device, batch->ibuffer);
+		batch->ibuffer = NULL;
+	}
+	Culling_ResetBounds(&batch->cell_bounds);
+	SDL_free(batch->ranges);
+	SDL_free(batch->cells);
+	SDL_free(batch->visible_cells);
+	batch->ranges = NULL;
+	batch->cells = NULL;
+	batch->visible_cells = NULL;
+	batch->num_ranges = batch->num_cells = 0;
+}
+
+bool StaticBatch_Build(StaticBatch *batch)
+{
+	if(batch->num_instances == 0 || batch->vbuffer != NULL)
+	{
+		return false;
+	}
+	Uint32 num_vertices, num_indices;
+	BuildItem *items = place_instances(batch, &num_vertices, &num_indices);
+	Vertex3D *vertices = (Vertex3D*)SDL_malloc(sizeof(Vertex3D) * (num_vertices + 1));
+	Uint32 *indices = (Uint32*)SDL_malloc(sizeof(Uint32) * (num_indices + 1));
+	//at worst one range and one cell per instance
+	batch->ranges = (StaticRange*)SDL_malloc(sizeof(StaticRange) * batch->num_instances);
+	batch->cells = (StaticCell*)SDL_malloc(sizeof(StaticCell) * batch->num_instances);
+	bool ok = items != NULL && vertices != NULL && indices != NULL && batch->ranges != NULL && batch->cells != NULL;
+
+	Uint32 vertex = 0, index = 0;
+	for(Uint32 i = 0; ok && i < batch->num_instances; i++)
+	{
+		const BuildItem *item = &items[i];
+		const StaticInstance *instance = &batch->instances[item->instance];
+		const Mesh *mesh = instance->mesh;
+		AABB bounds = Culling_TransformAABB(mesh->bounds, instance->transform);
+		bool new_cell = i == 0 || item->cell_x != items[i - 1].cell_x ||
+						item->cell_y != items[i - 1].cell_y || item->cell_z != items[i - 1].cell_z;
+		if(new_cell)
+		{
+			batch->cells[batch->num_cells++] = (StaticCell){ bounds, batch->num_ranges, 0 };
+		}
+		StaticCell *cell = &batch->cells[batch->num_cells - 1];
+		if(new_cell || item->material != items[i - 1].material)
+		{
+			batch->ranges[batch->num_ranges++] = (StaticRange){ mesh, index, 0, batch->num_cells - 1, bounds };
+			cell->num_ranges++;
+		}
+		StaticRange *range = &batch->ranges[batch->num_ranges - 1];
+		range->bounds = merge_bounds(range->bounds, bounds);
+		cell->bounds = merge_bounds(cell->bounds, bounds);
+
+		//world space positions, indices rebased onto the merged vertices
+		for(size_t v = 0; v < mesh->varray.count; v++)
+		{
+			vertices[vertex + v] = mesh->varray.vertices[v];
+			vertices[vertex + v].position = transform_point(mesh->varray.vertices[v].position, &instance->transform);
+		}
+		for(size_t n = 0; n < mesh->iarray.count; n++)
+		{
+			indices[index + n] = mesh->iarray.indices[n] + vertex;
+		}
+		vertex += (Uint32)mesh->varray.count;
+		index += (Uint32)mesh->iarray.count;
+		range->index_count += (Uint32)mesh->iarray.count;
+	}
+	for(Uint32 i = 0; ok && i < batch->num_cells; i++)
+	{
+		ok = Culling_AddBounds(&batch->cell_bounds, batch->cells[i].bounds) >= 0;
+	}
+	batch->visible_cells = ok ? (Uint32*)SDL_malloc(sizeof(Uint32) * batch->num_cells) : NULL;
+	ok = ok && batch->visible_cells != NULL && upload(batch, vertices, num_vertices, indices, num_indices);
+
+	if(ok)
+	{
+		batch->stats = (StaticBatchStats){
+			.meshes = batch->num_instances,
+			.ranges = batch->num_ranges,
+			.cells = batch->num_cells,
+			.vertices = num_vertices,
+			.indices = num_indices
+		};
+		SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Static batch: %u meshes in %u draws over %u cells.",
+					batch->num_instances, batch->num_ranges, batch->num_cells);
+		SDL_free(batch->instances);
+		batch->instances = NULL;
+		batch->num_instances = batch->instances_capacity = 0;
+	}
+	else
+	{
+		discard_build(batch);
+	}
+	SDL_free(items);
+	SDL_free(vertices);
+	SDL_free(indices);
+	return ok;
+}
+
+/*******************************************************************
+ * DRAWING *********************************************************
+ ******************************************************************/
+
+Uint32 StaticBatch_Cull(StaticBatch *batch, const Frustum *frustum, Uint32 *ranges)
+{
+	if(batch->vbuffer == NULL)
+	{
+		return 0;
+	}
+	size_t num_visible = Culling_CullFrustum(&batch->cell_bounds, frustum, batch->visible_cells);
+	Uint32 count = 0;
+	for(size_t i = 0; i < num_visible; i++)
+	{
+		const StaticCell *cell = &batch->cells[batch->visible_cells[i]];
+		for(Uint32 r = 0; r < cell->num_ranges; r++)
+		{
+			ranges[count++] = cell->first_range + r;
+		}
+	}
+	batch->stats.visible_ranges = count;
+	return count;
+}
+
+void StaticBatch_Bind(const StaticBatch *batch, SDL_GPURenderPass *renderpass)
+{
+	SDL_BindGPUVertexBuffers(renderpass, 0, &(SDL_GPUBufferBinding){ batch->vbuffer, 0 }, 1);
+	SDL_BindGPUIndexBuffer(renderpass, &(SDL_GPUBufferBinding){ batch->ibuffer, 0 }, SDL_GPU_INDEXELEMENTSIZE_32BIT);
+}
+
+void StaticBatch_Destroy(StaticBatch *batch)
+{
+	if(batch->device == NULL)
+	{
+		return;
+	}
+	if(batch->vbuffer != NULL)
+	{
+		GPUMem_ReleaseBuffer(batch->device, batch->vbuffer);
+	}
+	if(batch->ibuffer != NULL)
+	{
+		GPUMem_ReleaseBuffer(batch->device, batch->ibuffer);
+	}
+	Culling_DestroyBounds(&batch->cell_bounds);
+	SDL_free(batch->instances);
+	SDL_free(batch->ranges);
+	SDL_free(batch->cells);
+	SDL_free(batch->visible_cells);
+	*batch = (StaticBatch){ 0 };
+}
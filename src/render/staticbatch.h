@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2025 Matheus Klein Schaefer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef STATICBATCH_H
+#define STATICBATCH_H
+
+#include <SDL3/SDL.h>
+#include <linmath.h>
+#include <assets.h>
+#include <culling.h>
+
+/*******************************************************************
+ * STRUCTURES AND ENUMS ********************************************
+ ******************************************************************/
+
+//edge of the world space grid static geometry is split into
+#define STATICBATCH_DEFAULT_CELL 32.0f
+
+//a mesh waiting for StaticBatch_Build
+typedef struct StaticInstance
+{
+	const Mesh *mesh;
+	Matrix4x4 transform;
+} StaticInstance;
+
+//every static mesh of one cell sharing a material, one draw call
+typedef struct StaticRange
+{
+	//first mesh merged in, its material and textures stand for all of them
+	const Mesh *source;
+	Uint32 first_index, index_count;
+	Uint32 cell;
+	AABB bounds; //world space
+} StaticRange;
+
+typedef struct StaticCell
+{
+	AABB bounds; //world space, of everything assigned to the cell
+	Uint32 first_range, num_ranges;
+} StaticCell;
+
+typedef struct StaticBatchStats
+{
+	Uint32 meshes; //draw calls it would take without batching
+	Uint32 ranges;
+	Uint32 cells;
+	Uint32 vertices, indices;
+	Uint32 visible_ranges; //from the last StaticBatch_Cull
+} StaticBatchStats;
+
+//geometry that never moves, merged once when the scene is built: the
+//vertices are pre-transformed into world space, so a whole cell's worth
+//of meshes with one material draws with a single call and no per
+//object uniforms
+typedef struct StaticBatch
+{
+	SDL_GPUDevice *device;
+	float cell_size;
+
+	//collected by StaticBatch_Add, dropped by StaticBatch_Build
+	StaticInstance *instances;
+	Uint32 num_instances, instances_capacity;
+
+	//shared by every range, bind once
+	SDL_GPUBuffer *vbuffer;
+	SDL_GPUBuffer *ibuffer;
+
+	StaticRange *ranges;
+	Uint32 num_ranges;
+	StaticCell *cells; //ranges of a cell are contiguous
+	Uint32 num_cells;
+	CullingBounds cell_bounds;
+	Uint32 *visible_cells;
+
+	StaticBatchStats stats;
+} StaticBatch;
+
+/*******************************************************************
+ * FUNCTIONS *******************************************************
+ ******************************************************************/
+
+//cell_size 0 picks STATICBATCH_DEFAULT_CELL
+bool StaticBatch_Init(SDL_GPUDevice *device, StaticBatch *batch, float cell_size);
+
+//queues every mesh of the model at that transform, reads the RAM
+//buffers the loader keeps; the model must outlive the batch since the
+//ranges point at its meshes for materials and textures
+bool StaticBatch_Add(StaticBatch *batch, const Model *model, Matrix4x4 transform);
+
+//merges and uploads everything added, once per scene
+bool StaticBatch_Build(StaticBatch *batch);
+
+//writes the indices of the ranges in cells touching the frustum to
+//ranges (must hold num_ranges entries) and returns how many
+Uint32 StaticBatch_Cull(StaticBatch *batch, const Frustum *frustum, Uint32 *ranges);
+
+//buffers for every range, then draw with first_index and no vertex offset
+void StaticBatch_Bind(const StaticBatch *batch, SDL_GPURenderPass *renderpass);
+
+void StaticBatch_Destroy(StaticBatch *batch);
+
+#endif
@@ -0,0 +1,239 @@
+/*
+ * Copyright (C) 2025 Matheus Klein Schaefer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <SDL3/SDL.h>
+#include <texarray.h>
+#include <gpumem.h>
+
+void TexArray_Init(SDL_GPUDevice *device, TextureArrays *arrays)
+{
+	*arrays = (TextureArrays){ 0 };
+	arrays->device = device;
+}
+
+//LoadTextureFile converts everything to ABGR8888
+static SDL_GPUTextureFormat gpu_format(SDL_PixelFormat format)
+{
+	switch(format)
+	{
+		case SDL_PIXELFORMAT_ABGR8888: return SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM;
+		default: return SDL_GPU_TEXTUREFORMAT_INVALID;
+	}
+}
+
+//an array still being filled, with room for one more layer
+static int find_array(TextureArrays *arrays, Uint32 first_new, SDL_GPUTextureFormat format,
+						Uint32 width, Uint32 height)
+{
+	for(Uint32 i = first_new; i < arrays->num_arrays; i++)
+	{
+		TextureArray *array = &arrays->arrays[i];
+		if(array->format == format && array->width == width && array->height == height &&
+			array->num_layers < TEXARRAY_MAX_LAYERS)
+		{
+			return (int)i;
+		}
+	}
+	if(arrays->num_arrays == TEXARRAY_MAX_ARRAYS)
+	{
+		return -1;
+	}
+	arrays->arrays[arrays->num_arrays] = (TextureArray){ .format = format, .width = width, .height = height };
+	return (int)arrays->num_arrays++;
+}
+
+static bool upload(TextureArrays *arrays, Uint32 first_new, SDL_Surface **sources)
+{
+	Uint32 size = 0;
+	for(Uint32 i = first_new; i < arrays->num_arrays; i++)
+	{
+		TextureArray *array = &arrays->arrays[i];
+		array->texture = GPUMem_CreateTexture(arrays->device, &(SDL_GPUTextureCreateInfo){
+			.type = SDL_GPU_TEXTURETYPE_2D_ARRAY,
+			.format = array->format,
+			.usage = SDL_GPU_TEXTUREUSAGE_SAMPLER,
+			.width = array->width,
+			.height = array->height,
+			.layer_count_or_depth = array->num_layers,
+			.num_levels = 1
+		});
+		if(array->texture == NULL)
+		{
+			SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Graphics: Error: Failed to create texture array: %s", SDL_GetError());
+			return false;
+		}
+		size += array->width * array->height * SDL_GPUTextureFormatTexelBlockSize(array->format) * array->num_layers;
+	}
+	if(size == 0)
+	{
+		return true;
+	}
+
+	SDL_GPUTransferBuffer *transfer = GPUMem_CreateTransferBuffer(arrays->device, &(SDL_GPUTransferBufferCreateInfo){
+		.usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
+		.size = size
+	});
+	if(transfer == NULL)
+	{
+		return false;
+	}
+	Uint8 *mapped = (Uint8*)SDL_MapGPUTransferBuffer(arrays->device, transfer, false);
+	if(mapped == NULL)
+	{
+		GPUMem_ReleaseTransferBuffer(arrays->device, transfer);
+		return false;
+	}
+
+	SDL_GPUCommandBuffer *cmdbuf = SDL_AcquireGPUCommandBuffer(arrays->device);
+	if(cmdbuf == NULL)
+	{
+		SDL_UnmapGPUTransferBuffer(arrays->device, transfer);
+		GPUMem_ReleaseTransferBuffer(arrays->device, transfer);
+		return false;
+	}
+	SDL_GPUCopyPass *copypass = SDL_BeginGPUCopyPass(cmdbuf);
+	Uint32 offset = 0;
+	for(Uint32 i = first_new; i < arrays->num_arrays; i++)
+	{
+		TextureArray *array = &arrays->arrays[i];
+		Uint32 row = array->width * SDL_GPUTextureFormatTexelBlockSize(array->format);
+		for(Uint32 layer = 0; layer < array->num_layers; layer++)
+		{
+			//surfaces may have padded rows, the transfer is tightly packed
+			SDL_Surface *surface = sources[i * TEXARRAY_MAX_LAYERS + layer];
+			for(Uint32 y = 0; y < array->height; y++)
+			{
+				SDL_memcpy(mapped + offset + y * row, (Uint8*)surface->pixels + y * surface->pitch, row);
+			}
+			SDL_UploadToGPUTexture(copypass,
+				&(SDL_GPUTextureTransferInfo){ .transfer_buffer = transfer, .offset = offset },
+				&(SDL_GPUTextureRegion){
+					.texture = array->texture,
+					.layer = layer,
+					.w = array->width,
+					.h = array->height,
+					.d = 1
+				},
+				false);
+			offset += row * array->height;
+		}
+	}
+	SDL_UnmapGPUTransferBuffer(arrays->device, transfer);
+	SDL_EndGPUCopyPass(copypass);
+	bool ok = SDL_SubmitGPUCommandBuffer(cmdbuf);
+	GPUMem_ReleaseTransferBuffer(arrays->device, transfer);
+	return ok;
+}
+
+bool TexArray_Pack(TextureArrays *arrays, Model **models, Uint32 count)
+{
+	Uint32 first_new = arrays->num_arrays;
+	Uint32 total = 0;
+	for(Uint32 m = 0; m < count; m++)
+	{
+		total += (models[m] != NULL) ? (Uint32)models[m]->meshes.count : 0;
+	}
+	SDL_Surface **sources = (SDL_Surface**)SDL_calloc(TEXARRAY_MAX_ARRAYS * TEXARRAY_MAX_LAYERS, sizeof(SDL_Surface*));
+	Mesh **packed = (Mesh**)SDL_malloc(sizeof(Mesh*) * (total + 1));
+	Uint32 *packed_array = (Uint32*)SDL_malloc(sizeof(Uint32) * (total + 1));
+	if(sources == NULL || packed == NULL || packed_array == NULL)
+	{
+		SDL_free(sources);
+		SDL_free(packed);
+		SDL_free(packed_array);
+		return false;
+	}
+
+	//pick a layer for every texture first, the array sizes must be
+	//known before creating them
+	Uint32 num_packed = 0;
+	for(Uint32 m = 0; m < count; m++)
+	{
+		if(models[m] == NULL)
+		{
+			continue;
+		}
+		for(size_t i = 0; i < models[m]->meshes.count; i++)
+		{
+			Mesh *mesh = &models[m]->meshes.meshes[i];
+			SDL_Surface *surface = mesh->diffuse.surface;
+			SDL_GPUTextureFormat format = (surface != NULL) ? gpu_format(surface->format) : SDL_GPU_TEXTUREFORMAT_INVALID;
+			int index = -1;
+			if(format != SDL_GPU_TEXTUREFORMAT_INVALID && mesh->diffuse_array == NULL)
+			{
+				index = find_array(arrays, first_new, format, (Uint32)surface->w, (Uint32)surface->h);
+			}
+			if(index < 0)
+			{
+				arrays->skipped_meshes++;
+				continue;
+			}
+			TextureArray *array = &arrays->arrays[index];
+			sources[index * TEXARRAY_MAX_LAYERS + array->num_layers] = surface;
+			mesh->diffuse_layer = array->num_layers++;
+			packed[num_packed] = mesh;
+			packed_array[num_packed++] = (Uint32)index;
+		}
+	}
+
+	bool ok = upload(arrays, first_new, sources);
+	for(Uint32 i = 0; ok && i < num_packed; i++)
+	{
+		packed[i]->diffuse_array = arrays->arrays[packed_array[i]].texture;
+	}
+	if(ok)
+	{
+		arrays->packed_meshes += num_packed;
+		SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Texture arrays: %u meshes in %u arrays, %u left out.",
+					arrays->packed_meshes, arrays->num_arrays, arrays->skipped_meshes);
+	}
+	else
+	{
+		for(Uint32 i = first_new; i < arrays->num_arrays; i++)
+		{
+			if(arrays->arrays[i].texture != NULL)
+			{
+				GPUMem_ReleaseTexture(arrays->device, arrays->arrays[i].texture);
+			}
+		}
+		arrays->num_arrays = first_new;
+	}
+
+	SDL_free(sources);
+	SDL_free(packed);
+	SDL_free(packed_array);
+	return ok;
+}
+
+void TexArray_Destroy(TextureArrays *arrays, Model **models, Uint32 count)
+{
+	if(arrays->device == NULL)
+	{
+		return;
+	}
+	for(Uint32 m = 0; m < count; m++)
+	{
+		for(size_t i = 0; models[m] != NULL && i < models[m]->meshes.count; i++)
+		{
+			models[m]->meshes.meshes[i].diffuse_array = NULL;
+		}
+	}
+	for(Uint32 i = 0; i < arrays->num_arrays; i++)
+	{
+		GPUMem_ReleaseTexture(arrays->device, arrays->arrays[i].texture);
+	}
+	*arrays = (TextureArrays){ 0 };
+}
@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2025 Matheus Klein Schaefer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef TEXARRAY_H
+#define TEXARRAY_H
+
+#include <SDL3/SDL.h>
+#include <assets.h>
+
+/*******************************************************************
+ * STRUCTURES AND ENUMS ********************************************
+ ******************************************************************/
+
+#define TEXARRAY_MAX_ARRAYS 16
+//lowest maxImageArrayLayers Vulkan allows
+#define TEXARRAY_MAX_LAYERS 256
+
+//diffuse textures of one size and format as layers of a 2D array, so
+//meshes using any of them can share one sampler binding
+typedef struct TextureArray
+{
+	SDL_GPUTexture *texture;
+	SDL_GPUTextureFormat format;
+	Uint32 width, height;
+	Uint32 num_layers;
+} TextureArray;
+
+typedef struct TextureArrays
+{
+	SDL_GPUDevice *device;
+	TextureArray arrays[TEXARRAY_MAX_ARRAYS];
+	Uint32 num_arrays;
+	Uint32 packed_meshes, skipped_meshes;
+} TextureArrays;
+
+/*******************************************************************
+ * FUNCTIONS *******************************************************
+ ******************************************************************/
+
+void TexArray_Init(SDL_GPUDevice *device, TextureArrays *arrays);
+
+//at load time, after the models are imported: groups their diffuse
+//textures by size and format, uploads the arrays from the surfaces the
+//loader keeps and sets diffuse_array and diffuse_layer on each mesh
+//meshes that don't fit keep drawing with their own texture
+//the arrays don't grow afterwards, call once with every model
+bool TexArray_Pack(TextureArrays *arrays, Model **models, Uint32 count);
+
+//also clears the arrays from the meshes that still point at them
+void TexArray_Destroy(TextureArrays *arrays, Model **models, Uint32 count);
+
+#endif
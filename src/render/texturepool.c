@@ -0,0 +1,308 @@
+/*
+ * Copyright (C) 2025 Matheus Klein Schaefer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <SDL3/SDL.h>
+#include <texturepool.h>
+#include <gpumem.h>
+
+typedef struct PoolEntry
+{
+	SDL_GPUTexture *texture;
+	TexturePoolDesc desc;
+	Uint32 size;
+	bool in_use;
+	Uint64 last_frame; //last frame that used it
+} PoolEntry;
+
+typedef struct PoolFence
+{
+	SDL_GPUFence *fence;
+	Uint64 frame;
+} PoolFence;
+
+static SDL_GPUDevice *pool_device = NULL;
+static PoolEntry entries[TEXTUREPOOL_MAX_TEXTURES];
+static Uint32 entry_count = 0;
+static PoolFence fences[TEXTUREPOOL_FRAMES];
+static Uint64 current_frame = 1;
+//every frame up to this one is known to be finished on the GPU
+static Uint64 completed_frame = 0;
+static TexturePoolStats stats;
+
+bool TexturePool_Init(SDL_GPUDevice *device)
+{
+	if(device == NULL)
+	{
+		return false;
+	}
+	pool_device = device;
+	entry_count = 0;
+	SDL_zeroa(fences);
+	current_frame = 1;
+	completed_frame = 0;
+	stats = (TexturePoolStats){ 0 };
+	return true;
+}
+
+/*******************************************************************
+ * FRAMES **********************************************************
+ ******************************************************************/
+
+//the queue finishes in order, so a signaled fence also covers every
+//frame before it
+static void poll_fences()
+{
+	for(int i = 0; i < TEXTUREPOOL_FRAMES; i++)
+	{
+		PoolFence *slot = &fences[i];
+		if(slot->fence == NULL || !SDL_QueryGPUFence(pool_device, slot->fence))
+		{
+			continue;
+		}
+		completed_frame = SDL_max(completed_frame, slot->frame);
+		SDL_ReleaseGPUFence(pool_device, slot->fence);
+		slot->fence = NULL;
+	}
+}
+
+bool TexturePool_Submit(SDL_GPUCommandBuffer *cmdbuf)
+{
+	if(pool_device == NULL)
+	{
+		return SDL_SubmitGPUCommandBuffer(cmdbuf);
+	}
+	PoolFence *slot = &fences[current_frame % TEXTUREPOOL_FRAMES];
+	if(slot->fence != NULL)
+	{
+		//the GPU is more than TEXTUREPOOL_FRAMES behind, that frame just
+		//never counts as done and its textures keep cycling
+		SDL_ReleaseGPUFence(pool_device, slot->fence);
+		slot->fence = NULL;
+	}
+	slot->fence = SDL_SubmitGPUCommandBufferAndAcquireFence(cmdbuf);
+	slot->frame = current_frame;
+	current_frame++;
+	poll_fences();
+	return slot->fence != NULL;
+}
+
+Uint64 TexturePool_GetFrame()
+{
+	return current_frame;
+}
+
+bool TexturePool_FrameDone(Uint64 frame)
+{
+	if(frame <= completed_frame)
+	{
+		return true;
+	}
+	poll_fences();
+	return frame <= completed_frame;
+}
+
+/*******************************************************************
+ * TEXTURES ********************************************************
+ ******************************************************************/
+
+static bool same_desc(const TexturePoolDesc *a, const TexturePoolDesc *b)
+{
+	return a->width == b->width && a->height == b->height && a->format == b->format &&
+			a->usage == b->usage && a->sample_count == b->sample_count;
+}
+
+static void remove_entry(Uint32 index)
+{
+	PoolEntry *entry = &entries[index];
+	GPUMem_ReleaseTexture(pool_device, entry->texture);
+	stats.bytes -= entry->size;
+	stats.idle_bytes -= entry->size;
+	stats.released++;
+	entries[index] = entries[--entry_count];
+}
+
+//oldest idle texture, or -1
+static int oldest_idle()
+{
+	int oldest = -1;
+	for(Uint32 i = 0; i < entry_count; i++)
+	{
+		if(!entries[i].in_use && (oldest < 0 || entries[i].last_frame < entries[oldest].last_frame))
+		{
+			oldest = (int)i;
+		}
+	}
+	return oldest;
+}
+
+static void enforce_budget()
+{
+	while(stats.idle_bytes > TEXTUREPOOL_IDLE_BUDGET)
+	{
+		int oldest = oldest_idle();
+		if(oldest < 0)
+		{
+			break;
+		}
+		remove_entry((Uint32)oldest);
+	}
+}
+
+SDL_GPUTexture *TexturePool_Acquire(const TexturePoolDesc *desc, bool *cycle)
+{
+	if(pool_device == NULL || desc == NULL)
+	{
+		return NULL;
+	}
+	bool dummy;
+	cycle = (cycle != NULL) ? cycle : &dummy;
+	poll_fences();
+
+	//prefer one the GPU is done with, so it needn't be cycled
+	int match = -1;
+	for(Uint32 i = 0; i < entry_count; i++)
+	{
+		PoolEntry *entry = &entries[i];
+		if(entry->in_use || !same_desc(&entry->desc, desc))
+		{
+			continue;
+		}
+		//same frame means another user just finished with it in
+		//submission order
+		bool done = entry->last_frame == current_frame || entry->last_frame <= completed_frame;
+		if(match < 0 || done)
+		{
+			match = (int)i;
+		}
+		if(done)
+		{
+			break;
+		}
+	}
+	if(match >= 0)
+	{
+		PoolEntry *entry = &entries[match];
+		*cycle = !(entry->last_frame == current_frame || entry->last_frame <= completed_frame);
+		entry->in_use = true;
+		entry->last_frame = current_frame;
+		stats.idle_bytes -= entry->size;
+		stats.in_use++;
+		stats.reused++;
+		return entry->texture;
+	}
+
+	if(entry_count == TEXTUREPOOL_MAX_TEXTURES)
+	{
+		int oldest = oldest_idle();
+		if(oldest < 0)
+		{
+			SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Graphics: Error: Texture pool is full.");
+			return NULL;
+		}
+		remove_entry((Uint32)oldest);
+	}
+	SDL_GPUSampleCount samples = desc->sample_count;
+	SDL_GPUTexture *texture = GPUMem_CreateTexture(
+		pool_device,
+		&(SDL_GPUTextureCreateInfo) {
+			.type = SDL_GPU_TEXTURETYPE_2D,
+			.width = desc->width,
+			.height = desc->height,
+			.layer_count_or_depth = 1,
+			.num_levels = 1,
+			.sample_count = samples,
+			.format = desc->format,
+			.usage = desc->usage
+		}
+	);
+	if(texture == NULL)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Graphics: Error: Failed to create pooled texture: %s", SDL_GetError());
+		return NULL;
+	}
+	PoolEntry *entry = &entries[entry_count++];
+	*entry = (PoolEntry){
+		.texture = texture,
+		.desc = *desc,
+		.size = SDL_CalculateGPUTextureFormatSize(desc->format, desc->width, desc->height, 1) << (Uint32)samples,
+		.in_use = true,
+		.last_frame = current_frame
+	};
+	stats.bytes += entry->size;
+	stats.in_use++;
+	stats.created++;
+	*cycle = false;
+	return texture;
+}
+
+void TexturePool_Release(SDL_GPUTexture *texture)
+{
+	for(Uint32 i = 0; i < entry_count; i++)
+	{
+		PoolEntry *entry = &entries[i];
+		if(entry->texture == texture && entry->in_use)
+		{
+			entry->in_use = false;
+			entry->last_frame = current_frame;
+			stats.idle_bytes += entry->size;
+			stats.in_use--;
+			enforce_budget();
+			return;
+		}
+	}
+}
+
+void TexturePool_Trim()
+{
+	for(Uint32 i = entry_count; i > 0; i--)
+	{
+		if(!entries[i - 1].in_use)
+		{
+			remove_entry(i - 1);
+		}
+	}
+}
+
+TexturePoolStats TexturePool_GetStats()
+{
+	TexturePoolStats current = stats;
+	current.textures = entry_count;
+	return current;
+}
+
+void TexturePool_Destroy()
+{
+	if(pool_device == NULL)
+	{
+		return;
+	}
+	for(Uint32 i = 0; i < entry_count; i++)
+	{
+		GPUMem_ReleaseTexture(pool_device, entries[i].texture);
+	}
+	for(int i = 0; i < TEXTUREPOOL_FRAMES; i++)
+	{
+		if(fences[i].fence != NULL)
+		{
+			SDL_ReleaseGPUFence(pool_device, fences[i].fence);
+		}
+	}
+	SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Texture pool: %u created, %u reused, %u released.",
+				stats.created, stats.reused, stats.released);
+	entry_count = 0;
+	SDL_zeroa(fences);
+	pool_device = NULL;
+}
@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2025 Matheus Klein Schaefer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef TEXTUREPOOL_H
+#define TEXTUREPOOL_H
+
+#include <SDL3/SDL.h>
+
+/*******************************************************************
+ * STRUCTURES AND ENUMS ********************************************
+ ******************************************************************/
+
+#define TEXTUREPOOL_MAX_TEXTURES 64
+//submitted frames whose fences are polled
+#define TEXTUREPOOL_FRAMES 4
+//idle textures are kept across screens and resizes until they add up to
+//more than this, then the oldest go first
+#define TEXTUREPOOL_IDLE_BUDGET (256u * 1024u * 1024u)
+
+//what makes two textures interchangeable
+typedef struct TexturePoolDesc
+{
+	Uint32 width, height;
+	SDL_GPUTextureFormat format;
+	SDL_GPUTextureUsageFlags usage;
+	SDL_GPUSampleCount sample_count;
+} TexturePoolDesc;
+
+typedef struct TexturePoolStats
+{
+	Uint32 textures;
+	Uint32 in_use;
+	Uint32 created; //since TexturePool_Init
+	Uint32 reused;
+	Uint32 released;
+	Uint64 bytes;
+	Uint64 idle_bytes;
+} TexturePoolStats;
+
+/*******************************************************************
+ * FUNCTIONS *******************************************************
+ ******************************************************************/
+
+//one pool per device, shared by every screen and render graph
+bool TexturePool_Init(SDL_GPUDevice *device);
+
+//borrows a texture, creating it only when nothing idle matches
+//cycle is set when a frame the GPU hasn't finished may still use it,
+//the first pass writing it should cycle unless it loads the content
+SDL_GPUTexture *TexturePool_Acquire(const TexturePoolDesc *desc, bool *cycle);
+
+//gives it back, other users may get it later in the same frame
+void TexturePool_Release(SDL_GPUTexture *texture);
+
+//submits the frame's command buffer with a fence, so textures it used
+//can be handed out again without cycling once it's done; frames only
+//advance here, so any command buffer using pool textures has to go
+//through this, after a plain submit nothing is cycled or reclaimed
+bool TexturePool_Submit(SDL_GPUCommandBuffer *cmdbuf);
+
+//frame numbers start at 1 and advance on every TexturePool_Submit
+Uint64 TexturePool_GetFrame();
+bool TexturePool_FrameDone(Uint64 frame);
+
+//releases every idle texture
+void TexturePool_Trim();
+
+TexturePoolStats TexturePool_GetStats();
+
+void TexturePool_Destroy();
+
+#endif
@@ -0,0 +1,437 @@
+/*
+ * Copyright (C) 2025 Matheus Klein Schaefer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <SDL3/SDL.h>
+#include <scene.h>
+#include <fileio.h>
+
+#define PVS_MAGIC "LPVS"
+#define PVS_VERSION 2
+
+typedef struct PVSHeader
+{
+	char magic[4];
+	Uint32 version;
+	Uint32 num_cells;
+	Uint32 num_portals;
+	Uint32 layout_hash; //cell bounds and portal polygons
+} PVSHeader;
+
+//cell_visible flags, the path one is cleared on the way back
+#define CELL_VISIBLE 1
+#define CELL_ON_PATH 2
+
+typedef struct PortalPlanes
+{
+	Vector4 planes[SCENE_MAX_PORTAL_PLANES];
+	Uint32 count;
+} PortalPlanes;
+
+typedef struct PortalWalk
+{
+	Scene *scene;
+	Vector3 eye;
+	Vector4 far_plane;
+	Uint8 *cells; //CELL_ flags
+	const Uint8 *pvs_row; //NULL to walk everything reachable
+	Uint32 visits;
+} PortalWalk;
+
+static float plane_distance(Vector4 plane, Vector3 point)
+{
+	return plane.x * point.x + plane.y * point.y + plane.z * point.z + plane.w;
+}
+
+static Vector4 plane_from(Vector3 normal, Vector3 point)
+{
+	return (Vector4){ normal.x, normal.y, normal.z, -Vector3_Dot(normal, point) };
+}
+
+static Vector4 flip_plane(Vector4 plane)
+{
+	return (Vector4){ -plane.x, -plane.y, -plane.z, -plane.w };
+}
+
+static bool pvs_bit(const Uint8 *row, Uint32 cell)
+{
+	return (row[cell / 8] >> (cell % 8)) & 1;
+}
+
+//Newell's method, fine with slightly non-planar or collinear corners
+static Vector3 polygon_normal(const Vector3 *vertices, Uint32 count)
+{
+	Vector3 normal = { 0 };
+	for(Uint32 i = 0; i < count; i++)
+	{
+		Vector3 a = vertices[i];
+		Vector3 b = vertices[(i + 1) % count];
+		normal.x += (a.y - b.y) * (a.z + b.z);
+		normal.y += (a.z - b.z) * (a.x + b.x);
+		normal.z += (a.x - b.x) * (a.y + b.y);
+	}
+	return Vector3_Normalize(normal);
+}
+
+//Sutherland-Hodgman against every plane, keeps what's inside
+static Uint32 clip_polygon(const PortalPlanes *planes, const Vector3 *vertices, Uint32 count, Vector3 *out)
+{
+	Vector3 buffers[2][SCENE_MAX_CLIP_VERTICES];
+	SDL_memcpy(buffers[0], vertices, sizeof(Vector3) * count);
+	Uint32 current = 0;
+	for(Uint32 p = 0; p < planes->count && count >= 3; p++)
+	{
+		const Vector3 *in = buffers[current];
+		Vector3 *clipped = buffers[current ^ 1];
+		Uint32 n = 0;
+		for(Uint32 i = 0; i < count && n < SCENE_MAX_CLIP_VERTICES - 1; i++)
+		{
+			Vector3 a = in[i];
+			Vector3 b = in[(i + 1) % count];
+			float da = plane_distance(planes->planes[p], a);
+			float db = plane_distance(planes->planes[p], b);
+			if(da >= 0.0f)
+			{
+				clipped[n++] = a;
+			}
+			if((da >= 0.0f) != (db >= 0.0f))
+			{
+				clipped[n++] = Vector3_Add(a, Vector3_Scale(Vector3_Sub(b, a), da / (da - db)));
+			}
+		}
+		count = n;
+		current ^= 1;
+	}
+	if(count < 3)
+	{
+		return 0;
+	}
+	SDL_memcpy(out, buffers[current], sizeof(Vector3) * count);
+	return count;
+}
+
+//the eye's view narrowed to the clipped opening: one plane per edge,
+//the portal's own plane so nothing in front of it counts, and the far
+//plane
+static void portal_planes(const PortalWalk *walk, const Vector3 *vertices, Uint32 count, PortalPlanes *out)
+{
+	Vector3 centroid = { 0 };
+	for(Uint32 i = 0; i < count; i++)
+	{
+		centroid = Vector3_Add(centroid, vertices[i]);
+	}
+	centroid = Vector3_Scale(centroid, 1.0f / (float)count);
+
+	out->count = 0;
+	for(Uint32 i = 0; i < count; i++)
+	{
+		Vector3 normal = Vector3_Cross(Vector3_Sub(vertices[i], walk->eye),
+										Vector3_Sub(vertices[(i + 1) % count], walk->eye));
+		if(Vector3_Dot(normal, normal) < 1e-12f)
+		{
+			continue;
+		}
+		Vector4 plane = plane_from(Vector3_Normalize(normal), walk->eye);
+		out->planes[out->count++] = (plane_distance(plane, centroid) < 0.0f) ? flip_plane(plane) : plane;
+	}
+	Vector4 plane = plane_from(polygon_normal(vertices, count), centroid);
+	out->planes[out->count++] = (plane_distance(plane, walk->eye) > 0.0f) ? flip_plane(plane) : plane;
+	out->planes[out->count++] = walk->far_plane;
+}
+
+static void walk_cell(PortalWalk *walk, Uint32 cell, const PortalPlanes *planes, Uint32 depth)
+{
+	walk->cells[cell] |= CELL_VISIBLE;
+	if(depth == SCENE_MAX_PORTAL_DEPTH)
+	{
+		return;
+	}
+	walk->cells[cell] |= CELL_ON_PATH;
+	const SceneCell *current = &walk->scene->cells[cell];
+	for(Uint32 i = 0; i < current->num_portals && walk->visits < SCENE_MAX_PORTAL_VISITS; i++)
+	{
+		const ScenePortal *portal = &walk->scene->portals[current->portals[i]];
+		Uint32 next = (portal->cells[0] == cell) ? portal->cells[1] : portal->cells[0];
+		//no loops back through cells already on this path, and nothing
+		//the set says can't be seen from here
+		if((walk->cells[next] & CELL_ON_PATH) || (walk->pvs_row != NULL && !pvs_bit(walk->pvs_row, next)))
+		{
+			continue;
+		}
+		walk->visits++;
+		walk->scene->stats.portals_tested++;
+
+		PortalPlanes narrowed;
+		Vector4 portal_plane = plane_from(polygon_normal(portal->vertices, portal->num_vertices), portal->vertices[0]);
+		if(SDL_fabsf(plane_distance(portal_plane, walk->eye)) < SCENE_PORTAL_EPSILON)
+		{
+			//walking through it, clipping would leave nothing
+			narrowed = *planes;
+		}
+		else
+		{
+			Vector3 clipped[SCENE_MAX_CLIP_VERTICES];
+			Uint32 count = clip_polygon(planes, portal->vertices, portal->num_vertices, clipped);
+			if(count == 0)
+			{
+				continue;
+			}
+			portal_planes(walk, clipped, count, &narrowed);
+		}
+		walk->scene->stats.portals_passed++;
+		walk_cell(walk, next, &narrowed, depth + 1);
+	}
+	walk->cells[cell] &= ~CELL_ON_PATH;
+}
+
+static void walk_from(Scene *scene, Uint32 cell, Vector3 eye, const Frustum *frustum, Uint8 *cells, const Uint8 *pvs_row)
+{
+	PortalWalk walk = {
+		.scene = scene,
+		.eye = eye,
+		.far_plane = frustum->planes[5],
+		.cells = cells,
+		.pvs_row = pvs_row
+	};
+	PortalPlanes planes = { .count = 6 };
+	SDL_memcpy(planes.planes, frustum->planes, sizeof(frustum->planes));
+	walk_cell(&walk, cell, &planes, 0);
+}
+
+void Scene_UpdateVisibility(Scene *scene, const Camera *camera)
+{
+	SceneStats *stats = &scene->stats;
+	*stats = (SceneStats){ .camera_cell = Scene_FindCell(scene, camera->position) };
+	if(stats->camera_cell == SCENE_NO_CELL)
+	{
+		//outside the level there is nothing to look through
+		if(scene->num_cells > 0)
+		{
+			SDL_memset(scene->cell_visible, CELL_VISIBLE, scene->num_cells);
+		}
+		stats->visible_cells = scene->num_cells;
+		return;
+	}
+
+	SDL_memset(scene->cell_visible, 0, scene->num_cells);
+	const Uint8 *pvs_row = NULL;
+	if(scene->use_pvs && scene->pvs != NULL)
+	{
+		pvs_row = scene->pvs + stats->camera_cell * ((scene->num_cells + 7) / 8);
+		stats->pvs = true;
+	}
+	Frustum frustum = Culling_FrustumFromCamera(camera);
+	walk_from(scene, stats->camera_cell, camera->position, &frustum, scene->cell_visible, pvs_row);
+	for(Uint32 i = 0; i < scene->num_cells; i++)
+	{
+		stats->visible_cells += scene->cell_visible[i] != 0;
+	}
+}
+
+/*******************************************************************
+ * POTENTIALLY VISIBLE SET *****************************************
+ ******************************************************************/
+
+//a sight line leaves every portal it goes through on the far side of
+//it for good, so a later portal with no corner past an earlier one
+//can't be seen through both
+typedef struct PVSWalk
+{
+	Scene *scene;
+	Uint32 source; //where the eye is
+	Uint8 *cells; //CELL_ flags
+	Vector4 planes[SCENE_MAX_PORTAL_DEPTH]; //facing away from where the line came from
+} PVSWalk;
+
+static bool past_planes(const PVSWalk *walk, Uint32 count, const ScenePortal *portal)
+{
+	for(Uint32 p = 0; p < count; p++)
+	{
+		bool past = false;
+		for(Uint32 i = 0; i < portal->num_vertices && !past; i++)
+		{
+			past = plane_distance(walk->planes[p], portal->vertices[i]) > -SCENE_PORTAL_EPSILON;
+		}
+		if(!past)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+//how far the box reaches either side of its center along the plane's normal
+static float box_radius(AABB box, Vector4 plane)
+{
+	return SDL_fabsf(plane.x) * box.half_size.x + SDL_fabsf(plane.y) * box.half_size.y +
+			SDL_fabsf(plane.z) * box.half_size.z;
+}
+
+//the portal's plane facing out of the cell; one nothing fails when the
+//walk doesn't narrow there for some eye in the source cell, or when the
+//plane cuts through the cell and the line could come from either side
+static Vector4 exit_plane(const PVSWalk *walk, const SceneCell *cell, const ScenePortal *portal)
+{
+	const Vector4 none = { 0.0f, 0.0f, 0.0f, 1.0f };
+	Vector4 plane = plane_from(polygon_normal(portal->vertices, portal->num_vertices), portal->vertices[0]);
+	AABB source = walk->scene->cells[walk->source].bounds;
+	if(SDL_fabsf(plane_distance(plane, source.center)) < box_radius(source, plane) + SCENE_PORTAL_EPSILON)
+	{
+		return none;
+	}
+	float distance = plane_distance(plane, cell->bounds.center);
+	if(SDL_fabsf(distance) + SCENE_PORTAL_EPSILON < box_radius(cell->bounds, plane))
+	{
+		return none;
+	}
+	return (distance > 0.0f) ? flip_plane(plane) : plane;
+}
+
+//same depth and path rules as walk_cell, so whatever the runtime walk
+//reaches from any eye in the cell is in the set
+static void pvs_walk(PVSWalk *walk, Uint32 cell, Uint32 depth)
+{
+	walk->cells[cell] |= CELL_VISIBLE;
+	if(depth == SCENE_MAX_PORTAL_DEPTH)
+	{
+		return;
+	}
+	walk->cells[cell] |= CELL_ON_PATH;
+	const SceneCell *current = &walk->scene->cells[cell];
+	for(Uint32 i = 0; i < current->num_portals; i++)
+	{
+		const ScenePortal *portal = &walk->scene->portals[current->portals[i]];
+		Uint32 next = (portal->cells[0] == cell) ? portal->cells[1] : portal->cells[0];
+		if((walk->cells[next] & CELL_ON_PATH) || !past_planes(walk, depth, portal))
+		{
+			continue;
+		}
+		walk->planes[depth] = exit_plane(walk, current, portal);
+		pvs_walk(walk, next, depth + 1);
+	}
+	walk->cells[cell] &= ~CELL_ON_PATH;
+}
+
+bool Scene_BuildPVS(Scene *scene)
+{
+	Uint32 row_size = (scene->num_cells + 7) / 8;
+	Uint8 *pvs = (Uint8*)SDL_calloc(scene->num_cells, row_size);
+	Uint8 *cells = (Uint8*)SDL_malloc(scene->num_cells + 1);
+	if(pvs == NULL || cells == NULL)
+	{
+		SDL_free(pvs);
+		SDL_free(cells);
+		return false;
+	}
+	Uint64 start = SDL_GetTicksNS();
+	for(Uint32 c = 0; c < scene->num_cells; c++)
+	{
+		SDL_memset(cells, 0, scene->num_cells);
+		PVSWalk walk = { .scene = scene, .source = c, .cells = cells };
+		pvs_walk(&walk, c, 0);
+		for(Uint32 i = 0; i < scene->num_cells; i++)
+		{
+			if(cells[i])
+			{
+				pvs[c * row_size + i / 8] |= (Uint8)(1 << (i % 8));
+			}
+		}
+	}
+	SDL_free(cells);
+	SDL_free(scene->pvs);
+	scene->pvs = pvs;
+	scene->stats = (SceneStats){ .camera_cell = SCENE_NO_CELL };
+	SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Scene: PVS for %u cells built in %.2f ms.",
+				scene->num_cells, (double)(SDL_GetTicksNS() - start) / 1000000.0);
+	return true;
+}
+
+//FNV-1a over the cells and portals the set was built from
+static Uint32 hash_bytes(Uint32 hash, const void *data, size_t size)
+{
+	const Uint8 *bytes = (const Uint8*)data;
+	for(size_t i = 0; i < size; i++)
+	{
+		hash = (hash ^ bytes[i]) * 16777619u;
+	}
+	return hash;
+}
+
+static Uint32 layout_hash(const Scene *scene)
+{
+	Uint32 hash = 2166136261u;
+	for(Uint32 i = 0; i < scene->num_cells; i++)
+	{
+		hash = hash_bytes(hash, &scene->cells[i].bounds, sizeof(AABB));
+	}
+	for(Uint32 i = 0; i < scene->num_portals; i++)
+	{
+		const ScenePortal *portal = &scene->portals[i];
+		hash = hash_bytes(hash, portal->cells, sizeof(portal->cells));
+		hash = hash_bytes(hash, portal->vertices, sizeof(Vector3) * portal->num_vertices);
+	}
+	return hash;
+}
+
+bool Scene_SavePVS(const Scene *scene, const char *filename)
+{
+	if(scene->pvs == NULL)
+	{
+		return false;
+	}
+	PVSHeader header;
+	SDL_memcpy(header.magic, PVS_MAGIC, 4);
+	header.version = SDL_Swap32LE(PVS_VERSION);
+	header.num_cells = SDL_Swap32LE(scene->num_cells);
+	header.num_portals = SDL_Swap32LE(scene->num_portals);
+	header.layout_hash = SDL_Swap32LE(layout_hash(scene));
+	size_t size = (size_t)scene->num_cells * ((scene->num_cells + 7) / 8);
+	return FileIOWrite(filename, &header, sizeof(header), false) && FileIOWrite(filename, scene->pvs, size, true);
+}
+
+bool Scene_LoadPVS(Scene *scene, const char *filename)
+{
+	size_t size;
+	Uint8 *file = FileIOReadBytes(filename, &size);
+	if(file == NULL)
+	{
+		return false;
+	}
+	PVSHeader header;
+	size_t pvs_size = (size_t)scene->num_cells * ((scene->num_cells + 7) / 8);
+	Uint8 *pvs = NULL;
+	if(size == sizeof(header) + pvs_size)
+	{
+		SDL_memcpy(&header, file, sizeof(header));
+		//a set for another layout would hide the wrong cells
+		if(SDL_memcmp(header.magic, PVS_MAGIC, 4) == 0 && SDL_Swap32LE(header.version) == PVS_VERSION &&
+			SDL_Swap32LE(header.num_cells) == scene->num_cells && SDL_Swap32LE(header.num_portals) == scene->num_portals &&
+			SDL_Swap32LE(header.layout_hash) == layout_hash(scene))
+		{
+			pvs = (Uint8*)SDL_malloc(pvs_size + 1);
+		}
+	}
+	if(pvs == NULL)
+	{
+		SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Scene: %s doesn't match the level, ignoring it.", filename);
+		SDL_free(file);
+		return false;
+	}
+	SDL_memcpy(pvs, file + sizeof(header), pvs_size);
+	SDL_free(file);
+	SDL_free(scene->pvs);
+	scene->pvs = pvs;
+	return true;
+}
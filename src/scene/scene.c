@@ -0,0 +1,198 @@
+/*
+ * Copyright (C) 2025 Matheus Klein Schaefer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <SDL3/SDL.h>
+#include <scene.h>
+
+void Scene_Init(Scene *scene)
+{
+	*scene = (Scene){ 0 };
+	scene->stats.camera_cell = SCENE_NO_CELL;
+}
+
+//doubles capacity like the other growable arrays
+static bool grow(void **array, Uint32 *capacity, Uint32 count, size_t size)
+{
+	if(count < *capacity)
+	{
+		return true;
+	}
+	Uint32 new_capacity = (*capacity == 0) ? 16 : *capacity * 2;
+	void *aux = SDL_realloc(*array, size * new_capacity);
+	if(aux == NULL)
+	{
+		return false;
+	}
+	*array = aux;
+	*capacity = new_capacity;
+	return true;
+}
+
+/*******************************************************************
+ * LEVEL ***********************************************************
+ ******************************************************************/
+
+int Scene_AddCell(Scene *scene, AABB bounds)
+{
+	if(!grow((void**)&scene->cells, &scene->cells_capacity, scene->num_cells, sizeof(SceneCell)))
+	{
+		return -1;
+	}
+	Uint8 *visible = (Uint8*)SDL_realloc(scene->cell_visible, scene->num_cells + 1);
+	if(visible == NULL)
+	{
+		return -1;
+	}
+	scene->cell_visible = visible;
+	scene->cell_visible[scene->num_cells] = 1;
+	scene->cells[scene->num_cells] = (SceneCell){ .bounds = bounds };
+	//a set built for fewer cells is stale
+	SDL_free(scene->pvs);
+	scene->pvs = NULL;
+	return (int)scene->num_cells++;
+}
+
+int Scene_AddPortal(Scene *scene, Uint32 cell_a, Uint32 cell_b, const Vector3 *vertices, Uint32 num_vertices)
+{
+	if(cell_a >= scene->num_cells || cell_b >= scene->num_cells || cell_a == cell_b ||
+		num_vertices < 3 || num_vertices > SCENE_MAX_PORTAL_VERTICES)
+	{
+		return -1;
+	}
+	SceneCell *a = &scene->cells[cell_a];
+	SceneCell *b = &scene->cells[cell_b];
+	if(a->num_portals == SCENE_MAX_CELL_PORTALS || b->num_portals == SCENE_MAX_CELL_PORTALS)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Scene: Error: Too many portals in cell %u or %u.", cell_a, cell_b);
+		return -1;
+	}
+	if(!grow((void**)&scene->portals, &scene->portals_capacity, scene->num_portals, sizeof(ScenePortal)))
+	{
+		return -1;
+	}
+	ScenePortal *portal = &scene->portals[scene->num_portals];
+	*portal = (ScenePortal){ .num_vertices = num_vertices, .cells = { cell_a, cell_b } };
+	SDL_memcpy(portal->vertices, vertices, sizeof(Vector3) * num_vertices);
+	a->portals[a->num_portals++] = scene->num_portals;
+	b->portals[b->num_portals++] = scene->num_portals;
+	SDL_free(scene->pvs);
+	scene->pvs = NULL;
+	return (int)scene->num_portals++;
+}
+
+static bool contains(AABB box, Vector3 point)
+{
+	return SDL_fabsf(point.x - box.center.x) <= box.half_size.x &&
+			SDL_fabsf(point.y - box.center.y) <= box.half_size.y &&
+			SDL_fabsf(point.z - box.center.z) <= box.half_size.z;
+}
+
+Uint32 Scene_FindCell(const Scene *scene, Vector3 point)
+{
+	Uint32 found = SCENE_NO_CELL;
+	float found_volume = 0.0f;
+	for(Uint32 i = 0; i < scene->num_cells; i++)
+	{
+		AABB box = scene->cells[i].bounds;
+		float volume = box.half_size.x * box.half_size.y * box.half_size.z;
+		if(contains(box, point) && (found == SCENE_NO_CELL || volume < found_volume))
+		{
+			found = i;
+			found_volume = volume;
+		}
+	}
+	return found;
+}
+
+static Vector3 object_center(const Object *object)
+{
+	if(object->renderable != NULL)
+	{
+		return Culling_TransformAABB(object->renderable->bounds, object->transform).center;
+	}
+	return (Vector3){ object->transform.da, object->transform.db, object->transform.dc };
+}
+
+int Scene_AddObject(Scene *scene, Object *object)
+{
+	if(!grow((void**)&scene->objects, &scene->objects_capacity, scene->num_objects, sizeof(SceneObject)))
+	{
+		return -1;
+	}
+	scene->objects[scene->num_objects] = (SceneObject){ object, Scene_FindCell(scene, object_center(object)) };
+	return (int)scene->num_objects++;
+}
+
+void Scene_UpdateObject(Scene *scene, Uint32 index)
+{
+	if(index < scene->num_objects)
+	{
+		SceneObject *entry = &scene->objects[index];
+		entry->cell = Scene_FindCell(scene, object_center(entry->object));
+	}
+}
+
+Uint32 Scene_GatherObjects(const Scene *scene, Object **objects, Uint32 max)
+{
+	Uint32 count = 0;
+	for(Uint32 i = 0; i < scene->num_objects && count < max; i++)
+	{
+		const SceneObject *entry = &scene->objects[i];
+		if(entry->cell == SCENE_NO_CELL || scene->cell_visible[entry->cell])
+		{
+			objects[count++] = entry->object;
+		}
+	}
+	return count;
+}
+
+/*******************************************************************
+ * LIGHTS **********************************************************
+ ******************************************************************/
+
+int Scene_AddLight(Scene *scene, SceneLight light)
+{
+	if(!grow((void**)&scene->lights, &scene->lights_capacity, scene->num_lights, sizeof(SceneLight)))
+	{
+		return -1;
+	}
+	scene->lights[scene->num_lights] = light;
+	return (int)scene->num_lights++;
+}
+
+SceneLight *Scene_GetLight(Scene *scene, Uint32 index)
+{
+	return (index < scene->num_lights) ? &scene->lights[index] : NULL;
+}
+
+void Scene_RemoveLight(Scene *scene, Uint32 index)
+{
+	if(index < scene->num_lights)
+	{
+		scene->lights[index] = scene->lights[--scene->num_lights];
+	}
+}
+
+void Scene_Destroy(Scene *scene)
+{
+	SDL_free(scene->cells);
+	SDL_free(scene->portals);
+	SDL_free(scene->objects);
+	SDL_free(scene->lights);
+	SDL_free(scene->cell_visible);
+	SDL_free(scene->pvs);
+	Scene_Init(scene);
+}
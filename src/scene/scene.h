@@ -18,15 +18,152 @@
 #define SCENE_H
 
 #include <SDL3/SDL.h>
+#include <linmath.h>
+#include <physics.h>
+#include <assets.h>
+#include <culling.h>
 
-//incomplete, file is still a placeholder
+/*******************************************************************
+ * STRUCTURES AND ENUMS ********************************************
+ ******************************************************************/
 
+#define SCENE_NO_CELL 0xFFFFFFFFu
+#define SCENE_MAX_CELL_PORTALS 16
+//portals are convex polygons, a doorway is usually 4
+#define SCENE_MAX_PORTAL_VERTICES 8
+//each plane clipped against can add a vertex
+#define SCENE_MAX_CLIP_VERTICES 32
+//one side plane per clipped edge, plus the portal and far planes
+#define SCENE_MAX_PORTAL_PLANES (SCENE_MAX_CLIP_VERTICES + 2)
+//how many portals deep a view goes, and how many it may pass through
+//in total, cells reached through many paths are walked once per path
+#define SCENE_MAX_PORTAL_DEPTH 16
+#define SCENE_MAX_PORTAL_VISITS 1024
+//closer than this to a portal's plane the camera is treated as
+//standing in it, the view goes through unclipped
+#define SCENE_PORTAL_EPSILON 0.2f
+
+//a convex opening between two cells, visible from both sides
+typedef struct ScenePortal
+{
+	Vector3 vertices[SCENE_MAX_PORTAL_VERTICES]; //world space, in order
+	Uint32 num_vertices;
+	Uint32 cells[2];
+} ScenePortal;
+
+//a room or any other closed volume, walls are just objects in it
+typedef struct SceneCell
+{
+	AABB bounds;
+	Uint32 portals[SCENE_MAX_CELL_PORTALS];
+	Uint32 num_portals;
+} SceneCell;
+
+typedef struct SceneObject
+{
+	Object *object;
+	Uint32 cell; //SCENE_NO_CELL when outside every cell
+} SceneObject;
+
+//point light, falls off to nothing at radius
+typedef struct SceneLight
+{
+	Vector3 position;
+	float radius;
+	Vector3 color;
+	float intensity;
+} SceneLight;
+
+typedef struct SceneStats
+{
+	Uint32 camera_cell;
+	Uint32 visible_cells;
+	Uint32 portals_tested;
+	Uint32 portals_passed;
+	bool pvs; //the potentially visible set bounded the walk
+} SceneStats;
+
+//what gets drawn and where it is; with cells and portals defined,
+//only objects in cells the camera can see through the portals are
+//handed out
+//TODO pipeline, camera
 typedef struct Scene
 {
-	//TODO
-	//pipeline
-	//camera
-	//objects
+	SceneCell *cells;
+	Uint32 num_cells, cells_capacity;
+	ScenePortal *portals;
+	Uint32 num_portals, portals_capacity;
+	SceneObject *objects;
+	Uint32 num_objects, objects_capacity;
+	//dynamic, binned on the GPU every frame (see clusters.h)
+	SceneLight *lights;
+	Uint32 num_lights, lights_capacity;
+
+	//per frame, from Scene_UpdateVisibility
+	Uint8 *cell_visible;
+	//num_cells rows of num_cells bits, NULL until built or loaded
+	Uint8 *pvs;
+	bool use_pvs;
+
+	SceneStats stats;
 } Scene;
 
+/*******************************************************************
+ * FUNCTIONS *******************************************************
+ ******************************************************************/
+
+void Scene_Init(Scene *scene);
+
+/* LEVEL */
+
+//cells first, then portals between them, then objects
+//each returns the new index, or -1 if out of memory or space
+int Scene_AddCell(Scene *scene, AABB bounds);
+int Scene_AddPortal(Scene *scene, Uint32 cell_a, Uint32 cell_b, const Vector3 *vertices, Uint32 num_vertices);
+
+//the object goes in the cell holding the center of its bounds
+int Scene_AddObject(Scene *scene, Object *object);
+
+//call after moving an object so it's looked up in the right cell
+void Scene_UpdateObject(Scene *scene, Uint32 index);
+
+//smallest cell holding the point, cells overlap at doorways
+Uint32 Scene_FindCell(const Scene *scene, Vector3 point);
+
+/* LIGHTS */
+
+//returns the index, or -1 if out of memory
+int Scene_AddLight(Scene *scene, SceneLight light);
+
+//edit in place to move or recolor it, NULL past the end
+SceneLight *Scene_GetLight(Scene *scene, Uint32 index);
+
+//the last light takes the removed one's index
+void Scene_RemoveLight(Scene *scene, Uint32 index);
+
+/* VISIBILITY */
+
+//finds the camera's cell and walks the portals from it, narrowing the
+//frustum to each portal; from outside every cell all of them count
+void Scene_UpdateVisibility(Scene *scene, const Camera *camera);
+
+//writes the objects in visible cells (and those outside any cell) to
+//objects, up to max, and returns how many
+Uint32 Scene_GatherObjects(const Scene *scene, Object **objects, Uint32 max);
+
+/* POTENTIALLY VISIBLE SET */
+
+//offline step for static levels: every portal chain the runtime walk
+//could take from a cell goes in its row, minus chains where a portal
+//lies wholly behind an earlier one; conservative, nothing visible from
+//anywhere in the cell is left out
+bool Scene_BuildPVS(Scene *scene);
+
+//the set only stays valid for the same cells and portals, loading one
+//saved for a different layout fails
+bool Scene_SavePVS(const Scene *scene, const char *filename);
+bool Scene_LoadPVS(Scene *scene, const char *filename);
+
+void Scene_Destroy(Scene *scene);
+
 #endif
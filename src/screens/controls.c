@@ -15,9 +15,16 @@
  */
 
 #include <screens.h>
+#include <shader.h>
+#include <pipelinecache.h>
+#include <texturepool.h>
+#include <capture.h>
+#include <gpumem.h>
+#include <debugdraw.h>
 
 CurrentScreen current_screen;
 LeidenContext drawing_context;
+LeidenSettings screen_settings;
 bool exit_signal;
 
 void SCR_SetContext(SDL_Window *window, SDL_GPUDevice *device)
@@ -26,9 +33,40 @@ void SCR_SetContext(SDL_Window *window, SDL_GPUDevice *device)
 	drawing_context.device = device;
 }
 
+void SCR_SetSettings(const LeidenSettings *settings)
+{
+	screen_settings = *settings;
+	if(screen_settings.target_fps <= 0.0f)
+	{
+		screen_settings.target_fps = 60.0f;
+	}
+	if(screen_settings.min_render_scale <= 0.0f)
+	{
+		screen_settings.min_render_scale = 0.5f;
+	}
+	if(screen_settings.fifthgen_width <= 0 || screen_settings.fifthgen_height <= 0)
+	{
+		screen_settings.fifthgen_width = 320;
+		screen_settings.fifthgen_height = 240;
+	}
+}
+
 bool SCR_Setup()
 {
 	current_screen = SCREEN_SPLASH;
+	//before anything allocates, so every resource is counted
+	GPUMem_Init((Uint64)SDL_max(screen_settings.gpu_memory_budget_mb, 0) * 1024 * 1024);
+	//one read for every shader, then pipelines build in the
+	//background while the splash is up
+	ShaderLib_Init(drawing_context.device, "shaders/shaders.bundle");
+	if(PipelineCache_Init(drawing_context.device))
+	{
+		SCR_PrewarmPipelines();
+	}
+	//render targets outlive the screens that borrow them
+	TexturePool_Init(drawing_context.device);
+	Capture_Init(drawing_context.device);
+	DebugDraw_Init(drawing_context.device);
 	SplashScreen_Setup();
 	exit_signal = false;
 	return false;
@@ -36,6 +74,11 @@ bool SCR_Setup()
 
 void SCR_Input(SDL_Event event)
 {
+	SCR_CaptureInput(event);
+	if(event.type == SDL_EVENT_KEY_DOWN && event.key.key == SDLK_F10 && !event.key.repeat)
+	{
+		GPUMem_LogStats();
+	}
 	switch(current_screen)
 	{
 		case SCREEN_SPLASH: SplashScreen_Input(event); break;
@@ -70,6 +113,8 @@ void SCR_Draw()
 		case SCREEN_TEST3: TestScreen3_Draw(); break;
 		default: break;
 	}
+	//files are written by the capture workers, this only moves them along
+	Capture_Update();
 	return;
 }
 
@@ -83,5 +128,12 @@ void SCR_Destroy()
 		case SCREEN_TEST3: TestScreen3_Destroy(); break;
 		default: break;
 	}
+	Capture_Destroy();
+	DebugDraw_Destroy();
+	TexturePool_Destroy();
+	PipelineCache_Destroy();
+	ShaderLib_Destroy();
+	//whatever is left here leaked
+	GPUMem_Destroy();
 	return;
 }
@@ -19,6 +19,9 @@
 #include <assets.h>
 #include <shader.h>
 #include <screens.h>
+#include <pipelinecache.h>
+#include <capture.h>
+#include <gpumem.h>
 
 void SCR_CreateEffectBuffers(EffectBuffers *buffers)
 {
@@ -27,7 +30,7 @@ void SCR_CreateEffectBuffers(EffectBuffers *buffers)
 		return;
 	}
 
-	buffers->vbuffer = SDL_CreateGPUBuffer(
+	buffers->vbuffer = GPUMem_CreateBuffer(
 		drawing_context.device,
 		&(SDL_GPUBufferCreateInfo) {
 			.usage = SDL_GPU_BUFFERUSAGE_VERTEX,
@@ -35,7 +38,7 @@ void SCR_CreateEffectBuffers(EffectBuffers *buffers)
 		}
 	);
 
-	buffers->ibuffer = SDL_CreateGPUBuffer(
+	buffers->ibuffer = GPUMem_CreateBuffer(
 		drawing_context.device,
 		&(SDL_GPUBufferCreateInfo) {
 			.usage = SDL_GPU_BUFFERUSAGE_INDEX,
@@ -43,7 +46,7 @@ void SCR_CreateEffectBuffers(EffectBuffers *buffers)
 		}
 	);
 
-	SDL_GPUTransferBuffer* bufferTransferBuffer = SDL_CreateGPUTransferBuffer(
+	SDL_GPUTransferBuffer* bufferTransferBuffer = GPUMem_CreateTransferBuffer(
 		drawing_context.device,
 		&(SDL_GPUTransferBufferCreateInfo) {
 			.usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
@@ -105,86 +108,358 @@ void SCR_CreateEffectBuffers(EffectBuffers *buffers)
 
 	SDL_EndGPUCopyPass(copyPass);
 	SDL_SubmitGPUCommandBuffer(uploadCmdBuf);
-	SDL_ReleaseGPUTransferBuffer(drawing_context.device, bufferTransferBuffer);
+	GPUMem_ReleaseTransferBuffer(drawing_context.device, bufferTransferBuffer);
 }
 
 void SCR_ReleaseEffectBuffers(EffectBuffers *buffers)
 {
 	if(buffers != NULL)
 	{
-		SDL_ReleaseGPUBuffer(drawing_context.device, buffers->vbuffer);
-		SDL_ReleaseGPUBuffer(drawing_context.device, buffers->ibuffer);
+		GPUMem_ReleaseBuffer(drawing_context.device, buffers->vbuffer);
+		GPUMem_ReleaseBuffer(drawing_context.device, buffers->ibuffer);
 	}
 }
 
-//this only handles a vertex buffer with position and UV
-//useful for retro rendering - but not so much for more advanced NPR
-SDL_GPUGraphicsPipeline *SCR_CreateSimplePipeline(SDL_GPUShader *vs,
-													SDL_GPUShader *fs,
-													bool release_shaders)
+//every pipeline a screen may ask for, built from the same few
+//descriptions so the cache can share them between screens
+static PipelineDesc pipelinedesc(ScreenPipeline id)
 {
-	if(vs == NULL || fs == NULL)
+	PipelineDesc desc = { 0 };
+	desc.vertex_layout = PIPELINE_VERTEX_MESH;
+	desc.primitive_type = SDL_GPU_PRIMITIVETYPE_TRIANGLELIST;
+	desc.num_color_targets = 1;
+	desc.color_formats[0] = SDL_GetGPUSwapchainTextureFormat(drawing_context.device, drawing_context.window);
+	desc.depth_format = SDL_GPU_TEXTUREFORMAT_D16_UNORM;
+	desc.depth_test = true;
+	desc.depth_write = true;
+	desc.compare_op = SDL_GPU_COMPAREOP_LESS;
+	desc.cull_mode = SDL_GPU_CULLMODE_NONE;
+	desc.fill_mode = SDL_GPU_FILLMODE_FILL;
+
+	switch(id)
 	{
-		return NULL;
+		case SCR_PIPELINE_SPLASH:
+			desc.vertex_shader = "shaders/splash/quad.vert.spv";
+			desc.fragment_shader = "shaders/splash/quad.frag.spv";
+			desc.vertex_layout = PIPELINE_VERTEX_QUAD;
+			desc.depth_format = SDL_GPU_TEXTUREFORMAT_INVALID;
+			break;
+		case SCR_PIPELINE_CEL_COLOR:
+			//matrices come from the frame data storage buffer
+			desc.vertex_shader = "shaders/framedata/simple.vert.spv";
+			desc.fragment_shader = "shaders/simpletest/simple.frag.spv";
+			desc.color_formats[0] = SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM;
+			break;
+		case SCR_PIPELINE_CEL_NORMAL:
+			desc.vertex_shader = "shaders/framedata/norm.vert.spv";
+			desc.fragment_shader = "shaders/framedata/norm.frag.spv";
+			desc.color_formats[0] = SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM;
+			break;
+		case SCR_PIPELINE_CEL_GBUFFER:
+			//color and normal in one geometry pass
+			desc.vertex_shader = "shaders/framedata/gbuffer.vert.spv";
+			desc.fragment_shader = "shaders/framedata/gbuffer.frag.spv";
+			desc.num_color_targets = 2;
+			desc.color_formats[0] = SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM;
+			desc.color_formats[1] = SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM;
+			break;
+		case SCR_PIPELINE_FIFTHGEN:
+			//this only handles a vertex buffer with position and UV
+			//useful for retro rendering - but not so much for more advanced NPR
+			desc.vertex_shader = "shaders/fifthgen/fifthgen.vert.spv";
+			desc.fragment_shader = "shaders/fifthgen/fifthgen.frag.spv";
+			break;
+		case SCR_PIPELINE_GPU_SCENE:
+			//shared buffers and indirect draws from GPUScene
+			desc.vertex_shader = "shaders/gpuscene/scene.vert.spv";
+			desc.fragment_shader = "shaders/simpletest/simple.frag.spv";
+			break;
+		case SCR_PIPELINE_GPU_SCENE_ARRAY:
+			//meshes packed by TexArray_Pack
+			desc.vertex_shader = "shaders/gpuscene/scene.vert.spv";
+			desc.fragment_shader = "shaders/gpuscene/scene_array.frag.spv";
+			break;
+		default: break;
+	}
+	return desc;
+}
+
+PipelineDesc SCR_GetPipelineDesc(ScreenPipeline id)
+{
+	return pipelinedesc(id);
+}
+
+SDL_GPUGraphicsPipeline *SCR_GetPipeline(ScreenPipeline id)
+{
+	PipelineDesc desc = pipelinedesc(id);
+	SDL_GPUGraphicsPipeline *pipeline = PipelineCache_Get(&desc);
+	if(pipeline == NULL)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Graphics: Error: Pipeline %d not available.", (int)id);
+	}
+	return pipeline;
+}
+
+SDL_GPUSampler *SCR_GetSampler(SDL_GPUFilter filter, SDL_GPUSamplerMipmapMode mipmap,
+								SDL_GPUSamplerAddressMode address)
+{
+	SDL_GPUSamplerCreateInfo samplercreateinfo = { 0 };
+	samplercreateinfo.min_filter = filter;
+	samplercreateinfo.mag_filter = filter;
+	samplercreateinfo.mipmap_mode = mipmap;
+	samplercreateinfo.address_mode_u = address;
+	samplercreateinfo.address_mode_v = address;
+	samplercreateinfo.address_mode_w = address;
+	return PipelineCache_GetSampler(&samplercreateinfo);
+}
+
+void SCR_PrewarmPipelines()
+{
+	PipelineDesc descs[SCR_PIPELINE_COUNT];
+	for(int i = 0; i < SCR_PIPELINE_COUNT; i++)
+	{
+		descs[i] = pipelinedesc((ScreenPipeline)i);
+	}
+	PipelineCache_Prewarm(descs, SCR_PIPELINE_COUNT);
+}
+
+static const char *depth_mode_names[SCR_DEPTH_COUNT] = { "direct", "pre-pass EQUAL", "pre-pass LEQUAL" };
+
+void SCR_SetDepthMode(PipelineDesc *desc, ScreenDepthMode mode)
+{
+	desc->depth_test = true;
+	desc->depth_write = mode == SCR_DEPTH_DIRECT;
+	switch(mode)
+	{
+		case SCR_DEPTH_PREPASS_EQUAL: desc->compare_op = SDL_GPU_COMPAREOP_EQUAL; break;
+		case SCR_DEPTH_PREPASS_LEQUAL: desc->compare_op = SDL_GPU_COMPAREOP_LESS_OR_EQUAL; break;
+		default: desc->compare_op = SDL_GPU_COMPAREOP_LESS; break;
+	}
+}
+
+PipelineDesc SCR_GetDepthPrepassDesc(ScreenPipeline id)
+{
+	PipelineDesc desc = pipelinedesc(id);
+	desc.num_color_targets = 0;
+	desc.fragment_shader = "shaders/depth/depth.frag.spv";
+	//frame data shaders share an invariant position-only version, others
+	//(fifthgen) keep their own so the depth comes from the same code
+	if(id == SCR_PIPELINE_CEL_COLOR || id == SCR_PIPELINE_CEL_NORMAL || id == SCR_PIPELINE_CEL_GBUFFER)
+	{
+		desc.vertex_shader = "shaders/depth/depth.vert.spv";
 	}
+	SCR_SetDepthMode(&desc, SCR_DEPTH_DIRECT);
+	return desc;
+}
+
+PipelineDesc SCR_GetOverdrawDesc(ScreenPipeline id, ScreenDepthMode mode)
+{
+	PipelineDesc desc = pipelinedesc(id);
+	desc.num_color_targets = 1;
+	desc.color_formats[0] = SCR_OVERDRAW_FORMAT;
+	desc.fragment_shader = "shaders/depth/overdraw.frag.spv";
+	desc.blend = PIPELINE_BLEND_ADD;
+	SCR_SetDepthMode(&desc, mode);
+	return desc;
+}
 
-	SDL_GPUGraphicsPipelineCreateInfo pipeline_createinfo = { 0 };
-	pipeline_createinfo = (SDL_GPUGraphicsPipelineCreateInfo)
+bool SCR_GetDepthPipelines(ScreenPipeline id, ScreenDepthMode mode, ScreenDepthPipelines *pipelines)
+{
+	return SCR_GetMaterialPipelines(id, mode, NULL, pipelines);
+}
+
+bool SCR_GetMaterialPipelines(ScreenPipeline id, ScreenDepthMode mode, const Material *material,
+								ScreenDepthPipelines *pipelines)
+{
+	PipelineDesc main_desc = pipelinedesc(id);
+	PipelineDesc prepass_desc = SCR_GetDepthPrepassDesc(id);
+	PipelineDesc overdraw_desc = SCR_GetOverdrawDesc(id, mode);
+	//surfaces that don't write depth can't be in the pre-pass, they
+	//keep their own depth state in every mode
+	bool writes_depth = material == NULL || material->depth_write;
+	if(material != NULL)
 	{
-		.target_info =
+		Material_ApplyDesc(material, &main_desc);
+		Material_ApplyRaster(material, &prepass_desc);
+		Material_ApplyRaster(material, &overdraw_desc);
+		if(!writes_depth)
 		{
-			.num_color_targets = 1,
-			.color_target_descriptions = (SDL_GPUColorTargetDescription[]){{
-				.format = SDL_GetGPUSwapchainTextureFormat(drawing_context.device, drawing_context.window)
-			}},
-			.has_depth_stencil_target = true,
-			.depth_stencil_format = SDL_GPU_TEXTUREFORMAT_D16_UNORM
-		},
-		.depth_stencil_state = (SDL_GPUDepthStencilState){
-			.enable_depth_test = true,
-			.enable_depth_write = true,
-			.enable_stencil_test = false,
-			.compare_op = SDL_GPU_COMPAREOP_LESS,
-			.write_mask = 0xFF
-		},
-		.rasterizer_state = (SDL_GPURasterizerState){
-			.cull_mode = SDL_GPU_CULLMODE_NONE,
-			.fill_mode = SDL_GPU_FILLMODE_FILL,
-			.front_face = SDL_GPU_FRONTFACE_COUNTER_CLOCKWISE
-		},
-		.vertex_input_state = (SDL_GPUVertexInputState){
-			.num_vertex_buffers = 1,
-			.vertex_buffer_descriptions = (SDL_GPUVertexBufferDescription[]){{
-				.slot = 0,
-				.input_rate = SDL_GPU_VERTEXINPUTRATE_VERTEX,
-				.instance_step_rate = 0,
-				.pitch = sizeof(Vertex3D)
-			}},
-			.num_vertex_attributes = 2,
-			.vertex_attributes = (SDL_GPUVertexAttribute[]){{
-				//position
-				.buffer_slot = 0,
-				.format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT3,
-				.location = 0,
-				.offset = 0
-			}, {
-				//uv
-				.buffer_slot = 0,
-				.format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT2,
-				.location = 1,
-				.offset = (sizeof(float) * 3)
-			}}
-		},
-		.primitive_type = SDL_GPU_PRIMITIVETYPE_TRIANGLELIST,
-		.vertex_shader = vs,
-		.fragment_shader = fs
+			overdraw_desc.depth_test = material->depth_test;
+			overdraw_desc.depth_write = false;
+			overdraw_desc.compare_op = material->compare_op;
+		}
+	}
+	if(writes_depth)
+	{
+		SCR_SetDepthMode(&main_desc, mode);
+	}
+	bool prepass = mode != SCR_DEPTH_DIRECT && writes_depth;
+
+	ScreenDepthPipelines result = {
+		.mode = mode,
+		.prepass = prepass ? PipelineCache_Get(&prepass_desc) : NULL,
+		.main = PipelineCache_Get(&main_desc),
+		.overdraw = PipelineCache_Get(&overdraw_desc)
 	};
-	SDL_GPUGraphicsPipeline *pipeline = SDL_CreateGPUGraphicsPipeline(drawing_context.device, &pipeline_createinfo);
-	if(release_shaders)
+	if(result.main == NULL || result.overdraw == NULL || (prepass && result.prepass == NULL))
 	{
-		SDL_ReleaseGPUShader(drawing_context.device, vs);
-		SDL_ReleaseGPUShader(drawing_context.device, fs);
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Graphics: Error: Pipeline %d (%s) not available with %s depth.",
+						(int)id, (material != NULL) ? material->name : "no material", depth_mode_names[mode]);
+		return false;
 	}
+	*pipelines = result;
+	return true;
+}
 
-	return pipeline;
-}
\ No newline at end of file
+SDL_GPUGraphicsPipeline *SCR_PickDepthPipeline(const ScreenDepthPipelines *screen,
+												const ScreenDepthPipelines *material,
+												SDL_GPUGraphicsPipeline *given)
+{
+	if(given == NULL)
+	{
+		return NULL;
+	}
+	if(given == screen->prepass)
+	{
+		return material->prepass;
+	}
+	if(given == screen->overdraw)
+	{
+		return material->overdraw;
+	}
+	return material->main;
+}
+
+const char *SCR_GetDepthModeName(ScreenDepthMode mode)
+{
+	return (mode < SCR_DEPTH_COUNT) ? depth_mode_names[mode] : "unknown";
+}
+
+bool SCR_FifthgenInit(PostChain *upscale)
+{
+	//the only effect, enabled by SCR_FifthgenPresent for overdraw targets
+	return PostChain_Init(upscale) &&
+			PostChain_AddEffect(upscale, POST_EFFECT_OVERDRAW, (float[4]){ SCR_OVERDRAW_SCALE }) == 0;
+}
+
+void SCR_FifthgenBegin(RenderGraph *graph, Uint32 swapchain_w, Uint32 swapchain_h,
+						bool overdraw, FifthgenTargets *targets)
+{
+	//same format as the swapchain, so the fifthgen pipeline fits both
+	targets->width = SDL_min((Uint32)screen_settings.fifthgen_width, swapchain_w);
+	targets->height = SDL_min((Uint32)screen_settings.fifthgen_height, swapchain_h);
+	targets->overdraw = overdraw;
+	targets->color = RenderGraph_CreateTexture(graph, overdraw ? "fifthgen overdraw" : "fifthgen color",
+												targets->width, targets->height,
+												overdraw ? SCR_OVERDRAW_FORMAT : SDL_GetGPUSwapchainTextureFormat(drawing_context.device, drawing_context.window));
+	targets->depth = RenderGraph_CreateTexture(graph, "fifthgen depth", targets->width, targets->height,
+												SDL_GPU_TEXTUREFORMAT_D16_UNORM);
+}
+
+void SCR_FifthgenAddPasses(RenderGraph *graph, FifthgenTargets *targets, ScreenDepthPipelines *pipelines,
+							RenderGraphExecute draw, const SDL_FColor *clear)
+{
+	bool prepass = pipelines->mode != SCR_DEPTH_DIRECT;
+	RGPass pass;
+	if(prepass)
+	{
+		pass = RenderGraph_AddPass(graph, "fifthgen depth", draw, pipelines->prepass);
+		RenderGraph_WriteDepth(graph, pass, targets->depth, true);
+	}
+	pass = RenderGraph_AddPass(graph, "fifthgen", draw, targets->overdraw ? pipelines->overdraw : pipelines->main);
+	RenderGraph_WriteColor(graph, pass, targets->color, targets->overdraw ? &(SDL_FColor){ 0.0f, 0.0f, 0.0f, 0.0f } : clear);
+	RenderGraph_WriteDepth(graph, pass, targets->depth, !prepass);
+}
+
+bool SCR_FifthgenPresent(RenderGraph *graph, PostChain *upscale, FifthgenTargets *targets,
+							RGTexture backbuffer, Uint32 swapchain_w, Uint32 swapchain_h)
+{
+	//stretched to the window like the consoles did on a TV, the camera
+	//keeps the window's aspect so only the pixels aren't square
+	PostChain_SetEnabled(upscale, 0, targets->overdraw);
+	return PostChain_AddPasses(upscale, graph, &(PostChainTargets){
+		.input = targets->color,
+		.input_width = targets->width,
+		.input_height = targets->height,
+		.normals = RENDERGRAPH_INVALID,
+		.output = backbuffer,
+		.output_width = swapchain_w,
+		.output_height = swapchain_h,
+		.output_format = SDL_GetGPUSwapchainTextureFormat(drawing_context.device, drawing_context.window),
+		.point_upscale = true
+	});
+}
+
+void SCR_ShowStats(const char *fmt, ...)
+{
+	static Uint64 last_update = 0;
+	if(fmt == NULL)
+	{
+		last_update = 0;
+		SDL_SetWindowTitle(drawing_context.window, "Project Leiden");
+		return;
+	}
+
+	//some window managers are slow to retitle, 4 times per second is enough
+	Uint64 now = SDL_GetTicks();
+	if(last_update != 0 && now - last_update < 250)
+	{
+		return;
+	}
+	last_update = now;
+
+	char text[256];
+	va_list args;
+	va_start(args, fmt);
+	SDL_vsnprintf(text, sizeof(text), fmt, args);
+	va_end(args);
+
+	char title[300];
+	SDL_snprintf(title, sizeof(title), "Project Leiden | %s", text);
+	SDL_SetWindowTitle(drawing_context.window, title);
+}
+
+static bool screenshot_requested = false;
+static bool capturing = false;
+static Uint32 captured_frames = 0;
+
+void SCR_CaptureInput(SDL_Event event)
+{
+	if(event.type != SDL_EVENT_KEY_DOWN || event.key.repeat)
+	{
+		return;
+	}
+	if(event.key.key == SDLK_F12)
+	{
+		screenshot_requested = true;
+	}
+	if(event.key.key == SDLK_F11)
+	{
+		capturing = !capturing;
+		CaptureStats stats = Capture_GetStats();
+		SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Frame capture %s (%u written, %u dropped so far).",
+					capturing ? "on" : "off", stats.written, stats.dropped);
+	}
+}
+
+void SCR_CaptureFrame(SDL_GPUCommandBuffer *cmdbuf, SDL_GPUTexture *swapchain, Uint32 width, Uint32 height)
+{
+	if((!screenshot_requested && !capturing) || swapchain == NULL)
+	{
+		return;
+	}
+	SDL_GPUTextureFormat format = SDL_GetGPUSwapchainTextureFormat(drawing_context.device, drawing_context.window);
+	char filename[CAPTURE_MAX_PATH];
+	if(screenshot_requested)
+	{
+		SDL_snprintf(filename, sizeof(filename), "screenshot_%llu.png", (unsigned long long)SDL_GetTicks());
+		Capture_Texture(cmdbuf, swapchain, width, height, format, filename);
+		screenshot_requested = false;
+	}
+	if(capturing)
+	{
+		//numbered so runs line up frame by frame for image diffs
+		SDL_snprintf(filename, sizeof(filename), "capture_%06u.png", captured_frames++);
+		Capture_Texture(cmdbuf, swapchain, width, height, format, filename);
+	}
+}
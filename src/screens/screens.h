@@ -15,6 +15,10 @@
  */
 
 #include <SDL3/SDL.h>
+#include <pipelinecache.h>
+#include <rendergraph.h>
+#include <postchain.h>
+#include <material.h>
 
 typedef enum CurrentScreen
 {
@@ -43,8 +47,69 @@ typedef struct EffectVertex
 	float u, v;
 } EffectVertex;
 
+//pipelines shared by the screens, see helpers.c
+typedef enum ScreenPipeline
+{
+	SCR_PIPELINE_SPLASH = 0,
+	SCR_PIPELINE_CEL_COLOR,
+	SCR_PIPELINE_CEL_NORMAL,
+	SCR_PIPELINE_CEL_GBUFFER,
+	SCR_PIPELINE_FIFTHGEN,
+	SCR_PIPELINE_GPU_SCENE,
+	SCR_PIPELINE_GPU_SCENE_ARRAY,
+	SCR_PIPELINE_COUNT
+} ScreenPipeline;
+
+//how the main passes meet the depth buffer
+//with a pre-pass the depth is final before any shading, so the main
+//pipelines test against it without writing and each pixel is shaded once
+typedef enum ScreenDepthMode
+{
+	SCR_DEPTH_DIRECT = 0, //LESS and writes, overdraw follows submission order
+	SCR_DEPTH_PREPASS_EQUAL,
+	SCR_DEPTH_PREPASS_LEQUAL, //for vertex shaders that can't promise invariance
+	SCR_DEPTH_COUNT
+} ScreenDepthMode;
+
+//overdraw passes add one step per shaded fragment into the red channel
+#define SCR_OVERDRAW_FORMAT SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM
+#define SCR_OVERDRAW_SCALE 255.0f
+
+//the pipelines one ScreenPipeline needs for a depth mode
+typedef struct ScreenDepthPipelines
+{
+	ScreenDepthMode mode;
+	SDL_GPUGraphicsPipeline *prepass; //NULL in SCR_DEPTH_DIRECT
+	SDL_GPUGraphicsPipeline *main;
+	SDL_GPUGraphicsPipeline *overdraw;
+} ScreenDepthPipelines;
+
+//fifth-gen screens draw into these and get scaled up at the end
+typedef struct FifthgenTargets
+{
+	RGTexture color; //overdraw counts instead when overdraw is set
+	RGTexture depth;
+	Uint32 width, height;
+	bool overdraw;
+} FifthgenTargets;
+
+//from settings.ini, main hands them over before SCR_Setup
+typedef struct LeidenSettings
+{
+	bool dynamic_resolution;
+	float target_fps;
+	float min_render_scale;
+	//internal resolution of the fifth-gen screens
+	int fifthgen_width, fifthgen_height;
+	//pack model textures into arrays at load time (see texarray.h)
+	bool texture_arrays;
+	//warn when buffers and textures add up to more, 0 for no budget
+	int gpu_memory_budget_mb;
+} LeidenSettings;
+
 extern CurrentScreen current_screen;
 extern LeidenContext drawing_context;
+extern LeidenSettings screen_settings;
 extern bool exit_signal;
 
 /* HELPERS */
@@ -52,9 +117,54 @@ extern bool exit_signal;
 
 void SCR_CreateEffectBuffers(EffectBuffers *buffers);
 void SCR_ReleaseEffectBuffers(EffectBuffers *buffers);
-SDL_GPUGraphicsPipeline *SCR_CreateSimplePipeline(SDL_GPUShader *vs,
-													SDL_GPUShader *fs,
-													bool release_shaders);
+//pipelines and samplers come from the pipeline cache
+//they are shared, screens must not release them
+SDL_GPUGraphicsPipeline *SCR_GetPipeline(ScreenPipeline id);
+//base description, screens tweak it for variants (formats, shaders)
+//and get those through PipelineCache_Get
+PipelineDesc SCR_GetPipelineDesc(ScreenPipeline id);
+SDL_GPUSampler *SCR_GetSampler(SDL_GPUFilter filter, SDL_GPUSamplerMipmapMode mipmap,
+								SDL_GPUSamplerAddressMode address);
+//depth test and writes for the main pass of a depth mode
+void SCR_SetDepthMode(PipelineDesc *desc, ScreenDepthMode mode);
+//no color targets and a position-only vertex stage where the screen's
+//own shader allows it, depth format as in SCR_GetPipelineDesc
+PipelineDesc SCR_GetDepthPrepassDesc(ScreenPipeline id);
+//same geometry and depth state as the main pass of the mode, but writes
+//into a SCR_OVERDRAW_FORMAT counter target
+PipelineDesc SCR_GetOverdrawDesc(ScreenPipeline id, ScreenDepthMode mode);
+bool SCR_GetDepthPipelines(ScreenPipeline id, ScreenDepthMode mode, ScreenDepthPipelines *pipelines);
+//same with a mesh material on top, see material.h; prepass is NULL for
+//materials that don't write depth
+bool SCR_GetMaterialPipelines(ScreenPipeline id, ScreenDepthMode mode, const Material *material,
+								ScreenDepthPipelines *pipelines);
+//SCR_FifthgenAddPasses hands the screen's pipeline to the draw callback,
+//this picks the material's one for the same pass (NULL: skip the draw)
+SDL_GPUGraphicsPipeline *SCR_PickDepthPipeline(const ScreenDepthPipelines *screen,
+												const ScreenDepthPipelines *material,
+												SDL_GPUGraphicsPipeline *given);
+const char *SCR_GetDepthModeName(ScreenDepthMode mode);
+//post chain for SCR_FifthgenPresent, with the overdraw view in it
+bool SCR_FifthgenInit(PostChain *upscale);
+//low resolution targets from settings.ini (never bigger than the window)
+void SCR_FifthgenBegin(RenderGraph *graph, Uint32 swapchain_w, Uint32 swapchain_h,
+						bool overdraw, FifthgenTargets *targets);
+//scene passes for the depth mode, the callback gets the pipeline to
+//bind as userdata (prepass, main or overdraw)
+void SCR_FifthgenAddPasses(RenderGraph *graph, FifthgenTargets *targets, ScreenDepthPipelines *pipelines,
+							RenderGraphExecute draw, const SDL_FColor *clear);
+//nearest upscale to the swapchain, after the scene passes
+bool SCR_FifthgenPresent(RenderGraph *graph, PostChain *upscale, FifthgenTargets *targets,
+							RGTexture backbuffer, Uint32 swapchain_w, Uint32 swapchain_h);
+//starts compiling every ScreenPipeline on worker threads
+void SCR_PrewarmPipelines();
+//no text rendering yet, so stats are shown on the window title
+//passing NULL restores the default title
+void SCR_ShowStats(const char *fmt, ...);
+//F12 takes a screenshot, F11 starts and stops capturing every frame
+void SCR_CaptureInput(SDL_Event event);
+//screens call it with the finished swapchain, right before submitting
+void SCR_CaptureFrame(SDL_GPUCommandBuffer *cmdbuf, SDL_GPUTexture *swapchain, Uint32 width, Uint32 height);
 
 //END HELPERS
 
@@ -64,6 +174,8 @@ SDL_GPUGraphicsPipeline *SCR_CreateSimplePipeline(SDL_GPUShader *vs,
 //BEGIN SCREEN CONTROLS
 
 void SCR_SetContext(SDL_Window *window, SDL_GPUDevice *device);
+//missing values (0) get defaults
+void SCR_SetSettings(const LeidenSettings *settings);
 
 bool SCR_Setup();
 
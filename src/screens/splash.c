@@ -17,8 +17,9 @@
 #include <SDL3/SDL.h>
 #include <fileio.h>
 #include <assets.h>
-#include <shader.h>
 #include <screens.h>
+#include <texturepool.h>
+#include <gpumem.h>
 
 typedef struct Quad
 {
@@ -36,75 +37,22 @@ bool SplashScreen_Setup()
 {
 	SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Starting splash screen...");
 
-	SDL_GPUShader *vs = LoadShader("shaders/splash/quad.vert.spv", drawing_context.device, SDL_GPU_SHADERSTAGE_VERTEX, 0, 0, 0, 0);
-	if(vs == NULL)
-	{
-		return false;
-	}
-	SDL_GPUShader *fs = LoadShader("shaders/splash/quad.frag.spv", drawing_context.device, SDL_GPU_SHADERSTAGE_FRAGMENT, 1, 0, 0, 0);
-	if(fs == NULL)
-	{
-		return false;
-	}
-
 	if(!LoadTextureFile(drawing_context.device, &texture, "splash/splash2.qoi"))
 	{
 		return false;
 	}
 
-	// Create the pipeline
-	SDL_GPUGraphicsPipelineCreateInfo pipelineCreateInfo = {
-		.target_info = {
-			.num_color_targets = 1,
-			.color_target_descriptions = (SDL_GPUColorTargetDescription[]){{
-				.format = SDL_GetGPUSwapchainTextureFormat(drawing_context.device, drawing_context.window)
-			}},
-		},
-		.vertex_input_state = (SDL_GPUVertexInputState){
-			.num_vertex_buffers = 1,
-			.vertex_buffer_descriptions = (SDL_GPUVertexBufferDescription[]){{
-				.slot = 0,
-				.input_rate = SDL_GPU_VERTEXINPUTRATE_VERTEX,
-				.instance_step_rate = 0,
-				.pitch = sizeof(Quad)
-			}},
-			.num_vertex_attributes = 2,
-			.vertex_attributes = (SDL_GPUVertexAttribute[]){{
-				.buffer_slot = 0,
-				.format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT3,
-				.location = 0,
-				.offset = 0
-			}, {
-				.buffer_slot = 0,
-				.format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT2,
-				.location = 1,
-				.offset = sizeof(float) * 3
-			}}
-		},
-		.primitive_type = SDL_GPU_PRIMITIVETYPE_TRIANGLELIST,
-		.vertex_shader = vs,
-		.fragment_shader = fs
-	};
-
-	pipeline = SDL_CreateGPUGraphicsPipeline(drawing_context.device, &pipelineCreateInfo);
-	if (pipeline == NULL)
+	pipeline = SCR_GetPipeline(SCR_PIPELINE_SPLASH);
+	if(pipeline == NULL)
 	{
 		SDL_Log("Failed to create pipeline!");
-		return -1;
+		ReleaseTexture2D(drawing_context.device, &texture);
+		return false;
 	}
+	sampler = SCR_GetSampler(SDL_GPU_FILTER_NEAREST, SDL_GPU_SAMPLERMIPMAPMODE_NEAREST,
+								SDL_GPU_SAMPLERADDRESSMODE_REPEAT);
 
-	SDL_ReleaseGPUShader(drawing_context.device, vs);
-	SDL_ReleaseGPUShader(drawing_context.device, fs);
-	sampler = SDL_CreateGPUSampler(drawing_context.device, &(SDL_GPUSamplerCreateInfo){
-		.min_filter = SDL_GPU_FILTER_NEAREST,
-		.mag_filter = SDL_GPU_FILTER_NEAREST,
-		.mipmap_mode = SDL_GPU_SAMPLERMIPMAPMODE_NEAREST,
-		.address_mode_u = SDL_GPU_SAMPLERADDRESSMODE_REPEAT,
-		.address_mode_v = SDL_GPU_SAMPLERADDRESSMODE_REPEAT,
-		.address_mode_w = SDL_GPU_SAMPLERADDRESSMODE_REPEAT,
-	});
-
-	vbuffer = SDL_CreateGPUBuffer(
+	vbuffer = GPUMem_CreateBuffer(
 		drawing_context.device,
 		&(SDL_GPUBufferCreateInfo) {
 			.usage = SDL_GPU_BUFFERUSAGE_VERTEX,
@@ -112,7 +60,7 @@ bool SplashScreen_Setup()
 		}
 	);
 
-	ibuffer = SDL_CreateGPUBuffer(
+	ibuffer = GPUMem_CreateBuffer(
 		drawing_context.device,
 		&(SDL_GPUBufferCreateInfo) {
 			.usage = SDL_GPU_BUFFERUSAGE_INDEX,
@@ -121,7 +69,7 @@ bool SplashScreen_Setup()
 	);
 
 	// Set up buffer data
-	SDL_GPUTransferBuffer* buffer_transferbuffer = SDL_CreateGPUTransferBuffer(
+	SDL_GPUTransferBuffer* buffer_transferbuffer = GPUMem_CreateTransferBuffer(
 		drawing_context.device,
 		&(SDL_GPUTransferBufferCreateInfo) {
 			.usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
@@ -184,7 +132,7 @@ bool SplashScreen_Setup()
 
 	SDL_EndGPUCopyPass(copyPass);
 	SDL_SubmitGPUCommandBuffer(uploadCmdBuf);
-	SDL_ReleaseGPUTransferBuffer(drawing_context.device, buffer_transferbuffer);
+	GPUMem_ReleaseTransferBuffer(drawing_context.device, buffer_transferbuffer);
 	return true;
 }
 
@@ -245,7 +193,8 @@ void SplashScreen_Draw()
 		return;
 	}
 	SDL_GPUTexture *swapchain_texture;
-	if(!SDL_WaitAndAcquireGPUSwapchainTexture(cmdbuf, drawing_context.window, &swapchain_texture, NULL, NULL))
+	Uint32 swapchain_w, swapchain_h;
+	if(!SDL_WaitAndAcquireGPUSwapchainTexture(cmdbuf, drawing_context.window, &swapchain_texture, &swapchain_w, &swapchain_h))
 	{
 		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Graphics: Renderer: Failed to acquire swapchain texture: %s", SDL_GetError());
 		return;
@@ -265,19 +214,19 @@ void SplashScreen_Draw()
 		SDL_BindGPUFragmentSamplers(renderPass, 0, &(SDL_GPUTextureSamplerBinding){ .texture = texture.texture, .sampler = sampler }, 1);
 		SDL_DrawGPUIndexedPrimitives(renderPass, 6, 1, 0, 0, 0);
 		SDL_EndGPURenderPass(renderPass);
+		SCR_CaptureFrame(cmdbuf, swapchain_texture, swapchain_w, swapchain_h);
 	}
 
-	SDL_SubmitGPUCommandBuffer(cmdbuf);
+	//keeps the pool's frames moving while no graph borrows from it
+	TexturePool_Submit(cmdbuf);
 	return;
 }
 
 void SplashScreen_Destroy()
 {
 	SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Finishing splash screen...");
-	SDL_ReleaseGPUGraphicsPipeline(drawing_context.device, pipeline);
-	SDL_ReleaseGPUBuffer(drawing_context.device, vbuffer);
-	SDL_ReleaseGPUBuffer(drawing_context.device, ibuffer);
+	GPUMem_ReleaseBuffer(drawing_context.device, vbuffer);
+	GPUMem_ReleaseBuffer(drawing_context.device, ibuffer);
 	ReleaseTexture2D(drawing_context.device, &texture);
-	SDL_ReleaseGPUSampler(drawing_context.device, sampler);
 	return;
 }
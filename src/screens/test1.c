@@ -21,21 +21,145 @@
 #include <assets.h>
 #include <shader.h>
 #include <screens.h>
+#include <framedata.h>
+#include <rendergraph.h>
+#include <rtformat.h>
+#include <postchain.h>
+#include <dynres.h>
+#include <texturepool.h>
+#include <clusters.h>
+#include <scene.h>
+#include <particles.h>
 
-static SDL_GPUGraphicsPipeline *effect_pipeline;
 static SDL_GPUSampler *effect_sampler;
-static EffectBuffers effect_buffer;
+
+//post effects, 1-5 toggle them in this order
+static PostChain post;
+static int fx_outline, fx_blur, fx_sharpen, fx_grade, fx_vignette;
+//heat map over the overdraw counts, only in the overdraw view
+static int fx_overdraw;
+
+//color and normal either in two geometry passes or in a single one
+//writing both targets
+typedef enum CelMode
+{
+	CEL_MODE_TWOPASS = 0,
+	CEL_MODE_MRT,
+	CEL_MODE_COUNT
+} CelMode;
+
+static const char *cel_mode_names[CEL_MODE_COUNT] = { "two-pass", "single-pass MRT" };
+
+//edge filter as a full-screen fragment pass or as a tiled compute pass
+typedef enum OutlinePath
+{
+	OUTLINE_PATH_FRAGMENT = 0,
+	OUTLINE_PATH_COMPUTE,
+	OUTLINE_PATH_COUNT
+} OutlinePath;
+
+static const char *outline_path_names[OUTLINE_PATH_COUNT] = { "fragment", "compute" };
+
+//must match outline.comp
+#define OUTLINE_TILE 16
+
+typedef struct OutlineInfo
+{
+	Sint32 width, height;
+	Sint32 octahedral;
+	Sint32 padding;
+} OutlineInfo;
+
+//frame time comparisons, each phase runs for a while with vsync off
+#define BENCH_WARMUP 60
+#define BENCH_FRAMES 600
+#define BENCH_MAX_PHASES 4
+
+typedef enum BenchKind
+{
+	BENCH_CEL = 0, //two-pass vs MRT
+	BENCH_OUTLINE, //fragment vs compute outline at 1080p and 4K
+	BENCH_DEPTH //every ScreenDepthMode
+} BenchKind;
+
+typedef struct Benchmark
+{
+	bool running;
+	BenchKind kind;
+	int phase, num_phases;
+	Uint32 frames;
+	Uint64 start;
+	double frame_ms[BENCH_MAX_PHASES];
+	CelMode previous_mode;
+	OutlinePath previous_path;
+	bool previous_outline;
+	ScreenDepthMode previous_depth;
+} Benchmark;
+
+static const Uint32 outlinebench_sizes[2][2] = { { 1920, 1080 }, { 3840, 2160 } };
+
+static SDL_GPUGraphicsPipeline *gbuffer_pipeline;
+static SDL_GPUGraphicsPipeline *prepass_pipeline;
+static SDL_GPUGraphicsPipeline *overdraw_pipeline;
+static GBufferFormats gbuffer;
+static ScreenDepthMode depth_mode;
+static bool overdraw_view;
+static CelMode cel_mode;
+static Benchmark bench;
+static Uint64 last_draw;
+static double frame_ms;
+
+static bool outline_enabled;
+
+static SDL_GPUComputePipeline *outline_compute;
+static OutlinePath outline_path;
+static RGTexture outline_texture;
+//scene targets are allocated at target_w x target_h (the swapchain,
+//or the benchmark size) and drawn at scene_w x scene_h in their corner
+static Uint32 target_w, target_h;
+static Uint32 scene_w, scene_h;
+static DynamicResolution dynres;
+static bool dynres_enabled;
 
 static SDL_GPUGraphicsPipeline *norm_pipeline;
-static SDL_GPUTexture *scene_normtexture;
+static RGTexture scene_normtexture;
 
-static SDL_GPUTexture *scene_colortexture;
+static RGTexture scene_colortexture;
 
 static SDL_GPUGraphicsPipeline *simple;
 static SDL_GPUSampler *sampler;
-static SDL_GPUTexture *depth_texture;
+static RenderGraph graph;
 static Model *car;
+static Uint32 car_index;
 static Matrix4x4 car_transform;
+static FrameData framedata;
+
+//point lights orbiting the car, L cycles how many
+#define TEST1_LIGHT_STEPS 4
+static const Uint32 light_steps[TEST1_LIGHT_STEPS] = { 0, 64, 256, 1024 };
+static int light_step;
+static Scene lights_scene;
+static ClusteredLights clusters;
+static bool clusters_ready;
+
+//a fountain over the car, F cycles how many particles it keeps alive
+//and X turns the collisions against the depth buffer on and off
+#define TEST1_PARTICLE_STEPS 4
+#define TEST1_PARTICLE_CAPACITY (1024 * 1024)
+static const Uint32 particle_steps[TEST1_PARTICLE_STEPS] = { 0, 64 * 1024, 256 * 1024, TEST1_PARTICLE_CAPACITY };
+static int particle_step;
+static ParticleSystem particles;
+static bool particles_ready;
+static float particle_backlog; //fraction of a particle not emitted yet
+static const ParticleEmitter fountain = {
+	.position = { 0.0f, 4.0f, -8.0f },
+	.radius = 0.25f,
+	.velocity = { 0.0f, 3.0f, 0.0f },
+	.spread = 2.5f,
+	.life_min = 2.0f,
+	.life_max = 4.0f,
+	.color = 0xFF40A0FFu //orange, rgba8 read from the low byte
+};
 
 static float deltatime;
 static float lastframe;
@@ -46,211 +170,255 @@ static float mouse_x, mouse_y;
 static bool first_mouse;
 static Camera cam_1;
 
-static SDL_GPUGraphicsPipeline *createpipeline_simple(SDL_GPUShader *vs, SDL_GPUShader *fs,
-														bool release_shaders)
+static void set_vsync(bool vsync)
 {
-	if(vs == NULL || fs == NULL)
+	SDL_GPUPresentMode mode = vsync ? SDL_GPU_PRESENTMODE_VSYNC : SDL_GPU_PRESENTMODE_IMMEDIATE;
+	if(!SDL_WindowSupportsGPUPresentMode(drawing_context.device, drawing_context.window, mode))
 	{
-		return NULL;
+		SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Present mode not supported, timings may be capped by vsync.");
+		return;
 	}
+	SDL_SetGPUSwapchainParameters(drawing_context.device, drawing_context.window,
+									SDL_GPU_SWAPCHAINCOMPOSITION_SDR, mode);
+}
 
-	SDL_GPUGraphicsPipelineCreateInfo pipeline_createinfo = { 0 };
-	pipeline_createinfo = (SDL_GPUGraphicsPipelineCreateInfo)
+//pipelines writing or reading the G-buffer are variants of the shared
+//ones, with the negotiated formats and the matching encode/decode shaders
+//the depth mode picks the depth state and whether a pre-pass goes first
+static bool select_gbuffer(GBufferNormalEncoding normal, GBufferColorEncoding color, ScreenDepthMode depth)
+{
+	GBufferFormats formats;
+	if(!RTFormat_NegotiateGBuffer(drawing_context.device, normal, color, &formats))
 	{
-		.target_info =
-		{
-			.num_color_targets = 1,
-			.color_target_descriptions = (SDL_GPUColorTargetDescription[]){{
-				.format = SDL_GetGPUSwapchainTextureFormat(drawing_context.device, drawing_context.window)
-			}},
-			.has_depth_stencil_target = true,
-			.depth_stencil_format = SDL_GPU_TEXTUREFORMAT_D16_UNORM
-		},
-		.depth_stencil_state = (SDL_GPUDepthStencilState){
-			.enable_depth_test = true,
-			.enable_depth_write = true,
-			.enable_stencil_test = false,
-			.compare_op = SDL_GPU_COMPAREOP_LESS,
-			.write_mask = 0xFF
-		},
-		.rasterizer_state = (SDL_GPURasterizerState){
-			.cull_mode = SDL_GPU_CULLMODE_NONE,
-			.fill_mode = SDL_GPU_FILLMODE_FILL,
-			.front_face = SDL_GPU_FRONTFACE_COUNTER_CLOCKWISE
-		},
-		.vertex_input_state = (SDL_GPUVertexInputState){
-			.num_vertex_buffers = 1,
-			.vertex_buffer_descriptions = (SDL_GPUVertexBufferDescription[]){{
-				.slot = 0,
-				.input_rate = SDL_GPU_VERTEXINPUTRATE_VERTEX,
-				.instance_step_rate = 0,
-				.pitch = sizeof(Vertex3D)
-			}},
-			.num_vertex_attributes = 2,
-			.vertex_attributes = (SDL_GPUVertexAttribute[]){{
-				//position
-				.buffer_slot = 0,
-				.format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT3,
-				.location = 0,
-				.offset = 0
-			}, {
-				//uv
-				.buffer_slot = 0,
-				.format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT2,
-				.location = 1,
-				.offset = (sizeof(float) * 3)
-			}} //there's more, but I need only these now
-		},
-		.primitive_type = SDL_GPU_PRIMITIVETYPE_TRIANGLELIST,
-		.vertex_shader = vs,
-		.fragment_shader = fs
-	};
-	SDL_GPUGraphicsPipeline *pipeline = SDL_CreateGPUGraphicsPipeline(drawing_context.device, &pipeline_createinfo);
-	if(release_shaders)
+		return false;
+	}
+	bool oct = formats.normal_encoding != GBUFFER_NORMAL_RGBA8;
+
+	PipelineDesc color_desc = SCR_GetPipelineDesc(SCR_PIPELINE_CEL_COLOR);
+	color_desc.color_formats[0] = formats.color;
+	color_desc.depth_format = formats.depth;
+	SCR_SetDepthMode(&color_desc, depth);
+	//lit variants need the world position, gbuffer.vert has it
+	bool lit = clusters_ready && light_steps[light_step] != 0;
+	if(lit)
+	{
+		color_desc.vertex_shader = "shaders/framedata/gbuffer.vert.spv";
+		color_desc.fragment_shader = "shaders/clusters/lit.frag.spv";
+	}
+
+	PipelineDesc norm_desc = SCR_GetPipelineDesc(SCR_PIPELINE_CEL_NORMAL);
+	norm_desc.color_formats[0] = formats.normal;
+	norm_desc.depth_format = formats.depth;
+	SCR_SetDepthMode(&norm_desc, depth);
+	if(oct)
+	{
+		norm_desc.fragment_shader = "shaders/framedata/norm_oct.frag.spv";
+	}
+
+	PipelineDesc gbuffer_desc = SCR_GetPipelineDesc(SCR_PIPELINE_CEL_GBUFFER);
+	gbuffer_desc.color_formats[0] = formats.color;
+	gbuffer_desc.color_formats[1] = formats.normal;
+	gbuffer_desc.depth_format = formats.depth;
+	SCR_SetDepthMode(&gbuffer_desc, depth);
+	if(oct)
+	{
+		gbuffer_desc.fragment_shader = lit ? "shaders/clusters/gbuffer_lit_oct.frag.spv" : "shaders/framedata/gbuffer_oct.frag.spv";
+	}
+	else if(lit)
+	{
+		gbuffer_desc.fragment_shader = "shaders/clusters/gbuffer_lit.frag.spv";
+	}
+
+	PipelineDesc prepass_desc = SCR_GetDepthPrepassDesc(SCR_PIPELINE_CEL_COLOR);
+	prepass_desc.depth_format = formats.depth;
+	PipelineDesc overdraw_desc = SCR_GetOverdrawDesc(SCR_PIPELINE_CEL_COLOR, depth);
+	overdraw_desc.depth_format = formats.depth;
+
+	SDL_GPUGraphicsPipeline *new_simple = PipelineCache_Get(&color_desc);
+	SDL_GPUGraphicsPipeline *new_norm = PipelineCache_Get(&norm_desc);
+	SDL_GPUGraphicsPipeline *new_gbuffer = PipelineCache_Get(&gbuffer_desc);
+	SDL_GPUGraphicsPipeline *new_prepass = PipelineCache_Get(&prepass_desc);
+	SDL_GPUGraphicsPipeline *new_overdraw = PipelineCache_Get(&overdraw_desc);
+	if(new_simple == NULL || new_norm == NULL || new_gbuffer == NULL || new_prepass == NULL || new_overdraw == NULL)
 	{
-		SDL_ReleaseGPUShader(drawing_context.device, vs);
-		SDL_ReleaseGPUShader(drawing_context.device, fs);
+		SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "G-buffer %s/%s pipelines not available with %s depth.",
+					RTFormat_GetNormalEncodingName(formats.normal_encoding),
+					RTFormat_GetColorEncodingName(formats.color_encoding),
+					SCR_GetDepthModeName(depth));
+		return false;
 	}
 
-	return pipeline;
+	simple = new_simple;
+	norm_pipeline = new_norm;
+	gbuffer_pipeline = new_gbuffer;
+	prepass_pipeline = new_prepass;
+	overdraw_pipeline = new_overdraw;
+	gbuffer = formats;
+	depth_mode = depth;
+	SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "G-buffer: normals %s, color %s, outline reads %u bytes per pixel.",
+				RTFormat_GetNormalEncodingName(gbuffer.normal_encoding),
+				RTFormat_GetColorEncodingName(gbuffer.color_encoding),
+				SDL_GPUTextureFormatTexelBlockSize(gbuffer.normal) + SDL_GPUTextureFormatTexelBlockSize(gbuffer.color));
+	return true;
+}
+
+//phases change the settings they compare, everything else stays put
+static void bench_apply_phase()
+{
+	if(bench.kind == BENCH_CEL)
+	{
+		cel_mode = (CelMode)bench.phase;
+	}
+	else if(bench.kind == BENCH_DEPTH)
+	{
+		select_gbuffer(gbuffer.normal_encoding, gbuffer.color_encoding, (ScreenDepthMode)bench.phase);
+	}
+	else
+	{
+		outline_path = (OutlinePath)(bench.phase % OUTLINE_PATH_COUNT);
+	}
 }
 
-static SDL_GPUGraphicsPipeline *createpipeline_norm(SDL_GPUShader *vs, SDL_GPUShader *fs,
-														bool release_shaders)
+static void bench_start(BenchKind kind)
 {
-	if(vs == NULL || fs == NULL)
+	bench = (Benchmark){
+		.running = true,
+		.kind = kind,
+		.num_phases = (kind == BENCH_CEL) ? CEL_MODE_COUNT : (kind == BENCH_DEPTH) ? SCR_DEPTH_COUNT : 2 * OUTLINE_PATH_COUNT,
+		.previous_mode = cel_mode,
+		.previous_path = outline_path,
+		.previous_outline = outline_enabled,
+		.previous_depth = depth_mode
+	};
+	if(kind == BENCH_OUTLINE)
 	{
-		return NULL;
+		outline_enabled = true;
 	}
+	SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Benchmark: %d frames per phase...", BENCH_FRAMES);
+	bench_apply_phase();
+	set_vsync(false);
+}
 
-	SDL_GPUGraphicsPipelineCreateInfo pipeline_createinfo = { 0 };
-	pipeline_createinfo = (SDL_GPUGraphicsPipelineCreateInfo)
+static void bench_report()
+{
+	if(bench.kind == BENCH_CEL)
 	{
-		.target_info =
+		int width, height;
+		SDL_GetWindowSizeInPixels(drawing_context.window, &width, &height);
+		double twopass = bench.frame_ms[CEL_MODE_TWOPASS];
+		double mrt = bench.frame_ms[CEL_MODE_MRT];
+		SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Cel benchmark (%dx%d, outline %s): %s %.3f ms, %s %.3f ms (%+.1f%%)",
+					width, height, outline_enabled ? "on" : "off",
+					cel_mode_names[CEL_MODE_TWOPASS], twopass,
+					cel_mode_names[CEL_MODE_MRT], mrt,
+					(twopass > 0.0) ? (mrt - twopass) * 100.0 / twopass : 0.0);
+		return;
+	}
+	if(bench.kind == BENCH_DEPTH)
+	{
+		double direct = bench.frame_ms[SCR_DEPTH_DIRECT];
+		for(int mode = 0; mode < SCR_DEPTH_COUNT; mode++)
 		{
-			.num_color_targets = 1,
-			.color_target_descriptions = (SDL_GPUColorTargetDescription[]){{
-				.format = SDL_GetGPUSwapchainTextureFormat(drawing_context.device, drawing_context.window)
-			}},
-			.has_depth_stencil_target = true,
-			.depth_stencil_format = SDL_GPU_TEXTUREFORMAT_D16_UNORM
-		},
-		.depth_stencil_state = (SDL_GPUDepthStencilState){
-			.enable_depth_test = true,
-			.enable_depth_write = true,
-			.enable_stencil_test = false,
-			.compare_op = SDL_GPU_COMPAREOP_LESS,
-			.write_mask = 0xFF
-		},
-		.rasterizer_state = (SDL_GPURasterizerState){
-			.cull_mode = SDL_GPU_CULLMODE_NONE,
-			.fill_mode = SDL_GPU_FILLMODE_FILL,
-			.front_face = SDL_GPU_FRONTFACE_COUNTER_CLOCKWISE
-		},
-		.vertex_input_state = (SDL_GPUVertexInputState){
-			.num_vertex_buffers = 1,
-			.vertex_buffer_descriptions = (SDL_GPUVertexBufferDescription[]){{
-				.slot = 0,
-				.input_rate = SDL_GPU_VERTEXINPUTRATE_VERTEX,
-				.instance_step_rate = 0,
-				.pitch = sizeof(Vertex3D)
-			}},
-			.num_vertex_attributes = 2,
-			.vertex_attributes = (SDL_GPUVertexAttribute[]){{
-				//position
-				.buffer_slot = 0,
-				.format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT3,
-				.location = 0,
-				.offset = 0
-			}, {
-				//normal
-				.buffer_slot = 0,
-				.format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT3,
-				.location = 1,
-				.offset = (sizeof(float) * 3)
-			}} //there's more, but I need only these now
-		},
-		.primitive_type = SDL_GPU_PRIMITIVETYPE_TRIANGLELIST,
-		.vertex_shader = vs,
-		.fragment_shader = fs
-	};
-	SDL_GPUGraphicsPipeline *pipeline = SDL_CreateGPUGraphicsPipeline(drawing_context.device, &pipeline_createinfo);
-	if(release_shaders)
+			SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Depth benchmark (%s): %s %.3f ms (%+.1f%%)",
+						cel_mode_names[cel_mode], SCR_GetDepthModeName((ScreenDepthMode)mode), bench.frame_ms[mode],
+						(direct > 0.0) ? (bench.frame_ms[mode] - direct) * 100.0 / direct : 0.0);
+		}
+		return;
+	}
+	for(int size = 0; size < 2; size++)
 	{
-		SDL_ReleaseGPUShader(drawing_context.device, vs);
-		SDL_ReleaseGPUShader(drawing_context.device, fs);
+		double fragment = bench.frame_ms[size * OUTLINE_PATH_COUNT + OUTLINE_PATH_FRAGMENT];
+		double compute = bench.frame_ms[size * OUTLINE_PATH_COUNT + OUTLINE_PATH_COMPUTE];
+		SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Outline benchmark (%ux%u, %s): fragment %.3f ms, compute %.3f ms (%+.1f%%)",
+					outlinebench_sizes[size][0], outlinebench_sizes[size][1], cel_mode_names[cel_mode],
+					fragment, compute, (fragment > 0.0) ? (compute - fragment) * 100.0 / fragment : 0.0);
 	}
+}
 
-	return pipeline;
+static void bench_stop()
+{
+	bench.running = false;
+	cel_mode = bench.previous_mode;
+	outline_path = bench.previous_path;
+	outline_enabled = bench.previous_outline;
+	if(depth_mode != bench.previous_depth)
+	{
+		select_gbuffer(gbuffer.normal_encoding, gbuffer.color_encoding, bench.previous_depth);
+	}
+	set_vsync(true);
 }
 
-static SDL_GPUGraphicsPipeline *createpipeline_effect(SDL_GPUShader *vs, SDL_GPUShader *fs,
-														bool release_shaders)
+//called once per frame; acquiring the swapchain waits for the GPU, so
+//with vsync off the frame interval follows the GPU cost of each phase
+static void bench_frame()
 {
-	if(vs == NULL || fs == NULL)
+	if(!bench.running)
 	{
-		return NULL;
+		return;
+	}
+	bench.frames++;
+	if(bench.frames == BENCH_WARMUP)
+	{
+		bench.start = SDL_GetPerformanceCounter();
+		return;
+	}
+	if(bench.frames < BENCH_WARMUP + BENCH_FRAMES)
+	{
+		return;
 	}
 
-	SDL_GPUGraphicsPipelineCreateInfo pipeline_createinfo = { 0 };
-	pipeline_createinfo = (SDL_GPUGraphicsPipelineCreateInfo)
+	Uint64 elapsed = SDL_GetPerformanceCounter() - bench.start;
+	bench.frame_ms[bench.phase] = (double)elapsed * 1000.0 / (double)SDL_GetPerformanceFrequency() / BENCH_FRAMES;
+	bench.phase++;
+	bench.frames = 0;
+	if(bench.phase < bench.num_phases)
 	{
-		.target_info =
-		{
-			.num_color_targets = 1,
-			.color_target_descriptions = (SDL_GPUColorTargetDescription[]){{
-				.format = SDL_GetGPUSwapchainTextureFormat(drawing_context.device, drawing_context.window)
-			}},
-			.has_depth_stencil_target = true,
-			.depth_stencil_format = SDL_GPU_TEXTUREFORMAT_D16_UNORM
-		},
-		.depth_stencil_state = (SDL_GPUDepthStencilState){
-			.enable_depth_test = true,
-			.enable_depth_write = true,
-			.enable_stencil_test = false,
-			.compare_op = SDL_GPU_COMPAREOP_LESS,
-			.write_mask = 0xFF
-		},
-		.rasterizer_state = (SDL_GPURasterizerState){
-			.cull_mode = SDL_GPU_CULLMODE_NONE,
-			.fill_mode = SDL_GPU_FILLMODE_FILL,
-			.front_face = SDL_GPU_FRONTFACE_COUNTER_CLOCKWISE
-		},
-		.vertex_input_state = (SDL_GPUVertexInputState){
-			.num_vertex_buffers = 1,
-			.vertex_buffer_descriptions = (SDL_GPUVertexBufferDescription[]){{
-				.slot = 0,
-				.input_rate = SDL_GPU_VERTEXINPUTRATE_VERTEX,
-				.instance_step_rate = 0,
-				.pitch = sizeof(EffectVertex)
-			}},
-			.num_vertex_attributes = 2,
-			.vertex_attributes = (SDL_GPUVertexAttribute[]){{
-				//position
-				.buffer_slot = 0,
-				.format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT3,
-				.location = 0,
-				.offset = 0
-			}, {
-				//uv
-				.buffer_slot = 0,
-				.format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT2,
-				.location = 1,
-				.offset = (sizeof(float) * 3)
-			}}
-		},
-		.primitive_type = SDL_GPU_PRIMITIVETYPE_TRIANGLELIST,
-		.vertex_shader = vs,
-		.fragment_shader = fs
-	};
-	SDL_GPUGraphicsPipeline *pipeline = SDL_CreateGPUGraphicsPipeline(drawing_context.device, &pipeline_createinfo);
-	if(release_shaders)
+		bench_apply_phase();
+		return;
+	}
+	bench_report();
+	bench_stop();
+}
+
+//rings of lights at different heights around the car, colors spread
+//over the hue wheel; positions are set every frame by animate_lights
+static void set_light_count(Uint32 count)
+{
+	while(lights_scene.num_lights > count)
 	{
-		SDL_ReleaseGPUShader(drawing_context.device, vs);
-		SDL_ReleaseGPUShader(drawing_context.device, fs);
+		Scene_RemoveLight(&lights_scene, lights_scene.num_lights - 1);
 	}
+	while(lights_scene.num_lights < count)
+	{
+		float hue = (float)lights_scene.num_lights * 0.618034f;
+		hue = (hue - SDL_floorf(hue)) * 6.0f;
+		Vector3 color = {
+			SDL_clamp(SDL_fabsf(hue - 3.0f) - 1.0f, 0.0f, 1.0f),
+			SDL_clamp(2.0f - SDL_fabsf(hue - 2.0f), 0.0f, 1.0f),
+			SDL_clamp(2.0f - SDL_fabsf(hue - 4.0f), 0.0f, 1.0f)
+		};
+		if(Scene_AddLight(&lights_scene, (SceneLight){ .radius = 3.0f, .color = color, .intensity = 1.5f }) < 0)
+		{
+			break;
+		}
+	}
+}
 
-	return pipeline;
+static void animate_lights(float seconds)
+{
+	Uint32 count = lights_scene.num_lights;
+	for(Uint32 i = 0; i < count; i++)
+	{
+		SceneLight *light = Scene_GetLight(&lights_scene, i);
+		float ring = (float)(i % 8);
+		float angle = seconds * (0.3f + 0.05f * ring) + (float)i * (2.0f * SDL_PI_F / (float)count) * 8.0f;
+		float distance = 3.0f + 0.75f * ring;
+		light->position = (Vector3){
+			SDL_cosf(angle) * distance,
+			-1.5f + 0.5f * ring,
+			-8.0f + SDL_sinf(angle) * distance
+		};
+	}
 }
 
 bool TestScreen1_Setup()
@@ -268,119 +436,84 @@ bool TestScreen1_Setup()
 	//need to bring lookat, or a camera update thing
 	InitCameraBasic(&cam_1, (Vector3){0.0f, 0.0f, 8.0f}, (float)width / (float)height);
 
-	SDL_GPUShader *vsimpleshader = LoadShader("shaders/simpletest/simple.vert.spv", drawing_context.device, SDL_GPU_SHADERSTAGE_VERTEX, 0, 1, 0, 0);
-	if(vsimpleshader == NULL)
+	//unlit until L, the scene only holds the lights here
+	light_step = 0;
+	Scene_Init(&lights_scene);
+	clusters_ready = Clusters_Init(drawing_context.device, &clusters);
+	particle_step = 0;
+	particle_backlog = 0.0f;
+	particles_ready = Particles_Init(drawing_context.device, &particles, TEST1_PARTICLE_CAPACITY);
+
+	//compact G-buffer by default, the RGBA8 layout is the fallback
+	if(!select_gbuffer(GBUFFER_NORMAL_OCT8, GBUFFER_COLOR_RGBA8, SCR_DEPTH_DIRECT) &&
+		!select_gbuffer(GBUFFER_NORMAL_RGBA8, GBUFFER_COLOR_RGBA8, SCR_DEPTH_DIRECT))
 	{
-		SDL_Log("Failed to load simple vertex shader.");
-		return NULL;
+		return false;
 	}
-	SDL_GPUShader *fsimpleshader = LoadShader("shaders/simpletest/simple.frag.spv", drawing_context.device, SDL_GPU_SHADERSTAGE_FRAGMENT, 1, 0, 0, 0);
-	if(fsimpleshader == NULL)
+	overdraw_view = false;
+
+	car = (Model*)SDL_malloc(sizeof(Model));
+	if(car != NULL)
 	{
-		SDL_Log("Failed to load simple fragment shader.");
-		return NULL;
+		ImportIQM(drawing_context.device, car, "testmodels/nimrud/nimrud_body.iqm");
 	}
-	simple = createpipeline_simple(vsimpleshader, fsimpleshader, true);
 
-	SDL_GPUShader *vnormshader = LoadShader("shaders/norm/norm.vert.spv", drawing_context.device, SDL_GPU_SHADERSTAGE_VERTEX, 0, 1, 0, 0);
-	if(vsimpleshader == NULL)
+	sampler = SCR_GetSampler(SDL_GPU_FILTER_LINEAR, SDL_GPU_SAMPLERMIPMAPMODE_LINEAR,
+								SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE);
+
+	//scene targets are transient, the render graph hands them out per frame
+	if(!RenderGraph_Init(drawing_context.device, &graph))
 	{
-		SDL_Log("Failed to load norm vertex shader.");
-		return NULL;
+		return false;
 	}
-	SDL_GPUShader *fnormshader = LoadShader("shaders/norm/norm.frag.spv", drawing_context.device, SDL_GPU_SHADERSTAGE_FRAGMENT, 0, 0, 0, 0);
-	if(fnormshader == NULL)
+	outline_enabled = true;
+	cel_mode = CEL_MODE_TWOPASS;
+	bench = (Benchmark){ 0 };
+
+	//compute outline needs an RGBA8 storage target, the fragment pass
+	//covers devices without one
+	outline_path = OUTLINE_PATH_FRAGMENT;
+	outline_compute = ShaderLib_GetCompute("shaders/outline/outline.comp.spv");
+	if(outline_compute != NULL &&
+		SDL_GPUTextureSupportsFormat(drawing_context.device, SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM, SDL_GPU_TEXTURETYPE_2D,
+										SDL_GPU_TEXTUREUSAGE_COMPUTE_STORAGE_WRITE | SDL_GPU_TEXTUREUSAGE_SAMPLER))
 	{
-		SDL_Log("Failed to load skybox fragment shader.");
-		return NULL;
+		outline_path = OUTLINE_PATH_COMPUTE;
 	}
-	norm_pipeline = createpipeline_simple(vnormshader, fnormshader, true);
-
-	car = (Model*)SDL_malloc(sizeof(Model));
-	if(car != NULL)
+	else
 	{
-		ImportIQM(drawing_context.device, car, "testmodels/nimrud/nimrud_body.iqm");
+		outline_compute = NULL;
+		SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Compute outline not available, using the fragment pass.");
 	}
-
-	SDL_GPUSamplerCreateInfo samplercreateinfo = { 0 };
-	samplercreateinfo.min_filter = SDL_GPU_FILTER_LINEAR;
-	samplercreateinfo.mag_filter = SDL_GPU_FILTER_LINEAR;
-	samplercreateinfo.mipmap_mode = SDL_GPU_SAMPLERMIPMAPMODE_LINEAR;
-	samplercreateinfo.address_mode_u = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE;
-	samplercreateinfo.address_mode_v = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE;
-	samplercreateinfo.address_mode_w = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE;
-	sampler = SDL_CreateGPUSampler(drawing_context.device, &samplercreateinfo);
-
-	depth_texture = SDL_CreateGPUTexture(
-		drawing_context.device,
-		&(SDL_GPUTextureCreateInfo) {
-			.type = SDL_GPU_TEXTURETYPE_2D,
-			.width = width,
-			.height = height,
-			.layer_count_or_depth = 1,
-			.num_levels = 1,
-			.sample_count = SDL_GPU_SAMPLECOUNT_1,
-			.format = SDL_GPU_TEXTUREFORMAT_D16_UNORM,
-			.usage = SDL_GPU_TEXTUREUSAGE_SAMPLER | SDL_GPU_TEXTUREUSAGE_DEPTH_STENCIL_TARGET
-		}
-	);
-
-	scene_colortexture = SDL_CreateGPUTexture(
-		drawing_context.device,
-		&(SDL_GPUTextureCreateInfo) {
-			.type = SDL_GPU_TEXTURETYPE_2D,
-			.width = width,
-			.height = height,
-			.layer_count_or_depth = 1,
-			.num_levels = 1,
-			.sample_count = SDL_GPU_SAMPLECOUNT_1,
-			.format = SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM,
-			.usage = SDL_GPU_TEXTUREUSAGE_SAMPLER | SDL_GPU_TEXTUREUSAGE_COLOR_TARGET
-		}
-	);
-
-	scene_normtexture = SDL_CreateGPUTexture(
-		drawing_context.device,
-		&(SDL_GPUTextureCreateInfo) {
-			.type = SDL_GPU_TEXTURETYPE_2D,
-			.width = width,
-			.height = height,
-			.layer_count_or_depth = 1,
-			.num_levels = 1,
-			.sample_count = SDL_GPU_SAMPLECOUNT_1,
-			.format = SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM,
-			.usage = SDL_GPU_TEXTUREUSAGE_SAMPLER | SDL_GPU_TEXTUREUSAGE_COLOR_TARGET
-		}
-	);
+	last_draw = 0;
+	frame_ms = 0.0;
+	DynRes_Init(&dynres, screen_settings.target_fps, screen_settings.min_render_scale, 1.0f);
+	dynres_enabled = screen_settings.dynamic_resolution;
 
 	//effect stuff
-	SDL_GPUShader *effectvs = LoadShader("shaders/outline/default.vert.spv", drawing_context.device, SDL_GPU_SHADERSTAGE_VERTEX, 0, 0, 0, 0);
-	if(effectvs == NULL)
+	effect_sampler = SCR_GetSampler(SDL_GPU_FILTER_NEAREST, SDL_GPU_SAMPLERMIPMAPMODE_NEAREST,
+										SDL_GPU_SAMPLERADDRESSMODE_REPEAT);
+
+	if(!PostChain_Init(&post))
 	{
-		SDL_Log("Failed to load effect vertex shader.");
-		return NULL;
+		return false;
 	}
-	//tried with blur, some sharpening, etc. all did work
-	SDL_GPUShader *effectfs = LoadShader("shaders/outline/outline.frag.spv", drawing_context.device, SDL_GPU_SHADERSTAGE_FRAGMENT, 2, 1, 0, 0);
-	if(effectfs == NULL)
+	//counts become colors before anything else touches them
+	fx_overdraw = PostChain_AddEffect(&post, POST_EFFECT_OVERDRAW, (float[4]){ SCR_OVERDRAW_SCALE });
+	fx_outline = PostChain_AddEffect(&post, POST_EFFECT_OUTLINE, (float[4]){ 1.0f });
+	fx_blur = PostChain_AddEffect(&post, POST_EFFECT_BLUR, (float[4]){ 1.0f });
+	fx_sharpen = PostChain_AddEffect(&post, POST_EFFECT_SHARPEN, (float[4]){ 0.5f });
+	fx_grade = PostChain_AddEffect(&post, POST_EFFECT_GRADE, (float[4]){ 1.1f, 1.2f, 1.3f });
+	fx_vignette = PostChain_AddEffect(&post, POST_EFFECT_VIGNETTE, (float[4]){ 0.6f, 0.4f });
+	PostChain_SetEnabled(&post, fx_blur, false);
+	PostChain_SetEnabled(&post, fx_sharpen, false);
+	PostChain_SetEnabled(&post, fx_grade, false);
+	PostChain_SetEnabled(&post, fx_vignette, false);
+
+	if(!FrameData_Init(drawing_context.device, &framedata, 16))
 	{
-		SDL_Log("Failed to load effect fragment shader.");
-		return NULL;
+		return false;
 	}
-	effect_pipeline = createpipeline_effect(effectvs, effectfs, true);
-
-	samplercreateinfo = (SDL_GPUSamplerCreateInfo){ 0 };
-	samplercreateinfo.min_filter = SDL_GPU_FILTER_NEAREST;
-	samplercreateinfo.mag_filter = SDL_GPU_FILTER_NEAREST;
-	samplercreateinfo.mipmap_mode = SDL_GPU_SAMPLERMIPMAPMODE_NEAREST;
-	samplercreateinfo.address_mode_u = SDL_GPU_SAMPLERADDRESSMODE_REPEAT;
-	samplercreateinfo.address_mode_v = SDL_GPU_SAMPLERADDRESSMODE_REPEAT;
-	samplercreateinfo.address_mode_w = SDL_GPU_SAMPLERADDRESSMODE_REPEAT;
-	effect_sampler = SDL_CreateGPUSampler(drawing_context.device, &samplercreateinfo);
-
-	//TODO gen buffers
-	effect_buffer = (EffectBuffers){ 0 };
-	SCR_CreateEffectBuffers(&effect_buffer);
 
 	return true;
 }
@@ -413,6 +546,92 @@ void TestScreen1_Input(SDL_Event event)
 			newpos.z = newpos.z - aux.z;
 			UpdateCameraPosition(&cam_1, newpos);
 		}
+		if(event.key.key == SDLK_O || event.key.key == SDLK_1)
+		{
+			//without the outline nothing reads the normals, so the
+			//graph drops the normal pass by itself
+			outline_enabled = !outline_enabled;
+			SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Outline %s.", outline_enabled ? "on" : "off");
+		}
+		if(event.key.key >= SDLK_2 && event.key.key <= SDLK_5)
+		{
+			//the outline (1) follows outline_enabled, see Draw
+			int fx[] = { fx_blur, fx_sharpen, fx_grade, fx_vignette };
+			int effect = fx[event.key.key - SDLK_2];
+			PostChain_SetEnabled(&post, effect, !PostChain_IsEnabled(&post, effect));
+		}
+		if((event.key.key == SDLK_U) && !bench.running && outline_compute != NULL)
+		{
+			outline_path = (outline_path + 1) % OUTLINE_PATH_COUNT;
+			SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Outline path: %s.", outline_path_names[outline_path]);
+		}
+		if(event.key.key == SDLK_K && !bench.running)
+		{
+			if(outline_compute != NULL)
+			{
+				bench_start(BENCH_OUTLINE);
+			}
+			else
+			{
+				SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Outline benchmark needs the compute path.");
+			}
+		}
+		if(event.key.key == SDLK_R)
+		{
+			dynres_enabled = !dynres_enabled;
+			DynRes_Reset(&dynres);
+			SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Dynamic resolution %s.", dynres_enabled ? "on" : "off");
+		}
+		if(event.key.key == SDLK_M && !bench.running)
+		{
+			cel_mode = (cel_mode + 1) % CEL_MODE_COUNT;
+			SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Cel mode: %s.", cel_mode_names[cel_mode]);
+		}
+		if(event.key.key == SDLK_G)
+		{
+			//cycles the normal encoding, keeps the current one on failure
+			select_gbuffer((gbuffer.normal_encoding + 1) % GBUFFER_NORMAL_COUNT, gbuffer.color_encoding, depth_mode);
+		}
+		if(event.key.key == SDLK_C)
+		{
+			select_gbuffer(gbuffer.normal_encoding, (gbuffer.color_encoding + 1) % GBUFFER_COLOR_COUNT, depth_mode);
+		}
+		if(event.key.key == SDLK_P && !bench.running)
+		{
+			select_gbuffer(gbuffer.normal_encoding, gbuffer.color_encoding, (depth_mode + 1) % SCR_DEPTH_COUNT);
+			SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Depth: %s.", SCR_GetDepthModeName(depth_mode));
+		}
+		if(event.key.key == SDLK_V)
+		{
+			//counts what the color pass shades, with the current depth mode
+			overdraw_view = !overdraw_view;
+			SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Overdraw view %s.", overdraw_view ? "on" : "off");
+		}
+		if(event.key.key == SDLK_L && clusters_ready)
+		{
+			light_step = (light_step + 1) % TEST1_LIGHT_STEPS;
+			set_light_count(light_steps[light_step]);
+			select_gbuffer(gbuffer.normal_encoding, gbuffer.color_encoding, depth_mode);
+			SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "%u point lights.", light_steps[light_step]);
+		}
+		if(event.key.key == SDLK_F && particles_ready)
+		{
+			particle_step = (particle_step + 1) % TEST1_PARTICLE_STEPS;
+			SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "%u particles.", particle_steps[particle_step]);
+		}
+		if(event.key.key == SDLK_X && particles_ready)
+		{
+			particles.collide = !particles.collide;
+			SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Particle collisions %s.", particles.collide ? "on" : "off");
+		}
+		if(event.key.key == SDLK_Z && !bench.running)
+		{
+			bench_start(BENCH_DEPTH);
+		}
+		if(event.key.key == SDLK_B && !bench.running)
+		{
+			bench_start(BENCH_CEL);
+		}
 		if(event.key.key == SDLK_ESCAPE)
 		{
 			SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "leaving...");
@@ -447,54 +666,40 @@ void TestScreen1_Iterate()
 	//car_transform = Matrix4x4_Scale(car_transform, (Vector3){0.1f, 0.1f, 0.1f});
 	car_transform = Matrix4x4_Rotate(car_transform, (Vector3){0.0f, 1.0f, 0.0f}, DegToRad(SDL_GetTicks() / 20));
 	car_transform = Matrix4x4_Translate(car_transform, 0.0f, 0.0f, -8.0f);
-}
+	animate_lights(current_frame / 1000.0f);
 
-void TestScreen1_Draw()
-{
-	SDL_GPUCommandBuffer* cmdbuf = SDL_AcquireGPUCommandBuffer(drawing_context.device);
-	if (cmdbuf == NULL)
+	//enough new ones to replace what dies, at the average lifetime
+	if(particles_ready && particle_step != 0)
 	{
-		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Graphics: Error: Failed to acquire command buffer.");
-		return;
+		float seconds = SDL_min(deltatime / 1000.0f, 0.1f);
+		float lifetime = (fountain.life_min + fountain.life_max) * 0.5f;
+		particle_backlog += (float)particle_steps[particle_step] * seconds / lifetime;
+		Uint32 count = (Uint32)particle_backlog;
+		particle_backlog -= (float)count;
+		Particles_Emit(&particles, &fountain, count);
 	}
+}
 
-	SDL_GPUTexture* swapchain_texture;
-	if (!SDL_WaitAndAcquireGPUSwapchainTexture(cmdbuf, drawing_context.window, &swapchain_texture, NULL, NULL))
-	{
-		return ;
-	}
+static void set_scene_viewport(SDL_GPURenderPass *renderpass)
+{
+	SDL_SetGPUViewport(renderpass, &(SDL_GPUViewport){ 0.0f, 0.0f, (float)scene_w, (float)scene_h, 0.0f, 1.0f });
+}
 
-	if(swapchain_texture == NULL)
+//SIMPLE RENDER PASS
+static void pass_color(RenderGraph *rg, SDL_GPUCommandBuffer *cmdbuf,
+						SDL_GPURenderPass *renderpass_simple, void *userdata)
+{
+	//binding graphics pipeline and per-frame object data
+	SDL_BindGPUGraphicsPipeline(renderpass_simple, simple);
+	set_scene_viewport(renderpass_simple);
+	FrameData_Bind(&framedata, renderpass_simple, 0);
+	if(lights_scene.num_lights != 0)
 	{
-		return;
+		Clusters_Bind(&clusters, renderpass_simple, cmdbuf);
 	}
-
-	SDL_GPUDepthStencilTargetInfo depthstenciltargetinfo = { 0 };
-	depthstenciltargetinfo.texture = depth_texture;
-	depthstenciltargetinfo.cycle = true;
-	depthstenciltargetinfo.clear_depth = 1;
-	depthstenciltargetinfo.clear_stencil = 0;
-	depthstenciltargetinfo.load_op = SDL_GPU_LOADOP_CLEAR;
-	depthstenciltargetinfo.store_op = SDL_GPU_STOREOP_STORE;
-	depthstenciltargetinfo.stencil_load_op = SDL_GPU_LOADOP_CLEAR;
-	depthstenciltargetinfo.stencil_store_op = SDL_GPU_STOREOP_STORE;
-
-	//SIMPLE RENDER PASS
-	SDL_GPUColorTargetInfo colorTargetInfo = { 0 };
-	colorTargetInfo.texture = scene_colortexture;
-	colorTargetInfo.clear_color = (SDL_FColor){ 0.0f, 0.7f, 0.5f, 1.0f };
-	colorTargetInfo.load_op = SDL_GPU_LOADOP_CLEAR;
-	colorTargetInfo.store_op = SDL_GPU_STOREOP_STORE;
-	SDL_GPURenderPass *renderpass_simple = SDL_BeginGPURenderPass(cmdbuf, &colorTargetInfo, 1, &depthstenciltargetinfo);
-	Matrix4x4 viewproj;
-	viewproj = Matrix4x4_Mul(cam_1.view, cam_1.projection);
-	//Matrix4x4 mvp = Matrix4x4_Mul(car->transform, viewproj);
-	Matrix4x4 mvp = Matrix4x4_Mul(car_transform, viewproj);
 	for(size_t i = 0; i < car->meshes.count; i++)
 	{
 		Mesh *mesh = &car->meshes.meshes[i];
-		//binding graphics pipeline
-		SDL_BindGPUGraphicsPipeline(renderpass_simple, simple);
 
 		//binding vertex and index buffers
 		SDL_BindGPUVertexBuffers(renderpass_simple, 0, &(SDL_GPUBufferBinding){ mesh->vbuffer, 0 }, 1);
@@ -507,66 +712,257 @@ void TestScreen1_Draw()
 		}*/
 		SDL_BindGPUFragmentSamplers(renderpass_simple, 0, &(SDL_GPUTextureSamplerBinding){ mesh->diffuse.texture, sampler }, 1);
 
-		//UBO
-		SDL_PushGPUVertexUniformData(cmdbuf, 0, &mvp, sizeof(mvp));
+		//object index goes as first_instance
+		SDL_DrawGPUIndexedPrimitives(renderpass_simple, mesh->iarray.count, 1, 0, 0, car_index);
+	}
+}
+
+//DEPTH PRE-PASS / OVERDRAW
+//positions only, no textures; userdata is the pipeline
+static void pass_positions(RenderGraph *rg, SDL_GPUCommandBuffer *cmdbuf,
+							SDL_GPURenderPass *renderpass, void *userdata)
+{
+	SDL_BindGPUGraphicsPipeline(renderpass, (SDL_GPUGraphicsPipeline*)userdata);
+	set_scene_viewport(renderpass);
+	FrameData_Bind(&framedata, renderpass, 0);
+	for(size_t i = 0; i < car->meshes.count; i++)
+	{
+		Mesh *mesh = &car->meshes.meshes[i];
+		SDL_BindGPUVertexBuffers(renderpass, 0, &(SDL_GPUBufferBinding){ mesh->vbuffer, 0 }, 1);
+		SDL_BindGPUIndexBuffer(renderpass, &(SDL_GPUBufferBinding){ mesh->ibuffer, 0 }, SDL_GPU_INDEXELEMENTSIZE_32BIT);
+		SDL_DrawGPUIndexedPrimitives(renderpass, mesh->iarray.count, 1, 0, 0, car_index);
+	}
+}
 
-		SDL_DrawGPUIndexedPrimitives(renderpass_simple, mesh->iarray.count, 1, 0, 0, 0);
+//COLOR + NORM IN ONE PASS
+static void pass_gbuffer(RenderGraph *rg, SDL_GPUCommandBuffer *cmdbuf,
+							SDL_GPURenderPass *renderpass, void *userdata)
+{
+	SDL_BindGPUGraphicsPipeline(renderpass, gbuffer_pipeline);
+	set_scene_viewport(renderpass);
+	FrameData_Bind(&framedata, renderpass, 0);
+	if(lights_scene.num_lights != 0)
+	{
+		Clusters_Bind(&clusters, renderpass, cmdbuf);
+	}
+	for(size_t i = 0; i < car->meshes.count; i++)
+	{
+		Mesh *mesh = &car->meshes.meshes[i];
+		SDL_BindGPUVertexBuffers(renderpass, 0, &(SDL_GPUBufferBinding){ mesh->vbuffer, 0 }, 1);
+		SDL_BindGPUIndexBuffer(renderpass, &(SDL_GPUBufferBinding){ mesh->ibuffer, 0 }, SDL_GPU_INDEXELEMENTSIZE_32BIT);
+		SDL_BindGPUFragmentSamplers(renderpass, 0, &(SDL_GPUTextureSamplerBinding){ mesh->diffuse.texture, sampler }, 1);
+		SDL_DrawGPUIndexedPrimitives(renderpass, mesh->iarray.count, 1, 0, 0, car_index);
 	}
-	SDL_EndGPURenderPass(renderpass_simple);
+}
 
-	//NORM RENDER PASS
-	colorTargetInfo = (SDL_GPUColorTargetInfo){ 0 };
-	colorTargetInfo.texture = scene_normtexture;
-	colorTargetInfo.clear_color = (SDL_FColor){ 0.0f, 0.7f, 0.5f, 1.0f };
-	colorTargetInfo.load_op = SDL_GPU_LOADOP_CLEAR;
-	colorTargetInfo.store_op = SDL_GPU_STOREOP_STORE;
-	SDL_GPURenderPass *renderpass_norm = SDL_BeginGPURenderPass(cmdbuf, &colorTargetInfo, 1, &depthstenciltargetinfo);
+//NORM RENDER PASS
+static void pass_normal(RenderGraph *rg, SDL_GPUCommandBuffer *cmdbuf,
+						SDL_GPURenderPass *renderpass_norm, void *userdata)
+{
+	SDL_BindGPUGraphicsPipeline(renderpass_norm, norm_pipeline);
+	set_scene_viewport(renderpass_norm);
+	FrameData_Bind(&framedata, renderpass_norm, 0);
 	for(size_t i = 0; i < car->meshes.count; i++)
 	{
 		Mesh *mesh = &car->meshes.meshes[i];
-		//binding graphics pipeline
-		SDL_BindGPUGraphicsPipeline(renderpass_norm, norm_pipeline);
 
 		//binding vertex and index buffers
 		SDL_BindGPUVertexBuffers(renderpass_norm, 0, &(SDL_GPUBufferBinding){ mesh->vbuffer, 0 }, 1);
 		SDL_BindGPUIndexBuffer(renderpass_norm, &(SDL_GPUBufferBinding){ mesh->ibuffer, 0 }, SDL_GPU_INDEXELEMENTSIZE_32BIT);
 
-		//UBO
-		struct ubo
-		{
-			Matrix4x4 mvp;
-			Matrix4x4 matmodel;
-		};
-		struct ubo ubo_object = {mvp, car_transform};
-		SDL_PushGPUVertexUniformData(cmdbuf, 0, &ubo_object, sizeof(ubo_object));
+		SDL_DrawGPUIndexedPrimitives(renderpass_norm, mesh->iarray.count, 1, 0, 0, car_index);
+	}
+}
+
+//PARTICLES
+//over the lit color, tested against the scene depth
+static void pass_particles(RenderGraph *rg, SDL_GPUCommandBuffer *cmdbuf,
+							SDL_GPURenderPass *renderpass, void *userdata)
+{
+	set_scene_viewport(renderpass);
+	Particles_Draw(&particles, renderpass, cmdbuf, &cam_1, gbuffer.color, gbuffer.depth);
+}
+
+//EFFECT COMPUTE PASS
+//same filter, one thread per pixel, 16x16 tiles
+static void pass_outline_compute(RenderGraph *rg, SDL_GPUCommandBuffer *cmdbuf,
+									SDL_GPUComputePass *computepass, void *userdata)
+{
+	OutlineInfo info = {
+		.width = (Sint32)scene_w,
+		.height = (Sint32)scene_h,
+		.octahedral = gbuffer.normal_encoding != GBUFFER_NORMAL_RGBA8
+	};
+	SDL_BindGPUComputePipeline(computepass, outline_compute);
+	SDL_BindGPUComputeSamplers(computepass, 0, (SDL_GPUTextureSamplerBinding[]){
+									{ .texture = RenderGraph_GetTexture(rg, scene_normtexture), .sampler = effect_sampler },
+									{ .texture = RenderGraph_GetTexture(rg, scene_colortexture), .sampler = effect_sampler }}, 2);
+	SDL_PushGPUComputeUniformData(cmdbuf, 0, &info, sizeof(info));
+	SDL_DispatchGPUCompute(computepass, (scene_w + OUTLINE_TILE - 1) / OUTLINE_TILE,
+							(scene_h + OUTLINE_TILE - 1) / OUTLINE_TILE, 1);
+}
+
+void TestScreen1_Draw()
+{
+	SDL_GPUCommandBuffer* cmdbuf = SDL_AcquireGPUCommandBuffer(drawing_context.device);
+	if (cmdbuf == NULL)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Graphics: Error: Failed to acquire command buffer.");
+		return;
+	}
 
-		SDL_DrawGPUIndexedPrimitives(renderpass_norm, mesh->iarray.count, 1, 0, 0, 0);
+	SDL_GPUTexture* swapchain_texture;
+	Uint32 swapchain_w, swapchain_h;
+	if (!SDL_WaitAndAcquireGPUSwapchainTexture(cmdbuf, drawing_context.window, &swapchain_texture, &swapchain_w, &swapchain_h))
+	{
+		return ;
 	}
-	SDL_EndGPURenderPass(renderpass_norm);
 
-	//EFFECT RENDER PASS
-	colorTargetInfo = (SDL_GPUColorTargetInfo){ 0 };
-	colorTargetInfo.texture = swapchain_texture;
-	colorTargetInfo.clear_color = (SDL_FColor){ 0.0f, 0.0f, 0.0f, 1.0f };
-	colorTargetInfo.load_op = SDL_GPU_LOADOP_CLEAR;
-	colorTargetInfo.store_op = SDL_GPU_STOREOP_STORE;
+	if(swapchain_texture == NULL)
+	{
+		return;
+	}
 
-	int width, height;
-	SDL_GetWindowSize(drawing_context.window, &width, &height);
-	Vector2 screensize = {(float)width, (float)height};
-
-	SDL_GPURenderPass *renderpass_effect = SDL_BeginGPURenderPass(cmdbuf, &colorTargetInfo, 1, NULL);
-	SDL_PushGPUFragmentUniformData(cmdbuf, 0, &screensize, sizeof(screensize));
-	SDL_BindGPUGraphicsPipeline(renderpass_effect, effect_pipeline);
-	SDL_BindGPUVertexBuffers(renderpass_effect, 0, &(SDL_GPUBufferBinding){ effect_buffer.vbuffer, 0 }, 1);
-	SDL_BindGPUIndexBuffer(renderpass_effect, &(SDL_GPUBufferBinding){ effect_buffer.ibuffer, 0 }, SDL_GPU_INDEXELEMENTSIZE_32BIT);
-	SDL_BindGPUFragmentSamplers(renderpass_effect, 0, (SDL_GPUTextureSamplerBinding[]){
-									{ .texture = scene_normtexture, .sampler = effect_sampler },
-									{ .texture = scene_colortexture,.sampler = effect_sampler }}, 2);
-	SDL_DrawGPUIndexedPrimitives(renderpass_effect, 6, 1, 0, 0, 0);
-	SDL_EndGPURenderPass(renderpass_effect);
-
-	SDL_SubmitGPUCommandBuffer(cmdbuf);
+	Uint64 now = SDL_GetPerformanceCounter();
+	double ms = 0.0;
+	if(last_draw != 0)
+	{
+		ms = (double)(now - last_draw) * 1000.0 / (double)SDL_GetPerformanceFrequency();
+		frame_ms = (frame_ms == 0.0) ? ms : frame_ms * 0.95 + ms * 0.05;
+	}
+	last_draw = now;
+	bench_frame();
+
+	//every object matrix goes up once, both passes read the same buffer
+	FrameData_Begin(&framedata, Matrix4x4_Mul(cam_1.view, cam_1.projection));
+	car_index = FrameData_Push(&framedata, car_transform);
+	FrameData_Upload(drawing_context.device, &framedata, cmdbuf);
+
+	//passes only say what they touch, the graph picks load/store ops,
+	//allocates the transients and drops what nobody reads
+	SDL_FColor scene_clear = { 0.0f, 0.7f, 0.5f, 1.0f };
+	RenderGraph_Begin(&graph);
+	RGTexture backbuffer = RenderGraph_ImportTexture(&graph, "swapchain", swapchain_texture, swapchain_w, swapchain_h);
+	target_w = swapchain_w;
+	target_h = swapchain_h;
+	if(bench.running && bench.kind == BENCH_OUTLINE)
+	{
+		//fixed resolutions, scaled to the window by the post chain
+		target_w = outlinebench_sizes[bench.phase / OUTLINE_PATH_COUNT][0];
+		target_h = outlinebench_sizes[bench.phase / OUTLINE_PATH_COUNT][1];
+	}
+	//benchmarks want a fixed cost, the controller stays out of them
+	DynRes_SetMaxSize(&dynres, target_w, target_h);
+	scene_w = target_w;
+	scene_h = target_h;
+	if(dynres_enabled && !bench.running)
+	{
+		DynRes_Update(&dynres, ms);
+		scene_w = dynres.width;
+		scene_h = dynres.height;
+	}
+	//binning only writes buffers, the graph would drop it as unread
+	if(lights_scene.num_lights != 0 && !overdraw_view)
+	{
+		Clusters_Update(&clusters, cmdbuf, &lights_scene, &cam_1, scene_w, scene_h);
+	}
+	//keeps simulating with the fountain off, so the last ones die out
+	if(particles_ready)
+	{
+		Particles_Update(&particles, cmdbuf, SDL_min(deltatime / 1000.0f, 0.1f));
+	}
+	scene_colortexture = RenderGraph_CreateTexture(&graph, "scene color", target_w, target_h, gbuffer.color);
+	scene_normtexture = RenderGraph_CreateTexture(&graph, "scene normal", target_w, target_h, gbuffer.normal);
+	RGTexture depth = RenderGraph_CreateTexture(&graph, "depth", target_w, target_h, gbuffer.depth);
+
+	//with a pre-pass the depth is done before any shading and the main
+	//passes only test against it; without one each pass clears its own
+	RGPass pass;
+	bool prepass = depth_mode != SCR_DEPTH_DIRECT;
+	if(prepass)
+	{
+		pass = RenderGraph_AddPass(&graph, "depth prepass", pass_positions, prepass_pipeline);
+		RenderGraph_WriteDepth(&graph, pass, depth, true);
+	}
+	if(overdraw_view)
+	{
+		//replaces the scene, the post chain shows the counts as a heat map
+		scene_colortexture = RenderGraph_CreateTexture(&graph, "overdraw", target_w, target_h, SCR_OVERDRAW_FORMAT);
+		pass = RenderGraph_AddPass(&graph, "overdraw", pass_positions, overdraw_pipeline);
+		RenderGraph_WriteColor(&graph, pass, scene_colortexture, &(SDL_FColor){ 0.0f, 0.0f, 0.0f, 0.0f });
+		RenderGraph_WriteDepth(&graph, pass, depth, !prepass);
+	}
+	else if(cel_mode == CEL_MODE_MRT)
+	{
+		//one raster of the model, two targets
+		pass = RenderGraph_AddPass(&graph, "cel gbuffer", pass_gbuffer, NULL);
+		RenderGraph_WriteColor(&graph, pass, scene_colortexture, &scene_clear);
+		RenderGraph_WriteColor(&graph, pass, scene_normtexture, &scene_clear);
+		RenderGraph_WriteDepth(&graph, pass, depth, !prepass);
+	}
+	else
+	{
+		pass = RenderGraph_AddPass(&graph, "cel color", pass_color, NULL);
+		RenderGraph_WriteColor(&graph, pass, scene_colortexture, &scene_clear);
+		RenderGraph_WriteDepth(&graph, pass, depth, !prepass);
+
+		pass = RenderGraph_AddPass(&graph, "cel normal", pass_normal, NULL);
+		RenderGraph_WriteColor(&graph, pass, scene_normtexture, &scene_clear);
+		RenderGraph_WriteDepth(&graph, pass, depth, !prepass);
+	}
+
+	if(particles_ready && !overdraw_view)
+	{
+		pass = RenderGraph_AddPass(&graph, "particles", pass_particles, NULL);
+		RenderGraph_WriteColor(&graph, pass, scene_colortexture, NULL);
+		RenderGraph_WriteDepth(&graph, pass, depth, false);
+		//next frame's simulation collides with this frame's depth
+		Particles_AddDepthPass(&particles, &graph, depth, scene_w, scene_h, Matrix4x4_Mul(cam_1.view, cam_1.projection));
+	}
+
+	//the swapchain can't be a storage texture, the compute outline goes
+	//to its own target and the post chain takes it from there
+	RGTexture post_input = scene_colortexture;
+	if(outline_enabled && outline_path == OUTLINE_PATH_COMPUTE && !overdraw_view)
+	{
+		outline_texture = RenderGraph_CreateTexture(&graph, "outline", target_w, target_h, SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM);
+		pass = RenderGraph_AddComputePass(&graph, "outline compute", pass_outline_compute, NULL);
+		RenderGraph_Read(&graph, pass, scene_normtexture);
+		RenderGraph_Read(&graph, pass, scene_colortexture);
+		RenderGraph_WriteStorage(&graph, pass, outline_texture);
+		post_input = outline_texture;
+	}
+
+	//runs at scene resolution and scales into the swapchain at the end
+	PostChain_SetEnabled(&post, fx_outline, outline_enabled && outline_path == OUTLINE_PATH_FRAGMENT);
+	PostChain_SetEnabled(&post, fx_overdraw, overdraw_view);
+	PostChain_AddPasses(&post, &graph, &(PostChainTargets){
+		.input = post_input,
+		.input_width = target_w,
+		.input_height = target_h,
+		.viewport_width = scene_w,
+		.viewport_height = scene_h,
+		.normals = overdraw_view ? RENDERGRAPH_INVALID : scene_normtexture,
+		.octahedral_normals = gbuffer.normal_encoding != GBUFFER_NORMAL_RGBA8,
+		.output = backbuffer,
+		.output_width = swapchain_w,
+		.output_height = swapchain_h,
+		.output_format = SDL_GetGPUSwapchainTextureFormat(drawing_context.device, drawing_context.window),
+		.point_upscale = overdraw_view //counts don't filter
+	});
+
+	RenderGraph_Execute(&graph, cmdbuf);
+	SCR_ShowStats("Cel %s, depth %s, normals %s (%u B/px), %s outline: %.2f ms at %ux%u | lights %u/%u | particles %u%s | %u post effects in %u passes | %u passes run, %u culled, %u transient targets in %u textures",
+					cel_mode_names[cel_mode], SCR_GetDepthModeName(depth_mode), RTFormat_GetNormalEncodingName(gbuffer.normal_encoding),
+					SDL_GPUTextureFormatTexelBlockSize(gbuffer.normal), outline_path_names[outline_path], frame_ms, scene_w, scene_h,
+					clusters.stats.visible, lights_scene.num_lights,
+					particle_steps[particle_step], particles.stats.collisions ? " colliding" : "",
+					post.stats.effects, post.stats.passes,
+					graph.stats.passes_run, graph.stats.passes_culled,
+					graph.stats.transient_textures, graph.stats.pooled_textures);
+	SCR_CaptureFrame(cmdbuf, swapchain_texture, swapchain_w, swapchain_h);
+
+	TexturePool_Submit(cmdbuf);
 	return;
 }
 
@@ -574,14 +970,17 @@ void TestScreen1_Destroy()
 {
 	SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Finishing test screen 1...");
 	ReleaseModel(drawing_context.device, car);
-	SCR_ReleaseEffectBuffers(&effect_buffer);
-	SDL_ReleaseGPUGraphicsPipeline(drawing_context.device, effect_pipeline);
-	SDL_ReleaseGPUGraphicsPipeline(drawing_context.device, norm_pipeline);
-	SDL_ReleaseGPUGraphicsPipeline(drawing_context.device, simple);
-	SDL_ReleaseGPUSampler(drawing_context.device, effect_sampler);
-	SDL_ReleaseGPUSampler(drawing_context.device, sampler);
-	SDL_ReleaseGPUTexture(drawing_context.device, scene_normtexture);
-	SDL_ReleaseGPUTexture(drawing_context.device, scene_colortexture);
-	SDL_ReleaseGPUTexture(drawing_context.device, depth_texture);
+	FrameData_Destroy(drawing_context.device, &framedata);
+	Clusters_Destroy(&clusters);
+	Scene_Destroy(&lights_scene);
+	Particles_Destroy(&particles);
+	particles_ready = false;
+	clusters_ready = false;
+	RenderGraph_Destroy(&graph);
+	if(bench.running)
+	{
+		bench_stop();
+	}
+	SCR_ShowStats(NULL);
 	return;
 }
@@ -18,10 +18,19 @@
 #include <assets.h>
 #include <shader.h>
 #include <screens.h>
+#include <rendergraph.h>
+#include <texturepool.h>
 
-static SDL_GPUGraphicsPipeline *simple;
+static ScreenDepthPipelines pipelines;
+//one set per mesh of test_model, drawn in material order
+static ScreenDepthPipelines *mesh_pipelines;
+static MaterialDraw *mesh_order;
+//-1 draws with the materials' culling, otherwise forced (C key)
+static int cull_override;
+static bool overdraw_view;
 static SDL_GPUSampler *sampler;
-static SDL_GPUTexture *depth_texture;
+static RenderGraph graph;
+static PostChain upscale;
 static Model *test_model;
 static Matrix4x4 test_model_transform;
 
@@ -34,6 +43,43 @@ static float mouse_x, mouse_y;
 static bool first_mouse;
 static Camera cam_1;
 
+//screen pipelines for the pass roles, then each mesh's material on top
+static bool select_pipelines(ScreenDepthMode mode)
+{
+	ScreenDepthPipelines screen;
+	if(!SCR_GetDepthPipelines(SCR_PIPELINE_FIFTHGEN, mode, &screen))
+	{
+		return false;
+	}
+	size_t count = test_model->meshes.count;
+	if(mesh_pipelines == NULL)
+	{
+		mesh_pipelines = (ScreenDepthPipelines*)SDL_malloc(sizeof(ScreenDepthPipelines) * (count + 1));
+		mesh_order = (MaterialDraw*)SDL_malloc(sizeof(MaterialDraw) * (count + 1));
+		if(mesh_pipelines == NULL || mesh_order == NULL)
+		{
+			return false;
+		}
+	}
+	for(size_t i = 0; i < count; i++)
+	{
+		Material material = test_model->meshes.meshes[i].material;
+		if(cull_override >= 0)
+		{
+			material.cull_mode = (SDL_GPUCullMode)cull_override;
+		}
+		if(!SCR_GetMaterialPipelines(SCR_PIPELINE_FIFTHGEN, mode, &material, &mesh_pipelines[i]))
+		{
+			mesh_pipelines[i] = screen;
+		}
+		//one object, so only the state part of the key matters
+		mesh_order[i] = (MaterialDraw){ Material_SortKey(&material, 0.0f), (Uint32)i };
+	}
+	Material_SortDraws(mesh_order, (Uint32)count);
+	pipelines = screen;
+	return true;
+}
+
 bool TestScreen2_Setup()
 {
 	SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Starting retro test screen...");
@@ -49,48 +95,29 @@ bool TestScreen2_Setup()
 	//need to bring lookat, or a camera update thing
 	InitCameraBasic(&cam_1, (Vector3){0.0f, 1.3f, 8.0f}, (float)width / (float)height);
 
-	SDL_GPUShader *vsimpleshader = LoadShader("shaders/fifthgen/fifthgen.vert.spv", drawing_context.device, SDL_GPU_SHADERSTAGE_VERTEX, 0, 1, 0, 0);
-	if(vsimpleshader == NULL)
-	{
-		SDL_Log("Failed to load simple vertex shader.");
-		return NULL;
-	}
-	SDL_GPUShader *fsimpleshader = LoadShader("shaders/fifthgen/fifthgen.frag.spv", drawing_context.device, SDL_GPU_SHADERSTAGE_FRAGMENT, 1, 0, 0, 0);
-	if(fsimpleshader == NULL)
-	{
-		SDL_Log("Failed to load simple fragment shader.");
-		return NULL;
-	}
-	simple = SCR_CreateSimplePipeline(vsimpleshader, fsimpleshader, true);
+	overdraw_view = false;
+	cull_override = -1;
+	mesh_pipelines = NULL;
+	mesh_order = NULL;
 
 	test_model = (Model*)SDL_malloc(sizeof(Model));
 	if(test_model != NULL)
 	{
 		ImportIQM(drawing_context.device, test_model, "testmodels/tower/tower.iqm");
 	}
+	if(test_model == NULL || !select_pipelines(SCR_DEPTH_DIRECT))
+	{
+		return false;
+	}
 
-	SDL_GPUSamplerCreateInfo samplercreateinfo = { 0 };
-	samplercreateinfo.min_filter = SDL_GPU_FILTER_NEAREST;
-	samplercreateinfo.mag_filter = SDL_GPU_FILTER_NEAREST;
-	samplercreateinfo.mipmap_mode = SDL_GPU_SAMPLERMIPMAPMODE_LINEAR;
-	samplercreateinfo.address_mode_u = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE;
-	samplercreateinfo.address_mode_v = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE;
-	samplercreateinfo.address_mode_w = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE;
-	sampler = SDL_CreateGPUSampler(drawing_context.device, &samplercreateinfo);
-
-	depth_texture = SDL_CreateGPUTexture(
-		drawing_context.device,
-		&(SDL_GPUTextureCreateInfo) {
-			.type = SDL_GPU_TEXTURETYPE_2D,
-			.width = width,
-			.height = height,
-			.layer_count_or_depth = 1,
-			.num_levels = 1,
-			.sample_count = SDL_GPU_SAMPLECOUNT_1,
-			.format = SDL_GPU_TEXTUREFORMAT_D16_UNORM,
-			.usage = SDL_GPU_TEXTUREUSAGE_SAMPLER | SDL_GPU_TEXTUREUSAGE_DEPTH_STENCIL_TARGET
-		}
-	);
+	sampler = SCR_GetSampler(SDL_GPU_FILTER_NEAREST, SDL_GPU_SAMPLERMIPMAPMODE_LINEAR,
+								SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE);
+
+	//targets come from the render graph every frame
+	if(!RenderGraph_Init(drawing_context.device, &graph) || !SCR_FifthgenInit(&upscale))
+	{
+		return false;
+	}
 
 	return true;
 }
@@ -123,6 +150,28 @@ void TestScreen2_Input(SDL_Event event)
 			newpos.z = newpos.z - aux.z;
 			UpdateCameraPosition(&cam_1, newpos);
 		}
+		if(event.key.key == SDLK_P)
+		{
+			//keeps the current mode on failure
+			select_pipelines((pipelines.mode + 1) % SCR_DEPTH_COUNT);
+			SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Depth: %s.", SCR_GetDepthModeName(pipelines.mode));
+		}
+		if(event.key.key == SDLK_C)
+		{
+			//material, none, front: front culling shows the inside, a quick
+			//check that the winding is right
+			static const int overrides[] = { -1, SDL_GPU_CULLMODE_NONE, SDL_GPU_CULLMODE_FRONT };
+			static const char *names[] = { "material", "none", "front" };
+			static int current = 0;
+			current = (current + 1) % SDL_arraysize(overrides);
+			cull_override = overrides[current];
+			select_pipelines(pipelines.mode);
+			SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Culling: %s.", names[current]);
+		}
+		if(event.key.key == SDLK_V)
+		{
+			overdraw_view = !overdraw_view;
+		}
 		if(event.key.key == SDLK_ESCAPE)
 		{
 			SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "leaving...");
@@ -156,6 +205,50 @@ void TestScreen2_Iterate()
 	test_model_transform = Matrix4x4_Translate(test_model_transform, 0.0f, 0.0f, -8.0f);
 }
 
+//SIMPLE RENDER PASS
+static void fifthgen_pass(RenderGraph *rg, SDL_GPUCommandBuffer *cmdbuf,
+							SDL_GPURenderPass *renderpass_simple, void *userdata)
+{
+	Matrix4x4 viewproj;
+	viewproj = Matrix4x4_Mul(cam_1.view, cam_1.projection);
+	//Matrix4x4 mvp = Matrix4x4_Mul(car->transform, viewproj);
+	Matrix4x4 mvp = Matrix4x4_Mul(test_model_transform, viewproj);
+	//pre-pass and overdraw pipelines have no textures
+	SDL_GPUGraphicsPipeline *given = (SDL_GPUGraphicsPipeline*)userdata;
+	bool textured = given == pipelines.main;
+	SDL_GPUGraphicsPipeline *bound = NULL;
+	for(size_t i = 0; i < test_model->meshes.count; i++)
+	{
+		Uint32 index = mesh_order[i].index;
+		Mesh *mesh = &test_model->meshes.meshes[index];
+		SDL_GPUGraphicsPipeline *pipeline = SCR_PickDepthPipeline(&pipelines, &mesh_pipelines[index], given);
+		if(pipeline == NULL)
+		{
+			continue;
+		}
+		//binding graphics pipeline, sorted so equal ones come together
+		if(pipeline != bound)
+		{
+			SDL_BindGPUGraphicsPipeline(renderpass_simple, pipeline);
+			bound = pipeline;
+		}
+
+		//binding vertex and index buffers
+		SDL_BindGPUVertexBuffers(renderpass_simple, 0, &(SDL_GPUBufferBinding){ mesh->vbuffer, 0 }, 1);
+		SDL_BindGPUIndexBuffer(renderpass_simple, &(SDL_GPUBufferBinding){ mesh->ibuffer, 0 }, SDL_GPU_INDEXELEMENTSIZE_32BIT);
+
+		if(textured)
+		{
+			SDL_BindGPUFragmentSamplers(renderpass_simple, 0, &(SDL_GPUTextureSamplerBinding){ mesh->diffuse.texture, sampler }, 1);
+		}
+
+		//UBO
+		SDL_PushGPUVertexUniformData(cmdbuf, 0, &mvp, sizeof(mvp));
+
+		SDL_DrawGPUIndexedPrimitives(renderpass_simple, mesh->iarray.count, 1, 0, 0, 0);
+	}
+}
+
 void TestScreen2_Draw()
 {
 	SDL_GPUCommandBuffer* cmdbuf = SDL_AcquireGPUCommandBuffer(drawing_context.device);
@@ -166,7 +259,8 @@ void TestScreen2_Draw()
 	}
 
 	SDL_GPUTexture* swapchain_texture;
-	if (!SDL_WaitAndAcquireGPUSwapchainTexture(cmdbuf, drawing_context.window, &swapchain_texture, NULL, NULL))
+	Uint32 swapchain_w, swapchain_h;
+	if (!SDL_WaitAndAcquireGPUSwapchainTexture(cmdbuf, drawing_context.window, &swapchain_texture, &swapchain_w, &swapchain_h))
 	{
 		return ;
 	}
@@ -176,47 +270,18 @@ void TestScreen2_Draw()
 		return;
 	}
 
-	SDL_GPUDepthStencilTargetInfo depthstenciltargetinfo = { 0 };
-	depthstenciltargetinfo.texture = depth_texture;
-	depthstenciltargetinfo.cycle = true;
-	depthstenciltargetinfo.clear_depth = 1;
-	depthstenciltargetinfo.clear_stencil = 0;
-	depthstenciltargetinfo.load_op = SDL_GPU_LOADOP_CLEAR;
-	depthstenciltargetinfo.store_op = SDL_GPU_STOREOP_STORE;
-	depthstenciltargetinfo.stencil_load_op = SDL_GPU_LOADOP_CLEAR;
-	depthstenciltargetinfo.stencil_store_op = SDL_GPU_STOREOP_STORE;
-
-	//SIMPLE RENDER PASS
-	SDL_GPUColorTargetInfo colorTargetInfo = { 0 };
-	colorTargetInfo.texture = swapchain_texture;
-	colorTargetInfo.clear_color = (SDL_FColor){ 0.0f, 0.0f, 0.0f, 1.0f };
-	colorTargetInfo.load_op = SDL_GPU_LOADOP_CLEAR;
-	colorTargetInfo.store_op = SDL_GPU_STOREOP_STORE;
-	SDL_GPURenderPass *renderpass_simple = SDL_BeginGPURenderPass(cmdbuf, &colorTargetInfo, 1, &depthstenciltargetinfo);
-	Matrix4x4 viewproj;
-	viewproj = Matrix4x4_Mul(cam_1.view, cam_1.projection);
-	//Matrix4x4 mvp = Matrix4x4_Mul(car->transform, viewproj);
-	Matrix4x4 mvp = Matrix4x4_Mul(test_model_transform, viewproj);
-	for(size_t i = 0; i < test_model->meshes.count; i++)
-	{
-		Mesh *mesh = &test_model->meshes.meshes[i];
-		//binding graphics pipeline
-		SDL_BindGPUGraphicsPipeline(renderpass_simple, simple);
-
-		//binding vertex and index buffers
-		SDL_BindGPUVertexBuffers(renderpass_simple, 0, &(SDL_GPUBufferBinding){ mesh->vbuffer, 0 }, 1);
-		SDL_BindGPUIndexBuffer(renderpass_simple, &(SDL_GPUBufferBinding){ mesh->ibuffer, 0 }, SDL_GPU_INDEXELEMENTSIZE_32BIT);
-
-		SDL_BindGPUFragmentSamplers(renderpass_simple, 0, &(SDL_GPUTextureSamplerBinding){ mesh->diffuse.texture, sampler }, 1);
-
-		//UBO
-		SDL_PushGPUVertexUniformData(cmdbuf, 0, &mvp, sizeof(mvp));
-
-		SDL_DrawGPUIndexedPrimitives(renderpass_simple, mesh->iarray.count, 1, 0, 0, 0);
-	}
-	SDL_EndGPURenderPass(renderpass_simple);
+	//depth is transient: cleared, used and dropped without a store
+	//the scene is drawn at the fifth-gen resolution and blown up after
+	FifthgenTargets targets;
+	RenderGraph_Begin(&graph);
+	RGTexture backbuffer = RenderGraph_ImportTexture(&graph, "swapchain", swapchain_texture, swapchain_w, swapchain_h);
+	SCR_FifthgenBegin(&graph, swapchain_w, swapchain_h, overdraw_view, &targets);
+	SCR_FifthgenAddPasses(&graph, &targets, &pipelines, fifthgen_pass, &(SDL_FColor){ 0.0f, 0.0f, 0.0f, 1.0f });
+	SCR_FifthgenPresent(&graph, &upscale, &targets, backbuffer, swapchain_w, swapchain_h);
+	RenderGraph_Execute(&graph, cmdbuf);
+	SCR_CaptureFrame(cmdbuf, swapchain_texture, swapchain_w, swapchain_h);
 
-	SDL_SubmitGPUCommandBuffer(cmdbuf);
+	TexturePool_Submit(cmdbuf);
 	return;
 }
 
@@ -224,8 +289,10 @@ void TestScreen2_Destroy()
 {
 	SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Finishing test screen 2...");
 	ReleaseModel(drawing_context.device, test_model);
-	SDL_ReleaseGPUGraphicsPipeline(drawing_context.device, simple);
-	SDL_ReleaseGPUSampler(drawing_context.device, sampler);
-	SDL_ReleaseGPUTexture(drawing_context.device, depth_texture);
+	RenderGraph_Destroy(&graph);
+	SDL_free(mesh_pipelines);
+	SDL_free(mesh_order);
+	mesh_pipelines = NULL;
+	mesh_order = NULL;
 	return;
 }
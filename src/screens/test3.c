@@ -21,19 +21,87 @@
 #include <screens.h>
 #include <shader.h>
 #include <list.h>
+#include <culling.h>
+#include <rendergraph.h>
+#include <hiz.h>
+#include <gpuscene.h>
+#include <texarray.h>
+#include <staticbatch.h>
+#include <scene.h>
+#include <shadowcache.h>
+#include <debugdraw.h>
 
 typedef struct test3render
 {
-	SDL_GPUGraphicsPipeline *pipeline;
+	ScreenDepthPipelines pipelines;
+	//per mesh, from each mesh's material
+	ScreenDepthPipelines *tower_pipelines;
+	ScreenDepthPipelines *box_pipelines;
+	Uint32 pipeline_binds;
+	Uint32 draw_calls;
+	bool overdraw_view;
 	SDL_GPUSampler *sampler;
-	SDL_GPUTexture *depth_texture;
+	RenderGraph graph;
+	PostChain upscale;
+	HiZ hiz;
+	bool hiz_available;
+	bool occlusion;
+	//same objects, culled and drawn from the GPU
+	GPUScene gpuscene;
+	ScreenDepthPipelines gpuscene_pipelines;
+	SDL_GPUGraphicsPipeline *gpuscene_array_pipeline;
+	TextureArrays texarrays;
+	bool gpuscene_available;
+	bool gpu_driven;
+	int tower_model, box_model;
+	Uint32 box_object;
+	Uint32 props;
+	//level geometry that never moves, merged at setup
+	StaticBatch statics;
+	Object *static_objects;
+	Uint32 num_static;
+	Uint32 *static_visible;
+	bool static_batching;
+	//indoor rooms behind the tower, culled through their doorways
+	Scene level;
+	Object *level_objects;
+	Uint32 num_level;
+	Object **level_visible;
+	bool portals;
+	//sun shadows over the whole area, static casters cached per tile
+	ShadowCache shadows;
+	bool shadows_available;
+	SDL_GPUGraphicsPipeline *shadow_view_pipeline;
+	bool shadow_view;
+	float sun_angle;
+	bool sun_moving;
+	Uint32 tower_object;
+	bool tower_moved;
+	//culling boxes, rooms, portals and shadow tiles as lines
+	bool debug_lines;
 } test3render;
 
+typedef struct test3drawitem
+{
+	Object *object;
+	const Mesh *mesh;
+	ScreenDepthPipelines *pipelines;
+	const StaticRange *range; //instead of object and mesh when batched
+} test3drawitem;
+
 static test3render renderstuff;
 
 static Object tower;
 static Object box;
 
+//one entry per mesh of every object, rebuilt each frame
+static CullingBounds cullbounds;
+static test3drawitem *drawitems;
+static Uint32 *visible;
+static MaterialDraw *draworder;
+static size_t drawitems_capacity;
+static size_t visible_count;
+
 static float deltatime;
 static float lastframe;
 
@@ -44,6 +112,242 @@ static Camera cam_1;
 
 static bool collision;
 
+//props spawned with N, only in the GPU scene
+#define TEST3_PROP_ROW 32
+#define TEST3_PROP_SPACING 6.0f
+
+//static field to the side of the tower, a tower every few boxes so
+//there's more than one material
+#define TEST3_STATIC_ROW 32
+#define TEST3_STATIC_SPACING 8.0f
+#define TEST3_STATIC_TOWER_EVERY 16
+
+//a grid of rooms with a doorway to each neighbour, walls and props
+//are boxes scaled to size
+#define TEST3_ROOMS 3
+#define TEST3_ROOM_SIZE 24.0f
+#define TEST3_ROOM_HEIGHT 6.0f
+#define TEST3_ROOM_PROPS 3
+#define TEST3_WALL 0.5f
+#define TEST3_DOOR_WIDTH 4.0f
+#define TEST3_DOOR_HEIGHT 4.0f
+#define TEST3_LEVEL_X -180.0f
+#define TEST3_LEVEL_Z -36.0f
+#define TEST3_PVS_FILE "test3.pvs"
+
+//the sun's shadow is a grid of square tiles covering the static field
+//and the rooms, one atlas tile each
+#define TEST3_SHADOW_TILES_X 4
+#define TEST3_SHADOW_TILES_Z 2
+#define TEST3_SHADOW_TILE_WORLD 128.0f
+#define TEST3_SHADOW_ORIGIN_X -192.0f
+#define TEST3_SHADOW_ORIGIN_Z -128.0f
+#define TEST3_SHADOW_DEPTH 400.0f
+//radians per millisecond while Y keeps the sun moving
+#define TEST3_SUN_SPEED 0.0005f
+//T moves the tower by this much along x and back
+#define TEST3_TOWER_MOVE -8.0f
+
+//camera far plane, scales view depth for the sort keys
+#define TEST3_SORT_FAR 5000.0f
+
+//one set per mesh, meshes whose material pipelines fail use the
+//screen's ones
+static ScreenDepthPipelines *material_pipelines(Model *model, ScreenDepthMode mode, ScreenDepthPipelines *pipelines)
+{
+	if(model == NULL)
+	{
+		return pipelines;
+	}
+	if(pipelines == NULL)
+	{
+		pipelines = (ScreenDepthPipelines*)SDL_malloc(sizeof(ScreenDepthPipelines) * (model->meshes.count + 1));
+		if(pipelines == NULL)
+		{
+			return NULL;
+		}
+	}
+	for(size_t i = 0; i < model->meshes.count; i++)
+	{
+		if(!SCR_GetMaterialPipelines(SCR_PIPELINE_FIFTHGEN, mode, &model->meshes.meshes[i].material, &pipelines[i]))
+		{
+			pipelines[i] = renderstuff.pipelines;
+		}
+	}
+	return pipelines;
+}
+
+//box model stretched over min..max, added to the level
+static void add_level_box(Vector3 min, Vector3 max)
+{
+	Object *object = &renderstuff.level_objects[renderstuff.num_level++];
+	AABB bounds = box.renderable->bounds;
+	Vector3 scale = {
+		(max.x - min.x) * 0.5f / bounds.half_size.x,
+		(max.y - min.y) * 0.5f / bounds.half_size.y,
+		(max.z - min.z) * 0.5f / bounds.half_size.z
+	};
+	*object = (Object){ .renderable = box.renderable };
+	object->transform = Matrix4x4_Scale(Matrix4x4_Identity(), scale);
+	object->transform = Matrix4x4_Translate(object->transform,
+											(min.x + max.x) * 0.5f - bounds.center.x * scale.x,
+											(min.y + max.y) * 0.5f - bounds.center.y * scale.y,
+											(min.z + max.z) * 0.5f - bounds.center.z * scale.z);
+	Scene_AddObject(&renderstuff.level, object);
+}
+
+//one side of a room from a to b along x (or z when along_z), at
+//offset on the other axis, split around the door if there is one
+static void add_wall(float a, float b, float offset, bool along_z, bool door)
+{
+	float spans[3][3] = { { a, b, 0.0f } };
+	int count = 1;
+	if(door)
+	{
+		float mid = (a + b) * 0.5f;
+		float half = TEST3_DOOR_WIDTH * 0.5f;
+		spans[0][1] = mid - half;
+		spans[1][0] = mid + half; spans[1][1] = b;
+		//lintel over the doorway
+		spans[2][0] = mid - half; spans[2][1] = mid + half; spans[2][2] = TEST3_DOOR_HEIGHT;
+		count = 3;
+	}
+	for(int i = 0; i < count; i++)
+	{
+		Vector3 min = { spans[i][0], spans[i][2], offset };
+		Vector3 max = { spans[i][1], TEST3_ROOM_HEIGHT, offset + TEST3_WALL };
+		if(along_z)
+		{
+			min = (Vector3){ offset, spans[i][2], spans[i][0] };
+			max = (Vector3){ offset + TEST3_WALL, TEST3_ROOM_HEIGHT, spans[i][1] };
+		}
+		add_level_box(min, max);
+	}
+}
+
+static bool build_level()
+{
+	Scene_Init(&renderstuff.level);
+	renderstuff.num_level = 0;
+	if(box.renderable == NULL)
+	{
+		return false;
+	}
+	//at most three wall pieces per side
+	Uint32 max_objects = TEST3_ROOMS * TEST3_ROOMS * (12 + TEST3_ROOM_PROPS);
+	renderstuff.level_objects = (Object*)SDL_calloc(max_objects, sizeof(Object));
+	renderstuff.level_visible = (Object**)SDL_malloc(sizeof(Object*) * max_objects);
+	if(renderstuff.level_objects == NULL || renderstuff.level_visible == NULL)
+	{
+		return false;
+	}
+
+	//cells, then the doorways between them, then what's inside
+	const float size = TEST3_ROOM_SIZE;
+	for(int i = 0; i < TEST3_ROOMS * TEST3_ROOMS; i++)
+	{
+		float x = TEST3_LEVEL_X + size * (float)(i % TEST3_ROOMS);
+		float z = TEST3_LEVEL_Z + size * (float)(i / TEST3_ROOMS);
+		Scene_AddCell(&renderstuff.level, (AABB){
+			{ x + size * 0.5f, TEST3_ROOM_HEIGHT * 0.5f, z + size * 0.5f },
+			{ size * 0.5f, TEST3_ROOM_HEIGHT * 0.5f, size * 0.5f }
+		});
+	}
+	for(int i = 0; i < TEST3_ROOMS * TEST3_ROOMS; i++)
+	{
+		int column = i % TEST3_ROOMS, row = i / TEST3_ROOMS;
+		float x = TEST3_LEVEL_X + size * (float)column;
+		float z = TEST3_LEVEL_Z + size * (float)row;
+		float half = TEST3_DOOR_WIDTH * 0.5f;
+		if(column + 1 < TEST3_ROOMS)
+		{
+			float mid = z + size * 0.5f;
+			Scene_AddPortal(&renderstuff.level, i, i + 1, (Vector3[]){
+				{ x + size, 0.0f, mid - half }, { x + size, 0.0f, mid + half },
+				{ x + size, TEST3_DOOR_HEIGHT, mid + half }, { x + size, TEST3_DOOR_HEIGHT, mid - half }
+			}, 4);
+		}
+		if(row + 1 < TEST3_ROOMS)
+		{
+			float mid = x + size * 0.5f;
+			Scene_AddPortal(&renderstuff.level, i, i + TEST3_ROOMS, (Vector3[]){
+				{ mid - half, 0.0f, z + size }, { mid + half, 0.0f, z + size },
+				{ mid + half, TEST3_DOOR_HEIGHT, z + size }, { mid - half, TEST3_DOOR_HEIGHT, z + size }
+			}, 4);
+		}
+
+		//each room owns the walls on its side of the boundary, so they
+		//land in its cell
+		add_wall(x, x + size, z, false, row > 0);
+		add_wall(x, x + size, z + size - TEST3_WALL, false, row + 1 < TEST3_ROOMS);
+		add_wall(z, z + size, x, true, column > 0);
+		add_wall(z, z + size, x + size - TEST3_WALL, true, column + 1 < TEST3_ROOMS);
+		for(int p = 0; p < TEST3_ROOM_PROPS; p++)
+		{
+			float px = x + size * (0.25f + 0.25f * (float)p);
+			float pz = z + size * (0.3f + 0.2f * (float)((p + i) % TEST3_ROOM_PROPS));
+			add_level_box((Vector3){ px - 1.0f, 0.0f, pz - 1.0f }, (Vector3){ px + 1.0f, 2.0f, pz + 1.0f });
+		}
+	}
+
+	//the visible set is worked out once and kept next to the user data
+	if(!Scene_LoadPVS(&renderstuff.level, TEST3_PVS_FILE) && Scene_BuildPVS(&renderstuff.level))
+	{
+		Scene_SavePVS(&renderstuff.level, TEST3_PVS_FILE);
+	}
+	renderstuff.level.use_pvs = true;
+	return true;
+}
+
+//each tile looks down the sun direction at its own piece of the ground
+static Matrix4x4 sun_tile(float angle, Uint32 tile)
+{
+	Vector3 dir = Vector3_Normalize((Vector3){ 0.5f * SDL_cosf(angle), -1.0f, 0.5f * SDL_sinf(angle) });
+	Vector3 center = {
+		TEST3_SHADOW_ORIGIN_X + TEST3_SHADOW_TILE_WORLD * ((float)(tile % TEST3_SHADOW_TILES_X) + 0.5f),
+		0.0f,
+		TEST3_SHADOW_ORIGIN_Z + TEST3_SHADOW_TILE_WORLD * ((float)(tile / TEST3_SHADOW_TILES_X) + 0.5f)
+	};
+	Vector3 eye = Vector3_Sub(center, Vector3_Scale(dir, TEST3_SHADOW_DEPTH * 0.5f));
+	float half = TEST3_SHADOW_TILE_WORLD * 0.5f;
+	return Matrix4x4_Mul(Matrix4x4_LookAt(eye, center, (Vector3){ 0.0f, 0.0f, -1.0f }),
+							Matrix4x4_Orthographic(-half, half, -half, half, 0.0f, TEST3_SHADOW_DEPTH));
+}
+
+static bool setup_shadows()
+{
+	if(!ShadowCache_Init(drawing_context.device, &renderstuff.shadows, 0, 0))
+	{
+		return false;
+	}
+	for(Uint32 i = 0; i < TEST3_SHADOW_TILES_X * TEST3_SHADOW_TILES_Z; i++)
+	{
+		ShadowCache_AddTile(&renderstuff.shadows, sun_tile(renderstuff.sun_angle, i));
+	}
+	PipelineDesc view_desc = {
+		.vertex_shader = "shaders/post/fullscreen.vert.spv",
+		.fragment_shader = "shaders/shadows/view.frag.spv",
+		.vertex_layout = PIPELINE_VERTEX_NONE,
+		.primitive_type = SDL_GPU_PRIMITIVETYPE_TRIANGLELIST,
+		.num_color_targets = 1,
+		.color_formats = { SDL_GetGPUSwapchainTextureFormat(drawing_context.device, drawing_context.window) },
+		.cull_mode = SDL_GPU_CULLMODE_NONE,
+		.fill_mode = SDL_GPU_FILLMODE_FILL
+	};
+	renderstuff.shadow_view_pipeline = PipelineCache_Get(&view_desc);
+	return true;
+}
+
+//world bounds of every mesh, for shadow tiles the object touches
+static void invalidate_shadows(Object *object)
+{
+	for(size_t m = 0; object->renderable != NULL && m < object->renderable->meshes.count; m++)
+	{
+		ShadowCache_InvalidateBounds(&renderstuff.shadows,
+										Culling_TransformAABB(object->renderable->meshes.meshes[m].bounds, object->transform));
+	}
+}
+
 bool TestScreen3_Setup()
 {
 	SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Starting physics test screen...");
@@ -62,42 +366,22 @@ bool TestScreen3_Setup()
 	InitCameraFull(&cam_1, (Vector3){0.0f, 20.0f, 30.0f}, (Vector3){0.0f, 1.0f, 0.0f},
 					-90.0f, -30.0f, 0.0f, 45.0f, (float)width / (float)height);
 
-	SDL_GPUShader *vsimpleshader = LoadShader("shaders/fifthgen/fifthgen.vert.spv", drawing_context.device, SDL_GPU_SHADERSTAGE_VERTEX, 0, 1, 0, 0);
-	if(vsimpleshader == NULL)
+	if(!SCR_GetDepthPipelines(SCR_PIPELINE_FIFTHGEN, SCR_DEPTH_DIRECT, &renderstuff.pipelines))
 	{
-		SDL_Log("Failed to load simple vertex shader.");
-		return NULL;
+		return false;
 	}
-	SDL_GPUShader *fsimpleshader = LoadShader("shaders/fifthgen/fifthgen.frag.spv", drawing_context.device, SDL_GPU_SHADERSTAGE_FRAGMENT, 1, 0, 0, 0);
-	if(fsimpleshader == NULL)
+	renderstuff.sampler = SCR_GetSampler(SDL_GPU_FILTER_NEAREST, SDL_GPU_SAMPLERMIPMAPMODE_LINEAR,
+											SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE);
+
+	//targets come from the render graph every frame
+	if(!RenderGraph_Init(drawing_context.device, &renderstuff.graph) || !SCR_FifthgenInit(&renderstuff.upscale))
 	{
-		SDL_Log("Failed to load simple fragment shader.");
-		return NULL;
+		return false;
 	}
-	renderstuff.pipeline = SCR_CreateSimplePipeline(vsimpleshader, fsimpleshader, true);
 
-	SDL_GPUSamplerCreateInfo samplercreateinfo = { 0 };
-	samplercreateinfo.min_filter = SDL_GPU_FILTER_NEAREST;
-	samplercreateinfo.mag_filter = SDL_GPU_FILTER_NEAREST;
-	samplercreateinfo.mipmap_mode = SDL_GPU_SAMPLERMIPMAPMODE_LINEAR;
-	samplercreateinfo.address_mode_u = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE;
-	samplercreateinfo.address_mode_v = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE;
-	samplercreateinfo.address_mode_w = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE;
-	renderstuff.sampler = SDL_CreateGPUSampler(drawing_context.device, &samplercreateinfo);
-
-	renderstuff.depth_texture = SDL_CreateGPUTexture(
-		drawing_context.device,
-		&(SDL_GPUTextureCreateInfo) {
-			.type = SDL_GPU_TEXTURETYPE_2D,
-			.width = width,
-			.height = height,
-			.layer_count_or_depth = 1,
-			.num_levels = 1,
-			.sample_count = SDL_GPU_SAMPLECOUNT_1,
-			.format = SDL_GPU_TEXTUREFORMAT_D16_UNORM,
-			.usage = SDL_GPU_TEXTUREUSAGE_SAMPLER | SDL_GPU_TEXTUREUSAGE_DEPTH_STENCIL_TARGET
-		}
-	);
+	//occlusion culling is optional, frustum culling works without it
+	renderstuff.hiz_available = HiZ_Init(drawing_context.device, &renderstuff.hiz);
+	renderstuff.occlusion = renderstuff.hiz_available;
 
 	//load tower
 	tower = (Object){ 0 };
@@ -124,6 +408,75 @@ bool TestScreen3_Setup()
 
 	collision = false;
 
+	renderstuff.tower_pipelines = material_pipelines(tower.renderable, SCR_DEPTH_DIRECT, NULL);
+	renderstuff.box_pipelines = material_pipelines(box.renderable, SCR_DEPTH_DIRECT, NULL);
+	if((tower.renderable != NULL && renderstuff.tower_pipelines == NULL) ||
+		(box.renderable != NULL && renderstuff.box_pipelines == NULL))
+	{
+		return false;
+	}
+
+	//GPU-driven path, direct depth only since the pre-pass pipelines
+	//use the per-draw vertex shader
+	renderstuff.gpuscene_pipelines.mode = SCR_DEPTH_DIRECT;
+	renderstuff.gpuscene_pipelines.main = SCR_GetPipeline(SCR_PIPELINE_GPU_SCENE);
+	renderstuff.gpuscene_available = renderstuff.gpuscene_pipelines.main != NULL &&
+										GPUScene_Init(drawing_context.device, &renderstuff.gpuscene, 1024);
+	TexArray_Init(drawing_context.device, &renderstuff.texarrays);
+	if(renderstuff.gpuscene_available && screen_settings.texture_arrays)
+	{
+		//packed meshes draw with one binding per array instead of one
+		//per texture, the CPU path keeps the separate textures
+		renderstuff.gpuscene_array_pipeline = SCR_GetPipeline(SCR_PIPELINE_GPU_SCENE_ARRAY);
+		if(renderstuff.gpuscene_array_pipeline != NULL)
+		{
+			TexArray_Pack(&renderstuff.texarrays, (Model*[]){ tower.renderable, box.renderable }, 2);
+		}
+	}
+	if(renderstuff.gpuscene_available)
+	{
+		renderstuff.tower_model = GPUScene_AddModel(&renderstuff.gpuscene, tower.renderable);
+		renderstuff.box_model = GPUScene_AddModel(&renderstuff.gpuscene, box.renderable);
+		int object = GPUScene_AddObject(&renderstuff.gpuscene, renderstuff.tower_model, tower.transform);
+		renderstuff.tower_object = (object < 0) ? 0 : (Uint32)object;
+		object = GPUScene_AddObject(&renderstuff.gpuscene, renderstuff.box_model, box.transform);
+		renderstuff.box_object = (object < 0) ? 0 : (Uint32)object;
+	}
+
+	//the same objects either go through the per object path or get
+	//merged, K switches between them to compare
+	renderstuff.num_static = TEST3_STATIC_ROW * TEST3_STATIC_ROW;
+	renderstuff.static_objects = (Object*)SDL_calloc(renderstuff.num_static, sizeof(Object));
+	if(renderstuff.static_objects == NULL || !StaticBatch_Init(drawing_context.device, &renderstuff.statics, 0.0f))
+	{
+		return false;
+	}
+	for(Uint32 i = 0; i < renderstuff.num_static; i++)
+	{
+		float x = 20.0f + TEST3_STATIC_SPACING * (float)(i % TEST3_STATIC_ROW);
+		float z = TEST3_STATIC_SPACING * ((float)(i / TEST3_STATIC_ROW) - TEST3_STATIC_ROW / 2);
+		Object *object = &renderstuff.static_objects[i];
+		object->renderable = (i % TEST3_STATIC_TOWER_EVERY == 0) ? tower.renderable : box.renderable;
+		object->transform = Matrix4x4_Translate(Matrix4x4_Identity(), x, 0.0f, z);
+		StaticBatch_Add(&renderstuff.statics, object->renderable, object->transform);
+	}
+	renderstuff.static_batching = StaticBatch_Build(&renderstuff.statics);
+	if(renderstuff.static_batching)
+	{
+		renderstuff.static_visible = (Uint32*)SDL_malloc(sizeof(Uint32) * renderstuff.statics.num_ranges);
+		renderstuff.static_batching = renderstuff.static_visible != NULL;
+	}
+
+	renderstuff.portals = build_level();
+	renderstuff.shadows_available = setup_shadows();
+
+	Culling_InitBounds(&cullbounds, 64);
+	drawitems_capacity = 0;
+	drawitems = NULL;
+	visible = NULL;
+	draworder = NULL;
+	visible_count = 0;
+
 	return true;
 }
 
@@ -146,6 +499,97 @@ void TestScreen3_Input(SDL_Event event)
 				return;
 			}
 		}
+		if(event.key.key == SDLK_B)
+		{
+			Culling_Benchmark(1000000);
+		}
+		if(event.key.key == SDLK_P)
+		{
+			ScreenDepthMode mode = (renderstuff.pipelines.mode + 1) % SCR_DEPTH_COUNT;
+			if(SCR_GetDepthPipelines(SCR_PIPELINE_FIFTHGEN, mode, &renderstuff.pipelines))
+			{
+				material_pipelines(tower.renderable, mode, renderstuff.tower_pipelines);
+				material_pipelines(box.renderable, mode, renderstuff.box_pipelines);
+			}
+			SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Depth: %s.", SCR_GetDepthModeName(renderstuff.pipelines.mode));
+		}
+		if(event.key.key == SDLK_V)
+		{
+			renderstuff.overdraw_view = !renderstuff.overdraw_view;
+		}
+		if(event.key.key == SDLK_H && renderstuff.hiz_available)
+		{
+			renderstuff.occlusion = !renderstuff.occlusion;
+			SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Hi-Z occlusion %s.", renderstuff.occlusion ? "on" : "off");
+		}
+		if(event.key.key == SDLK_K && renderstuff.static_visible != NULL)
+		{
+			renderstuff.static_batching = !renderstuff.static_batching;
+			SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Static batching %s.", renderstuff.static_batching ? "on" : "off");
+		}
+		if(event.key.key == SDLK_I && renderstuff.level_objects != NULL)
+		{
+			renderstuff.portals = !renderstuff.portals;
+			SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Portal culling %s.", renderstuff.portals ? "on" : "off");
+		}
+		if(event.key.key == SDLK_L && renderstuff.level.pvs != NULL)
+		{
+			renderstuff.level.use_pvs = !renderstuff.level.use_pvs;
+			SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "PVS %s.", renderstuff.level.use_pvs ? "on" : "off");
+		}
+		if(event.key.key == SDLK_J && renderstuff.gpuscene_available)
+		{
+			renderstuff.gpu_driven = !renderstuff.gpu_driven;
+			SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "GPU-driven rendering %s.", renderstuff.gpu_driven ? "on" : "off");
+		}
+		if(event.key.key == SDLK_N && renderstuff.gpuscene_available)
+		{
+			//another row of props behind the tower
+			float z = -TEST3_PROP_SPACING * (float)(1 + renderstuff.props / TEST3_PROP_ROW);
+			for(int i = 0; i < TEST3_PROP_ROW; i++)
+			{
+				float x = TEST3_PROP_SPACING * (float)(i - TEST3_PROP_ROW / 2);
+				int model = (i % 2 == 0) ? renderstuff.box_model : renderstuff.tower_model;
+				if(GPUScene_AddObject(&renderstuff.gpuscene, model, Matrix4x4_Translate(Matrix4x4_Identity(), x, 0.0f, z)) >= 0)
+				{
+					renderstuff.props++;
+				}
+			}
+		}
+		if(event.key.key == SDLK_Y && renderstuff.shadows_available)
+		{
+			//every tile's light changes, so all of them redraw while it moves
+			renderstuff.sun_moving = !renderstuff.sun_moving;
+		}
+		if(event.key.key == SDLK_T)
+		{
+			//static content changing, only the tiles around it redraw
+			if(renderstuff.shadows_available)
+			{
+				invalidate_shadows(&tower);
+			}
+			renderstuff.tower_moved = !renderstuff.tower_moved;
+			tower.transform.da = renderstuff.tower_moved ? TEST3_TOWER_MOVE : 0.0f;
+			tower.aabb.center.x = tower.transform.da;
+			if(renderstuff.shadows_available)
+			{
+				invalidate_shadows(&tower);
+			}
+			if(renderstuff.gpuscene_available)
+			{
+				GPUScene_SetTransform(&renderstuff.gpuscene, renderstuff.tower_object, tower.transform);
+			}
+		}
+#ifdef LEIDEN_DEBUG_DRAW
+		if(event.key.key == SDLK_G)
+		{
+			renderstuff.debug_lines = !renderstuff.debug_lines;
+		}
+#endif
+		if(event.key.key == SDLK_O && renderstuff.shadow_view_pipeline != NULL)
+		{
+			renderstuff.shadow_view = !renderstuff.shadow_view;
+		}
 		if(event.key.key == SDLK_LEFT)
 		{
 			box.transform.da -= 0.5f; //x
@@ -167,6 +611,110 @@ void TestScreen3_Input(SDL_Event event)
 	return;
 }
 
+//grows the per frame lists together
+static bool reserve_items(size_t count)
+{
+	while(count > drawitems_capacity)
+	{
+		size_t new_capacity = (drawitems_capacity == 0) ? 16 : drawitems_capacity * 2;
+		test3drawitem *aux = (test3drawitem*)SDL_realloc(drawitems, sizeof(test3drawitem) * new_capacity);
+		Uint32 *aux_visible = (Uint32*)SDL_realloc(visible, sizeof(Uint32) * new_capacity);
+		MaterialDraw *aux_order = (MaterialDraw*)SDL_realloc(draworder, sizeof(MaterialDraw) * new_capacity);
+		if(aux != NULL)
+		{
+			drawitems = aux;
+		}
+		if(aux_visible != NULL)
+		{
+			visible = aux_visible;
+		}
+		if(aux_order != NULL)
+		{
+			draworder = aux_order;
+		}
+		if(aux == NULL || aux_visible == NULL || aux_order == NULL)
+		{
+			return false;
+		}
+		drawitems_capacity = new_capacity;
+	}
+	return true;
+}
+
+//one draw item and one culling box per mesh
+static void gather_object(Object *object, ScreenDepthPipelines *pipelines, size_t *itemcount)
+{
+	if(object->renderable == NULL)
+	{
+		return;
+	}
+	MeshArray *meshes = &object->renderable->meshes;
+	if(!reserve_items(*itemcount + meshes->count))
+	{
+		return;
+	}
+	for(size_t m = 0; m < meshes->count; m++)
+	{
+		//the item only counts once its box is in, the two stay index for index
+		if(Culling_AddBounds(&cullbounds, Culling_TransformAABB(meshes->meshes[m].bounds, object->transform)) < 0)
+		{
+			return;
+		}
+		drawitems[*itemcount] = (test3drawitem){ object, &meshes->meshes[m], &pipelines[m], NULL };
+		(*itemcount)++;
+	}
+}
+
+//static ranges point back at the first mesh merged into them
+static ScreenDepthPipelines *source_pipelines(const Mesh *mesh)
+{
+	Model *models[] = { tower.renderable, box.renderable };
+	ScreenDepthPipelines *pipelines[] = { renderstuff.tower_pipelines, renderstuff.box_pipelines };
+	for(size_t i = 0; i < SDL_arraysize(models); i++)
+	{
+		if(models[i] != NULL && mesh >= models[i]->meshes.meshes && mesh < models[i]->meshes.meshes + models[i]->meshes.count)
+		{
+			return &pipelines[i][mesh - models[i]->meshes.meshes];
+		}
+	}
+	return &renderstuff.pipelines;
+}
+
+#ifdef LEIDEN_DEBUG_DRAW
+//green boxes were kept by culling, red ones were culled by the frustum
+//or hi-z; only the visible list is walked, it's still in box order
+static void debug_shapes()
+{
+	size_t next = 0;
+	for(size_t i = 0; i < cullbounds.count; i++)
+	{
+		bool kept = next < visible_count && visible[next] == i;
+		next += kept ? 1 : 0;
+		AABB box = {
+			{ cullbounds.center_x[i], cullbounds.center_y[i], cullbounds.center_z[i] },
+			{ cullbounds.extent_x[i], cullbounds.extent_y[i], cullbounds.extent_z[i] }
+		};
+		DebugDraw_AABB(box, kept ? DEBUGDRAW_GREEN : DEBUGDRAW_RED);
+	}
+	Scene *level = &renderstuff.level;
+	for(Uint32 i = 0; i < level->num_cells; i++)
+	{
+		bool seen = !renderstuff.portals || level->cell_visible == NULL || level->cell_visible[i];
+		DebugDraw_AABB(level->cells[i].bounds, seen ? DEBUGDRAW_BLUE : DEBUGDRAW_RGBA(64, 64, 96, 255));
+	}
+	for(Uint32 i = 0; i < level->num_portals; i++)
+	{
+		DebugDraw_Polygon(level->portals[i].vertices, level->portals[i].num_vertices, DEBUGDRAW_YELLOW);
+	}
+	for(Uint32 i = 0; renderstuff.shadows_available && i < renderstuff.shadows.num_tiles; i++)
+	{
+		DebugDraw_Frustum(&renderstuff.shadows.tiles[i].frustum, DEBUGDRAW_RGBA(255, 255, 255, 96));
+	}
+	DebugDraw_AABB(tower.aabb, collision ? DEBUGDRAW_RED : DEBUGDRAW_WHITE);
+	DebugDraw_AABB(box.aabb, collision ? DEBUGDRAW_RED : DEBUGDRAW_WHITE);
+}
+#endif
+
 void TestScreen3_Iterate()
 {
 	float current_frame = (float)SDL_GetTicks();
@@ -175,6 +723,15 @@ void TestScreen3_Iterate()
 
 	box.aabb.center = (Vector3){box.transform.da, box.transform.db, box.transform.dc};
 
+	if(renderstuff.shadows_available && renderstuff.sun_moving)
+	{
+		renderstuff.sun_angle += TEST3_SUN_SPEED * deltatime;
+		for(Uint32 i = 0; i < renderstuff.shadows.num_tiles; i++)
+		{
+			ShadowCache_SetTile(&renderstuff.shadows, i, sun_tile(renderstuff.sun_angle, i));
+		}
+	}
+
 	if(Physics_AABBvsAABB(box.aabb, tower.aabb))
 	{
 		collision = true;
@@ -183,36 +740,248 @@ void TestScreen3_Iterate()
 	{
 		collision = false;
 	}
+
+	if(renderstuff.gpu_driven)
+	{
+		//nothing per object on the CPU besides what moved
+		GPUScene_SetTransform(&renderstuff.gpuscene, renderstuff.box_object, box.transform);
+		GPUSceneStats *stats = &renderstuff.gpuscene.stats;
+		SCR_ShowStats("GPU-driven: objects: %u draws: %u draw calls: %u | shadow tiles redrawn %u/%u",
+						stats->objects, stats->draws, stats->draw_calls,
+						renderstuff.shadows.stats.redrawn, renderstuff.shadows.stats.tiles);
+		return;
+	}
+
+	//gather mesh bounds in world space and cull them against the camera
+	Culling_ResetBounds(&cullbounds);
+	size_t itemcount = 0;
+	gather_object(&tower, renderstuff.tower_pipelines, &itemcount);
+	gather_object(&box, renderstuff.box_pipelines, &itemcount);
+	for(Uint32 i = 0; !renderstuff.static_batching && i < renderstuff.num_static; i++)
+	{
+		Object *object = &renderstuff.static_objects[i];
+		gather_object(object, (object->renderable == tower.renderable) ? renderstuff.tower_pipelines : renderstuff.box_pipelines,
+						&itemcount);
+	}
+	//only the rooms seen through the doorways from the camera's room
+	Uint32 level_count = renderstuff.num_level;
+	if(renderstuff.portals)
+	{
+		Scene_UpdateVisibility(&renderstuff.level, &cam_1);
+		level_count = Scene_GatherObjects(&renderstuff.level, renderstuff.level_visible, renderstuff.num_level);
+	}
+	for(Uint32 i = 0; i < level_count; i++)
+	{
+		Object *object = renderstuff.portals ? renderstuff.level_visible[i] : &renderstuff.level_objects[i];
+		gather_object(object, renderstuff.box_pipelines, &itemcount);
+	}
+	Frustum frustum = Culling_FrustumFromCamera(&cam_1);
+	visible_count = Culling_CullFrustum(&cullbounds, &frustum, visible);
+	size_t in_frustum = visible_count;
+	//then against the depth of a few frames ago
+	if(renderstuff.occlusion)
+	{
+		visible_count = HiZ_CullOcclusion(&renderstuff.hiz, &cullbounds, visible, visible_count,
+											Matrix4x4_Mul(cam_1.view, cam_1.projection));
+	}
+#ifdef LEIDEN_DEBUG_DRAW
+	if(renderstuff.debug_lines)
+	{
+		debug_shapes();
+	}
+#endif
+
+	//merged static geometry is culled per cell, the ranges of visible
+	//cells join the list after the objects
+	Uint32 static_ranges = 0;
+	if(renderstuff.static_batching)
+	{
+		static_ranges = StaticBatch_Cull(&renderstuff.statics, &frustum, renderstuff.static_visible);
+	}
+	if(reserve_items(itemcount + static_ranges))
+	{
+		for(Uint32 i = 0; i < static_ranges; i++)
+		{
+			const StaticRange *range = &renderstuff.statics.ranges[renderstuff.static_visible[i]];
+			drawitems[itemcount + i] = (test3drawitem){ NULL, range->source, source_pipelines(range->source), range };
+			visible[visible_count++] = (Uint32)(itemcount + i);
+		}
+	}
+
+	//material order: fewer pipeline and texture changes, opaque front to
+	//back so early depth rejects more, blended back to front after them
+	for(size_t i = 0; i < visible_count; i++)
+	{
+		Uint32 index = visible[i];
+		Vector3 center;
+		if(drawitems[index].range != NULL)
+		{
+			center = drawitems[index].range->bounds.center;
+		}
+		else
+		{
+			center = (Vector3){ cullbounds.center_x[index], cullbounds.center_y[index], cullbounds.center_z[index] };
+		}
+		float depth = Vector3_Dot(Vector3_Sub(center, cam_1.position), cam_1.front);
+		draworder[i] = (MaterialDraw){ Material_SortKey(&drawitems[index].mesh->material, depth / TEST3_SORT_FAR), index };
+	}
+	Material_SortDraws(draworder, (Uint32)visible_count);
+	for(size_t i = 0; i < visible_count; i++)
+	{
+		visible[i] = draworder[i].index;
+	}
+
+	//draws and binds are from the last frame drawn
+	SceneStats *rooms = &renderstuff.level.stats;
+	SCR_ShowStats("visible: %zu frustum culled: %zu (%s) occluded: %zu%s | draws: %u binds: %u | static %s | rooms %u/%u%s | shadow tiles redrawn %u/%u | depth %s%s",
+					visible_count, cullbounds.count - in_frustum, Culling_GetPathName(), in_frustum - visible_count,
+					(renderstuff.occlusion && !renderstuff.hiz.stats.active) ? " (waiting for hi-z)" : "",
+					renderstuff.draw_calls, renderstuff.pipeline_binds,
+					renderstuff.static_batching ? "batched" : "per object",
+					renderstuff.portals ? rooms->visible_cells : renderstuff.level.num_cells, renderstuff.level.num_cells,
+					(renderstuff.portals && rooms->pvs) ? " (pvs)" : "",
+					renderstuff.shadows.stats.redrawn, renderstuff.shadows.stats.tiles,
+					SCR_GetDepthModeName(renderstuff.pipelines.mode), renderstuff.overdraw_view ? ", overdraw view" : "");
 }
 
-static void drawobject(Object *object, SDL_GPURenderPass *renderpass, SDL_GPUCommandBuffer *cmdbuf, SDL_GPUGraphicsPipeline *pipeline)
+static void drawitem(test3drawitem *item, SDL_GPURenderPass *renderpass, SDL_GPUCommandBuffer *cmdbuf,
+						SDL_GPUGraphicsPipeline *given, SDL_GPUGraphicsPipeline **bound)
 {
+	//NULL for the pre-pass of meshes that don't write depth
+	SDL_GPUGraphicsPipeline *pipeline = SCR_PickDepthPipeline(&renderstuff.pipelines, item->pipelines, given);
+	if(pipeline == NULL)
+	{
+		return;
+	}
+
 	Matrix4x4 viewproj;
 	viewproj = Matrix4x4_Mul(cam_1.view, cam_1.projection);
 
-	Matrix4x4 model = Matrix4x4_Identity();
-	//model = Matrix4x4_Scale(model, (Vector3){object->scale, object->scale, object->scale});
-	//model = Matrix4x4_Translate(model, object->position.x, object->position.y, object->position.z);
-	model = object->transform;
+	//static ranges are already in world space
+	Matrix4x4 mvp = (item->range != NULL) ? viewproj : Matrix4x4_Mul(item->object->transform, viewproj);
+	const Mesh *mesh = item->mesh;
 
-	Matrix4x4 mvp = Matrix4x4_Mul(model, viewproj);
-	for(size_t i = 0; i < object->renderable->meshes.count; i++)
+	//binding graphics pipeline, the draws are sorted by it
+	if(pipeline != *bound)
 	{
-		Mesh *mesh = &object->renderable->meshes.meshes[i];
-		//binding graphics pipeline
 		SDL_BindGPUGraphicsPipeline(renderpass, pipeline);
+		renderstuff.pipeline_binds++;
+		*bound = pipeline;
+	}
 
-		//binding vertex and index buffers
+	//binding vertex and index buffers
+	if(item->range != NULL)
+	{
+		StaticBatch_Bind(&renderstuff.statics, renderpass);
+	}
+	else
+	{
 		SDL_BindGPUVertexBuffers(renderpass, 0, &(SDL_GPUBufferBinding){ mesh->vbuffer, 0 }, 1);
 		SDL_BindGPUIndexBuffer(renderpass, &(SDL_GPUBufferBinding){ mesh->ibuffer, 0 }, SDL_GPU_INDEXELEMENTSIZE_32BIT);
+	}
 
+	if(given == renderstuff.pipelines.main)
+	{
 		SDL_BindGPUFragmentSamplers(renderpass, 0, &(SDL_GPUTextureSamplerBinding){ mesh->diffuse.texture, renderstuff.sampler }, 1);
+	}
 
-		//UBO
-		SDL_PushGPUVertexUniformData(cmdbuf, 0, &mvp, sizeof(mvp));
+	//UBO
+	SDL_PushGPUVertexUniformData(cmdbuf, 0, &mvp, sizeof(mvp));
 
+	if(item->range != NULL)
+	{
+		SDL_DrawGPUIndexedPrimitives(renderpass, item->range->index_count, 1, item->range->first_index, 0, 0);
+	}
+	else
+	{
 		SDL_DrawGPUIndexedPrimitives(renderpass, mesh->iarray.count, 1, 0, 0, 0);
 	}
+	renderstuff.draw_calls++;
+}
+
+static void fifthgen_pass(RenderGraph *graph, SDL_GPUCommandBuffer *cmdbuf,
+							SDL_GPURenderPass *renderpass, void *userdata)
+{
+	//only what survived culling on iterate, the pipeline depends on the
+	//depth mode and the pass (see SCR_FifthgenAddPasses)
+	SDL_GPUGraphicsPipeline *bound = NULL;
+	for(size_t i = 0; i < visible_count; i++)
+	{
+		drawitem(&drawitems[visible[i]], renderpass, cmdbuf, (SDL_GPUGraphicsPipeline*)userdata, &bound);
+	}
+}
+
+static void gpuscene_pass(RenderGraph *graph, SDL_GPUCommandBuffer *cmdbuf,
+							SDL_GPURenderPass *renderpass, void *userdata)
+{
+	GPUScene_Draw(&renderstuff.gpuscene, renderpass, cmdbuf, (SDL_GPUGraphicsPipeline*)userdata,
+					renderstuff.gpuscene_array_pipeline, renderstuff.sampler);
+}
+
+static void draw_caster(SDL_GPURenderPass *renderpass, SDL_GPUCommandBuffer *cmdbuf, const ShadowTile *tile, Object *object)
+{
+	for(size_t m = 0; object->renderable != NULL && m < object->renderable->meshes.count; m++)
+	{
+		Mesh *mesh = &object->renderable->meshes.meshes[m];
+		SDL_BindGPUVertexBuffers(renderpass, 0, &(SDL_GPUBufferBinding){ mesh->vbuffer, 0 }, 1);
+		SDL_BindGPUIndexBuffer(renderpass, &(SDL_GPUBufferBinding){ mesh->ibuffer, 0 }, SDL_GPU_INDEXELEMENTSIZE_32BIT);
+		ShadowCache_PushTransform(cmdbuf, tile, object->transform);
+		SDL_DrawGPUIndexedPrimitives(renderpass, mesh->iarray.count, 1, 0, 0, 0);
+	}
+}
+
+//the tower and the level only change with T, the box moves any time
+static void shadow_casters(SDL_GPURenderPass *renderpass, SDL_GPUCommandBuffer *cmdbuf,
+							const ShadowTile *tile, bool static_casters, void *userdata)
+{
+	if(!static_casters)
+	{
+		draw_caster(renderpass, cmdbuf, tile, &box);
+		return;
+	}
+	draw_caster(renderpass, cmdbuf, tile, &tower);
+	for(Uint32 i = 0; i < renderstuff.num_level; i++)
+	{
+		draw_caster(renderpass, cmdbuf, tile, &renderstuff.level_objects[i]);
+	}
+	if(renderstuff.static_visible != NULL)
+	{
+		//the draw list already holds its ranges, the indices can be reused
+		Uint32 ranges = StaticBatch_Cull(&renderstuff.statics, &tile->frustum, renderstuff.static_visible);
+		StaticBatch_Bind(&renderstuff.statics, renderpass);
+		ShadowCache_PushTransform(cmdbuf, tile, Matrix4x4_Identity());
+		for(Uint32 i = 0; i < ranges; i++)
+		{
+			const StaticRange *range = &renderstuff.statics.ranges[renderstuff.static_visible[i]];
+			SDL_DrawGPUIndexedPrimitives(renderpass, range->index_count, 1, range->first_index, 0, 0);
+		}
+		return;
+	}
+	for(Uint32 i = 0; i < renderstuff.num_static; i++)
+	{
+		draw_caster(renderpass, cmdbuf, tile, &renderstuff.static_objects[i]);
+	}
+}
+
+//the atlas in a corner of the window
+static void shadow_view_pass(RenderGraph *graph, SDL_GPUCommandBuffer *cmdbuf,
+								SDL_GPURenderPass *renderpass, void *userdata)
+{
+	SDL_BindGPUGraphicsPipeline(renderpass, renderstuff.shadow_view_pipeline);
+	SDL_SetGPUViewport(renderpass, &(SDL_GPUViewport){ 0.0f, 0.0f, 256.0f, 256.0f, 0.0f, 1.0f });
+	SDL_BindGPUFragmentSamplers(renderpass, 0, &(SDL_GPUTextureSamplerBinding){
+									renderstuff.shadows.atlas, renderstuff.shadows.sampler }, 1);
+	SDL_DrawGPUPrimitives(renderpass, 3, 1, 0, 0);
+}
+
+//over the upscaled image, not depth tested: the depth target is at the
+//internal resolution
+static void debug_lines_pass(RenderGraph *graph, SDL_GPUCommandBuffer *cmdbuf,
+								SDL_GPURenderPass *renderpass, void *userdata)
+{
+	DebugDraw_Render(renderpass, cmdbuf, Matrix4x4_Mul(cam_1.view, cam_1.projection),
+						SDL_GetGPUSwapchainTextureFormat(drawing_context.device, drawing_context.window),
+						SDL_GPU_TEXTUREFORMAT_INVALID);
 }
 
 void TestScreen3_Draw()
@@ -225,7 +994,8 @@ void TestScreen3_Draw()
 	}
 
 	SDL_GPUTexture* swapchain_texture;
-	if (!SDL_WaitAndAcquireGPUSwapchainTexture(cmdbuf, drawing_context.window, &swapchain_texture, NULL, NULL))
+	Uint32 swapchain_w, swapchain_h;
+	if (!SDL_WaitAndAcquireGPUSwapchainTexture(cmdbuf, drawing_context.window, &swapchain_texture, &swapchain_w, &swapchain_h))
 	{
 		return ;
 	}
@@ -234,16 +1004,8 @@ void TestScreen3_Draw()
 	{
 		return;
 	}
-
-	SDL_GPUDepthStencilTargetInfo depthstenciltargetinfo = { 0 };
-	depthstenciltargetinfo.texture = renderstuff.depth_texture;
-	depthstenciltargetinfo.cycle = true;
-	depthstenciltargetinfo.clear_depth = 1;
-	depthstenciltargetinfo.clear_stencil = 0;
-	depthstenciltargetinfo.load_op = SDL_GPU_LOADOP_CLEAR;
-	depthstenciltargetinfo.store_op = SDL_GPU_STOREOP_STORE;
-	depthstenciltargetinfo.stencil_load_op = SDL_GPU_LOADOP_CLEAR;
-	depthstenciltargetinfo.stencil_store_op = SDL_GPU_STOREOP_STORE;
+	renderstuff.pipeline_binds = 0;
+	renderstuff.draw_calls = 0;
 
 	SDL_FColor clearcolor;
 	if(collision)
@@ -251,28 +1013,92 @@ void TestScreen3_Draw()
 	else
 		clearcolor = (SDL_FColor){ 0.0f, 0.0f, 0.0f, 1.0f };
 
-	SDL_GPUColorTargetInfo colorTargetInfo = { 0 };
-	colorTargetInfo.texture = swapchain_texture;
-	colorTargetInfo.clear_color = clearcolor;
-	colorTargetInfo.load_op = SDL_GPU_LOADOP_CLEAR;
-	colorTargetInfo.store_op = SDL_GPU_STOREOP_STORE;
-	SDL_GPURenderPass *renderpass = SDL_BeginGPURenderPass(cmdbuf, &colorTargetInfo, 1, &depthstenciltargetinfo);
+	bool gpu_driven = renderstuff.gpu_driven;
+	bool occlusion = renderstuff.occlusion && !gpu_driven;
+	if(gpu_driven)
+	{
+		//culling and command writing go before the graph, which would
+		//drop a compute pass that only writes buffers
+		GPUScene_Prepare(&renderstuff.gpuscene, cmdbuf, Matrix4x4_Mul(cam_1.view, cam_1.projection));
+	}
 
-	drawobject(&tower, renderpass, cmdbuf, renderstuff.pipeline);
-	drawobject(&box, renderpass, cmdbuf, renderstuff.pipeline);
+	//nothing samples the atlas through the graph, it's drawn up front
+	if(renderstuff.shadows_available)
+	{
+		ShadowCache_Render(&renderstuff.shadows, cmdbuf, shadow_casters, NULL);
+	}
+	//whatever iterate collected, the pass below draws it
+	DebugDraw_Upload(cmdbuf);
 
-	SDL_EndGPURenderPass(renderpass);
+	FifthgenTargets targets;
+	RenderGraph *graph = &renderstuff.graph;
+	RenderGraph_Begin(graph);
+	RGTexture backbuffer = RenderGraph_ImportTexture(graph, "swapchain", swapchain_texture, swapchain_w, swapchain_h);
+	SCR_FifthgenBegin(graph, swapchain_w, swapchain_h, renderstuff.overdraw_view && !gpu_driven, &targets);
+	if(gpu_driven)
+	{
+		SCR_FifthgenAddPasses(graph, &targets, &renderstuff.gpuscene_pipelines, gpuscene_pass, &clearcolor);
+	}
+	else
+	{
+		SCR_FifthgenAddPasses(graph, &targets, &renderstuff.pipelines, fifthgen_pass, &clearcolor);
+	}
+	if(occlusion)
+	{
+		//pyramid for the next frames' culling
+		HiZ_AddPasses(&renderstuff.hiz, graph, targets.depth, targets.width, targets.height,
+						Matrix4x4_Mul(cam_1.view, cam_1.projection));
+	}
+	SCR_FifthgenPresent(graph, &renderstuff.upscale, &targets, backbuffer, swapchain_w, swapchain_h);
+	if(renderstuff.shadows_available && renderstuff.shadow_view)
+	{
+		RGTexture atlas = RenderGraph_ImportTexture(graph, "shadow atlas", renderstuff.shadows.atlas,
+													renderstuff.shadows.size, renderstuff.shadows.size);
+		RGPass pass = RenderGraph_AddPass(graph, "shadow view", shadow_view_pass, NULL);
+		RenderGraph_Read(graph, pass, atlas);
+		RenderGraph_WriteColor(graph, pass, backbuffer, NULL);
+	}
+	if(renderstuff.debug_lines)
+	{
+		RGPass pass = RenderGraph_AddPass(graph, "debug lines", debug_lines_pass, NULL);
+		RenderGraph_WriteColor(graph, pass, backbuffer, NULL);
+	}
+	RenderGraph_Execute(graph, cmdbuf);
+	SCR_CaptureFrame(cmdbuf, swapchain_texture, swapchain_w, swapchain_h);
 
-	SDL_SubmitGPUCommandBuffer(cmdbuf);
+	if(occlusion)
+	{
+		HiZ_Readback(&renderstuff.hiz, cmdbuf);
+	}
+	HiZ_Submit(&renderstuff.hiz, cmdbuf);
 }
 
 void TestScreen3_Destroy()
 {
 	SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Finishing test screen 3...");
+	TexArray_Destroy(&renderstuff.texarrays, (Model*[]){ tower.renderable, box.renderable }, 2);
 	ReleaseModel(drawing_context.device, tower.renderable);
 	ReleaseModel(drawing_context.device, box.renderable);
-	SDL_ReleaseGPUGraphicsPipeline(drawing_context.device, renderstuff.pipeline);
-	SDL_ReleaseGPUSampler(drawing_context.device, renderstuff.sampler);
-	SDL_ReleaseGPUTexture(drawing_context.device, renderstuff.depth_texture);
+	RenderGraph_Destroy(&renderstuff.graph);
+	HiZ_Destroy(&renderstuff.hiz);
+	GPUScene_Destroy(&renderstuff.gpuscene);
+	StaticBatch_Destroy(&renderstuff.statics);
+	ShadowCache_Destroy(&renderstuff.shadows);
+	Scene_Destroy(&renderstuff.level);
+	SDL_free(renderstuff.level_objects);
+	SDL_free(renderstuff.level_visible);
+	SDL_free(renderstuff.static_objects);
+	SDL_free(renderstuff.static_visible);
+	Culling_DestroyBounds(&cullbounds);
+	SDL_free(drawitems);
+	SDL_free(visible);
+	SDL_free(draworder);
+	SDL_free(renderstuff.tower_pipelines);
+	SDL_free(renderstuff.box_pipelines);
+	drawitems = NULL;
+	visible = NULL;
+	draworder = NULL;
+	drawitems_capacity = visible_count = 0;
+	SCR_ShowStats(NULL);
 	return;
 }
@@ -0,0 +1,52 @@
+//clustered lighting layout, must match clusters.h
+
+#define CLUSTERS_X 16
+#define CLUSTERS_Y 9
+#define CLUSTERS_Z 24
+#define CLUSTERS_LIGHTS_PER_CLUSTER 128
+
+struct Light
+{
+	vec3 position; //world space
+	float radius;
+	vec3 color; //premultiplied by the intensity
+	float padding;
+};
+
+struct ClusterParams
+{
+	mat4 view;
+	vec4 camera_position;
+	vec4 camera_forward;
+	vec2 projection_scale; //1 / projection diagonal
+	vec2 depth_range;
+	vec2 viewport;
+	uint light_count;
+	float ambient;
+};
+
+//slice 0 covers everything closer than depth_range.x, the rest split
+//the range exponentially so clusters stay roughly cubic
+uint cluster_slice(float depth, vec2 depth_range)
+{
+	if(depth < depth_range.x)
+	{
+		return 0u;
+	}
+	float t = log(depth / depth_range.x) / log(depth_range.y / depth_range.x);
+	return min(1u + uint(t * float(CLUSTERS_Z - 1)), uint(CLUSTERS_Z - 1));
+}
+
+float slice_near(uint slice, vec2 depth_range)
+{
+	if(slice == 0u)
+	{
+		return 0.0;
+	}
+	return depth_range.x * pow(depth_range.y / depth_range.x, float(slice - 1u) / float(CLUSTERS_Z - 1));
+}
+
+uint cluster_flat(uvec3 cluster)
+{
+	return (cluster.z * CLUSTERS_Y + cluster.y) * CLUSTERS_X + cluster.x;
+}
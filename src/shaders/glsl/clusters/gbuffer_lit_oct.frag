@@ -0,0 +1,23 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+//gbuffer_lit.frag with the normal octahedral-encoded
+
+#include "../common/octahedral.glsl"
+#include "lighting.glsl"
+
+layout(set = 2, binding = 0) uniform sampler2D diffuse;
+
+layout(location = 0) in vec2 in_uv;
+layout(location = 1) in vec3 in_worldpos;
+
+layout(location = 0) out vec4 out_color;
+layout(location = 1) out vec4 out_normal;
+
+void main()
+{
+	vec4 color = texture(diffuse, in_uv);
+	vec3 normal = normalize(cross(dFdx(in_worldpos), dFdy(in_worldpos)));
+	out_color = vec4(color.rgb * cluster_lighting(gl_FragCoord, in_worldpos, normal), color.a);
+	out_normal = vec4(oct_encode(normal), 0.0, 1.0);
+}
@@ -0,0 +1,60 @@
+//point lights from the cluster grid for fragment shaders with one
+//sampler; the buffers are storage buffer slots 0-2, bind with
+//Clusters_Bind
+
+#include "clusters.glsl"
+
+//cel bands the summed light snaps to
+#define LIGHT_BANDS 4.0
+
+layout(std430, set = 2, binding = 1) readonly buffer ClusterLights
+{
+	Light lights[];
+};
+
+layout(std430, set = 2, binding = 2) readonly buffer ClusterCounts
+{
+	uint cluster_counts[];
+};
+
+layout(std430, set = 2, binding = 3) readonly buffer ClusterIndices
+{
+	uint cluster_indices[];
+};
+
+layout(std140, set = 3, binding = 0) uniform ClusterUniforms
+{
+	ClusterParams clusters;
+};
+
+uint cluster_index(vec4 frag_coord, vec3 worldpos)
+{
+	vec2 tile = frag_coord.xy / clusters.viewport * vec2(CLUSTERS_X, CLUSTERS_Y);
+	uvec2 xy = min(uvec2(tile), uvec2(CLUSTERS_X - 1, CLUSTERS_Y - 1));
+	float depth = dot(worldpos - clusters.camera_position.xyz, clusters.camera_forward.xyz);
+	return cluster_flat(uvec3(xy, cluster_slice(depth, clusters.depth_range)));
+}
+
+//lambert with a smooth falloff reaching zero at the radius, banded
+vec3 cluster_lighting(vec4 frag_coord, vec3 worldpos, vec3 normal)
+{
+	//derivative normals face either way, lights come from the camera's side
+	if(dot(normal, clusters.camera_position.xyz - worldpos) < 0.0)
+	{
+		normal = -normal;
+	}
+	uint cluster = cluster_index(frag_coord, worldpos);
+	uint count = cluster_counts[cluster];
+	vec3 light = vec3(0.0);
+	for(uint i = 0u; i < count; i++)
+	{
+		Light l = lights[cluster_indices[cluster * CLUSTERS_LIGHTS_PER_CLUSTER + i]];
+		vec3 to_light = l.position - worldpos;
+		float distance = length(to_light);
+		float fade = clamp(1.0 - (distance * distance) / (l.radius * l.radius), 0.0, 1.0);
+		float lambert = max(dot(normal, to_light / max(distance, 0.0001)), 0.0);
+		light += l.color * lambert * fade * fade;
+	}
+	light = floor(light * LIGHT_BANDS + 0.5) / LIGHT_BANDS;
+	return vec3(clusters.ambient) + light;
+}
@@ -0,0 +1,24 @@
+//octahedral normal encoding, unit vector <-> [0,1]^2
+//fits R8G8 or R16G16 instead of three channels
+
+vec2 oct_wrap(vec2 v)
+{
+	return (1.0 - abs(v.yx)) * vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+}
+
+vec2 oct_encode(vec3 n)
+{
+	n /= (abs(n.x) + abs(n.y) + abs(n.z));
+	n.xy = (n.z >= 0.0) ? n.xy : oct_wrap(n.xy);
+	return n.xy * 0.5 + 0.5;
+}
+
+vec3 oct_decode(vec2 f)
+{
+	f = f * 2.0 - 1.0;
+	vec3 n = vec3(f.x, f.y, 1.0 - abs(f.x) - abs(f.y));
+	float t = clamp(-n.z, 0.0, 1.0);
+	n.x += (n.x >= 0.0) ? -t : t;
+	n.y += (n.y >= 0.0) ? -t : t;
+	return normalize(n);
+}
@@ -0,0 +1,19 @@
+//edge term from the normals around a pixel, 0 = flat, 1 = outline
+//shared by the fragment and compute outline passes
+
+#define OUTLINE_LOW 0.2
+#define OUTLINE_HIGH 0.4
+
+float outline_edge(vec3 center, vec3 left, vec3 right, vec3 up, vec3 down)
+{
+	float diff = 1.0 - dot(center, left);
+	diff = max(diff, 1.0 - dot(center, right));
+	diff = max(diff, 1.0 - dot(center, up));
+	diff = max(diff, 1.0 - dot(center, down));
+	return smoothstep(OUTLINE_LOW, OUTLINE_HIGH, diff);
+}
+
+vec4 outline_apply(vec4 color, float edge)
+{
+	return vec4(mix(color.rgb, vec3(0.0), edge), 1.0);
+}
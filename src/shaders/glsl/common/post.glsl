@@ -0,0 +1,54 @@
+//shared by the post chain shaders, see postchain.h
+//a fused pass is one neighbourhood effect (or a plain copy) followed by
+//every per-pixel effect the chain put after it
+
+layout(set = 3, binding = 0) uniform PostParams
+{
+	vec4 kernel; //xy = input texel size, z = strength, w = octahedral normals
+	vec4 grade; //x = exposure, y = contrast, z = saturation, w = enabled
+	vec4 vignette; //x = strength, y = radius, w = enabled
+	vec4 region; //xy = drawn part of the input in uv, see dynres.h
+	vec4 overdraw; //x = layers per unit of the red channel, w = enabled
+};
+
+//black for nothing, then blue, green, yellow, red, and white past five
+vec3 overdraw_heat(float layers)
+{
+	const vec3 ramp[6] = vec3[](vec3(0.0), vec3(0.0, 0.2, 1.0), vec3(0.0, 0.8, 0.2),
+								vec3(1.0, 0.9, 0.0), vec3(1.0, 0.1, 0.0), vec3(1.0));
+	int layer = clamp(int(layers + 0.5), 0, 5);
+	return ramp[layer];
+}
+
+//targets may be bigger than what was drawn into them, screen uv goes
+//to the drawn corner and taps are kept inside it
+vec2 post_uv(vec2 uv)
+{
+	return uv * region.xy;
+}
+
+vec4 post_sample(sampler2D tex, vec2 uv)
+{
+	return texture(tex, clamp(uv, kernel.xy * 0.5, region.xy - kernel.xy * 0.5));
+}
+
+vec3 post_tail(vec3 color, vec2 uv)
+{
+	if(overdraw.w != 0.0)
+	{
+		color = overdraw_heat(color.r * overdraw.x);
+	}
+	if(grade.w != 0.0)
+	{
+		color *= grade.x;
+		color = (color - 0.5) * grade.y + 0.5;
+		float luma = dot(color, vec3(0.2126, 0.7152, 0.0722));
+		color = mix(vec3(luma), color, grade.z);
+	}
+	if(vignette.w != 0.0)
+	{
+		float dist = length(uv - 0.5) * 1.41421356;
+		color *= 1.0 - vignette.x * smoothstep(vignette.y, 1.0, dist);
+	}
+	return clamp(color, 0.0, 1.0);
+}
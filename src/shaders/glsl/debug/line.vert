@@ -0,0 +1,20 @@
+#version 450
+
+//debug lines, already in world space; the matrix comes from
+//DebugDraw_Render
+
+layout(set = 1, binding = 0) uniform Transform
+{
+	mat4 viewproj;
+};
+
+layout(location = 0) in vec3 in_position;
+layout(location = 1) in vec4 in_color;
+
+layout(location = 0) out vec4 out_color;
+
+void main()
+{
+	out_color = in_color;
+	gl_Position = viewproj * vec4(in_position, 1.0);
+}
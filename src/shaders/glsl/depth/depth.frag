@@ -0,0 +1,7 @@
+#version 450
+
+//depth only, no color targets; pipelines still need a fragment shader
+
+void main()
+{
+}
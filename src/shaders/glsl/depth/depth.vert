@@ -0,0 +1,24 @@
+#version 450
+
+//position-only pre-pass for the frame data screens
+//same matrix and same math as simple.vert, so main passes can test EQUAL
+
+struct ObjectData
+{
+	mat4 mvp;
+	mat4 model;
+};
+
+layout(std430, set = 0, binding = 0) readonly buffer FrameObjects
+{
+	ObjectData objects[];
+};
+
+invariant gl_Position;
+
+layout(location = 0) in vec3 in_position;
+
+void main()
+{
+	gl_Position = objects[gl_InstanceIndex].mvp * vec4(in_position, 1.0);
+}
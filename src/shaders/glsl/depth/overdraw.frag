@@ -0,0 +1,11 @@
+#version 450
+
+//one step per shaded fragment, added up by the blend state
+//the post chain turns the count into a heat map (POST_EFFECT_OVERDRAW)
+
+layout(location = 0) out vec4 out_count;
+
+void main()
+{
+	out_count = vec4(1.0 / 255.0, 0.0, 0.0, 1.0);
+}
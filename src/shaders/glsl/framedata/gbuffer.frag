@@ -0,0 +1,19 @@
+#version 450
+
+//color goes to target 0 like simpletest/simple.frag, the derivative
+//normal from norm.frag goes to target 1
+
+layout(set = 2, binding = 0) uniform sampler2D diffuse;
+
+layout(location = 0) in vec2 in_uv;
+layout(location = 1) in vec3 in_worldpos;
+
+layout(location = 0) out vec4 out_color;
+layout(location = 1) out vec4 out_normal;
+
+void main()
+{
+	out_color = texture(diffuse, in_uv);
+	vec3 normal = normalize(cross(dFdx(in_worldpos), dFdy(in_worldpos)));
+	out_normal = vec4(normal * 0.5 + 0.5, 1.0);
+}
@@ -0,0 +1,21 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+//gbuffer.frag with the normal octahedral-encoded into the first two channels
+
+#include "../common/octahedral.glsl"
+
+layout(set = 2, binding = 0) uniform sampler2D diffuse;
+
+layout(location = 0) in vec2 in_uv;
+layout(location = 1) in vec3 in_worldpos;
+
+layout(location = 0) out vec4 out_color;
+layout(location = 1) out vec4 out_normal;
+
+void main()
+{
+	out_color = texture(diffuse, in_uv);
+	vec3 normal = normalize(cross(dFdx(in_worldpos), dFdy(in_worldpos)));
+	out_normal = vec4(oct_encode(normal), 0.0, 1.0);
+}
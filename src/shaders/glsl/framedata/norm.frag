@@ -0,0 +1,13 @@
+#version 450
+
+//Vertex3D has no normals, so the face normal comes from derivatives
+
+layout(location = 0) in vec3 in_worldpos;
+
+layout(location = 0) out vec4 out_color;
+
+void main()
+{
+	vec3 normal = normalize(cross(dFdx(in_worldpos), dFdy(in_worldpos)));
+	out_color = vec4(normal * 0.5 + 0.5, 1.0);
+}
@@ -0,0 +1,28 @@
+#version 450
+
+//normal pass, reads the frame data storage buffer (see simple.vert)
+
+struct ObjectData
+{
+	mat4 mvp;
+	mat4 model;
+};
+
+layout(std430, set = 0, binding = 0) readonly buffer FrameObjects
+{
+	ObjectData objects[];
+};
+
+invariant gl_Position; //see simple.vert
+
+layout(location = 0) in vec3 in_position;
+layout(location = 1) in vec2 in_uv;
+
+layout(location = 0) out vec3 out_worldpos;
+
+void main()
+{
+	ObjectData object = objects[gl_InstanceIndex];
+	gl_Position = object.mvp * vec4(in_position, 1.0);
+	out_worldpos = (object.model * vec4(in_position, 1.0)).xyz;
+}
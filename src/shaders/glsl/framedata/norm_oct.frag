@@ -0,0 +1,16 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+//norm.frag with the normal octahedral-encoded into the first two channels
+
+#include "../common/octahedral.glsl"
+
+layout(location = 0) in vec3 in_worldpos;
+
+layout(location = 0) out vec4 out_normal;
+
+void main()
+{
+	vec3 normal = normalize(cross(dFdx(in_worldpos), dFdy(in_worldpos)));
+	out_normal = vec4(oct_encode(normal), 0.0, 1.0);
+}
@@ -0,0 +1,32 @@
+#version 450
+
+//same outputs as simpletest/simple.vert, but the matrices come from the
+//frame data storage buffer instead of a uniform push per draw
+
+struct ObjectData
+{
+	mat4 mvp;
+	mat4 model;
+};
+
+layout(std430, set = 0, binding = 0) readonly buffer FrameObjects
+{
+	ObjectData objects[];
+};
+
+//depth pre-pass variants test with EQUAL, the depth has to come out
+//bit for bit the same as in depth.vert
+invariant gl_Position;
+
+layout(location = 0) in vec3 in_position;
+layout(location = 1) in vec2 in_uv;
+
+layout(location = 0) out vec2 out_uv;
+
+void main()
+{
+	//the object index comes as first_instance
+	ObjectData object = objects[gl_InstanceIndex];
+	gl_Position = object.mvp * vec4(in_position, 1.0);
+	out_uv = in_uv;
+}
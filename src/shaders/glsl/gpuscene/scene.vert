@@ -0,0 +1,62 @@
+#version 450
+
+//GPU scene geometry, same outputs as framedata/simple.vert but the
+//object matrices stay on the GPU and only the view-projection is pushed
+
+struct ObjectData
+{
+	mat4 model;
+};
+
+//see cull.comp
+struct MeshInfo
+{
+	uint index_count;
+	uint first_index;
+	int vertex_offset;
+	uint layer;
+	vec4 center;
+	vec4 extent;
+};
+
+struct DrawInfo
+{
+	uint object;
+	uint mesh;
+};
+
+layout(std430, set = 0, binding = 0) readonly buffer Objects
+{
+	ObjectData objects[];
+};
+
+layout(std430, set = 0, binding = 1) readonly buffer Meshes
+{
+	MeshInfo meshes[];
+};
+
+layout(std430, set = 0, binding = 2) readonly buffer Draws
+{
+	DrawInfo draws[];
+};
+
+layout(set = 1, binding = 0) uniform SceneInfo
+{
+	mat4 viewproj;
+};
+
+layout(location = 0) in vec3 in_position;
+layout(location = 1) in vec2 in_uv;
+
+layout(location = 0) out vec2 out_uv;
+//only read by scene_array.frag
+layout(location = 1) flat out uint out_layer;
+
+void main()
+{
+	//cull.comp puts the draw index in first_instance
+	DrawInfo draw = draws[gl_InstanceIndex];
+	gl_Position = viewproj * objects[draw.object].model * vec4(in_position, 1.0);
+	out_uv = in_uv;
+	out_layer = meshes[draw.mesh].layer;
+}
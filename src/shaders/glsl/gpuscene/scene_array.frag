@@ -0,0 +1,16 @@
+#version 450
+
+//simpletest/simple.frag for meshes packed into a texture array, the
+//layer comes per draw from scene.vert
+
+layout(set = 2, binding = 0) uniform sampler2DArray diffuse;
+
+layout(location = 0) in vec2 in_uv;
+layout(location = 1) flat in uint in_layer;
+
+layout(location = 0) out vec4 out_color;
+
+void main()
+{
+	out_color = texture(diffuse, vec3(in_uv, float(in_layer)));
+}
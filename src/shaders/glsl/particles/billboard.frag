@@ -0,0 +1,15 @@
+#version 450
+
+//round soft dot, premultiplied for the additive blend
+
+layout(location = 0) in vec2 in_uv;
+layout(location = 1) in vec4 in_color;
+
+layout(location = 0) out vec4 out_color;
+
+void main()
+{
+	float falloff = max(1.0 - dot(in_uv, in_uv), 0.0);
+	float alpha = in_color.a * falloff * falloff;
+	out_color = vec4(in_color.rgb * alpha, alpha);
+}
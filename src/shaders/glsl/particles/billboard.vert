@@ -0,0 +1,39 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+//one camera-facing quad per alive particle, 6 vertices per instance
+//from the indirect draw written by count.comp
+
+#include "particles.glsl"
+
+layout(std430, set = 0, binding = 0) readonly buffer Particles
+{
+	Particle particles[];
+};
+
+layout(set = 1, binding = 0) uniform DrawParams
+{
+	mat4 viewproj;
+	vec4 right; //w is the quad side
+	vec4 up;
+	float fade_time;
+};
+
+layout(location = 0) out vec2 out_uv;
+layout(location = 1) out vec4 out_color;
+
+const vec2 corners[6] = vec2[](
+	vec2(-1.0, -1.0), vec2(1.0, -1.0), vec2(1.0, 1.0),
+	vec2(-1.0, -1.0), vec2(1.0, 1.0), vec2(-1.0, 1.0)
+);
+
+void main()
+{
+	Particle particle = particles[gl_InstanceIndex];
+	vec2 corner = corners[gl_VertexIndex];
+	vec3 position = particle.position + (right.xyz * corner.x + up.xyz * corner.y) * (right.w * 0.5);
+	out_uv = corner;
+	out_color = unpackUnorm4x8(particle.color);
+	out_color.a *= clamp(particle.life / fade_time, 0.0, 1.0);
+	gl_Position = viewproj * vec4(position, 1.0);
+}
@@ -0,0 +1,15 @@
+#version 450
+
+//copies scene depth texel for texel into the particle system's own
+//texture, see Particles_AddDepthPass
+
+layout(set = 2, binding = 0) uniform sampler2D source;
+
+layout(location = 0) in vec2 in_uv;
+
+layout(location = 0) out float out_depth;
+
+void main()
+{
+	out_depth = texelFetch(source, ivec2(gl_FragCoord.xy), 0).r;
+}
@@ -0,0 +1,45 @@
+//shared by every particle shader, see particles.h
+
+//PARTICLES_GROUP
+#define GROUP_SIZE 256
+
+//Particle (std430)
+struct Particle
+{
+	vec3 position;
+	float life; //seconds left
+	vec3 velocity;
+	uint color; //rgba8, red in the low byte
+};
+
+//alive before the simulation, survivors counted during it
+struct Counters
+{
+	uint alive;
+	uint next_alive;
+	uint padding[2];
+};
+
+//pcg, good enough spread for spawn jitter from just an index and seed
+uint particle_hash(uint value)
+{
+	uint state = value * 747796405u + 2891336453u;
+	uint word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+	return (word >> 22u) ^ word;
+}
+
+float particle_random(inout uint state)
+{
+	state = particle_hash(state);
+	return float(state) / 4294967295.0;
+}
+
+//uniform inside the unit sphere
+vec3 particle_random_sphere(inout uint state)
+{
+	float z = particle_random(state) * 2.0 - 1.0;
+	float angle = particle_random(state) * 6.2831853;
+	float radius = pow(particle_random(state), 1.0 / 3.0);
+	float ring = sqrt(max(1.0 - z * z, 0.0));
+	return vec3(ring * cos(angle), ring * sin(angle), z) * radius;
+}
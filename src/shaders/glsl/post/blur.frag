@@ -0,0 +1,28 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+//3x3 gaussian, strength scales the tap distance
+
+#include "../common/post.glsl"
+
+layout(set = 2, binding = 0) uniform sampler2D source;
+
+layout(location = 0) in vec2 in_uv;
+
+layout(location = 0) out vec4 out_color;
+
+void main()
+{
+	vec2 uv = post_uv(in_uv);
+	vec2 step = kernel.xy * kernel.z;
+	vec3 sum = post_sample(source, uv).rgb * 4.0;
+	sum += post_sample(source, uv + vec2(-step.x, 0.0)).rgb * 2.0;
+	sum += post_sample(source, uv + vec2(step.x, 0.0)).rgb * 2.0;
+	sum += post_sample(source, uv + vec2(0.0, -step.y)).rgb * 2.0;
+	sum += post_sample(source, uv + vec2(0.0, step.y)).rgb * 2.0;
+	sum += post_sample(source, uv + vec2(-step.x, -step.y)).rgb;
+	sum += post_sample(source, uv + vec2(step.x, -step.y)).rgb;
+	sum += post_sample(source, uv + vec2(-step.x, step.y)).rgb;
+	sum += post_sample(source, uv + vec2(step.x, step.y)).rgb;
+	out_color = vec4(post_tail(sum / 16.0, in_uv), 1.0);
+}
@@ -0,0 +1,17 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+//per-pixel effects only, also does the final scale to the output
+
+#include "../common/post.glsl"
+
+layout(set = 2, binding = 0) uniform sampler2D source;
+
+layout(location = 0) in vec2 in_uv;
+
+layout(location = 0) out vec4 out_color;
+
+void main()
+{
+	out_color = vec4(post_tail(post_sample(source, post_uv(in_uv)).rgb, in_uv), 1.0);
+}
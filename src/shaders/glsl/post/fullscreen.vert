@@ -0,0 +1,13 @@
+#version 450
+
+//one triangle covering the screen, no vertex buffer
+//draw 3 vertices, the parts outside the viewport are clipped
+
+layout(location = 0) out vec2 out_uv;
+
+void main()
+{
+	vec2 pos = vec2((gl_VertexIndex << 1) & 2, gl_VertexIndex & 2);
+	out_uv = vec2(pos.x, 1.0 - pos.y);
+	gl_Position = vec4(pos * 2.0 - 1.0, 0.0, 1.0);
+}
@@ -0,0 +1,28 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+#include "../common/post.glsl"
+#include "../common/octahedral.glsl"
+#include "../common/outline.glsl"
+
+layout(set = 2, binding = 0) uniform sampler2D source;
+layout(set = 2, binding = 1) uniform sampler2D normals;
+
+layout(location = 0) in vec2 in_uv;
+
+layout(location = 0) out vec4 out_color;
+
+vec3 normal_at(vec2 offset)
+{
+	vec4 texel = post_sample(normals, post_uv(in_uv) + offset * kernel.xy);
+	return (kernel.w != 0.0) ? oct_decode(texel.xy) : normalize(texel.xyz * 2.0 - 1.0);
+}
+
+void main()
+{
+	float edge = outline_edge(normal_at(vec2(0.0)),
+								normal_at(vec2(-1.0, 0.0)), normal_at(vec2(1.0, 0.0)),
+								normal_at(vec2(0.0, -1.0)), normal_at(vec2(0.0, 1.0)));
+	vec4 color = outline_apply(post_sample(source, post_uv(in_uv)), edge * kernel.z);
+	out_color = vec4(post_tail(color.rgb, in_uv), 1.0);
+}
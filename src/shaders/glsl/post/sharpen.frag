@@ -0,0 +1,24 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+//5 tap unsharp mask, strength is the amount
+
+#include "../common/post.glsl"
+
+layout(set = 2, binding = 0) uniform sampler2D source;
+
+layout(location = 0) in vec2 in_uv;
+
+layout(location = 0) out vec4 out_color;
+
+void main()
+{
+	vec2 uv = post_uv(in_uv);
+	vec3 center = post_sample(source, uv).rgb;
+	vec3 around = post_sample(source, uv + vec2(-kernel.x, 0.0)).rgb;
+	around += post_sample(source, uv + vec2(kernel.x, 0.0)).rgb;
+	around += post_sample(source, uv + vec2(0.0, -kernel.y)).rgb;
+	around += post_sample(source, uv + vec2(0.0, kernel.y)).rgb;
+	vec3 color = center * (1.0 + 4.0 * kernel.z) - around * kernel.z;
+	out_color = vec4(post_tail(color, in_uv), 1.0);
+}
@@ -0,0 +1,16 @@
+#version 450
+
+//shadow casters, position only; the matrix comes from
+//ShadowCache_PushTransform
+
+layout(set = 1, binding = 0) uniform Transform
+{
+	mat4 mvp;
+};
+
+layout(location = 0) in vec3 in_position;
+
+void main()
+{
+	gl_Position = mvp * vec4(in_position, 1.0);
+}
@@ -0,0 +1,8 @@
+#version 450
+
+//clears one tile of the static depth, the viewport limits it
+
+void main()
+{
+	gl_FragDepth = 1.0;
+}
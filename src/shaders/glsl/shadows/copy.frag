@@ -0,0 +1,11 @@
+#version 450
+
+//cached static depth into the same tile of the atlas, both textures
+//share the layout so the pixel position is the lookup
+
+layout(set = 2, binding = 0) uniform sampler2D static_depth;
+
+void main()
+{
+	gl_FragDepth = texelFetch(static_depth, ivec2(gl_FragCoord.xy), 0).r;
+}
@@ -0,0 +1,15 @@
+#version 450
+
+//shadow atlas debug view, nearer casters are darker
+
+layout(set = 2, binding = 0) uniform sampler2D atlas;
+
+layout(location = 0) in vec2 in_uv;
+
+layout(location = 0) out vec4 out_color;
+
+void main()
+{
+	float depth = texture(atlas, in_uv).r;
+	out_color = vec4(vec3(depth), 1.0);
+}
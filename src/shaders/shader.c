@@ -15,6 +15,7 @@
  */
 
 #include <fileio.h>
+#include <hashtable.h>
 #include <shader.h>
 
 SDL_GPUShader* LoadShader(const char *path,
@@ -49,5 +50,606 @@ SDL_GPUShader* LoadShader(const char *path,
 		.num_storage_buffers = storageBufferCount,
 		.num_storage_textures = storageTextureCount
 	};
-	return SDL_CreateGPUShader(device, &shader_info);
+	SDL_GPUShader *shader = SDL_CreateGPUShader(device, &shader_info);
+	//the driver keeps its own copy
+	SDL_free(file);
+	return shader;
+}
+
+/*******************************************************************
+ * SPIR-V REFLECTION ***********************************************
+ ******************************************************************/
+
+#define SPV_MAGIC 0x07230203
+
+#define SPV_OP_EXECUTIONMODE 16
+#define SPV_OP_TYPEIMAGE 25
+#define SPV_OP_TYPESAMPLER 26
+#define SPV_OP_TYPESAMPLEDIMAGE 27
+#define SPV_OP_TYPEARRAY 28
+#define SPV_OP_TYPERUNTIMEARRAY 29
+#define SPV_OP_TYPESTRUCT 30
+#define SPV_OP_TYPEPOINTER 32
+#define SPV_OP_CONSTANT 43
+#define SPV_OP_VARIABLE 59
+#define SPV_OP_DECORATE 71
+
+#define SPV_DECORATION_BLOCK 2
+#define SPV_DECORATION_BUFFERBLOCK 3
+#define SPV_DECORATION_DESCRIPTORSET 34
+
+#define SPV_STORAGE_UNIFORMCONSTANT 0
+#define SPV_STORAGE_UNIFORM 2
+#define SPV_STORAGE_STORAGEBUFFER 12
+
+#define SPV_EXECUTIONMODE_LOCALSIZE 17
+
+//SDL puts compute resources on fixed sets
+#define SPV_COMPUTE_SET_READONLY 0
+#define SPV_COMPUTE_SET_READWRITE 1
+
+typedef struct SpvId
+{
+	Uint16 opcode;
+	Uint16 decoration; //block or bufferblock
+	Uint32 operand_a; //pointee, element type, image sampled mode or constant value
+	Uint32 operand_b; //array length id, pointer storage class
+	Sint32 set; //descriptor set, -1 when not decorated
+} SpvId;
+
+typedef enum SpvResourceKind
+{
+	SPV_RESOURCE_NONE = 0,
+	SPV_RESOURCE_SAMPLER,
+	SPV_RESOURCE_STORAGE_TEXTURE,
+	SPV_RESOURCE_STORAGE_BUFFER,
+	SPV_RESOURCE_UNIFORM_BUFFER
+} SpvResourceKind;
+
+//follows arrays down to the actual resource type
+static SpvResourceKind spv_classify(SpvId *ids, Uint32 bound, Uint32 type,
+									Uint32 storage, Uint32 *count)
+{
+	*count = 1;
+	while(type < bound && (ids[type].opcode == SPV_OP_TYPEARRAY || ids[type].opcode == SPV_OP_TYPERUNTIMEARRAY))
+	{
+		if(ids[type].opcode == SPV_OP_TYPEARRAY && ids[type].operand_b < bound)
+		{
+			*count *= ids[ids[type].operand_b].operand_a;
+		}
+		type = ids[type].operand_a;
+	}
+	if(type >= bound)
+	{
+		return SPV_RESOURCE_NONE;
+	}
+
+	SpvId *t = &ids[type];
+	if(storage == SPV_STORAGE_UNIFORMCONSTANT)
+	{
+		if(t->opcode == SPV_OP_TYPESAMPLEDIMAGE)
+		{
+			return SPV_RESOURCE_SAMPLER;
+		}
+		//sampled == 2 means storage image
+		if(t->opcode == SPV_OP_TYPEIMAGE && t->operand_a == 2)
+		{
+			return SPV_RESOURCE_STORAGE_TEXTURE;
+		}
+		return SPV_RESOURCE_NONE;
+	}
+	if(t->opcode != SPV_OP_TYPESTRUCT)
+	{
+		return SPV_RESOURCE_NONE;
+	}
+	//SPIR-V 1.0 marks storage buffers as Uniform + BufferBlock
+	if(storage == SPV_STORAGE_STORAGEBUFFER || t->decoration == SPV_DECORATION_BUFFERBLOCK)
+	{
+		return SPV_RESOURCE_STORAGE_BUFFER;
+	}
+	if(storage == SPV_STORAGE_UNIFORM)
+	{
+		return SPV_RESOURCE_UNIFORM_BUFFER;
+	}
+	return SPV_RESOURCE_NONE;
+}
+
+bool Shader_Reflect(const Uint8 *code, size_t size, ShaderResources *resources)
+{
+	if(code == NULL || resources == NULL || size < 20 || (size % 4) != 0)
+	{
+		return false;
+	}
+	*resources = (ShaderResources){ 0 };
+
+	//SPIR-V is a stream of 32-bit words, bundles and files keep them aligned
+	const Uint32 *words = (const Uint32*)code;
+	size_t word_count = size / 4;
+	if(SDL_Swap32LE(words[0]) != SPV_MAGIC)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Graphics: Error: Not a SPIR-V module.");
+		return false;
+	}
+	Uint32 bound = SDL_Swap32LE(words[3]);
+	SpvId *ids = (SpvId*)SDL_calloc(bound, sizeof(SpvId));
+	if(ids == NULL)
+	{
+		return false;
+	}
+	for(Uint32 i = 0; i < bound; i++)
+	{
+		ids[i].set = -1;
+	}
+
+	//first pass: types, constants and decorations
+	size_t i = 5;
+	while(i < word_count)
+	{
+		Uint32 word = SDL_Swap32LE(words[i]);
+		Uint16 opcode = word & 0xFFFF;
+		Uint16 length = word >> 16;
+		if(length == 0 || i + length > word_count)
+		{
+			break;
+		}
+		const Uint32 *op = &words[i + 1];
+		Uint32 result = (length > 1) ? SDL_Swap32LE(op[0]) : 0;
+
+		switch(opcode)
+		{
+			case SPV_OP_EXECUTIONMODE:
+				if(length >= 6 && SDL_Swap32LE(op[1]) == SPV_EXECUTIONMODE_LOCALSIZE)
+				{
+					resources->threadcount_x = SDL_Swap32LE(op[2]);
+					resources->threadcount_y = SDL_Swap32LE(op[3]);
+					resources->threadcount_z = SDL_Swap32LE(op[4]);
+				}
+				break;
+			case SPV_OP_TYPEIMAGE:
+				if(length >= 9 && result < bound)
+				{
+					ids[result].opcode = opcode;
+					ids[result].operand_a = SDL_Swap32LE(op[6]);
+				}
+				break;
+			case SPV_OP_TYPESAMPLER:
+			case SPV_OP_TYPESAMPLEDIMAGE:
+			case SPV_OP_TYPESTRUCT:
+				if(result < bound)
+				{
+					ids[result].opcode = opcode;
+				}
+				break;
+			case SPV_OP_TYPEARRAY:
+			case SPV_OP_TYPERUNTIMEARRAY:
+				if(length >= 3 && result < bound)
+				{
+					ids[result].opcode = opcode;
+					ids[result].operand_a = SDL_Swap32LE(op[1]);
+					ids[result].operand_b = (length >= 4) ? SDL_Swap32LE(op[2]) : 0;
+				}
+				break;
+			case SPV_OP_TYPEPOINTER:
+				if(length >= 4 && result < bound)
+				{
+					ids[result].opcode = opcode;
+					ids[result].operand_b = SDL_Swap32LE(op[1]);
+					ids[result].operand_a = SDL_Swap32LE(op[2]);
+				}
+				break;
+			case SPV_OP_CONSTANT:
+				//result type first, then id, then value
+				if(length >= 4 && SDL_Swap32LE(op[1]) < bound)
+				{
+					ids[SDL_Swap32LE(op[1])].opcode = opcode;
+					ids[SDL_Swap32LE(op[1])].operand_a = SDL_Swap32LE(op[2]);
+				}
+				break;
+			case SPV_OP_DECORATE:
+				if(length >= 3 && result < bound)
+				{
+					Uint32 decoration = SDL_Swap32LE(op[1]);
+					if(decoration == SPV_DECORATION_BLOCK || decoration == SPV_DECORATION_BUFFERBLOCK)
+					{
+						ids[result].decoration = decoration;
+					}
+					else if(decoration == SPV_DECORATION_DESCRIPTORSET && length >= 4)
+					{
+						ids[result].set = SDL_Swap32LE(op[2]);
+					}
+				}
+				break;
+			default: break;
+		}
+		i += length;
+	}
+
+	//second pass: variables, they come after every type they use
+	i = 5;
+	while(i < word_count)
+	{
+		Uint32 word = SDL_Swap32LE(words[i]);
+		Uint16 opcode = word & 0xFFFF;
+		Uint16 length = word >> 16;
+		if(length == 0 || i + length > word_count)
+		{
+			break;
+		}
+		if(opcode == SPV_OP_VARIABLE && length >= 4)
+		{
+			Uint32 pointer = SDL_Swap32LE(words[i + 1]);
+			Uint32 variable = SDL_Swap32LE(words[i + 2]);
+			Uint32 storage = SDL_Swap32LE(words[i + 3]);
+			if(pointer < bound && variable < bound && ids[pointer].opcode == SPV_OP_TYPEPOINTER)
+			{
+				Uint32 count;
+				bool readwrite = ids[variable].set == SPV_COMPUTE_SET_READWRITE;
+				switch(spv_classify(ids, bound, ids[pointer].operand_a, storage, &count))
+				{
+					case SPV_RESOURCE_SAMPLER: resources->samplers += count; break;
+					case SPV_RESOURCE_UNIFORM_BUFFER: resources->uniform_buffers += count; break;
+					case SPV_RESOURCE_STORAGE_TEXTURE:
+						if(readwrite) resources->readwrite_storage_textures += count;
+						else resources->storage_textures += count;
+						break;
+					case SPV_RESOURCE_STORAGE_BUFFER:
+						if(readwrite) resources->readwrite_storage_buffers += count;
+						else resources->storage_buffers += count;
+						break;
+					default: break;
+				}
+			}
+		}
+		i += length;
+	}
+
+	SDL_free(ids);
+	return true;
+}
+
+/*******************************************************************
+ * SHADER LIBRARY **************************************************
+ ******************************************************************/
+
+static SDL_GPUDevice *lib_device = NULL;
+static Hashtable *lib_shaders = NULL;
+static Hashtable *lib_compute = NULL;
+//names that failed to load or create, asked for again they stay NULL
+//instead of hitting the disk and the driver every time; shader keys
+//carry the stage so they can't clash with compute names
+static Hashtable *lib_failed = NULL;
+static SDL_Mutex *lib_lock = NULL;
+
+static bool name_has_suffix(const char *name, const char *suffix)
+{
+	size_t name_len = SDL_strlen(name);
+	size_t suffix_len = SDL_strlen(suffix);
+	return name_len >= suffix_len && SDL_strcmp(name + name_len - suffix_len, suffix) == 0;
+}
+
+static void shader_key(const char *name, SDL_GPUShaderStage stage, char *key, size_t len)
+{
+	SDL_snprintf(key, len, "%s#%d", name, (int)stage);
+}
+
+static SDL_GPUShader *create_shader(const char *name, SDL_GPUShaderStage stage,
+									const Uint8 *code, size_t size)
+{
+	ShaderResources resources;
+	if(!Shader_Reflect(code, size, &resources))
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Graphics: Error: Failed to reflect %s.", name);
+		return NULL;
+	}
+	SDL_GPUShaderCreateInfo shader_info = {
+		.code = code,
+		.code_size = size,
+		.entrypoint = "main",
+		.format = SDL_GPU_SHADERFORMAT_SPIRV,
+		.stage = stage,
+		.num_samplers = resources.samplers,
+		.num_uniform_buffers = resources.uniform_buffers,
+		.num_storage_buffers = resources.storage_buffers,
+		.num_storage_textures = resources.storage_textures
+	};
+	SDL_GPUShader *shader = SDL_CreateGPUShader(lib_device, &shader_info);
+	if(shader == NULL)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Graphics: Error: Failed to create shader %s: %s", name, SDL_GetError());
+	}
+	return shader;
+}
+
+static SDL_GPUComputePipeline *create_compute(const char *name, const Uint8 *code, size_t size)
+{
+	ShaderResources resources;
+	if(!Shader_Reflect(code, size, &resources))
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Graphics: Error: Failed to reflect %s.", name);
+		return NULL;
+	}
+	SDL_GPUComputePipelineCreateInfo pipeline_info = {
+		.code = code,
+		.code_size = size,
+		.entrypoint = "main",
+		.format = SDL_GPU_SHADERFORMAT_SPIRV,
+		.num_samplers = resources.samplers,
+		.num_readonly_storage_textures = resources.storage_textures,
+		.num_readonly_storage_buffers = resources.storage_buffers,
+		.num_readwrite_storage_textures = resources.readwrite_storage_textures,
+		.num_readwrite_storage_buffers = resources.readwrite_storage_buffers,
+		.num_uniform_buffers = resources.uniform_buffers,
+		.threadcount_x = SDL_max(resources.threadcount_x, 1),
+		.threadcount_y = SDL_max(resources.threadcount_y, 1),
+		.threadcount_z = SDL_max(resources.threadcount_z, 1)
+	};
+	SDL_GPUComputePipeline *pipeline = SDL_CreateGPUComputePipeline(lib_device, &pipeline_info);
+	if(pipeline == NULL)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Graphics: Error: Failed to create compute pipeline %s: %s", name, SDL_GetError());
+	}
+	return pipeline;
+}
+
+//takes one blob, creates whatever the name says it is
+static void add_from_code(const char *name, const Uint8 *code, size_t size)
+{
+	char key[SHADERBUNDLE_NAME_SIZE + 16];
+	if(name_has_suffix(name, ".comp.spv"))
+	{
+		SDL_GPUComputePipeline *pipeline = create_compute(name, code, size);
+		if(pipeline != NULL && !HashtableInsert(lib_compute, name, pipeline))
+		{
+			SDL_ReleaseGPUComputePipeline(lib_device, pipeline);
+		}
+		return;
+	}
+
+	SDL_GPUShaderStage stage;
+	if(name_has_suffix(name, ".vert.spv"))
+	{
+		stage = SDL_GPU_SHADERSTAGE_VERTEX;
+	}
+	else if(name_has_suffix(name, ".frag.spv"))
+	{
+		stage = SDL_GPU_SHADERSTAGE_FRAGMENT;
+	}
+	else
+	{
+		SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Graphics: unknown shader stage for %s, skipping.", name);
+		return;
+	}
+	SDL_GPUShader *shader = create_shader(name, stage, code, size);
+	shader_key(name, stage, key, sizeof(key));
+	if(shader != NULL && !HashtableInsert(lib_shaders, key, shader))
+	{
+		SDL_ReleaseGPUShader(lib_device, shader);
+	}
+}
+
+static bool load_bundle(const char *bundle_path)
+{
+	size_t size;
+	Uint8 *bundle = FileIOReadBytes(bundle_path, &size);
+	if(bundle == NULL)
+	{
+		return false;
+	}
+
+	ShaderBundleHeader header;
+	if(size < sizeof(header))
+	{
+		SDL_free(bundle);
+		return false;
+	}
+	SDL_memcpy(&header, bundle, sizeof(header));
+	header.version = SDL_Swap32LE(header.version);
+	header.count = SDL_Swap32LE(header.count);
+	if(SDL_memcmp(header.magic, SHADERBUNDLE_MAGIC, 4) != 0 ||
+		header.version != SHADERBUNDLE_VERSION ||
+		header.count > (size - sizeof(header)) / sizeof(ShaderBundleEntry))
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Graphics: Error: %s is not a valid shader bundle.", bundle_path);
+		SDL_free(bundle);
+		return false;
+	}
+
+	ShaderBundleEntry *entries = (ShaderBundleEntry*)(bundle + sizeof(header));
+	Uint32 loaded = 0;
+	for(Uint32 i = 0; i < header.count; i++)
+	{
+		ShaderBundleEntry *entry = &entries[i];
+		Uint32 offset = SDL_Swap32LE(entry->offset);
+		Uint32 code_size = SDL_Swap32LE(entry->size);
+		entry->name[SHADERBUNDLE_NAME_SIZE - 1] = '\0';
+		if((offset % 4) != 0 || offset > size || code_size > size - offset)
+		{
+			SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Graphics: Error: Bad bundle entry %s.", entry->name);
+			continue;
+		}
+		add_from_code(entry->name, bundle + offset, code_size);
+		loaded++;
+	}
+
+	//every module is on the driver side now
+	SDL_free(bundle);
+	SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Graphics: %u shaders loaded from %s.", loaded, bundle_path);
+	return true;
+}
+
+bool ShaderLib_Init(SDL_GPUDevice *device, const char *bundle_path)
+{
+	if(device == NULL)
+	{
+		return false;
+	}
+	if(lib_device != NULL)
+	{
+		return true;
+	}
+	lib_shaders = HashtableInit();
+	lib_compute = HashtableInit();
+	lib_failed = HashtableInit();
+	lib_lock = SDL_CreateMutex();
+	if(lib_shaders == NULL || lib_compute == NULL || lib_failed == NULL || lib_lock == NULL)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Graphics: Error: Failed to init shader library.");
+		ShaderLib_Destroy();
+		return false;
+	}
+	lib_device = device;
+
+	if(bundle_path != NULL && !load_bundle(bundle_path))
+	{
+		//not fatal, shaders will come from their own files
+		SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Graphics: shader bundle %s not loaded, using loose files.", bundle_path);
+	}
+	return true;
+}
+
+SDL_GPUShader *ShaderLib_Get(const char *name, SDL_GPUShaderStage stage)
+{
+	if(lib_device == NULL || name == NULL)
+	{
+		return NULL;
+	}
+	char key[SHADERBUNDLE_NAME_SIZE + 16];
+	shader_key(name, stage, key, sizeof(key));
+
+	//pipeline prewarm calls this from worker threads
+	SDL_LockMutex(lib_lock);
+	SDL_GPUShader *shader = (SDL_GPUShader*)HashtableFind(lib_shaders, key);
+	bool failed = HashtableFind(lib_failed, key) != NULL;
+	SDL_UnlockMutex(lib_lock);
+	if(shader != NULL || failed)
+	{
+		return shader;
+	}
+
+	//reading and creating stay outside the lock so a slow driver compile
+	//doesn't hold up threads asking for shaders that are already there
+	size_t size;
+	Uint8 *code = FileIOReadBytes(name, &size);
+	if(code != NULL)
+	{
+		shader = create_shader(name, stage, code, size);
+		SDL_free(code);
+	}
+	else
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Graphics: Error: Shader %s not found.", name);
+	}
+
+	SDL_LockMutex(lib_lock);
+	SDL_GPUShader *existing = (SDL_GPUShader*)HashtableFind(lib_shaders, key);
+	if(existing != NULL)
+	{
+		//another thread got there first, keep one
+		if(shader != NULL)
+		{
+			SDL_ReleaseGPUShader(lib_device, shader);
+		}
+		shader = existing;
+	}
+	else if(shader != NULL)
+	{
+		HashtableInsert(lib_shaders, key, shader);
+	}
+	else if(HashtableFind(lib_failed, key) == NULL)
+	{
+		HashtableInsert(lib_failed, key, lib_failed);
+	}
+	SDL_UnlockMutex(lib_lock);
+	return shader;
+}
+
+SDL_GPUComputePipeline *ShaderLib_GetCompute(const char *name)
+{
+	if(lib_device == NULL || name == NULL)
+	{
+		return NULL;
+	}
+	SDL_LockMutex(lib_lock);
+	SDL_GPUComputePipeline *pipeline = (SDL_GPUComputePipeline*)HashtableFind(lib_compute, name);
+	bool failed = HashtableFind(lib_failed, name) != NULL;
+	SDL_UnlockMutex(lib_lock);
+	if(pipeline != NULL || failed)
+	{
+		return pipeline;
+	}
+
+	size_t size;
+	Uint8 *code = FileIOReadBytes(name, &size);
+	if(code != NULL)
+	{
+		pipeline = create_compute(name, code, size);
+		SDL_free(code);
+	}
+	else
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Graphics: Error: Compute shader %s not found.", name);
+	}
+
+	SDL_LockMutex(lib_lock);
+	SDL_GPUComputePipeline *existing = (SDL_GPUComputePipeline*)HashtableFind(lib_compute, name);
+	if(existing != NULL)
+	{
+		if(pipeline != NULL)
+		{
+			SDL_ReleaseGPUComputePipeline(lib_device, pipeline);
+		}
+		pipeline = existing;
+	}
+	else if(pipeline != NULL)
+	{
+		HashtableInsert(lib_compute, name, pipeline);
+	}
+	else if(HashtableFind(lib_failed, name) == NULL)
+	{
+		HashtableInsert(lib_failed, name, lib_failed);
+	}
+	SDL_UnlockMutex(lib_lock);
+	return pipeline;
+}
+
+void ShaderLib_Destroy()
+{
+	for(int i = 0; i < HASH_SIZE; i++)
+	{
+		if(lib_shaders != NULL)
+		{
+			for(HashtableBucket *node = lib_shaders->buckets[i]; node != NULL; node = node->next)
+			{
+				SDL_ReleaseGPUShader(lib_device, (SDL_GPUShader*)node->value);
+			}
+		}
+		if(lib_compute != NULL)
+		{
+			for(HashtableBucket *node = lib_compute->buckets[i]; node != NULL; node = node->next)
+			{
+				SDL_ReleaseGPUComputePipeline(lib_device, (SDL_GPUComputePipeline*)node->value);
+			}
+		}
+	}
+	if(lib_shaders != NULL)
+	{
+		HashtableDestroy(lib_shaders);
+		lib_shaders = NULL;
+	}
+	if(lib_compute != NULL)
+	{
+		HashtableDestroy(lib_compute);
+		lib_compute = NULL;
+	}
+	if(lib_failed != NULL)
+	{
+		HashtableDestroy(lib_failed);
+		lib_failed = NULL;
+	}
+	if(lib_lock != NULL)
+	{
+		SDL_DestroyMutex(lib_lock);
+		lib_lock = NULL;
+	}
+	lib_device = NULL;
 }
@@ -19,6 +19,39 @@
 
 #include <SDL3/SDL.h>
 
+//bundle layout, little endian:
+//header, then count entries, then the SPIR-V blobs (4-byte aligned)
+#define SHADERBUNDLE_MAGIC "LSPV"
+#define SHADERBUNDLE_VERSION 1
+#define SHADERBUNDLE_NAME_SIZE 96
+
+typedef struct ShaderBundleHeader
+{
+	char magic[4];
+	Uint32 version;
+	Uint32 count;
+} ShaderBundleHeader;
+
+typedef struct ShaderBundleEntry
+{
+	char name[SHADERBUNDLE_NAME_SIZE]; //content path, e.g. shaders/splash/quad.vert.spv
+	Uint32 offset; //from the start of the file
+	Uint32 size;
+} ShaderBundleEntry;
+
+//what SDL wants to know about a shader, read from the SPIR-V itself
+typedef struct ShaderResources
+{
+	Uint32 samplers;
+	Uint32 uniform_buffers;
+	Uint32 storage_buffers; //read-only ones on compute
+	Uint32 storage_textures; //read-only ones on compute
+	Uint32 readwrite_storage_buffers; //compute only
+	Uint32 readwrite_storage_textures; //compute only
+	Uint32 threadcount_x, threadcount_y, threadcount_z; //compute only
+} ShaderResources;
+
+//single file loader, counts given by the caller
 SDL_GPUShader* LoadShader(const char *path,
 							SDL_GPUDevice *device,
 							SDL_GPUShaderStage stage,
@@ -27,4 +60,20 @@ SDL_GPUShader* LoadShader(const char *path,
 							Uint32 storageBufferCount,
 							Uint32 storageTextureCount);
 
+bool Shader_Reflect(const Uint8 *code, size_t size, ShaderResources *resources);
+
+//shader library
+//loads every shader in the bundle with a single read, creates them and
+//frees the bytes; anything missing from the bundle is loaded from its
+//own file on first use
+bool ShaderLib_Init(SDL_GPUDevice *device, const char *bundle_path);
+
+//shared, owned by the library; a name that failed once stays NULL
+SDL_GPUShader *ShaderLib_Get(const char *name, SDL_GPUShaderStage stage);
+
+//compute shaders are pipelines on SDL, so the library keeps those
+SDL_GPUComputePipeline *ShaderLib_GetCompute(const char *name);
+
+void ShaderLib_Destroy();
+
 #endif
@@ -0,0 +1,149 @@
+/*
+ * Copyright (C) 2025 Matheus Klein Schaefer
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+//packs compiled SPIR-V into the bundle read by ShaderLib_Init
+//usage: shaderbundle <output> <content dir> <file.spv>...
+//entry names are the file paths relative to the content dir, which is
+//what the game passes to ShaderLib_Get
+//example:
+//shaderbundle content/shaders/shaders.bundle content content/shaders/*/*.spv
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+//must match shader.h
+#define SHADERBUNDLE_MAGIC "LSPV"
+#define SHADERBUNDLE_VERSION 1
+#define SHADERBUNDLE_NAME_SIZE 96
+#define HEADER_SIZE 12
+#define ENTRY_SIZE (SHADERBUNDLE_NAME_SIZE + 8)
+
+static void write_u32(FILE *file, uint32_t value)
+{
+	unsigned char bytes[4] = {
+		value & 0xFF, (value >> 8) & 0xFF, (value >> 16) & 0xFF, (value >> 24) & 0xFF
+	};
+	fwrite(bytes, 1, 4, file);
+}
+
+static unsigned char *read_file(const char *path, uint32_t *size)
+{
+	FILE *file = fopen(path, "rb");
+	if(file == NULL)
+	{
+		return NULL;
+	}
+	fseek(file, 0, SEEK_END);
+	long len = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	unsigned char *data = (unsigned char*)malloc(len > 0 ? len : 1);
+	if(data == NULL || fread(data, 1, len, file) != (size_t)len)
+	{
+		free(data);
+		fclose(file);
+		return NULL;
+	}
+	fclose(file);
+	*size = (uint32_t)len;
+	return data;
+}
+
+static const char *entry_name(const char *path, const char *root)
+{
+	size_t root_len = strlen(root);
+	if(strncmp(path, root, root_len) == 0)
+	{
+		path += root_len;
+		while(*path == '/' || *path == '\\')
+		{
+			path++;
+		}
+	}
+	return path;
+}
+
+int main(int argc, char *argv[])
+{
+	if(argc < 4)
+	{
+		fprintf(stderr, "usage: %s <output> <content dir> <file.spv>...\n", argv[0]);
+		return 1;
+	}
+	uint32_t count = (uint32_t)(argc - 3);
+	unsigned char **blobs = (unsigned char**)calloc(count, sizeof(unsigned char*));
+	uint32_t *sizes = (uint32_t*)calloc(count, sizeof(uint32_t));
+	if(blobs == NULL || sizes == NULL)
+	{
+		return 1;
+	}
+
+	for(uint32_t i = 0; i < count; i++)
+	{
+		const char *path = argv[i + 3];
+		if(strlen(entry_name(path, argv[2])) >= SHADERBUNDLE_NAME_SIZE)
+		{
+			fprintf(stderr, "name too long: %s\n", path);
+			return 1;
+		}
+		blobs[i] = read_file(path, &sizes[i]);
+		if(blobs[i] == NULL || (sizes[i] % 4) != 0)
+		{
+			fprintf(stderr, "not a SPIR-V file: %s\n", path);
+			return 1;
+		}
+	}
+
+	FILE *out = fopen(argv[1], "wb");
+	if(out == NULL)
+	{
+		fprintf(stderr, "can't write %s\n", argv[1]);
+		return 1;
+	}
+	fwrite(SHADERBUNDLE_MAGIC, 1, 4, out);
+	write_u32(out, SHADERBUNDLE_VERSION);
+	write_u32(out, count);
+
+	//SPIR-V sizes are multiples of 4, so every blob stays aligned
+	uint32_t offset = HEADER_SIZE + ENTRY_SIZE * count;
+	for(uint32_t i = 0; i < count; i++)
+	{
+		char name[SHADERBUNDLE_NAME_SIZE] = { 0 };
+		strncpy(name, entry_name(argv[i + 3], argv[2]), SHADERBUNDLE_NAME_SIZE - 1);
+		for(char *c = name; *c != '\0'; c++)
+		{
+			if(*c == '\\')
+			{
+				*c = '/';
+			}
+		}
+		fwrite(name, 1, SHADERBUNDLE_NAME_SIZE, out);
+		write_u32(out, offset);
+		write_u32(out, sizes[i]);
+		offset += sizes[i];
+	}
+	for(uint32_t i = 0; i < count; i++)
+	{
+		fwrite(blobs[i], 1, sizes[i], out);
+		free(blobs[i]);
+	}
+	fclose(out);
+	free(blobs);
+	free(sizes);
+	printf("%u shaders written to %s\n", count, argv[1]);
+	return 0;
+}